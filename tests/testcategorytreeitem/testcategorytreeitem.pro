@@ -21,7 +21,8 @@ unix: CONFIG += link_pkgconfig
 unix: PKGCONFIG += protobuf
 
 HEADERS += \
-    ../../vizzyix/categorytreeitem.h
+    ../../vizzyix/categorytreeitem.h \
+    ../../vizzyix/facetindex.h
 
 DISTFILES += \
     meson.build
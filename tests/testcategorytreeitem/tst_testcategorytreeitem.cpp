@@ -26,7 +26,9 @@ class TestCategoryTreeItem : public QObject
     void test_addCount();
     void test_isContainer();
     void test_categoryNumber();
+    void test_packageRange();
     void test_findChild();
+    void test_insertRemoveMove();
 };
 
 TestCategoryTreeItem::TestCategoryTreeItem()
@@ -215,6 +217,19 @@ void TestCategoryTreeItem::test_categoryNumber()
     delete top;
 }
 
+void TestCategoryTreeItem::test_packageRange()
+{
+    CategoryTreeItem *top = CategoryTreeItem::newRootItem({"abc", 2, -1});
+    QCOMPARE(top->packageBegin(), 0);
+    QCOMPARE(top->packageEnd(), 0);
+
+    top->setPackageRange(10, 25);
+    QCOMPARE(top->packageBegin(), 10);
+    QCOMPARE(top->packageEnd(), 25);
+
+    delete top;
+}
+
 void TestCategoryTreeItem::test_findChild()
 {
     CategoryTreeItem *top = CategoryTreeItem::newRootItem({"def", 2, 3});
@@ -240,6 +255,56 @@ void TestCategoryTreeItem::test_findChild()
     delete top;
 }
 
+void TestCategoryTreeItem::test_insertRemoveMove()
+{
+    CategoryTreeItem *top = CategoryTreeItem::newRootItem({"def", 2, 3});
+    for (int n = 0; n < 1000; ++n) {
+        (void)top->appendChild({QStringLiteral("TEST_%1").arg(n), 8, 9});
+    }
+
+    // The rows and names follow the children about
+    CategoryTreeItem *inserted = top->insertChild(10, {"Inserted", 1, 2});
+    QCOMPARE(inserted->row(), 10);
+    QCOMPARE(top->findChild("TEST_10")->row(), 11);
+
+    top->moveChild(10, 500);
+    QCOMPARE(inserted->row(), 500);
+    QCOMPARE(top->findChild("TEST_10")->row(), 10);
+    QCOMPARE(top->findChild("TEST_499")->row(), 499);
+    QCOMPARE(top->findChild("TEST_500")->row(), 501);
+
+    const CategoryTreeItem *last = top->child(top->childCount() - 1);
+    top->removeChild(500);
+    QCOMPARE(top->findChild("Inserted"), nullptr);
+    QCOMPARE(top->childCount(), 1000);
+    QCOMPARE(last->row(), 999);
+    for (int row = 0; row < top->childCount(); ++row) {
+        QCOMPARE(top->child(row)->row(), row);
+    }
+
+    // A removed item is reused
+    CategoryTreeItem *reused = top->appendChild({"Reused", 1, 2});
+    QCOMPARE(reused, inserted);
+    QCOMPARE(reused->row(), 1000);
+    QCOMPARE(reused->childCount(), 0);
+
+    // Renamed, and the same name twice
+    top->child(0)->setData(CategoryTreeItem::Column::Name, "Renamed");
+    QCOMPARE(top->findChild("TEST_0"), nullptr);
+    QCOMPARE(top->findChild("Renamed"), top->child(0));
+    (void)top->appendChild({"Renamed", 1, 2});
+    QCOMPARE(top->findChild("Renamed"), top->child(0));
+    top->removeChild(0);
+    QCOMPARE(top->findChild("Renamed"), top->child(top->childCount() - 1));
+
+    // The same name under another parent
+    CategoryTreeItem *grandchild = top->child(1)->appendChild({"TEST_5", 0, 1});
+    QCOMPARE(top->child(1)->findChild("TEST_5"), grandchild);
+    QCOMPARE(top->findChild("TEST_5"), top->child(4));
+
+    delete top;
+}
+
 QTEST_APPLESS_MAIN(TestCategoryTreeItem)
 
 #include "tst_testcategorytreeitem.moc"
@@ -23,7 +23,8 @@ unix: PKGCONFIG += protobuf
 
 HEADERS += \
     ../../vizzyix/categorytreeitem.h \
-    ../../vizzyix/categorytreemodel.h
+    ../../vizzyix/categorytreemodel.h \
+    ../../vizzyix/facetindex.h
 
 DISTFILES += \
     meson.build
@@ -20,6 +20,9 @@ class TestCategoryTreeModel : public QObject
     void test_clear();
     void test_headerData();
     void test_addCategory();
+    void test_addCategory_signals();
+    void test_updateCategories();
+    void test_facetCounts();
     void test_index();
     void test_data();
     void test_parent();
@@ -182,6 +185,148 @@ void TestCategoryTreeModel::test_addCategory()
     QCOMPARE(third->packageCount(), 45u);
 }
 
+void TestCategoryTreeModel::test_addCategory_signals()
+{
+    // Outside of startUpdate/endUpdate, each new node is announced to the
+    // views, along with the changed package counts.
+    QSignalSpy inserted(base, &CategoryTreeModel::rowsInserted);
+    QSignalSpy changed(base, &CategoryTreeModel::dataChanged);
+    QModelIndex all = base->index(0, 0);
+
+    // New container and new child: two inserts, two count changes
+    base->addCategory(1, "First-One", 41);
+    QCOMPARE(inserted.count(), 2);
+    QCOMPARE(inserted[0][0].value<QModelIndex>(), all);
+    QCOMPARE(inserted[0][1].toInt(), 0);
+    QCOMPARE(inserted[1][0].value<QModelIndex>(), base->index(0, 0, all));
+    QCOMPARE(inserted[1][1].toInt(), 0);
+    QCOMPARE(changed.count(), 2);
+
+    // Existing container, new child
+    base->addCategory(2, "First-Two", 42);
+    QCOMPARE(inserted.count(), 3);
+    QCOMPARE(inserted[2][0].value<QModelIndex>(), base->index(0, 0, all));
+    QCOMPARE(inserted[2][1].toInt(), 1);
+    QCOMPARE(changed.count(), 4);
+
+    // No container, only the All count changes
+    base->addCategory(3, "Third", 45);
+    QCOMPARE(inserted.count(), 4);
+    QCOMPARE(inserted[3][0].value<QModelIndex>(), all);
+    QCOMPARE(inserted[3][1].toInt(), 1);
+    QCOMPARE(changed.count(), 5);
+    QCOMPARE(changed[4][0].value<QModelIndex>(),
+             base->index(0, CategoryTreeItem::Column::PkgCount));
+
+    // Nothing is announced during a reset
+    base->startUpdate();
+    base->addCategory(4, "Fourth-One", 4);
+    base->endUpdate();
+    QCOMPARE(inserted.count(), 4);
+    QCOMPARE(changed.count(), 5);
+}
+
+void TestCategoryTreeModel::test_updateCategories()
+{
+    base->updateCategories(
+        {{0, "First-One", 41}, {1, "First-Two", 42}, {2, "Third", 45}});
+    const CategoryTreeItem *all = base->allItem();
+    QCOMPARE(all->childCount(), 2);
+    QCOMPARE(all->packageCount(), 128u);
+    const CategoryTreeItem *first = all->child(0);
+    const CategoryTreeItem *firstTwo = first->child(1);
+
+    QSignalSpy reset(base, &CategoryTreeModel::modelReset);
+    QSignalSpy inserted(base, &CategoryTreeModel::rowsInserted);
+    QSignalSpy removed(base, &CategoryTreeModel::rowsRemoved);
+    QSignalSpy moved(base, &CategoryTreeModel::rowsMoved);
+    QSignalSpy changed(base, &CategoryTreeModel::dataChanged);
+
+    // The same again: nothing to tell the views
+    base->updateCategories(
+        {{0, "First-One", 41}, {1, "First-Two", 42}, {2, "Third", 45}});
+    QCOMPARE(inserted.count() + removed.count() + moved.count(), 0);
+    QCOMPARE(changed.count(), 0);
+
+    // First-One has gone, First-Two has fewer packages and a new eix number,
+    // Second-One is new
+    base->updateCategories(
+        {{0, "First-Two", 40}, {1, "Second-One", 5}, {2, "Third", 45}});
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed[0][0].value<QModelIndex>(),
+             base->index(0, 0, base->index(0, 0, {})));
+    QCOMPARE(inserted.count(), 2); // "Second" and "One" under it
+    QCOMPARE(moved.count(), 0);
+    QCOMPARE(changed.count(), 3); // First-Two, First and All
+
+    // The nodes that were kept are the same objects
+    QCOMPARE(all->child(0), first);
+    QCOMPARE(first->childCount(), 1);
+    QCOMPARE(first->child(0), firstTwo);
+    QCOMPARE(firstTwo->packageCount(), 40u);
+    QCOMPARE(firstTwo->categoryNumber(), 0);
+    QCOMPARE(first->packageCount(), 40u);
+    QCOMPARE(all->child(1)->data(CategoryTreeItem::Column::Name), "Second");
+    QCOMPARE(all->child(1)->child(0)->categoryNumber(), 1);
+    QCOMPARE(all->child(2)->data(CategoryTreeItem::Column::Name), "Third");
+    QCOMPARE(all->packageCount(), 90u);
+
+    // A change of order is a move
+    base->updateCategories(
+        {{0, "Third", 45}, {1, "First-Two", 40}, {2, "Second-One", 5}});
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(inserted.count(), 2);
+    QCOMPARE(all->child(0)->data(CategoryTreeItem::Column::Name), "Third");
+    QCOMPARE(all->child(1), first);
+
+    QCOMPARE(reset.count(), 0);
+}
+
+void TestCategoryTreeModel::test_facetCounts()
+{
+    FacetIndex::Counts oneCounts{};
+    oneCounts[FacetIndex::Installed] = 3;
+    oneCounts[FacetIndex::HasUpdate] = 1;
+    FacetIndex::Counts twoCounts{};
+    twoCounts[FacetIndex::Installed] = 2;
+    base->updateCategories({{0, "First-One", 41, oneCounts},
+                            {1, "First-Two", 42, twoCounts},
+                            {2, "Third", 45, {}}});
+
+    // Containers and All add up their categories
+    const CategoryTreeItem *all = base->allItem();
+    const CategoryTreeItem *first = all->child(0);
+    QCOMPARE(first->child(0)->facetCounts(), oneCounts);
+    QCOMPARE(first->facetCounts()[FacetIndex::Installed], 5u);
+    QCOMPARE(first->facetCounts()[FacetIndex::HasUpdate], 1u);
+    QCOMPARE(all->facetCounts()[FacetIndex::Installed], 5u);
+
+    // Shown in the tooltip, one facet to a line
+    const QModelIndex allIndex = base->index(0, 0);
+    const QString toolTip = base->data(allIndex, Qt::ToolTipRole).toString();
+    QCOMPARE(toolTip.split('\n').size(), int(FacetIndex::Repository));
+    QVERIFY(toolTip.contains(
+        CategoryTreeModel::facetTitle(FacetIndex::Installed) + ": 5"));
+    base->setRepositoryTitle("gentoo");
+    QVERIFY(base->data(allIndex, Qt::ToolTipRole)
+                .toString()
+                .endsWith("gentoo: 0"));
+    base->setRepositoryTitle("");
+
+    // A change of count is only a tooltip change for the views
+    QSignalSpy changed(base, &CategoryTreeModel::dataChanged);
+    twoCounts[FacetIndex::Installed] = 1;
+    base->updateCategories({{0, "First-One", 41, oneCounts},
+                            {1, "First-Two", 42, twoCounts},
+                            {2, "Third", 45, {}}});
+    QCOMPARE(changed.count(), 3); // First-Two, First and All
+    for (const auto &signal : changed) {
+        QCOMPARE(signal[2].value<QList<int>>(), QList<int>{Qt::ToolTipRole});
+    }
+    QCOMPARE(all->facetCounts()[FacetIndex::Installed], 4u);
+}
+
 void TestCategoryTreeModel::test_index()
 {
     setupTree();
@@ -0,0 +1,37 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+TEMPLATE = app
+
+SOURCES +=  tst_testcombinedpackagelist.cpp \
+    ../../vizzyix/combinedpackageinfo.cpp \
+    ../../vizzyix/combinedpackagelist.cpp \
+    ../../vizzyix/packagedatabasescanner.cpp \
+    ../../vizzyix/snapshotimage.cpp \
+    ../../vizzyix/stringpool.cpp \
+    ../../vizzyix/versionkey.cpp
+
+LIBS += -L../../eixpb -leixpb
+
+INCLUDEPATH += $$top_builddir/eixpb ../../vizzyix
+
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += protobuf
+
+HEADERS += \
+    ../../vizzyix/combinedpackageinfo.h \
+    ../../vizzyix/combinedpackagelist.h \
+    ../../vizzyix/packagedatabasescanner.h \
+    ../../vizzyix/snapshotimage.h \
+    ../../vizzyix/stringpool.h \
+    ../../vizzyix/versionkey.h
+
+DISTFILES += \
+    meson.build
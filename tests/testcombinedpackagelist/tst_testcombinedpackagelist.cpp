@@ -0,0 +1,269 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include "combinedpackagelist.h"
+#include "eix.pb.h"
+#include "snapshotimage.h"
+
+class TestCombinedPackageList : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestCombinedPackageList();
+    ~TestCombinedPackageList();
+
+  private slots:
+    void initTestCase();
+    void test_empty();
+    void test_isZombie();
+    void test_zombieVersions();
+    void test_zombieVersionNames();
+    void test_sameVersion();
+    void test_zombieList();
+    void test_reloadCategories();
+    void test_saveRestore();
+    void test_largeTree();
+
+  private:
+    static void addPackage(eix_proto::Category *cat,
+                           const std::string &name,
+                           const QStringList &installed,
+                           const QStringList &available = {});
+
+  private:
+    eix_proto::Collection eix;
+    QStringList packageDatabase;
+    CombinedPackageList list{"/var/db/pkg"};
+};
+
+TestCombinedPackageList::TestCombinedPackageList()
+{
+}
+
+TestCombinedPackageList::~TestCombinedPackageList()
+{
+}
+
+void TestCombinedPackageList::addPackage(eix_proto::Category *cat,
+                                         const std::string &name,
+                                         const QStringList &installed,
+                                         const QStringList &available)
+{
+    auto *pkg = cat->add_package();
+    pkg->set_name(name);
+    for (const auto &id : available) {
+        pkg->add_version()->set_id(id.toStdString());
+    }
+    for (const auto &id : installed) {
+        auto *ver = pkg->add_version();
+        ver->set_id(id.toStdString());
+        ver->mutable_installed()->set_date(1700000000);
+    }
+}
+
+void TestCombinedPackageList::initTestCase()
+{
+    auto *cat = eix.add_category();
+    cat->set_category("dev-qt");
+    addPackage(cat, "qtbase", {"6.7.2"}, {"6.7.1"});
+    addPackage(cat, "qt-creator", {"14.0.1"});
+    cat = eix.add_category();
+    cat->set_category("app-misc");
+    addPackage(cat, "screen", {}, {"4.9.1"});
+
+    packageDatabase = QStringList{
+        "dev-qt/qtbase-6.7.2",
+        "dev-qt/qt-creator-14.0.1",
+        "dev-qt/qt-creator-13.0.0", // no longer known to eix
+        "sys-libs/oldlib-1.0",      // nor is the whole package
+        "dev-qt/noversion",         // ignored
+    };
+
+    list.load(eix, packageDatabase);
+}
+
+void TestCombinedPackageList::test_empty()
+{
+    CombinedPackageList empty("/var/db/pkg");
+    QCOMPARE(empty.packageCount(), 0);
+    QVERIFY(!empty.isZombie("dev-qt", "qtbase"));
+    QVERIFY(empty.zombieVersions("dev-qt", "qtbase").isEmpty());
+    QVERIFY(empty.zombieList().isEmpty());
+}
+
+void TestCombinedPackageList::test_isZombie()
+{
+    QCOMPARE(list.packageCount(), 3);
+    QVERIFY(!list.isZombie("dev-qt", "qtbase"));
+    QVERIFY(list.isZombie("dev-qt", "qt-creator"));
+    QVERIFY(list.isZombie("sys-libs", "oldlib"));
+    QVERIFY(!list.isZombie("app-misc", "screen"));
+    QVERIFY(!list.isZombie("dev-qt", "noversion"));
+    QVERIFY(!list.isZombie("no-such", "package"));
+
+    // Names are only equal as a pair
+    QVERIFY(!list.isZombie("sys-libs", "qt-creator"));
+}
+
+void TestCombinedPackageList::test_zombieVersions()
+{
+    QVERIFY(list.zombieVersions("dev-qt", "qtbase").isEmpty());
+
+    // Only the version eix doesn't know about
+    VersionMap versions = list.zombieVersions("dev-qt", "qt-creator");
+    QCOMPARE(versions.keys(), QStringList{"13.0.0"});
+
+    const auto &zombie = versions["13.0.0"];
+    QCOMPARE(zombie.versionName(), QString("13.0.0"));
+    QVERIFY(zombie.inPkgDb());
+    QVERIFY(!zombie.inEixDb());
+    QCOMPARE(zombie.versionDir().path(),
+             QString("/var/db/pkg/dev-qt/qt-creator-13.0.0"));
+}
+
+void TestCombinedPackageList::test_zombieVersionNames()
+{
+    QCOMPARE(list.zombieIndex("dev-qt", "qtbase"), -1);
+    QCOMPARE(list.zombieIndex("no-such", "package"), -1);
+
+    const int creator = list.zombieIndex("dev-qt", "qt-creator");
+    const int oldlib = list.zombieIndex("sys-libs", "oldlib");
+    QVERIFY(creator >= 0);
+    QVERIFY(oldlib >= 0);
+    QVERIFY(creator != oldlib);
+    QCOMPARE(list.zombieVersionNames(creator), QStringList{"13.0.0"});
+    QCOMPARE(list.zombieVersionNames(oldlib), QStringList{"1.0"});
+
+    // Several zombie versions are in version order, whatever order they
+    // were read in
+    CombinedPackageList several("/var/db/pkg");
+    several.load(eix,
+                 {"dev-qt/qt-creator-12.0.0",
+                  "dev-qt/qt-creator-14.0.1",
+                  "dev-qt/qt-creator-9.0.0"});
+    QCOMPARE(several.zombieVersionNames(
+                 several.zombieIndex("dev-qt", "qt-creator")),
+             (QStringList{"9.0.0", "12.0.0"}));
+}
+
+void TestCombinedPackageList::test_sameVersion()
+{
+    // The same version, written differently, isn't a zombie
+    CombinedPackageList same("/var/db/pkg");
+    same.load(eix, {"dev-qt/qtbase-6.7.2-r0", "dev-qt/qt-creator-14.0.01"});
+    QVERIFY(!same.isZombie("dev-qt", "qtbase"));
+    QVERIFY(same.isZombie("dev-qt", "qt-creator"));
+    QCOMPARE(same.zombieVersionNames(same.zombieIndex("dev-qt", "qt-creator")),
+             QStringList{"14.0.01"});
+}
+
+void TestCombinedPackageList::test_zombieList()
+{
+    QStringList zombies = list.zombieList();
+    zombies.sort();
+    QCOMPARE(zombies, (QStringList{"dev-qt/qt-creator", "sys-libs/oldlib"}));
+}
+
+void TestCombinedPackageList::test_reloadCategories()
+{
+    CombinedPackageList reloaded("/var/db/pkg");
+    reloaded.load(eix, packageDatabase);
+
+    // The old qt-creator has been uninstalled
+    reloaded.reloadCategories(
+        eix,
+        {"dev-qt"},
+        {"dev-qt/qtbase-6.7.2", "dev-qt/qt-creator-14.0.1"});
+    QVERIFY(!reloaded.isZombie("dev-qt", "qt-creator"));
+    QVERIFY(!reloaded.isZombie("dev-qt", "qtbase"));
+    QVERIFY(reloaded.isZombie("sys-libs", "oldlib"));
+    QCOMPARE(reloaded.zombieList(), QStringList{"sys-libs/oldlib"});
+
+    // And so has the old library, leaving its category empty
+    reloaded.reloadCategories(eix, {"sys-libs"}, {});
+    QVERIFY(reloaded.zombieList().isEmpty());
+    QCOMPARE(reloaded.packageCount(), 2);
+}
+
+void TestCombinedPackageList::test_saveRestore()
+{
+    SnapshotImage saved;
+    list.save(saved);
+
+    // The same zombies, without the eix data or the package database
+    CombinedPackageList restored("/var/db/pkg");
+    SnapshotImage image(saved.bytes().constData(), saved.bytes().size());
+    QVERIFY(restored.restore(image));
+    QVERIFY(image.atEnd());
+    QCOMPARE(restored.packageCount(), list.packageCount());
+    QVERIFY(restored.isZombie("dev-qt", "qt-creator"));
+    QVERIFY(!restored.isZombie("dev-qt", "qtbase"));
+    QCOMPARE(restored.zombieVersionNames(
+                 restored.zombieIndex("sys-libs", "oldlib")),
+             QStringList{"1.0"});
+    QStringList zombies = restored.zombieList();
+    zombies.sort();
+    QCOMPARE(zombies, (QStringList{"dev-qt/qt-creator", "sys-libs/oldlib"}));
+
+    // It can be reloaded like one that was loaded
+    restored.reloadCategories(eix, {"sys-libs"}, {});
+    QVERIFY(!restored.isZombie("sys-libs", "oldlib"));
+
+    // Cut short, nothing is restored
+    SnapshotImage cut(saved.bytes().constData(), saved.bytes().size() - 1);
+    QVERIFY(!restored.restore(cut));
+    QCOMPARE(restored.packageCount(), 0);
+}
+
+void TestCombinedPackageList::test_largeTree()
+{
+    // About the size of a well used desktop system
+    eix_proto::Collection large;
+    QStringList largeDatabase;
+    for (int catNumber = 0; catNumber < 160; ++catNumber) {
+        auto *cat = large.add_category();
+        cat->set_category("cat-" + std::to_string(catNumber));
+        for (int pkgNumber = 0; pkgNumber < 125; ++pkgNumber) {
+            const std::string name = "package" + std::to_string(pkgNumber);
+            if (pkgNumber % 5 == 0) {
+                addPackage(cat, name, {"1.2.3"}, {"1.2.2", "1.2.4"});
+                largeDatabase.append(
+                    QString::fromStdString(cat->category() + "/" + name) +
+                    "-1.2.3");
+            } else {
+                addPackage(cat, name, {}, {"2.0"});
+            }
+        }
+    }
+    largeDatabase.append("cat-0/zombie-1.0");
+
+    QElapsedTimer timer;
+    timer.start();
+    CombinedPackageList largeList("/var/db/pkg");
+    largeList.load(large, largeDatabase);
+    const qint64 loadTime = timer.nsecsElapsed() / 1000;
+    QCOMPARE(largeList.packageCount(), 4001);
+
+    timer.restart();
+    int zombies = 0;
+    for (const auto &cat : large.category()) {
+        for (const auto &pkg : cat.package()) {
+            zombies += largeList.isZombie(cat.category(), pkg.name());
+        }
+    }
+    const qint64 lookupTime = timer.nsecsElapsed() / 1000;
+    QCOMPARE(zombies, 0);
+    QVERIFY(largeList.isZombie("cat-0", "zombie"));
+
+    qInfo() << largeList.packageCount() << "installed packages merged in"
+            << loadTime << "us, zombie check of" << large.category_size() * 125
+            << "packages in" << lookupTime << "us";
+}
+
+QTEST_APPLESS_MAIN(TestCombinedPackageList)
+
+#include "tst_testcombinedpackagelist.moc"
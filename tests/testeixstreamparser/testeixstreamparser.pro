@@ -0,0 +1,31 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+DEFINES += TESTDATA=\\\"$$top_srcdir/pbtesting/eix.pb\\\"
+
+TEMPLATE = app
+
+SOURCES +=  tst_testeixstreamparser.cpp \
+    ../../vizzyix/eixlazydecoder.cpp \
+    ../../vizzyix/eixstreamparser.cpp
+
+LIBS += -L../../eixpb -leixpb
+
+INCLUDEPATH += $$top_builddir/eixpb ../../vizzyix
+
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += protobuf
+
+HEADERS += \
+    ../../vizzyix/eixlazydecoder.h \
+    ../../vizzyix/eixstreamparser.h
+
+DISTFILES += \
+    meson.build
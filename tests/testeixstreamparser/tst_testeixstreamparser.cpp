@@ -0,0 +1,312 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QThread>
+#include <QtTest>
+#include <atomic>
+
+#include "eix.pb.h"
+#include "eixlazydecoder.h"
+#include "eixstreamparser.h"
+
+class TestEixStreamParser : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestEixStreamParser();
+    ~TestEixStreamParser();
+
+  private slots:
+    void initTestCase();
+    void test_whole();
+    void test_chunked_data();
+    void test_chunked();
+    void test_threads_data();
+    void test_threads();
+    void test_background();
+    void test_truncated();
+    void test_reset();
+    void test_lazy_summary();
+    void test_lazy_details();
+    void benchmark_streamed_data();
+    void benchmark_streamed();
+
+  private:
+    QByteArray testData;
+    eix_proto::Collection reference;
+};
+
+TestEixStreamParser::TestEixStreamParser()
+{
+}
+
+TestEixStreamParser::~TestEixStreamParser()
+{
+}
+
+void TestEixStreamParser::initTestCase()
+{
+    QFile input(TESTDATA);
+    if (!input.open(QIODevice::ReadOnly)) {
+        QFAIL("Failed to open data file: " TESTDATA);
+    }
+    testData = input.readAll();
+
+    QVERIFY(reference.ParseFromArray(testData.constData(), testData.size()));
+    QVERIFY(reference.category_size() > 0);
+}
+
+void TestEixStreamParser::test_whole()
+{
+    eix_proto::Collection eix;
+    EixStreamParser parser(&eix);
+
+    QCOMPARE(parser.feed(testData) + parser.wait(), reference.category_size());
+    QVERIFY(parser.finish());
+    QCOMPARE(eix.SerializeAsString(), reference.SerializeAsString());
+}
+
+void TestEixStreamParser::test_chunked_data()
+{
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("1 byte") << 1;
+    QTest::newRow("7 bytes") << 7;
+    QTest::newRow("4k") << 4096;
+    QTest::newRow("64k") << 65536;
+}
+
+void TestEixStreamParser::test_chunked()
+{
+    QFETCH(int, chunkSize);
+
+    eix_proto::Collection eix;
+    EixStreamParser parser(&eix);
+
+    int decoded = 0;
+    for (qsizetype pos = 0; pos < testData.size(); pos += chunkSize) {
+        decoded += parser.feed(testData.mid(pos, chunkSize));
+
+        // Categories are only ever added in one piece
+        QCOMPARE(decoded, eix.category_size());
+    }
+
+    decoded += parser.wait();
+    QVERIFY(parser.finish());
+    QCOMPARE(decoded, reference.category_size());
+    QCOMPARE(eix.SerializeAsString(), reference.SerializeAsString());
+}
+
+void TestEixStreamParser::test_threads_data()
+{
+    QTest::addColumn<int>("threadCount");
+
+    QTest::newRow("serial") << 1;
+    QTest::newRow("2 threads") << 2;
+    QTest::newRow("8 threads") << 8;
+    QTest::newRow("64 threads") << 64;
+}
+
+void TestEixStreamParser::test_threads()
+{
+    QFETCH(int, threadCount);
+
+    eix_proto::Collection eix;
+    EixStreamParser parser(&eix);
+    parser.setThreadCount(threadCount);
+
+    // However many threads decode the categories, they must come out in the
+    // same order as the eix output
+    QCOMPARE(parser.feed(testData) + parser.wait(), reference.category_size());
+    QVERIFY(parser.finish());
+    for (int catNumber = 0; catNumber < reference.category_size();
+         ++catNumber) {
+        QCOMPARE(eix.category(catNumber).category(),
+                 reference.category(catNumber).category());
+    }
+    QCOMPARE(eix.SerializeAsString(), reference.SerializeAsString());
+}
+
+void TestEixStreamParser::test_background()
+{
+    eix_proto::Collection eix;
+    EixStreamParser parser(&eix);
+    std::atomic<int> signalled{0};
+    QObject::connect(&parser,
+                     &EixStreamParser::categoriesDecoded,
+                     [&signalled]() { ++signalled; });
+
+    // The categories are decoded without waiting for them, and are added to
+    // the collection by collect() as they are done
+    int decoded = parser.feed(testData);
+    QElapsedTimer timer;
+    timer.start();
+    while (decoded < reference.category_size() && timer.elapsed() < 10000) {
+        QThread::yieldCurrentThread();
+        decoded += parser.collect();
+        QCOMPARE(decoded, eix.category_size());
+    }
+    QCOMPARE(decoded, reference.category_size());
+    QVERIFY(signalled > 0);
+
+    QVERIFY(parser.finish());
+    QCOMPARE(eix.SerializeAsString(), reference.SerializeAsString());
+}
+
+void TestEixStreamParser::test_truncated()
+{
+    eix_proto::Collection eix;
+    EixStreamParser parser(&eix);
+
+    parser.feed(testData.first(testData.size() - 1));
+    parser.wait();
+    QCOMPARE(eix.category_size(), reference.category_size() - 1);
+    QVERIFY(!parser.finish());
+}
+
+void TestEixStreamParser::test_reset()
+{
+    eix_proto::Collection first;
+    eix_proto::Collection second;
+    EixStreamParser parser(&first);
+
+    parser.feed(testData.first(testData.size() / 2));
+    parser.reset(&second);
+    parser.feed(testData);
+
+    QVERIFY(parser.finish());
+    QCOMPARE(second.category_size(), reference.category_size());
+}
+
+void TestEixStreamParser::test_lazy_summary()
+{
+    eix_proto::Collection eix;
+    EixLazyDecoder lazy;
+    EixStreamParser parser;
+    parser.reset(&eix, &lazy);
+    parser.setThreadCount(4);
+
+    QCOMPARE(parser.feed(testData) + parser.wait(), reference.category_size());
+    QVERIFY(parser.finish());
+    QVERIFY(lazy.retainedBytes() > 0);
+
+    // The summaries and the raw bytes kept for the details take clearly less
+    // memory than decoding everything
+    QVERIFY(qint64(eix.SpaceUsedLong()) + lazy.retainedBytes() <
+            qint64(reference.SpaceUsedLong()) * 9 / 10);
+
+    // The fields needed for the tree and package list are all there, the
+    // details are not
+    for (int catNumber = 0; catNumber < reference.category_size();
+         ++catNumber) {
+        const auto &cat = eix.category(catNumber);
+        const auto &refCat = reference.category(catNumber);
+        QCOMPARE(cat.category(), refCat.category());
+        QCOMPARE(cat.package_size(), refCat.package_size());
+
+        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
+            const auto &pkg = cat.package(pkgNumber);
+            const auto &refPkg = refCat.package(pkgNumber);
+            QVERIFY(lazy.isSummary(pkg));
+            QCOMPARE(pkg.name(), refPkg.name());
+            QCOMPARE(pkg.description(), refPkg.description());
+            QVERIFY(pkg.homepage().empty());
+            QCOMPARE(pkg.version_size(), refPkg.version_size());
+
+            for (int verNumber = 0; verNumber < pkg.version_size();
+                 ++verNumber) {
+                const auto &ver = pkg.version(verNumber);
+                const auto &refVer = refPkg.version(verNumber);
+                QCOMPARE(ver.id(), refVer.id());
+                QCOMPARE(ver.has_installed(), refVer.has_installed());
+                QCOMPARE(ver.local_mask_flags().SerializeAsString(),
+                         refVer.local_mask_flags().SerializeAsString());
+                QCOMPARE(ver.system_key_flags().SerializeAsString(),
+                         refVer.system_key_flags().SerializeAsString());
+                QCOMPARE(ver.repository().repository(),
+                         refVer.repository().repository());
+                QCOMPARE(ver.iuse_size(), 0);
+            }
+        }
+    }
+}
+
+void TestEixStreamParser::test_lazy_details()
+{
+    eix_proto::Collection eix;
+    EixLazyDecoder lazy;
+    EixStreamParser parser;
+    parser.reset(&eix, &lazy);
+
+    // Feed in pieces, to check the package offsets within each category
+    for (qsizetype pos = 0; pos < testData.size(); pos += 1000) {
+        parser.feed(testData.mid(pos, 1000));
+    }
+    QVERIFY(parser.finish());
+
+    for (int catNumber = 0; catNumber < reference.category_size();
+         ++catNumber) {
+        const auto &cat = eix.category(catNumber);
+        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
+            const auto &pkg = cat.package(pkgNumber);
+
+            // Decoded in place, so references to the package stay good
+            QCOMPARE(&lazy.details(pkg), &pkg);
+            QVERIFY(!lazy.isSummary(pkg));
+            QCOMPARE(pkg.SerializeAsString(),
+                     reference.category(catNumber)
+                         .package(pkgNumber)
+                         .SerializeAsString());
+        }
+    }
+
+    // Packages it doesn't know about are left alone
+    eix_proto::Package other;
+    QVERIFY(!lazy.isSummary(other));
+    QCOMPARE(&lazy.details(other), &other);
+
+    lazy.clear();
+    QCOMPARE(lazy.retainedBytes(), 0);
+}
+
+void TestEixStreamParser::benchmark_streamed_data()
+{
+    QTest::addColumn<int>("threadCount");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all threads") << QThread::idealThreadCount();
+}
+
+/*!
+ * A streamed load: the test data over and over, to make 16 MB of eix
+ * output, fed in the 4k pieces a read from the eix pipe usually gives. Each
+ * piece holds a category or less, so this only gets faster with more
+ * threads if the pieces are decoded side by side.
+ */
+void TestEixStreamParser::benchmark_streamed()
+{
+    QFETCH(int, threadCount);
+    constexpr int chunkSize = 4096;
+
+    QByteArray stream;
+    while (stream.size() < 16 * 1024 * 1024) {
+        stream.append(testData);
+    }
+
+    QBENCHMARK {
+        eix_proto::Collection eix;
+        EixStreamParser parser(&eix);
+        parser.setThreadCount(threadCount);
+        for (qsizetype pos = 0; pos < stream.size(); pos += chunkSize) {
+            parser.feed(stream.mid(pos, chunkSize));
+        }
+        QVERIFY(parser.finish());
+    }
+}
+
+QTEST_APPLESS_MAIN(TestEixStreamParser)
+
+#include "tst_testeixstreamparser.moc"
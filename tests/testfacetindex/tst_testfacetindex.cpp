@@ -0,0 +1,296 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+
+#include "eix.pb.h"
+#include "eixprotohelper.h"
+#include "facetindex.h"
+#include "packagestore.h"
+#include "snapshotimage.h"
+#include <algorithm>
+#include <fstream>
+
+class TestFacetIndex : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestFacetIndex();
+    ~TestFacetIndex();
+
+  private slots:
+    void initTestCase();
+    void test_construction();
+    void test_build();
+    void test_narrow();
+    void test_count();
+    void test_clear();
+    void test_saveRestore();
+    void benchmark_narrowAndCount();
+
+  private:
+    bool expected(int index, FacetIndex::Facet facet, int repository) const;
+    std::vector<uint64_t> allRows() const;
+
+    eix_proto::Collection eix;
+    QStringList emptyVersionList;
+    PackageStore store;
+    FacetIndex facets;
+};
+
+TestFacetIndex::TestFacetIndex()
+{
+}
+
+TestFacetIndex::~TestFacetIndex()
+{
+}
+
+void TestFacetIndex::initTestCase()
+{
+    std::fstream input(TESTDATA, std::ios::in | std::ios::binary);
+    if (!eix.ParseFromIstream(&input)) {
+        QFAIL("Failed to parse data file: " TESTDATA);
+    } else {
+        for (const auto &cat : eix.category()) {
+            for (const auto &pkg : cat.package()) {
+                store.addPackage(cat.category(), pkg, emptyVersionList);
+            }
+        }
+        // One with zombies too
+        const auto &cat = eix.category(0);
+        store.addPackage(cat.category(), cat.package(0), {"0.0.1"});
+
+        facets.build(store);
+        QVERIFY(store.size() > 1);
+    }
+}
+
+void TestFacetIndex::test_construction()
+{
+    FacetIndex index;
+    QCOMPARE(index.size(), 0);
+    QVERIFY(index.repositories().isEmpty());
+    QVERIFY(FacetIndex::Selection().isEmpty());
+}
+
+void TestFacetIndex::test_build()
+{
+    QCOMPARE(facets.size(), store.size());
+    QVERIFY(!facets.repositories().isEmpty());
+
+    // The same as looking at each package in turn
+    for (int index = 0; index < store.size(); ++index) {
+        for (int facet = 0; facet < FacetIndex::Repository; ++facet) {
+            QCOMPARE(facets.has(index, FacetIndex::Facet(facet)),
+                     expected(index, FacetIndex::Facet(facet), -1));
+        }
+        for (int repository = 0; repository < facets.repositories().size();
+             ++repository) {
+            QCOMPARE(facets.has(index, FacetIndex::Repository, repository),
+                     expected(index, FacetIndex::Repository, repository));
+        }
+        QVERIFY(!facets.has(index, FacetIndex::Repository));
+    }
+
+    // The test data has some installed packages, and the extra zombie
+    QVERIFY(facets.has(store.size() - 1, FacetIndex::Zombie));
+    QVERIFY(!facets.has(0, FacetIndex::Zombie));
+    QVERIFY(facets.count(allRows(), 0, store.size())[FacetIndex::Installed] >
+            0);
+}
+
+void TestFacetIndex::test_narrow()
+{
+    // Every package with all of the facets, and no others
+    FacetIndex::Selection selection;
+    selection.facets = (1u << FacetIndex::Installed) |
+                       (1u << FacetIndex::UnstableInstalled);
+    selection.repository = 0;
+    QVERIFY(!selection.isEmpty());
+    QVERIFY(selection != FacetIndex::Selection());
+
+    std::vector<uint64_t> rows = allRows();
+    facets.narrow(selection, rows);
+    for (int index = 0; index < store.size(); ++index) {
+        QCOMPARE(FacetIndex::isSet(rows, index),
+                 expected(index, FacetIndex::Installed, -1) &&
+                     expected(index, FacetIndex::UnstableInstalled, -1) &&
+                     expected(index, FacetIndex::Repository, 0));
+    }
+
+    // Narrowing by nothing leaves everything
+    rows = allRows();
+    facets.narrow(FacetIndex::Selection(), rows);
+    QCOMPARE(rows, allRows());
+}
+
+void TestFacetIndex::test_count()
+{
+    // Only every third package, over ranges that do and don't line up with
+    // the words of the bitsets
+    std::vector<uint64_t> rows((store.size() + 63) / 64, 0);
+    for (int index = 0; index < store.size(); index += 3) {
+        FacetIndex::set(rows, index);
+    }
+    const int size = store.size();
+    for (const auto &range : QVector<QPair<int, int>>{{0, size},
+                                                      {0, 64},
+                                                      {1, 63},
+                                                      {5, 6},
+                                                      {size / 2, size},
+                                                      {70, 200},
+                                                      {10, 10}}) {
+        const int begin = qMin(range.first, size);
+        const int end = qMin(range.second, size);
+        const FacetIndex::Counts counts = facets.count(rows, begin, end, 0);
+        for (int facet = 0; facet < FacetIndex::FacetCount; ++facet) {
+            uint count = 0;
+            for (int index = begin; index < end; ++index) {
+                count += FacetIndex::isSet(rows, index) &&
+                         expected(index, FacetIndex::Facet(facet), 0);
+            }
+            QCOMPARE(counts[facet], count);
+        }
+    }
+
+    // No repository, no count
+    QCOMPARE(facets.count(rows, 0, size)[FacetIndex::Repository], 0u);
+}
+
+void TestFacetIndex::test_clear()
+{
+    FacetIndex index;
+    index.build(store);
+    index.clear();
+    QCOMPARE(index.size(), 0);
+    QVERIFY(index.repositories().isEmpty());
+    QVERIFY(!index.has(0, FacetIndex::Installed));
+}
+
+void TestFacetIndex::test_saveRestore()
+{
+    SnapshotImage saved;
+    facets.save(saved);
+
+    // The same facets, without the store
+    FacetIndex restored;
+    SnapshotImage image(saved.bytes().constData(), saved.bytes().size());
+    QVERIFY(restored.restore(image));
+    QVERIFY(image.atEnd());
+    QCOMPARE(restored.size(), facets.size());
+    QCOMPARE(restored.repositories(), facets.repositories());
+    for (int index = 0; index < store.size(); ++index) {
+        for (int facet = 0; facet < FacetIndex::Repository; ++facet) {
+            QCOMPARE(restored.has(index, FacetIndex::Facet(facet)),
+                     facets.has(index, FacetIndex::Facet(facet)));
+        }
+        for (int repository = 0; repository < facets.repositories().size();
+             ++repository) {
+            QCOMPARE(restored.has(index, FacetIndex::Repository, repository),
+                     facets.has(index, FacetIndex::Repository, repository));
+        }
+    }
+
+    // Cut short, nothing is restored
+    SnapshotImage cut(saved.bytes().constData(), saved.bytes().size() - 1);
+    QVERIFY(!restored.restore(cut));
+    QCOMPARE(restored.size(), 0);
+    QVERIFY(restored.repositories().isEmpty());
+}
+
+/*!
+ * A change of facets: narrowing the whole store by two facets, then counting
+ * each facet for every category, on the test data over and over to make
+ * 20,000 packages.
+ */
+void TestFacetIndex::benchmark_narrowAndCount()
+{
+    constexpr int packageCount = 20000;
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore big;
+    while (big.size() < packageCount) {
+        for (const auto &cat : eix.category()) {
+            big.addCategory(cat, combined);
+        }
+    }
+    FacetIndex index;
+    index.build(big);
+    FacetIndex::Selection selection;
+    selection.facets =
+        (1u << FacetIndex::Installed) | (1u << FacetIndex::HasUpdate);
+
+    std::vector<uint64_t> rows;
+    QBENCHMARK {
+        rows.assign((big.size() + 63) / 64, ~uint64_t(0));
+        index.narrow(selection, rows);
+        for (int catNumber = 0; catNumber < big.categoryCount(); ++catNumber) {
+            const int begin = big.index(catNumber, 0);
+            const int end = catNumber + 1 < big.categoryCount()
+                                ? big.index(catNumber + 1, 0)
+                                : big.size();
+            index.count(rows, begin, end);
+        }
+    }
+}
+
+/// Whether the package has the facet, worked out from its eix data
+bool TestFacetIndex::expected(int index,
+                              FacetIndex::Facet facet,
+                              int repository) const
+{
+    const eix_proto::Package &pkg = store.packageDetails(index);
+    switch (facet) {
+    case FacetIndex::Installed:
+        return store.installed(index);
+    case FacetIndex::World:
+        return store.marker(index) == PackageReportItem::WorldMarker;
+    case FacetIndex::Set:
+        return store.marker(index) == PackageReportItem::WorldSetMarker;
+    case FacetIndex::System:
+        return store.marker(index) == PackageReportItem::SystemMarker;
+    case FacetIndex::UnstableInstalled:
+        return std::any_of(
+            pkg.version().begin(), pkg.version().end(), [](const auto &ver) {
+                return ver.has_installed() && !EixProtoHelper::isStable(ver);
+            });
+    case FacetIndex::Zombie:
+        return !store.zombieVersions(index).isEmpty();
+    case FacetIndex::HasUpdate: {
+        const PackageReportItem item = store.item(index);
+        return item.installed() &&
+               item.data(PackageReportItem::Column::AvailableVersion,
+                         PackageReportItem::SortRole)
+                       .toByteArray() >
+                   item.data(PackageReportItem::Column::InstalledVersion,
+                             PackageReportItem::SortRole)
+                       .toByteArray();
+    }
+    case FacetIndex::Repository:
+        return repository >= 0 &&
+               std::any_of(pkg.version().begin(),
+                           pkg.version().end(),
+                           [&](const auto &ver) {
+                               return QString::fromStdString(
+                                          ver.repository().repository()) ==
+                                      facets.repositories()[repository];
+                           });
+    default:
+        return false;
+    }
+}
+
+/// Every package in the store, as a bitset
+std::vector<uint64_t> TestFacetIndex::allRows() const
+{
+    std::vector<uint64_t> rows((store.size() + 63) / 64, 0);
+    for (int index = 0; index < store.size(); ++index) {
+        FacetIndex::set(rows, index);
+    }
+    return rows;
+}
+
+QTEST_APPLESS_MAIN(TestFacetIndex)
+
+#include "tst_testfacetindex.moc"
@@ -0,0 +1,154 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+
+#include "filtercache.h"
+#include "packagefilter.h"
+
+class TestFilterCache : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestFilterCache();
+    ~TestFilterCache();
+
+  private slots:
+    void test_empty();
+    void test_find();
+    void test_key();
+    void test_replace();
+    void test_budget();
+    void test_generation();
+
+  private:
+    /// A result with the given number of packages in each of two categories
+    static FilterCache::Result makeResult(int size);
+};
+
+TestFilterCache::TestFilterCache()
+{
+}
+
+TestFilterCache::~TestFilterCache()
+{
+}
+
+FilterCache::Result TestFilterCache::makeResult(int size)
+{
+    FilterCache::Result result(2);
+    for (int pkgNumber = 0; pkgNumber < size; ++pkgNumber) {
+        result[0].push_back(pkgNumber);
+        result[1].push_back(pkgNumber * 2);
+    }
+    return result;
+}
+
+void TestFilterCache::test_empty()
+{
+    FilterCache cache;
+    QCOMPARE(cache.count(), 0);
+    QCOMPARE(cache.bytes(), qsizetype(0));
+    QVERIFY(cache.find(PackageFilter()) == nullptr);
+}
+
+void TestFilterCache::test_find()
+{
+    FilterCache cache;
+    const PackageFilter filter(PackageFilter::Installed, "qt");
+    cache.insert(filter, makeResult(3));
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(cache.bytes() > 0);
+
+    // A different filter object with the same settings
+    const auto *found =
+        cache.find(PackageFilter(PackageFilter::Installed, "qt"));
+    QVERIFY(found != nullptr);
+    QCOMPARE(*found, makeResult(3));
+
+    QVERIFY(cache.find(PackageFilter(PackageFilter::Installed, "q")) ==
+            nullptr);
+}
+
+void TestFilterCache::test_key()
+{
+    FilterCache cache;
+    PackageFilter filter(PackageFilter::All, "qt");
+    cache.insert(filter, makeResult(1));
+
+    // Each part of the filter changes the result
+    PackageFilter world(PackageFilter::World, "qt");
+    QVERIFY(cache.find(world) == nullptr);
+    filter.setSearchDescriptions(true);
+    QVERIFY(cache.find(filter) == nullptr);
+    cache.insert(filter, makeResult(2));
+    QCOMPARE(cache.count(), 2);
+    QCOMPARE(cache.find(filter)->at(0).size(), size_t(2));
+    filter.setSearchDescriptions(false);
+    QCOMPARE(cache.find(filter)->at(0).size(), size_t(1));
+}
+
+void TestFilterCache::test_replace()
+{
+    FilterCache cache;
+    const PackageFilter filter(PackageFilter::All, "qt");
+    cache.insert(filter, makeResult(10));
+    const qsizetype bytes = cache.bytes();
+    cache.insert(filter, makeResult(1));
+    QCOMPARE(cache.count(), 1);
+    QVERIFY(cache.bytes() < bytes);
+    QCOMPARE(*cache.find(filter), makeResult(1));
+}
+
+void TestFilterCache::test_budget()
+{
+    // Room for three of these results, but not four
+    FilterCache probe;
+    probe.insert(PackageFilter(), makeResult(100));
+    FilterCache cache(probe.bytes() * 3 + probe.bytes() / 2);
+
+    const PackageFilter a(PackageFilter::All, "a");
+    const PackageFilter b(PackageFilter::All, "b");
+    const PackageFilter c(PackageFilter::All, "c");
+    const PackageFilter d(PackageFilter::All, "d");
+    cache.insert(a, makeResult(100));
+    cache.insert(b, makeResult(100));
+    cache.insert(c, makeResult(100));
+    QCOMPARE(cache.count(), 3);
+
+    // Using a makes b the least recently used, so b is dropped for d
+    QVERIFY(cache.find(a) != nullptr);
+    cache.insert(d, makeResult(100));
+    QCOMPARE(cache.count(), 3);
+    QVERIFY(cache.find(a) != nullptr);
+    QVERIFY(cache.find(b) == nullptr);
+    QVERIFY(cache.find(c) != nullptr);
+    QVERIFY(cache.find(d) != nullptr);
+    QCOMPARE(cache.bytes(), probe.bytes() * 3);
+
+    // Too big to keep at all
+    cache.insert(b, makeResult(1000));
+    QVERIFY(cache.find(b) == nullptr);
+    QCOMPARE(cache.count(), 3);
+}
+
+void TestFilterCache::test_generation()
+{
+    FilterCache cache;
+    const PackageFilter filter(PackageFilter::All, "qt");
+    cache.setGeneration(1);
+    cache.insert(filter, makeResult(1));
+
+    cache.setGeneration(1);
+    QVERIFY(cache.find(filter) != nullptr);
+
+    cache.setGeneration(2);
+    QVERIFY(cache.find(filter) == nullptr);
+    QCOMPARE(cache.count(), 0);
+    QCOMPARE(cache.bytes(), qsizetype(0));
+}
+
+QTEST_APPLESS_MAIN(TestFilterCache)
+
+#include "tst_testfiltercache.moc"
@@ -0,0 +1,239 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QtTest>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "eix.pb.h"
+#include "eixstreamparser.h"
+#include "loadgeneration.h"
+
+// Every heap allocation in this test program is counted, so that loading
+// the eix data on the heap (the old way) can be compared with loading it
+// onto an arena.
+
+static std::atomic<quint64> allocationCount{0};
+
+void *operator new(std::size_t size)
+{
+    ++allocationCount;
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+class TestLoadGeneration : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestLoadGeneration();
+    ~TestLoadGeneration();
+
+  private slots:
+    void initTestCase();
+    void test_construction();
+    void test_parse();
+    void test_deferred();
+    void test_allocations();
+
+  private:
+    /// The results of loading the test data once
+    struct LoadCost {
+        quint64 parseAllocations;
+        qint64 parseTime;
+        qint64 freeTime;
+    };
+
+    LoadCost heapLoad();
+    LoadCost arenaLoad();
+
+    QByteArray testData;
+};
+
+TestLoadGeneration::TestLoadGeneration()
+{
+}
+
+TestLoadGeneration::~TestLoadGeneration()
+{
+}
+
+void TestLoadGeneration::initTestCase()
+{
+    QFile input(TESTDATA);
+    if (!input.open(QIODevice::ReadOnly)) {
+        QFAIL("Failed to open data file: " TESTDATA);
+    }
+    testData = input.readAll();
+}
+
+void TestLoadGeneration::test_construction()
+{
+    LoadGeneration first;
+    QCOMPARE(first.number(), quint64(0));
+    QCOMPARE(first.eix().category_size(), 0);
+
+    LoadGeneration second(first.number() + 1);
+    QCOMPARE(second.number(), quint64(1));
+
+    // The collection lives on the generation's arena
+    QVERIFY(second.eix().GetArena() != nullptr);
+}
+
+void TestLoadGeneration::test_parse()
+{
+    eix_proto::Collection reference;
+    QVERIFY(reference.ParseFromArray(testData.constData(), testData.size()));
+
+    LoadGeneration generation;
+    EixStreamParser parser(&generation.eix());
+    parser.feed(testData);
+    QVERIFY(parser.finish());
+
+    QCOMPARE(generation.eix().SerializeAsString(),
+             reference.SerializeAsString());
+    QVERIFY(generation.spaceUsed() > 0);
+}
+
+void TestLoadGeneration::test_deferred()
+{
+    eix_proto::Collection reference;
+    QVERIFY(reference.ParseFromArray(testData.constData(), testData.size()));
+    QVERIFY(reference.category_size() > 1);
+
+    // Packages are decoded one at a time, without the eix data
+    LoadGeneration generation;
+    QVERIFY(!generation.isDeferred());
+    generation.setStream(testData);
+    QVERIFY(generation.isDeferred());
+    for (int catNumber : {reference.category_size() - 1, 0}) {
+        const auto &cat = reference.category(catNumber);
+        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
+            const eix_proto::Package &pkg =
+                generation.package(catNumber, pkgNumber);
+            QCOMPARE(pkg.SerializeAsString(),
+                     cat.package(pkgNumber).SerializeAsString());
+            QCOMPARE(&generation.package(catNumber, pkgNumber), &pkg);
+        }
+    }
+    QCOMPARE(generation.eix().category_size(), 0);
+
+    // Then all of it, as a load would
+    const eix_proto::Package &first = generation.package(0, 0);
+    QVERIFY(generation.decodeStream(false));
+    QVERIFY(!generation.isDeferred());
+    QCOMPARE(generation.eix().SerializeAsString(),
+             reference.SerializeAsString());
+    QCOMPARE(first.name(), reference.category(0).package(0).name());
+    QCOMPARE(generation.package(0, 0).SerializeAsString(),
+             reference.category(0).package(0).SerializeAsString());
+
+    // Lazily, the details are decoded when the package is asked for
+    LoadGeneration lazy;
+    lazy.setStream(testData);
+    QVERIFY(lazy.decodeStream(true));
+    QCOMPARE(lazy.eix().category_size(), reference.category_size());
+    QCOMPARE(lazy.package(0, 0).SerializeAsString(),
+             reference.category(0).package(0).SerializeAsString());
+}
+
+void TestLoadGeneration::test_allocations()
+{
+    // Warm up, so one-off allocations (e.g. protobuf's own tables) are not
+    // charged to either run.
+    heapLoad();
+    arenaLoad();
+
+    LoadCost before = heapLoad();
+    LoadCost after = arenaLoad();
+
+    qInfo() << "Heap collection: " << before.parseAllocations
+            << "allocations, parse" << before.parseTime << "us, free"
+            << before.freeTime << "us";
+    qInfo() << "Arena collection:" << after.parseAllocations
+            << "allocations, parse" << after.parseTime << "us, free"
+            << after.freeTime << "us";
+
+    QVERIFY(after.parseAllocations < before.parseAllocations);
+}
+
+/// Loads the test data into a heap allocated collection, as it used to be
+TestLoadGeneration::LoadCost TestLoadGeneration::heapLoad()
+{
+    LoadCost cost;
+    QElapsedTimer timer;
+
+    auto *eix = new eix_proto::Collection;
+    EixStreamParser parser(eix);
+
+    quint64 startCount = allocationCount;
+    timer.start();
+    parser.feed(testData);
+    parser.finish();
+    cost.parseTime = timer.nsecsElapsed() / 1000;
+    cost.parseAllocations = allocationCount - startCount;
+
+    timer.restart();
+    delete eix;
+    cost.freeTime = timer.nsecsElapsed() / 1000;
+
+    return cost;
+}
+
+/// Loads the test data onto an arena, as ApplicationData now does
+TestLoadGeneration::LoadCost TestLoadGeneration::arenaLoad()
+{
+    LoadCost cost;
+    QElapsedTimer timer;
+
+    auto *generation = new LoadGeneration;
+    EixStreamParser parser(&generation->eix());
+
+    quint64 startCount = allocationCount;
+    timer.start();
+    parser.feed(testData);
+    parser.finish();
+    cost.parseTime = timer.nsecsElapsed() / 1000;
+    cost.parseAllocations = allocationCount - startCount;
+
+    timer.restart();
+    delete generation;
+    cost.freeTime = timer.nsecsElapsed() / 1000;
+
+    return cost;
+}
+
+QTEST_APPLESS_MAIN(TestLoadGeneration)
+
+#include "tst_testloadgeneration.moc"
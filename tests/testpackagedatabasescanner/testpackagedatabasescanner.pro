@@ -0,0 +1,24 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+TEMPLATE = app
+
+SOURCES +=  tst_testpackagedatabasescanner.cpp \
+    ../../vizzyix/packagedatabasescanner.cpp \
+    ../../vizzyix/versionkey.cpp
+
+INCLUDEPATH += ../../vizzyix
+
+HEADERS += \
+    ../../vizzyix/packagedatabasescanner.h \
+    ../../vizzyix/versionkey.h
+
+DISTFILES += \
+    meson.build
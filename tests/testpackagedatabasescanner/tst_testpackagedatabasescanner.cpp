@@ -0,0 +1,184 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "packagedatabasescanner.h"
+
+class TestPackageDatabaseScanner : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPackageDatabaseScanner();
+    ~TestPackageDatabaseScanner();
+
+  private slots:
+    void initTestCase();
+    void test_scan();
+    void test_scanCategories();
+    void test_serial();
+    void test_missingRoot();
+    void test_splitPackageDir_data();
+    void test_splitPackageDir();
+    void test_largeTree();
+
+  private:
+    void makeDir(const QString &name);
+
+  private:
+    QTemporaryDir dir;
+};
+
+TestPackageDatabaseScanner::TestPackageDatabaseScanner()
+{
+}
+
+TestPackageDatabaseScanner::~TestPackageDatabaseScanner()
+{
+}
+
+void TestPackageDatabaseScanner::makeDir(const QString &name)
+{
+    QVERIFY(QDir(dir.path()).mkpath(name));
+}
+
+void TestPackageDatabaseScanner::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    makeDir("sys-libs/zlib-1.3-r4");
+    makeDir("dev-qt/qtbase-6.7.2");
+    makeDir("dev-qt/qt-creator-14.0.1");
+    makeDir("dev-qt/-MERGING-qt-creator-14.0.2"); // being installed
+    makeDir("dev-qt/.hidden");
+    makeDir("app-misc/screen-4.9.1");
+    makeDir(".cache");
+
+    // Files aren't packages
+    QFile file(dir.filePath("dev-qt/notes.txt"));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+}
+
+void TestPackageDatabaseScanner::test_scan()
+{
+    PackageDatabaseScanner scanner(dir.path());
+    QCOMPARE(scanner.scan(),
+             (QStringList{"app-misc/screen-4.9.1",
+                          "dev-qt/qt-creator-14.0.1",
+                          "dev-qt/qtbase-6.7.2",
+                          "sys-libs/zlib-1.3-r4"}));
+}
+
+void TestPackageDatabaseScanner::test_scanCategories()
+{
+    PackageDatabaseScanner scanner(dir.path());
+    QCOMPARE(scanner.scan({"sys-libs", "dev-qt"}),
+             (QStringList{"sys-libs/zlib-1.3-r4",
+                          "dev-qt/qt-creator-14.0.1",
+                          "dev-qt/qtbase-6.7.2"}));
+
+    // A category that has gone is just empty
+    QCOMPARE(scanner.scan({"no-such"}), QStringList());
+}
+
+void TestPackageDatabaseScanner::test_serial()
+{
+    PackageDatabaseScanner scanner(dir.path());
+    scanner.setThreadCount(1);
+    QCOMPARE(scanner.scan().size(), qsizetype(4));
+}
+
+void TestPackageDatabaseScanner::test_missingRoot()
+{
+    PackageDatabaseScanner scanner(dir.filePath("no-such"));
+    QTest::ignoreMessage(QtWarningMsg,
+                         QRegularExpression("can't read"));
+    QVERIFY(scanner.scan().isEmpty());
+    QVERIFY(scanner.scan({"dev-qt"}).isEmpty());
+}
+
+void TestPackageDatabaseScanner::test_splitPackageDir_data()
+{
+    QTest::addColumn<QString>("dirName");
+    QTest::addColumn<bool>("valid");
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<QString>("version");
+
+    QTest::newRow("simple") << "screen-4.9.1" << true << "screen" << "4.9.1";
+    QTest::newRow("hyphens")
+        << "qt-creator-14.0.1" << true << "qt-creator" << "14.0.1";
+    QTest::newRow("revision")
+        << "zlib-1.3-r4" << true << "zlib" << "1.3-r4";
+    QTest::newRow("digits in name")
+        << "font-adobe-100dpi-1.0.4" << true << "font-adobe-100dpi"
+        << "1.0.4";
+    QTest::newRow("version-like name")
+        << "python-3.12-1.0" << true << "python-3.12" << "1.0";
+    QTest::newRow("letter") << "openssl-1.1.1w" << true << "openssl"
+                            << "1.1.1w";
+    QTest::newRow("suffixes") << "gcc-14.2.0_rc1_p20240801" << true << "gcc"
+                              << "14.2.0_rc1_p20240801";
+    QTest::newRow("pre") << "kde-6.0_pre" << true << "kde" << "6.0_pre";
+    QTest::newRow("live") << "vizzyix-9999" << true << "vizzyix" << "9999";
+    QTest::newRow("no version") << "noversion" << false << "" << "";
+    QTest::newRow("name only")
+        << "font-adobe-100dpi" << false << "" << "";
+    QTest::newRow("no name") << "-1.0" << false << "" << "";
+    QTest::newRow("revision only") << "zlib-r4" << false << "" << "";
+    QTest::newRow("bad suffix") << "zlib-1.3_foo" << false << "" << "";
+    QTest::newRow("two letters") << "zlib-1.3ab" << false << "" << "";
+    QTest::newRow("empty part") << "zlib-1..3" << false << "" << "";
+}
+
+void TestPackageDatabaseScanner::test_splitPackageDir()
+{
+    QFETCH(QString, dirName);
+    QFETCH(bool, valid);
+    QFETCH(QString, name);
+    QFETCH(QString, version);
+
+    const std::string text = dirName.toStdString();
+    std::string_view splitName;
+    std::string_view splitVersion;
+    QCOMPARE(PackageDatabaseScanner::splitPackageDir(
+                 text, splitName, splitVersion),
+             valid);
+    if (valid) {
+        QCOMPARE(std::string(splitName), name.toStdString());
+        QCOMPARE(std::string(splitVersion), version.toStdString());
+    }
+}
+
+void TestPackageDatabaseScanner::test_largeTree()
+{
+    // About the size of a well used desktop system
+    QTemporaryDir large;
+    QVERIFY(large.isValid());
+    QDir root(large.path());
+    for (int catNumber = 0; catNumber < 160; ++catNumber) {
+        for (int pkgNumber = 0; pkgNumber < 10; ++pkgNumber) {
+            QVERIFY(root.mkpath(QString("cat-%1/package%2-1.2.3")
+                                    .arg(catNumber)
+                                    .arg(pkgNumber)));
+        }
+    }
+
+    PackageDatabaseScanner scanner(large.path());
+    const QStringList packages = scanner.scan();
+    const qint64 parallelTime = scanner.lastScanTime();
+    QCOMPARE(packages.size(), qsizetype(1600));
+    QCOMPARE(packages.first(), QString("cat-0/package0-1.2.3"));
+
+    scanner.setThreadCount(1);
+    QCOMPARE(scanner.scan(), packages);
+    qInfo() << packages.size() << "package directories read in"
+            << parallelTime << "us, serially in" << scanner.lastScanTime()
+            << "us";
+}
+
+QTEST_APPLESS_MAIN(TestPackageDatabaseScanner)
+
+#include "tst_testpackagedatabasescanner.moc"
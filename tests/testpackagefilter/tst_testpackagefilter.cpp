@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+
+#include "eix.pb.h"
+#include "packagefilter.h"
+
+Q_DECLARE_METATYPE(PackageFilter::Selection)
+
+class TestPackageFilter : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPackageFilter();
+    ~TestPackageFilter();
+
+  private slots:
+    void initTestCase();
+    void test_default();
+    void test_filter_data();
+    void test_filter();
+    void test_classification();
+    void test_descriptions_data();
+    void test_descriptions();
+
+  private:
+    /// Names of the packages in category that pass the filter
+    QStringList matchingNames(const PackageFilter &filter) const;
+
+  private:
+    eix_proto::Category category;
+};
+
+TestPackageFilter::TestPackageFilter()
+{
+}
+
+TestPackageFilter::~TestPackageFilter()
+{
+}
+
+void TestPackageFilter::initTestCase()
+{
+    category.set_category("dev-qt");
+
+    // Not installed
+    auto *pkg = category.add_package();
+    pkg->set_name("qtcharts");
+    pkg->set_description("Chart component library for the Qt6 framework");
+    pkg->add_version()->set_id("6.7.2");
+
+    // Installed as a dependency
+    pkg = category.add_package();
+    pkg->set_name("qtbase");
+    pkg->add_version()->set_id("6.7.1");
+    auto *ver = pkg->add_version();
+    ver->set_id("6.7.2");
+    ver->mutable_installed()->set_date(1700000000);
+
+    // Installed and in the world file (only the system flags say so)
+    pkg = category.add_package();
+    pkg->set_name("qt-creator");
+    ver = pkg->add_version();
+    ver->set_id("14.0.1");
+    ver->mutable_installed()->set_date(1700000000);
+    ver->mutable_system_mask_flags()->add_mask_flag(
+        eix_proto::MaskFlags_MaskFlag_WORLD);
+
+    // In a world set
+    pkg = category.add_package();
+    pkg->set_name("Qt-Docs");
+    ver = pkg->add_version();
+    ver->set_id("6.7.2");
+    ver->mutable_installed()->set_date(1700000000);
+    ver->mutable_local_mask_flags()->add_mask_flag(
+        eix_proto::MaskFlags_MaskFlag_WORLD_SETS);
+
+    // Part of the system set; eix includes these in --world
+    pkg = category.add_package();
+    pkg->set_name("qtcore");
+    ver = pkg->add_version();
+    ver->set_id("5.15.14");
+    ver->mutable_installed()->set_date(1700000000);
+    ver->mutable_local_mask_flags()->add_mask_flag(
+        eix_proto::MaskFlags_MaskFlag_MASK_SYSTEM);
+}
+
+QStringList TestPackageFilter::matchingNames(const PackageFilter &filter) const
+{
+    QStringList result;
+    for (int pkgNumber : filter.matchingPackages(category)) {
+        result.append(
+            QString::fromStdString(category.package(pkgNumber).name()));
+    }
+    return result;
+}
+
+void TestPackageFilter::test_default()
+{
+    PackageFilter filter;
+    QVERIFY(!filter.isActive());
+    QCOMPARE(filter.matchingPackages(category).size(),
+             size_t(category.package_size()));
+}
+
+void TestPackageFilter::test_filter_data()
+{
+    QTest::addColumn<PackageFilter::Selection>("selection");
+    QTest::addColumn<QString>("search");
+    QTest::addColumn<QStringList>("expected");
+
+    const QStringList all{
+        "qtcharts", "qtbase", "qt-creator", "Qt-Docs", "qtcore"};
+
+    QTest::newRow("all") << PackageFilter::All << "" << all;
+    QTest::newRow("installed")
+        << PackageFilter::Installed << ""
+        << QStringList{"qtbase", "qt-creator", "Qt-Docs", "qtcore"};
+    QTest::newRow("world")
+        << PackageFilter::World << ""
+        << QStringList{"qt-creator", "Qt-Docs", "qtcore"};
+    QTest::newRow("substring")
+        << PackageFilter::All << "re" << QStringList{"qt-creator", "qtcore"};
+    QTest::newRow("ignores case")
+        << PackageFilter::All << "DOC" << QStringList{"Qt-Docs"};
+    QTest::newRow("dash") << PackageFilter::All << "t-"
+                          << QStringList{"qt-creator", "Qt-Docs"};
+    QTest::newRow("start") << PackageFilter::All << "^qtc"
+                           << QStringList{"qtcharts", "qtcore"};
+    QTest::newRow("end") << PackageFilter::All << "e$"
+                         << QStringList{"qtbase", "qtcore"};
+    QTest::newRow("whole name")
+        << PackageFilter::All << "^qtbase$" << QStringList{"qtbase"};
+    QTest::newRow("whole name, prefix only")
+        << PackageFilter::All << "^qtbas$" << QStringList{};
+    QTest::newRow("longer than names")
+        << PackageFilter::All << "qt-creator-extra" << QStringList{};
+    QTest::newRow("installed and search")
+        << PackageFilter::Installed << "charts" << QStringList{};
+    QTest::newRow("world and search")
+        << PackageFilter::World << "^qt-"
+        << QStringList{"qt-creator", "Qt-Docs"};
+}
+
+void TestPackageFilter::test_filter()
+{
+    QFETCH(PackageFilter::Selection, selection);
+    QFETCH(QString, search);
+    QFETCH(QStringList, expected);
+
+    PackageFilter filter(selection, search);
+    QCOMPARE(filter.isActive(),
+             selection != PackageFilter::All || !search.isEmpty());
+    QCOMPARE(filter.search(), search);
+    QCOMPARE(matchingNames(filter), expected);
+
+    // Changing the filter in place gives the same result
+    PackageFilter changed;
+    changed.setSelection(selection);
+    changed.setSearch(search);
+    QCOMPARE(matchingNames(changed), expected);
+}
+
+void TestPackageFilter::test_classification()
+{
+    QVERIFY(!PackageFilter::isInstalled(category.package(0)));
+    QVERIFY(PackageFilter::isInstalled(category.package(1)));
+    QVERIFY(!PackageFilter::isWorld(category.package(1)));
+    QVERIFY(PackageFilter::isWorld(category.package(2)));
+}
+
+void TestPackageFilter::test_descriptions_data()
+{
+    QTest::addColumn<QString>("search");
+    QTest::addColumn<QStringList>("names");
+    QTest::addColumn<QStringList>("descriptions");
+
+    QTest::newRow("name") << "charts" << QStringList{"qtcharts"}
+                          << QStringList{"qtcharts"};
+    QTest::newRow("description")
+        << "LIBRARY" << QStringList{} << QStringList{"qtcharts"};
+    QTest::newRow("category")
+        << "dev" << QStringList{}
+        << QStringList{"qtcharts", "qtbase", "qt-creator", "Qt-Docs", "qtcore"};
+    QTest::newRow("anchored, names only")
+        << "^library" << QStringList{} << QStringList{};
+}
+
+void TestPackageFilter::test_descriptions()
+{
+    QFETCH(QString, search);
+    QFETCH(QStringList, names);
+    QFETCH(QStringList, descriptions);
+
+    PackageFilter filter(PackageFilter::All, search);
+    QVERIFY(!filter.searchDescriptions());
+    QCOMPARE(matchingNames(filter), names);
+
+    filter.setSearchDescriptions(true);
+    QCOMPARE(matchingNames(filter), descriptions);
+}
+
+QTEST_APPLESS_MAIN(TestPackageFilter)
+
+#include "tst_testpackagefilter.moc"
@@ -0,0 +1,162 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+
+#include <QImage>
+#include <QScrollBar>
+#include <QStandardItemModel>
+#include <QTableView>
+
+#include "eix.pb.h"
+#include "packagelistdelegate.h"
+#include "packagereportmodel.h"
+#include <fstream>
+
+class TestPackageListDelegate : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPackageListDelegate();
+    ~TestPackageListDelegate();
+
+  private slots:
+    void initTestCase();
+    void test_paint();
+    void test_otherModel();
+    void benchmark_scroll_data();
+    void benchmark_scroll();
+
+  private:
+    void setUpView(QTableView &view, PackageListDelegate *delegate);
+    static QImage render(QTableView &view);
+
+    eix_proto::Collection eix;
+    QStringList emptyVersionList;
+    PackageStore store;
+    PackageReportModel model;
+};
+
+TestPackageListDelegate::TestPackageListDelegate()
+{
+}
+
+TestPackageListDelegate::~TestPackageListDelegate()
+{
+}
+
+void TestPackageListDelegate::initTestCase()
+{
+    std::fstream input(TESTDATA, std::ios::in | std::ios::binary);
+    if (!eix.ParseFromIstream(&input)) {
+        QFAIL("Failed to parse data file: " TESTDATA);
+    } else {
+        QVector<int> packages;
+        for (const auto &cat : eix.category()) {
+            for (const auto &pkg : cat.package()) {
+                packages.append(
+                    store.addPackage(cat.category(), pkg, emptyVersionList));
+            }
+        }
+        model.updatePackages(&store, packages);
+        while (model.canFetchMore(QModelIndex())) {
+            model.fetchMore(QModelIndex());
+        }
+        QVERIFY(model.rowCount() > 0);
+    }
+}
+
+void TestPackageListDelegate::test_paint()
+{
+    // Something is drawn, and the same again from the laid out text
+    QTableView view;
+    setUpView(view, new PackageListDelegate(&view));
+    const QImage first = render(view);
+    QImage blank(first.size(), first.format());
+    blank.fill(Qt::white);
+    QVERIFY(first != blank);
+    QCOMPARE(render(view), first);
+
+    // With a selected row
+    view.selectRow(0);
+    QVERIFY(render(view) != first);
+}
+
+void TestPackageListDelegate::test_otherModel()
+{
+    // Left to QStyledItemDelegate
+    QStandardItemModel other(1, 1);
+    other.setItem(0, 0, new QStandardItem("dev-qt/qtcore"));
+    QTableView view;
+    view.setModel(&other);
+    view.setItemDelegate(new PackageListDelegate(&view));
+    view.resize(200, 100);
+
+    QTableView plain;
+    plain.setModel(&other);
+    plain.resize(200, 100);
+    QCOMPARE(render(view), render(plain));
+}
+
+void TestPackageListDelegate::benchmark_scroll_data()
+{
+    QTest::addColumn<bool>("lightweight");
+    QTest::newRow("QStyledItemDelegate") << false;
+    QTest::newRow("PackageListDelegate") << true;
+}
+
+/*!
+ * The time for a frame while scrolling through the package list a page at a
+ * time, with the usual delegate (before) and with PackageListDelegate
+ * (after).
+ */
+void TestPackageListDelegate::benchmark_scroll()
+{
+    QFETCH(bool, lightweight);
+
+    QTableView view;
+    setUpView(view, lightweight ? new PackageListDelegate(&view) : nullptr);
+    QScrollBar *scrollBar = view.verticalScrollBar();
+    QVERIFY(scrollBar->maximum() > 0);
+
+    QImage frame(view.viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+    QBENCHMARK {
+        scrollBar->setValue((scrollBar->value() + scrollBar->pageStep()) %
+                            scrollBar->maximum());
+        view.viewport()->render(&frame);
+    }
+}
+
+/// Shows the package list in a view the size of the main window's
+void TestPackageListDelegate::setUpView(QTableView &view,
+                                        PackageListDelegate *delegate)
+{
+    QFont boldFont(view.font());
+    boldFont.setWeight(QFont::Bold);
+    PackageReportItem::setBoldFont(boldFont);
+    if (delegate) {
+        delegate->setFonts(view.font(), boldFont);
+        view.setItemDelegate(delegate);
+    }
+
+    view.setModel(&model);
+    view.setIconSize(QSize(16, 16));
+    view.setShowGrid(false);
+    view.horizontalHeader()->setStretchLastSection(true);
+    view.resize(900, 600);
+    view.show();
+}
+
+/// What a view's rows look like
+QImage TestPackageListDelegate::render(QTableView &view)
+{
+    QImage image(view.viewport()->size(), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::white);
+    view.viewport()->render(&image);
+    return image;
+}
+
+QTEST_MAIN(TestPackageListDelegate)
+
+#include "tst_testpackagelistdelegate.moc"
@@ -0,0 +1,35 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+TEMPLATE = app
+
+SOURCES +=  tst_testpackagemetadatatable.cpp \
+    ../../vizzyix/packagedatabasescanner.cpp \
+    ../../vizzyix/packagemetadatatable.cpp \
+    ../../vizzyix/snapshotimage.cpp \
+    ../../vizzyix/stringpool.cpp \
+    ../../vizzyix/versionkey.cpp
+
+LIBS += -L../../eixpb -leixpb
+
+INCLUDEPATH += $$top_builddir/eixpb ../../vizzyix
+
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += protobuf
+
+HEADERS += \
+    ../../vizzyix/packagedatabasescanner.h \
+    ../../vizzyix/packagemetadatatable.h \
+    ../../vizzyix/snapshotimage.h \
+    ../../vizzyix/stringpool.h \
+    ../../vizzyix/versionkey.h
+
+DISTFILES += \
+    meson.build
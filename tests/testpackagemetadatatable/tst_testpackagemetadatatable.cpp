@@ -0,0 +1,275 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "packagedatabasescanner.h"
+#include "packagemetadatatable.h"
+
+class TestPackageMetadataTable : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPackageMetadataTable();
+    ~TestPackageMetadataTable();
+
+  private slots:
+    void initTestCase();
+    void test_read();
+    void test_missingFiles();
+    void test_cache();
+    void test_removed();
+    void test_fillCollection();
+    void test_largeTree();
+
+  private:
+    void makePackage(QDir root,
+                     const QString &packageDir,
+                     const QString &slot,
+                     const QString &use,
+                     const QString &iuse,
+                     qint64 buildTime);
+    void writeFile(const QString &path, const QByteArray &text);
+    void setModified(const QString &path, qint64 seconds);
+
+  private:
+    QTemporaryDir dir;
+};
+
+TestPackageMetadataTable::TestPackageMetadataTable()
+{
+}
+
+TestPackageMetadataTable::~TestPackageMetadataTable()
+{
+}
+
+void TestPackageMetadataTable::writeFile(const QString &path,
+                                         const QByteArray &text)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write(text);
+}
+
+/// Sets a directory's modification time, which the cache goes by
+void TestPackageMetadataTable::setModified(const QString &path,
+                                           qint64 seconds)
+{
+    const time_t time = static_cast<time_t>(seconds);
+    struct timespec times[2] = {{time, 0}, {time, 0}};
+    QCOMPARE(
+        utimensat(AT_FDCWD, QFile::encodeName(path).constData(), times, 0), 0);
+}
+
+/// Makes a package directory with its metadata files, as portage would
+void TestPackageMetadataTable::makePackage(QDir root,
+                                           const QString &packageDir,
+                                           const QString &slot,
+                                           const QString &use,
+                                           const QString &iuse,
+                                           qint64 buildTime)
+{
+    QVERIFY(root.mkpath(packageDir));
+    const QString path = root.filePath(packageDir) + "/";
+    writeFile(path + "SLOT", slot.toUtf8() + "\n");
+    writeFile(path + "repository", "gentoo\n");
+    writeFile(path + "USE", use.toUtf8() + "\n");
+    writeFile(path + "IUSE", iuse.toUtf8() + "\n");
+    writeFile(path + "DESCRIPTION", packageDir.toUtf8() + " description\n");
+    writeFile(path + "SIZE", "123456\n");
+    writeFile(path + "BUILD_TIME", QByteArray::number(buildTime) + "\n");
+    writeFile(path + "COUNTER", QByteArray::number(buildTime % 1000) + "\n");
+    setModified(path, 1700000000);
+}
+
+void TestPackageMetadataTable::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    QDir root(dir.path());
+    makePackage(root,
+                "sys-libs/zlib-1.3-r4",
+                "0/1",
+                "abi_x86_64 amd64 elibc_glibc",
+                "minizip static-libs",
+                1700000100);
+    makePackage(root,
+                "dev-qt/qtbase-6.7.2",
+                "6/6.7.2",
+                "X dbus gui",
+                "+X +dbus gui -test",
+                1700000200);
+    makePackage(
+        root, "dev-qt/qtbase-6.8.0", "6/6.8.0", "dbus", "+X +dbus", 1700000300);
+}
+
+void TestPackageMetadataTable::test_read()
+{
+    PackageMetadataTable table(dir.path());
+    table.update(PackageDatabaseScanner(dir.path()).scan());
+    QCOMPARE(table.rowCount(), 3);
+    QCOMPARE(table.lastReadCount(), 3);
+
+    const int row = table.find("dev-qt/qtbase-6.7.2");
+    QVERIFY(row >= 0);
+    QCOMPARE(table.packageDir(row), QString("dev-qt/qtbase-6.7.2"));
+    QCOMPARE(std::string(table.text(row, PackageMetadataTable::Slot)),
+             std::string("6/6.7.2"));
+    QCOMPARE(std::string(table.text(row, PackageMetadataTable::Repository)),
+             std::string("gentoo"));
+    QCOMPARE(std::string(table.text(row, PackageMetadataTable::Use)),
+             std::string("X dbus gui"));
+    QCOMPARE(std::string(table.text(row, PackageMetadataTable::Iuse)),
+             std::string("+X +dbus gui -test"));
+    QCOMPARE(table.installedSize(row), qint64(123456));
+    QCOMPARE(table.buildTime(row), qint64(1700000200));
+    QCOMPARE(table.counter(row), qint64(200));
+
+    QCOMPARE(table.find("dev-qt/qtbase-1.0"), -1);
+}
+
+void TestPackageMetadataTable::test_missingFiles()
+{
+    // e.g. a virtual package has no USE flags
+    QTemporaryDir other;
+    QVERIFY(other.isValid());
+    QVERIFY(QDir(other.path()).mkpath("virtual/libc-1-r1"));
+
+    PackageMetadataTable table(other.path());
+    table.update({"virtual/libc-1-r1"});
+    QCOMPARE(table.rowCount(), 1);
+    QVERIFY(table.text(0, PackageMetadataTable::Use).empty());
+    QCOMPARE(table.buildTime(0), qint64(0));
+}
+
+void TestPackageMetadataTable::test_cache()
+{
+    PackageMetadataTable table(dir.path());
+    table.setThreadCount(1);
+    const QStringList packages = PackageDatabaseScanner(dir.path()).scan();
+    table.update(packages);
+    QCOMPARE(table.lastReadCount(), 3);
+
+    // Nothing has changed, so nothing is read
+    table.update(packages);
+    QCOMPARE(table.lastReadCount(), 0);
+    QCOMPARE(table.buildTime(table.find("sys-libs/zlib-1.3-r4")),
+             qint64(1700000100));
+
+    // A reinstall replaces the directory, so it has a new time
+    const QString zlib = dir.filePath("sys-libs/zlib-1.3-r4");
+    writeFile(zlib + "/BUILD_TIME", "1700000999\n");
+    setModified(zlib, 1700000999);
+    table.update(packages);
+    QCOMPARE(table.lastReadCount(), 1);
+    QCOMPARE(table.buildTime(table.find("sys-libs/zlib-1.3-r4")),
+             qint64(1700000999));
+    QCOMPARE(std::string(table.text(table.find("dev-qt/qtbase-6.8.0"),
+                                    PackageMetadataTable::Slot)),
+             std::string("6/6.8.0"));
+
+    table.clear();
+    QCOMPARE(table.rowCount(), 0);
+    table.update(packages);
+    QCOMPARE(table.lastReadCount(), 3);
+
+    // Put it back for the other tests
+    writeFile(zlib + "/BUILD_TIME", "1700000100\n");
+    setModified(zlib, 1700000000);
+}
+
+void TestPackageMetadataTable::test_removed()
+{
+    PackageMetadataTable table(dir.path());
+    table.update(PackageDatabaseScanner(dir.path()).scan());
+    table.update({"dev-qt/qtbase-6.8.0", "sys-libs/zlib-1.3-r4"});
+    QCOMPARE(table.rowCount(), 2);
+    QCOMPARE(table.lastReadCount(), 0);
+    QCOMPARE(table.find("dev-qt/qtbase-6.7.2"), -1);
+    QCOMPARE(table.find("sys-libs/zlib-1.3-r4"), 1);
+}
+
+void TestPackageMetadataTable::test_fillCollection()
+{
+    PackageMetadataTable table(dir.path());
+    table.update(PackageDatabaseScanner(dir.path()).scan());
+
+    eix_proto::Collection eix;
+    table.fillCollection(eix);
+    QCOMPARE(eix.category_size(), 2);
+    QCOMPARE(eix.category(0).category(), std::string("dev-qt"));
+    QCOMPARE(eix.category(1).category(), std::string("sys-libs"));
+
+    const auto &qtbase = eix.category(0).package(0);
+    QCOMPARE(qtbase.name(), std::string("qtbase"));
+    QCOMPARE(qtbase.description(),
+             std::string("dev-qt/qtbase-6.8.0 description"));
+    QCOMPARE(qtbase.version_size(), 2);
+    QCOMPARE(qtbase.version(1).id(), std::string("6.8.0"));
+
+    const auto &ver = qtbase.version(0);
+    QCOMPARE(ver.id(), std::string("6.7.2"));
+    QCOMPARE(ver.slot(), std::string("6/6.7.2"));
+    QCOMPARE(ver.repository().repository(), std::string("gentoo"));
+    QVERIFY(ver.has_installed());
+    QCOMPARE(ver.installed().date(), qint64(1700000200));
+    QCOMPARE(ver.iuse_plus_size(), 2);
+    QCOMPARE(ver.iuse_size(), 1);
+    QCOMPARE(ver.iuse_minus(0), std::string("test"));
+    QCOMPARE(ver.installed().use_enabled_size(), 3);
+    QCOMPARE(ver.installed().use_disabled(0), std::string("test"));
+
+    const auto &zlib = eix.category(1).package(0);
+    QCOMPARE(zlib.name(), std::string("zlib"));
+    QCOMPARE(zlib.version(0).id(), std::string("1.3-r4"));
+    QCOMPARE(zlib.version(0).installed().use_enabled_size(), 0);
+}
+
+void TestPackageMetadataTable::test_largeTree()
+{
+    // About the size of a well used desktop system
+    QTemporaryDir large;
+    QVERIFY(large.isValid());
+    QDir root(large.path());
+    for (int catNumber = 0; catNumber < 40; ++catNumber) {
+        for (int pkgNumber = 0; pkgNumber < 25; ++pkgNumber) {
+            makePackage(root,
+                        QString("cat-%1/package%2-1.2.3")
+                            .arg(catNumber)
+                            .arg(pkgNumber),
+                        "0",
+                        "X",
+                        "X wayland",
+                        1700000000 + pkgNumber);
+        }
+    }
+
+    const QStringList packages = PackageDatabaseScanner(large.path()).scan();
+    PackageMetadataTable table(large.path());
+    table.update(packages);
+    const qint64 parallelTime = table.lastUpdateTime();
+    QCOMPARE(table.rowCount(), 1000);
+    QCOMPARE(table.lastReadCount(), 1000);
+
+    table.update(packages);
+    const qint64 cachedTime = table.lastUpdateTime();
+    QCOMPARE(table.lastReadCount(), 0);
+
+    table.clear();
+    table.setThreadCount(1);
+    table.update(packages);
+    QCOMPARE(table.lastReadCount(), 1000);
+    qInfo() << packages.size() << "package directories read in"
+            << parallelTime << "us, serially in" << table.lastUpdateTime()
+            << "us, unchanged in" << cachedTime << "us";
+}
+
+QTEST_APPLESS_MAIN(TestPackageMetadataTable)
+
+#include "tst_testpackagemetadatatable.moc"
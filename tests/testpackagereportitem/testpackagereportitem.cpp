@@ -1,6 +1,7 @@
 // SPDX-FileCopyrightText: 2020 Bill Binder <dxtwjb@gmail.com>
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include <QIcon>
 #include <QtTest>
 #include <fstream>
 #include <iostream>
@@ -9,6 +10,7 @@
 #include "combinedpackagelist.h"
 #include "eix.pb.h"
 #include "packagereportitem.h"
+#include "versionkey.h"
 
 class TestReportModelItem : public QObject
 {
@@ -33,13 +35,15 @@ class TestReportModelItem : public QObject
     // TODO: void test_assignment();
     void test_vector_of();
     void test_cached_values();
+    void test_zombie_versions();
+    void test_sort_role();
 
   private:
     int findCat(std::string catName);
     int findPkg(int catNumber, std::string pkgName);
 
     eix_proto::Collection eix;
-    VersionMap emptyVersionMap;
+    QStringList emptyVersionList;
     int cat_dev_qt;
     int pkg_dev_qt_ww_qt_creator;
     int pkg_dev_qt_ww_qtcore;
@@ -116,7 +120,7 @@ void TestReportModelItem::test_name()
 {
     const eix_proto::Category &cat = eix.category(cat_dev_qt);
     const eix_proto::Package &pkg = cat.package(pkg_dev_qt_ww_qt_creator);
-    PackageReportItem something(cat.category(), pkg, emptyVersionMap);
+    PackageReportItem something(cat.category(), pkg, emptyVersionList);
 
     QCOMPARE(something.category(), "dev-qt");
     QCOMPARE(something.name(), "qt-creator");
@@ -126,7 +130,7 @@ void TestReportModelItem::test_description()
 {
     const eix_proto::Category &cat = eix.category(cat_dev_qt);
     const eix_proto::Package &pkg = cat.package(pkg_dev_qt_ww_qt_creator);
-    PackageReportItem something(cat.category(), pkg, emptyVersionMap);
+    PackageReportItem something(cat.category(), pkg, emptyVersionList);
 
     QCOMPARE(something.description(),
              cat.package(pkg_dev_qt_ww_qt_creator).description());
@@ -136,7 +140,7 @@ void TestReportModelItem::test_data_member()
 {
     const eix_proto::Category &cat = eix.category(cat_dev_qt);
     const eix_proto::Package &pkg = cat.package(pkg_dev_qt_ww_qt_creator);
-    PackageReportItem something(cat.category(), pkg, emptyVersionMap);
+    PackageReportItem something(cat.category(), pkg, emptyVersionList);
 
     QVariant installed = something.data(PackageReportItem::Column::Installed,
                                         Qt::DecorationRole);
@@ -146,6 +150,13 @@ void TestReportModelItem::test_data_member()
     // Could convert the reference image and this one to QImage and compare
     // size, format, and every pixel. Maybe someday ...
 
+    // The icon is made once and shared by every row that shows it
+    PackageReportItem other(cat.category(), pkg, emptyVersionList);
+    QVariant otherInstalled = other.data(PackageReportItem::Column::Installed,
+                                         Qt::DecorationRole);
+    QCOMPARE(otherInstalled.value<QIcon>().cacheKey(),
+             installed.value<QIcon>().cacheKey());
+
     QCOMPARE(something.data(PackageReportItem::Column::Name, Qt::DisplayRole)
                  .toString()
                  .toStdString(),
@@ -174,7 +185,7 @@ void TestReportModelItem::test_data_member_with_999()
     const eix_proto::Category &cat = eix.category(cat_app_accessibility);
     const eix_proto::Package &pkg =
         cat.package(pkg_app_accessibility_ww_emacspeak);
-    PackageReportItem something(cat.category(), pkg, emptyVersionMap);
+    PackageReportItem something(cat.category(), pkg, emptyVersionList);
 
     QVariant installed = something.data(PackageReportItem::Column::Installed,
                                         Qt::DecorationRole);
@@ -207,7 +218,7 @@ void TestReportModelItem::test_data_member_only_999()
 {
     const eix_proto::Category &cat = eix.category(cat_app_accessibility);
     const eix_proto::Package &pkg = cat.package(pkg_app_accessibility_ww_simon);
-    PackageReportItem something(cat.category(), pkg, emptyVersionMap);
+    PackageReportItem something(cat.category(), pkg, emptyVersionList);
 
     QVariant installed = something.data(PackageReportItem::Column::Installed,
                                         Qt::DecorationRole);
@@ -240,7 +251,7 @@ void TestReportModelItem::test_copy_constructor()
 {
     const eix_proto::Category &cat = eix.category(cat_dev_qt);
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
-    PackageReportItem first(cat.category(), pkg1, emptyVersionMap);
+    PackageReportItem first(cat.category(), pkg1, emptyVersionList);
 
     PackageReportItem second(first);
     QCOMPARE(second.name(), first.name());
@@ -257,10 +268,10 @@ void TestReportModelItem::test_vector_of()
 {
     const eix_proto::Category &cat = eix.category(cat_dev_qt);
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
-    PackageReportItem first(cat.category(), pkg1, emptyVersionMap);
+    PackageReportItem first(cat.category(), pkg1, emptyVersionList);
 
     const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
-    PackageReportItem second(cat.category(), pkg2, emptyVersionMap);
+    PackageReportItem second(cat.category(), pkg2, emptyVersionList);
 
     QVector<PackageReportItem> vector;
     vector.append(first);
@@ -279,29 +290,67 @@ void TestReportModelItem::test_cached_values()
 
     PackageReportItem qtcreator(cat1.category(),
                                 cat1.package(pkg_dev_qt_ww_qt_creator),
-                                emptyVersionMap);
+                                emptyVersionList);
     QVERIFY(qtcreator.installed());
     QVERIFY(qtcreator.installType());
 
     PackageReportItem qtcore(cat1.category(),
                              cat1.package(pkg_dev_qt_ww_qtcore),
-                             emptyVersionMap);
+                             emptyVersionList);
     QVERIFY(qtcore.installed());
     QVERIFY(!qtcore.installType());
 
     PackageReportItem qtdiag(cat1.category(),
                              cat1.package(pkg_dev_qt_ww_qtdiag),
-                             emptyVersionMap);
+                             emptyVersionList);
     QVERIFY(!qtdiag.installed());
     QVERIFY(!qtdiag.installType());
 
     PackageReportItem wjbtools(cat2.category(),
                                cat2.package(pkg_sys_apps_ww_wjbtools),
-                               emptyVersionMap);
+                               emptyVersionList);
     QVERIFY(wjbtools.installed());
     QVERIFY(wjbtools.installType());
 }
 
+void TestReportModelItem::test_zombie_versions()
+{
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    const eix_proto::Package &pkg = cat.package(pkg_dev_qt_ww_qt_creator);
+
+    PackageReportItem plain(cat.category(), pkg, emptyVersionList);
+    PackageReportItem zombie(cat.category(), pkg, QStringList{"1.0.0"});
+    QCOMPARE(zombie.versionNames(),
+             plain.versionNames() + QStringList{"1.0.0**"});
+    QVERIFY(!zombie.sameDisplay(plain));
+    QVERIFY(zombie.sameDisplay(PackageReportItem(
+        cat.category(), pkg, QStringList{"1.0.0"})));
+}
+
+void TestReportModelItem::test_sort_role()
+{
+    const eix_proto::Category &cat = eix.category(cat_app_accessibility);
+    PackageReportItem emacspeak(cat.category(),
+                                cat.package(pkg_app_accessibility_ww_emacspeak),
+                                emptyVersionList);
+
+    // The version columns sort by version key, the others by their text
+    QCOMPARE(emacspeak
+                 .data(PackageReportItem::Column::AvailableVersion,
+                       PackageReportItem::SortRole)
+                 .toByteArray(),
+             QByteArray::fromStdString(VersionKey::key("39.0-r2")));
+    QVERIFY(emacspeak
+                .data(PackageReportItem::Column::InstalledVersion,
+                      PackageReportItem::SortRole)
+                .toByteArray()
+                .isEmpty());
+    QCOMPARE(
+        emacspeak.data(PackageReportItem::Column::Name,
+                       PackageReportItem::SortRole),
+        emacspeak.data(PackageReportItem::Column::Name, Qt::DisplayRole));
+}
+
 int TestReportModelItem::findCat(std::string catName)
 {
     for (int catNumber = 0; catNumber < eix.category_size(); ++catNumber) {
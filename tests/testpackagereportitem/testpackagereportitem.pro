@@ -16,6 +16,10 @@ SOURCES +=  \
     ../../vizzyix/packagereportitem.cpp \
     ../../vizzyix/combinedpackageinfo.cpp \
     ../../vizzyix/combinedpackagelist.cpp \
+    ../../vizzyix/packagedatabasescanner.cpp \
+    ../../vizzyix/snapshotimage.cpp \
+    ../../vizzyix/stringpool.cpp \
+    ../../vizzyix/versionkey.cpp \
     testpackagereportitem.cpp
 
 LIBS += -L../../eixpb -leixpb
@@ -29,7 +33,11 @@ HEADERS += \
     ../../vizzyix/eixprotohelper.h \
     ../../vizzyix/packagereportitem.h \
     ../../vizzyix/combinedpackageinfo.h \
-    ../../vizzyix/combinedpackagelist.h
+    ../../vizzyix/combinedpackagelist.h \
+    ../../vizzyix/packagedatabasescanner.h \
+    ../../vizzyix/snapshotimage.h \
+    ../../vizzyix/stringpool.h \
+    ../../vizzyix/versionkey.h
 
 DISTFILES += \
     meson.build
@@ -16,7 +16,12 @@ SOURCES +=  tst_testpackagereportmodel.cpp \
     ../../vizzyix/packagereportitem.cpp \
     ../../vizzyix/combinedpackageinfo.cpp \
     ../../vizzyix/combinedpackagelist.cpp \
-    ../../vizzyix/packagereportmodel.cpp
+    ../../vizzyix/packagedatabasescanner.cpp \
+    ../../vizzyix/snapshotimage.cpp \
+    ../../vizzyix/stringpool.cpp \
+    ../../vizzyix/packagereportmodel.cpp \
+    ../../vizzyix/packagestore.cpp \
+    ../../vizzyix/versionkey.cpp
 
 LIBS += -L../../eixpb -leixpb
 
@@ -29,8 +34,13 @@ HEADERS += \
     ../../vizzyix/eixprotohelper.h \
     ../../vizzyix/packagereportitem.h \
     ../../vizzyix/packagereportmodel.h \
+    ../../vizzyix/packagestore.h \
     ../../vizzyix/combinedpackageinfo.h \
-    ../../vizzyix/combinedpackagelist.h
+    ../../vizzyix/combinedpackagelist.h \
+    ../../vizzyix/packagedatabasescanner.h \
+    ../../vizzyix/snapshotimage.h \
+    ../../vizzyix/stringpool.h \
+    ../../vizzyix/versionkey.h
 
 DISTFILES += \
     meson.build
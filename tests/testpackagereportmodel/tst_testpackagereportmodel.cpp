@@ -3,6 +3,8 @@
 
 #include <QtTest>
 
+#include <QIcon>
+
 #include "eix.pb.h"
 #include "packagereportmodel.h"
 #include <fstream>
@@ -24,13 +26,21 @@ class testpackagereportmodel : public QObject
     void test_data_fetch_data_role_a();
     void test_data_fetch_data_role_b();
     void test_packageItem();
+    void test_updatePackages();
+    void test_sort();
+    void test_fetchMore();
+    void benchmark_data_data();
+    void benchmark_data();
 
   private:
+    static QVariant uncachedData(const PackageReportItem &item,
+                                 int colNumber,
+                                 int role);
     int findCat(std::string catName);
     int findPkg(int catNumber, std::string pkgName);
 
     eix_proto::Collection eix;
-    VersionMap emptyVersionList;
+    QStringList emptyVersionList;
     int cat_dev_qt;
     int pkg_dev_qt_ww_qt_creator;
     int pkg_dev_qt_ww_qtcore;
@@ -101,10 +111,14 @@ void testpackagereportmodel::test_addPackage()
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
     const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
 
-    something.addPackage(cat.category(), pkg1, emptyVersionList);
+    PackageStore store;
+    QVector<int> packages{
+        store.addPackage(cat.category(), pkg1, emptyVersionList)};
+    something.updatePackages(&store, packages);
     QCOMPARE(something.rowCount(), 1);
 
-    something.addPackage(cat.category(), pkg2, emptyVersionList);
+    packages = {0, store.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&store, packages);
     QCOMPARE(something.rowCount(), 2);
 }
 
@@ -116,8 +130,11 @@ void testpackagereportmodel::test_clear()
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
     const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
 
-    something.addPackage(cat.category(), pkg1, emptyVersionList);
-    something.addPackage(cat.category(), pkg2, emptyVersionList);
+    PackageStore store;
+    QVector<int> packages{
+        store.addPackage(cat.category(), pkg1, emptyVersionList),
+        store.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&store, packages);
     QCOMPARE(something.rowCount(), 2);
 
     something.clear();
@@ -132,8 +149,11 @@ void testpackagereportmodel::test_data_fetch_data_role_a()
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
     const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
 
-    something.addPackage(cat.category(), pkg1, emptyVersionList);
-    something.addPackage(cat.category(), pkg2, emptyVersionList);
+    PackageStore store;
+    QVector<int> packages{
+        store.addPackage(cat.category(), pkg1, emptyVersionList),
+        store.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&store, packages);
 
     // qtcreator has two versions, the installed is ~testing, the other is 9999
 
@@ -168,8 +188,11 @@ void testpackagereportmodel::test_data_fetch_data_role_b()
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
     const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
 
-    something.addPackage(cat.category(), pkg1, emptyVersionList);
-    something.addPackage(cat.category(), pkg2, emptyVersionList);
+    PackageStore store;
+    QVector<int> packages{
+        store.addPackage(cat.category(), pkg1, emptyVersionList),
+        store.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&store, packages);
 
     // qtcore has one versions, it's installed
 
@@ -204,16 +227,317 @@ void testpackagereportmodel::test_packageItem()
     const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
     const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
 
-    something.addPackage(cat.category(), pkg1, emptyVersionList);
-    something.addPackage(cat.category(), pkg2, emptyVersionList);
+    PackageStore store;
+    QVector<int> packages{
+        store.addPackage(cat.category(), pkg1, emptyVersionList),
+        store.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&store, packages);
 
     // Just a simple check on contents - the PackageReportItem values are copied
     // into the model's vector so would need to create an == operator to make
     // this work.
-    QCOMPARE(something.packageItem(0).name(), "qt-creator");
+    QCOMPARE(something.packageItem(0).name(), std::string("qt-creator"));
     QCOMPARE(something.packageItem(1).name(), "qtcore");
 }
 
+void testpackagereportmodel::test_updatePackages()
+{
+    PackageReportModel something;
+
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
+    const eix_proto::Package &pkg2 = cat.package(pkg_dev_qt_ww_qtcore);
+
+    // The same package from a later load, with a new description
+    eix_proto::Package pkg2Changed(pkg2);
+    pkg2Changed.set_description("Changed");
+
+    // Each load of the data has its own store
+    PackageStore first;
+    QVector<int> packages{
+        first.addPackage(cat.category(), pkg1, emptyVersionList),
+        first.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&first, packages);
+    QCOMPARE(something.rowCount(), 2);
+    QVERIFY(packages.isEmpty());
+
+    QSignalSpy reset(&something, &PackageReportModel::modelReset);
+    QSignalSpy inserted(&something, &PackageReportModel::rowsInserted);
+    QSignalSpy removed(&something, &PackageReportModel::rowsRemoved);
+    QSignalSpy changed(&something, &PackageReportModel::dataChanged);
+
+    // Nothing has changed, so there is nothing to redraw
+    PackageStore second;
+    packages = {second.addPackage(cat.category(), pkg1, emptyVersionList),
+                second.addPackage(cat.category(), pkg2, emptyVersionList)};
+    something.updatePackages(&second, packages);
+    QCOMPARE(inserted.count() + removed.count() + changed.count(), 0);
+    QCOMPARE(something.store(), &second);
+
+    // One package gone, one changed
+    PackageStore third;
+    packages = {
+        third.addPackage(cat.category(), pkg2Changed, emptyVersionList)};
+    something.updatePackages(&third, packages);
+    QCOMPARE(something.rowCount(), 1);
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed[0][1].toInt(), 0);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed[0][0].value<QModelIndex>().row(), 0);
+    QCOMPARE(something.data(
+                 something.index(0, PackageReportItem::Column::Description),
+                 Qt::DisplayRole),
+             QVariant("Changed"));
+
+    // And back again
+    PackageStore fourth;
+    packages = {
+        fourth.addPackage(cat.category(), pkg1, emptyVersionList),
+        fourth.addPackage(cat.category(), pkg2Changed, emptyVersionList)};
+    something.updatePackages(&fourth, packages);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(inserted[0][1].toInt(), 0);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(something.packageItem(0).name(), std::string("qt-creator"));
+    QCOMPARE(something.packageIndex(1), 1);
+    QCOMPARE(reset.count(), 0);
+}
+
+void testpackagereportmodel::test_sort()
+{
+    PackageReportModel something;
+
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore store;
+    store.addCategory(cat, combined);
+    store.sortPackages();
+
+    QVector<int> packages;
+    for (int index = store.size() - 1; index >= 0; --index) {
+        packages.append(index);
+    }
+    something.updatePackages(&store, packages);
+    QCOMPARE(something.packageIndex(0), store.size() - 1);
+
+    auto names = [&]() {
+        QStringList result;
+        for (int row = 0; row < something.rowCount(); ++row) {
+            result.append(
+                something
+                    .data(something.index(row, PackageReportItem::Column::Name),
+                          Qt::DisplayRole)
+                    .toString());
+        }
+        return result;
+    };
+
+    QSignalSpy layout(&something, &PackageReportModel::layoutChanged);
+    something.sort(PackageReportItem::Column::Name);
+    QCOMPARE(layout.count(), 1);
+    QStringList sorted = names();
+    for (int row = 1; row < sorted.size(); ++row) {
+        QVERIFY(sorted[row - 1].compare(sorted[row], Qt::CaseInsensitive) <=
+                0);
+    }
+
+    // Updates keep the order, whatever order the packages are given in
+    packages = {store.index(0, pkg_dev_qt_ww_qtcore),
+                store.index(0, pkg_dev_qt_ww_qt_creator)};
+    something.updatePackages(&store, packages);
+    QCOMPARE(names(), QStringList({"qt-creator", "qtcore"}));
+
+    something.sort(PackageReportItem::Column::Name, Qt::DescendingOrder);
+    QCOMPARE(names(), QStringList({"qtcore", "qt-creator"}));
+}
+
+void testpackagereportmodel::test_fetchMore()
+{
+    PackageReportModel something;
+
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    const eix_proto::Package &pkg1 = cat.package(pkg_dev_qt_ww_qt_creator);
+
+    // Plenty of rows, more than the views are given at once
+    PackageStore store;
+    QVector<int> packages;
+    for (int n = 0; n < 1000; ++n) {
+        packages.append(
+            store.addPackage(cat.category(), pkg1, emptyVersionList));
+    }
+    something.updatePackages(&store, packages);
+    const int firstBatch = something.rowCount();
+    QVERIFY(firstBatch > 0 && firstBatch < 1000);
+    QVERIFY(something.canFetchMore(QModelIndex()));
+    QVERIFY(!something.canFetchMore(something.index(0, 0)));
+    QCOMPARE(something.samplePackages(10).size(), 10);
+    QCOMPARE(something.samplePackages(10).last(), 900);
+
+    // Only the rows that have been fetched are signalled, and the views are
+    // given more to make up the first batch again
+    QSignalSpy inserted(&something, &PackageReportModel::rowsInserted);
+    QSignalSpy removed(&something, &PackageReportModel::rowsRemoved);
+    for (int n = 0; n < 1000; n += 2) {
+        packages.append(n);
+    }
+    something.updatePackages(&store, packages);
+    QCOMPARE(removed.count(), firstBatch / 2);
+    QCOMPARE(inserted.count(), 1);
+    QCOMPARE(something.rowCount(), firstBatch);
+    QCOMPARE(something.packageIndex(1), 2);
+
+    inserted.clear();
+    while (something.canFetchMore(QModelIndex())) {
+        something.fetchMore(QModelIndex());
+    }
+    QCOMPARE(something.rowCount(), 500);
+    QCOMPARE(inserted.count(), (500 - 1) / firstBatch);
+    QCOMPARE(inserted[0][1].toInt(), firstBatch);
+    QCOMPARE(something.packageIndex(499), 998);
+
+    QSignalSpy reset(&something, &PackageReportModel::modelReset);
+    packages = {0, 2, 4, 6};
+    something.updatePackages(&store, packages);
+    QCOMPARE(something.rowCount(), 4);
+    QCOMPARE(reset.count(), 0);
+
+    // Mostly new, so the views get the first batch of them, with a reset
+    for (int n = 0; n < 1000; ++n) {
+        packages.append(n);
+    }
+    something.updatePackages(&store, packages);
+    QCOMPARE(reset.count(), 1);
+    QCOMPARE(something.rowCount(), firstBatch);
+    QCOMPARE(something.packageIndex(firstBatch - 1), firstBatch - 1);
+}
+
+void testpackagereportmodel::benchmark_data_data()
+{
+    QTest::addColumn<bool>("cached");
+    QTest::newRow("Worked out per call") << false;
+    QTest::newRow("PackageStore") << true;
+}
+
+/*!
+ * What a view asks for on a repaint: every cell's text, icon, font and sort
+ * key. This is with the values worked out on each call, as data() used to
+ * (before), and from the package store (after).
+ */
+void testpackagereportmodel::benchmark_data()
+{
+    QFETCH(bool, cached);
+
+    PackageReportModel something;
+    PackageStore store;
+    QVector<int> packages;
+    for (const auto &cat : eix.category()) {
+        for (const auto &pkg : cat.package()) {
+            packages.append(
+                store.addPackage(cat.category(), pkg, emptyVersionList));
+        }
+    }
+    something.updatePackages(&store, packages);
+    while (something.canFetchMore(QModelIndex())) {
+        something.fetchMore(QModelIndex());
+    }
+    QVERIFY(something.rowCount() > 0);
+
+    QVector<PackageReportItem> items;
+    for (int row = 0; row < something.rowCount(); ++row) {
+        items.append(store.item(something.packageIndex(row)));
+    }
+
+    const int roles[] = {Qt::DisplayRole,
+                         Qt::DecorationRole,
+                         Qt::FontRole,
+                         PackageReportItem::SortRole};
+    QBENCHMARK {
+        for (int row = 0; row < something.rowCount(); ++row) {
+            for (int column = 0; column < something.columnCount(); ++column) {
+                const QModelIndex index = something.index(row, column);
+                for (int role : roles) {
+                    if (cached) {
+                        something.data(index, role);
+                    } else {
+                        uncachedData(items[row], column, role);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * PackageReportItem::data() as it was before its values were cached: the
+ * icon, the strings and the joined versions are made again on every call.
+ * The sort keys and the highest version's label are taken as they are.
+ */
+QVariant testpackagereportmodel::uncachedData(const PackageReportItem &item,
+                                              int colNumber,
+                                              int role)
+{
+    typedef PackageReportItem::Column Column;
+
+    if (role == PackageReportItem::SortRole) {
+        switch (colNumber) {
+        case Column::InstalledVersion:
+        case Column::AvailableVersion:
+            return item.data(colNumber, role);
+        default:
+            return uncachedData(
+                item, colNumber, PackageReportItem::dataRole(colNumber));
+        }
+    }
+
+    if (role == Qt::FontRole && item.installed()) {
+        return PackageReportItem::boldFont();
+    }
+
+    if (PackageReportItem::dataRole(colNumber) != role)
+        return QVariant();
+
+    switch (colNumber) {
+    case Column::Installed:
+        if (item.installed()) {
+            switch (item.installType()) {
+            case eix_proto::MaskFlags_MaskFlag_WORLD:
+                return QVariant(
+                    QIcon(":/pkgtable/images/installed-world-marker.png"));
+            case eix_proto::MaskFlags_MaskFlag_WORLD_SETS:
+                return QVariant(
+                    QIcon(":/pkgtable/images/installed-world-set-marker.png"));
+            case eix_proto::MaskFlags_MaskFlag_MASK_SYSTEM:
+                return QVariant(
+                    QIcon(":/pkgtable/images/installed-system-marker.png"));
+            default:
+                return QVariant(
+                    QIcon(":/pkgtable/images/installed-marker.png"));
+            }
+        } else if (item.installType() !=
+                   eix_proto::MaskFlags_MaskFlag_UNKNOWN) {
+            return QVariant(QIcon(":/pkgtable/images/world-only-marker.png"));
+        }
+        return QVariant();
+
+    case Column::Name:
+        return QVariant::fromValue(
+            QString::fromStdString(item.packageDetails().name()));
+
+    case Column::InstalledVersion:
+        return QVariant::fromValue(item.versionNames().join(", "));
+
+    case Column::AvailableVersion:
+        return QVariant::fromValue(item.highestVersionName());
+
+    case Column::Description:
+        return QVariant::fromValue(
+            QString::fromStdString(item.packageDetails().description()));
+
+    default:
+        return QVariant();
+    }
+}
+
 int testpackagereportmodel::findCat(std::string catName)
 {
     int catNumber;
@@ -240,6 +564,6 @@ int testpackagereportmodel::findPkg(int catNumber, std::string pkgName)
     return -1;
 }
 
-QTEST_APPLESS_MAIN(testpackagereportmodel)
+QTEST_MAIN(testpackagereportmodel)
 
 #include "tst_testpackagereportmodel.moc"
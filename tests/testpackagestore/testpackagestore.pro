@@ -0,0 +1,44 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+TEMPLATE = app
+
+DEFINES += TESTDATA=\\\"$$top_srcdir/pbtesting/eix.pb\\\"
+
+SOURCES +=  tst_testpackagestore.cpp \
+    ../../vizzyix/eixprotohelper.cpp \
+    ../../vizzyix/packagereportitem.cpp \
+    ../../vizzyix/packagestore.cpp \
+    ../../vizzyix/combinedpackageinfo.cpp \
+    ../../vizzyix/combinedpackagelist.cpp \
+    ../../vizzyix/packagedatabasescanner.cpp \
+    ../../vizzyix/snapshotimage.cpp \
+    ../../vizzyix/stringpool.cpp \
+    ../../vizzyix/versionkey.cpp
+
+LIBS += -L../../eixpb -leixpb
+
+INCLUDEPATH += $$top_builddir/eixpb ../../vizzyix
+
+unix: CONFIG += link_pkgconfig
+unix: PKGCONFIG += protobuf
+
+HEADERS += \
+    ../../vizzyix/eixprotohelper.h \
+    ../../vizzyix/packagereportitem.h \
+    ../../vizzyix/packagestore.h \
+    ../../vizzyix/combinedpackageinfo.h \
+    ../../vizzyix/combinedpackagelist.h \
+    ../../vizzyix/packagedatabasescanner.h \
+    ../../vizzyix/snapshotimage.h \
+    ../../vizzyix/stringpool.h \
+    ../../vizzyix/versionkey.h
+
+DISTFILES += \
+    meson.build
@@ -0,0 +1,350 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+
+#include "combinedpackagelist.h"
+#include "eix.pb.h"
+#include "packagestore.h"
+#include "snapshotimage.h"
+#include <fstream>
+
+class TestPackageStore : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPackageStore();
+    ~TestPackageStore();
+
+  private slots:
+    void initTestCase();
+    void test_construction();
+    void test_sameAsItem();
+    void test_zombies();
+    void test_addCategory();
+    void test_addCategories();
+    void test_sameDisplay();
+    void test_clear();
+    void test_sort();
+    void test_saveRestore();
+
+  private:
+    int findCat(std::string catName);
+    int findPkg(int catNumber, std::string pkgName);
+
+    eix_proto::Collection eix;
+    QStringList emptyVersionList;
+    int cat_dev_qt;
+    int pkg_dev_qt_ww_qtcore;
+};
+
+TestPackageStore::TestPackageStore()
+{
+}
+
+TestPackageStore::~TestPackageStore()
+{
+}
+
+void TestPackageStore::initTestCase()
+{
+    std::fstream input(TESTDATA, std::ios::in | std::ios::binary);
+    if (!eix.ParseFromIstream(&input)) {
+        QFAIL("Failed to parse data file: " TESTDATA);
+    } else {
+        cat_dev_qt = findCat("dev-qt");
+        QVERIFY(cat_dev_qt >= 0);
+        pkg_dev_qt_ww_qtcore = findPkg(cat_dev_qt, "qtcore");
+        QVERIFY(pkg_dev_qt_ww_qtcore >= 0);
+    }
+}
+
+void TestPackageStore::test_construction()
+{
+    PackageStore store;
+    QCOMPARE(store.size(), 0);
+    QCOMPARE(store.categoryCount(), 0);
+}
+
+void TestPackageStore::test_sameAsItem()
+{
+    // Every package in the category shows the same as a PackageReportItem
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    PackageStore store;
+    for (const auto &pkg : cat.package()) {
+        const int index =
+            store.addPackage(cat.category(), pkg, emptyVersionList);
+        const PackageReportItem item(cat.category(), pkg, emptyVersionList);
+
+        QCOMPARE(std::string(store.name(index)), pkg.name());
+        QCOMPARE(std::string(store.category(index)), cat.category());
+        QCOMPARE(&store.packageDetails(index), &pkg);
+        QCOMPARE(store.installed(index), item.installed());
+        QCOMPARE(store.versionNames(index), item.versionNames());
+
+        for (int column = 0; column < PackageReportItem::columnCount();
+             ++column) {
+            for (int role : {int(Qt::DisplayRole),
+                             int(Qt::DecorationRole),
+                             int(Qt::FontRole),
+                             int(PackageReportItem::SortRole)}) {
+                const QVariant expected = item.data(column, role);
+                const QVariant actual = store.data(index, column, role);
+                if (role == Qt::DecorationRole) {
+                    QCOMPARE(actual.value<QIcon>().cacheKey(),
+                             expected.value<QIcon>().cacheKey());
+                } else {
+                    QCOMPARE(actual, expected);
+                }
+            }
+        }
+    }
+    QCOMPARE(store.size(), cat.package_size());
+}
+
+void TestPackageStore::test_zombies()
+{
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    const eix_proto::Package &pkg = cat.package(pkg_dev_qt_ww_qtcore);
+    const QStringList zombies{"5.0.1", "5.0.2"};
+
+    PackageStore store;
+    const int index = store.addPackage(cat.category(), pkg, zombies);
+    const PackageReportItem item(cat.category(), pkg, zombies);
+
+    QCOMPARE(store.zombieVersions(index), zombies);
+    QCOMPARE(store.versionNames(index), item.versionNames());
+    QVERIFY(store.versionNames(index).last().endsWith("**"));
+    QCOMPARE(store.item(index).versionNames(), item.versionNames());
+}
+
+void TestPackageStore::test_addCategory()
+{
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore store;
+    for (const auto &cat : eix.category()) {
+        store.addCategory(cat, combined);
+    }
+    QCOMPARE(store.categoryCount(), eix.category_size());
+
+    const int index = store.index(cat_dev_qt, pkg_dev_qt_ww_qtcore);
+    QCOMPARE(std::string(store.category(index)), std::string("dev-qt"));
+    QCOMPARE(std::string(store.name(index)), std::string("qtcore"));
+    QCOMPARE(store.index(eix.category_size(), 0), store.size());
+}
+
+void TestPackageStore::test_addCategories()
+{
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore serial;
+    for (const auto &cat : eix.category()) {
+        serial.addCategory(cat, combined);
+    }
+
+    // In parallel, and then serially, after the first category
+    for (int threads : {QThread::idealThreadCount(), 1}) {
+        PackageStore store;
+        store.setThreadCount(threads);
+        store.addCategory(eix.category(0), combined);
+        store.addCategories(eix, combined);
+        QCOMPARE(store.categoryCount(), eix.category_size());
+        QCOMPARE(store.size(), serial.size());
+        for (int index = 0; index < store.size(); ++index) {
+            QVERIFY(store.sameDisplay(index, serial, index));
+            QCOMPARE(&store.packageDetails(index),
+                     &serial.packageDetails(index));
+        }
+        QCOMPARE(store.index(cat_dev_qt, pkg_dev_qt_ww_qtcore),
+                 serial.index(cat_dev_qt, pkg_dev_qt_ww_qtcore));
+
+        // Nothing more to add
+        store.addCategories(eix, combined);
+        QCOMPARE(store.size(), serial.size());
+    }
+}
+
+void TestPackageStore::test_sameDisplay()
+{
+    const eix_proto::Category &cat = eix.category(cat_dev_qt);
+    const eix_proto::Package &pkg = cat.package(pkg_dev_qt_ww_qtcore);
+
+    PackageStore first;
+    PackageStore second;
+    first.addPackage(cat.category(), cat.package(0), emptyVersionList);
+    const int before = first.addPackage(cat.category(), pkg, emptyVersionList);
+    const int after = second.addPackage(cat.category(), pkg, emptyVersionList);
+    const int zombie = second.addPackage(cat.category(), pkg, {"5.0.1"});
+
+    QVERIFY(first.sameDisplay(before, second, after));
+    QVERIFY(!first.sameDisplay(before, second, zombie));
+    if (pkg.name() != cat.package(0).name()) {
+        QVERIFY(!first.sameDisplay(0, second, after));
+    }
+}
+
+void TestPackageStore::test_clear()
+{
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore store;
+    store.addCategory(eix.category(cat_dev_qt), combined);
+    QVERIFY(store.size() > 0);
+
+    store.clear();
+    QCOMPARE(store.size(), 0);
+    QCOMPARE(store.categoryCount(), 0);
+
+    // It can be filled again
+    store.addCategory(eix.category(cat_dev_qt), combined);
+    QCOMPARE(store.size(), eix.category(cat_dev_qt).package_size());
+}
+
+void TestPackageStore::test_sort()
+{
+    typedef PackageReportItem::Column Column;
+
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore store;
+    for (const auto &cat : eix.category()) {
+        store.addCategory(cat, combined);
+    }
+    store.sortPackages();
+
+    QVector<int> all;
+    for (int index = 0; index < store.size(); ++index) {
+        all.append(index);
+    }
+
+    // Every package, in order by name (ignoring case), then category
+    QVector<int> packages(all);
+    store.sort(packages, Column::Name, Qt::AscendingOrder);
+    QCOMPARE(packages.size(), store.size());
+    for (int row = 1; row < packages.size(); ++row) {
+        const QString before =
+            store.data(packages[row - 1], Column::Name, Qt::DisplayRole)
+                .toString();
+        const QString after =
+            store.data(packages[row], Column::Name, Qt::DisplayRole)
+                .toString();
+        const int compared = before.compare(after, Qt::CaseInsensitive);
+        QVERIFY(compared <= 0);
+        if (compared == 0 && before == after) {
+            QVERIFY(packages[row - 1] < packages[row]);
+        }
+    }
+
+    // The versions by their keys, newest first
+    auto versionKey = [&](int index) {
+        return store
+            .data(index, Column::AvailableVersion, PackageReportItem::SortRole)
+            .toByteArray();
+    };
+    packages = all;
+    store.sort(packages, Column::AvailableVersion, Qt::DescendingOrder);
+    for (int row = 1; row < packages.size(); ++row) {
+        QVERIFY(versionKey(packages[row - 1]) >= versionKey(packages[row]));
+    }
+
+    // Just some of them, with a repeat
+    const int qtcore = store.index(cat_dev_qt, pkg_dev_qt_ww_qtcore);
+    const int first = store.index(0, 0);
+    packages = {qtcore, first, qtcore};
+    store.sort(packages, Column::Name, Qt::AscendingOrder);
+    if (store.data(first, Column::Name, Qt::DisplayRole)
+            .toString()
+            .compare("qtcore", Qt::CaseInsensitive) < 0) {
+        QCOMPARE(packages, QVector<int>({first, qtcore, qtcore}));
+    } else {
+        QCOMPARE(packages, QVector<int>({qtcore, qtcore, first}));
+    }
+
+    // Left alone for a column that isn't there
+    packages = {qtcore, first};
+    store.sort(packages, -1, Qt::AscendingOrder);
+    QCOMPARE(packages, QVector<int>({qtcore, first}));
+}
+
+void TestPackageStore::test_saveRestore()
+{
+    typedef PackageReportItem::Column Column;
+
+    CombinedPackageList combined("/var/db/pkg");
+    PackageStore store;
+    store.addCategories(eix, combined);
+    store.sortPackages();
+    SnapshotImage saved;
+    store.save(saved);
+
+    // The same columns and order, with the eix data from the source
+    PackageStore restored;
+    SnapshotImage image(saved.bytes().constData(), saved.bytes().size());
+    QVERIFY(restored.restore(image));
+    QVERIFY(image.atEnd());
+    restored.setDetailsSource(
+        [this](int catNumber, int pkgNumber) -> const eix_proto::Package & {
+            return eix.category(catNumber).package(pkgNumber);
+        });
+
+    QCOMPARE(restored.size(), store.size());
+    QCOMPARE(restored.categoryCount(), store.categoryCount());
+    for (int catNumber = 0; catNumber < store.categoryCount(); ++catNumber) {
+        QCOMPARE(std::string(restored.categoryName(catNumber)),
+                 std::string(store.categoryName(catNumber)));
+        QCOMPARE(restored.categorySize(catNumber),
+                 store.categorySize(catNumber));
+    }
+    for (int index = 0; index < store.size(); ++index) {
+        QVERIFY(restored.sameDisplay(index, store, index));
+        QCOMPARE(restored.world(index), store.world(index));
+        QCOMPARE(restored.marker(index), store.marker(index));
+        QCOMPARE(restored.zombieVersions(index), store.zombieVersions(index));
+        QCOMPARE(&restored.packageDetails(index),
+                 &store.packageDetails(index));
+        for (int column = 0; column < PackageReportItem::columnCount();
+             ++column) {
+            QCOMPARE(restored.text(index, column), store.text(index, column));
+        }
+    }
+
+    QVector<int> expected;
+    for (int index = 0; index < store.size(); ++index) {
+        expected.append(index);
+    }
+    QVector<int> packages(expected);
+    store.sort(expected, Column::Name, Qt::AscendingOrder);
+    restored.sort(packages, Column::Name, Qt::AscendingOrder);
+    QCOMPARE(packages, expected);
+
+    // Cut short, e.g. a snapshot that wasn't all written
+    SnapshotImage cut(saved.bytes().constData(), saved.bytes().size() - 1);
+    QVERIFY(!restored.restore(cut));
+    QCOMPARE(restored.size(), 0);
+    QCOMPARE(restored.categoryCount(), 0);
+}
+
+int TestPackageStore::findCat(std::string catName)
+{
+    for (int catNumber = 0; catNumber < eix.category_size(); ++catNumber) {
+        if (catName == eix.category(catNumber).category()) {
+            return catNumber;
+        }
+    }
+    return -1;
+}
+
+int TestPackageStore::findPkg(int catNumber, std::string pkgName)
+{
+    if (catNumber >= 0 && catNumber < eix.category_size()) {
+        const eix_proto::Category &cat = eix.category(catNumber);
+        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
+            if (pkgName == cat.package(pkgNumber).name()) {
+                return pkgNumber;
+            }
+        }
+    }
+    return -1;
+}
+
+QTEST_APPLESS_MAIN(TestPackageStore)
+
+#include "tst_testpackagestore.moc"
@@ -0,0 +1,549 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cstdint>
+
+#include "eix.pb.h"
+#include "portageeixreader.h"
+
+namespace
+{
+/// Writes a number the way eix does (see PortageEixReader)
+void writeNumber(QByteArray &out, uint64_t value)
+{
+    QByteArray bytes;
+    do {
+        bytes.prepend(char(value & 0xFF));
+        value >>= 8;
+    } while (value != 0);
+
+    const bool firstIsMarker = uchar(bytes[0]) == 0xFF;
+    out.append(firstIsMarker ? bytes.size() : bytes.size() - 1, char(0xFF));
+    if (firstIsMarker) {
+        out.append(char(0));
+        bytes.remove(0, 1);
+    }
+    out.append(bytes);
+}
+
+void writeString(QByteArray &out, const QByteArray &text)
+{
+    writeNumber(out, text.size());
+    out.append(text);
+}
+
+void writeTable(QByteArray &out, const QList<QByteArray> &table)
+{
+    writeNumber(out, table.size());
+    for (const auto &text : table) {
+        writeString(out, text);
+    }
+}
+
+void writeWords(QByteArray &out, const QList<int> &words)
+{
+    writeNumber(out, words.size());
+    for (int word : words) {
+        writeNumber(out, word);
+    }
+}
+
+/// The string tables of the test database
+const QList<QByteArray> eapis = {"7", "8"};
+const QList<QByteArray> licenses = {"GPL-2", "LGPL-3", "MIT"};
+const QList<QByteArray> keywords = {"amd64", "~amd64", "~arm64", "x86"};
+const QList<QByteArray> slots = {"0", "6/6.7"};
+const QList<QByteArray> depends = {"dev-qt/qtbase:6", "qt?", "(", ")"};
+
+/// Writes a version with all of the optional fields
+void writeVersion(QByteArray &out,
+                  const QByteArray &id,
+                  int slot,
+                  int repository,
+                  uint64_t maskBits = 0,
+                  uint64_t keyBits = 0)
+{
+    writeNumber(out, maskBits);
+    writeNumber(out, keyBits);
+    writeNumber(out, 2); // LIVE
+    writeNumber(out, 32 | 64); // FETCH MIRROR
+    writeNumber(out, 1);
+    writeWords(out, {0, 2});
+    writeString(out, id);
+    writeNumber(out, slot);
+    writeNumber(out, repository);
+    writeWords(out, {0, 1, 2});
+    writeWords(out, {300});
+    writeWords(out, {1, 2, 0, 3});
+    writeWords(out, {0});
+    writeWords(out, {});
+    writeWords(out, {});
+    writeString(out, "https://example.org/" + id + ".tar.gz");
+}
+
+void writePackage(QByteArray &out,
+                  const QByteArray &name,
+                  const QByteArray &description,
+                  const QList<QByteArray> &versions)
+{
+    QByteArray pkg;
+    writeString(pkg, name);
+    writeString(pkg, description);
+    writeString(pkg, "https://example.org/" + name);
+    writeWords(pkg, {0, 2});
+    writeNumber(pkg, versions.size());
+    for (const auto &version : versions) {
+        pkg.append(version);
+    }
+
+    writeNumber(out, pkg.size());
+    out.append(pkg);
+}
+
+/// The IUSE table: three flags, and enough others to need two byte numbers
+QList<QByteArray> iuseTable()
+{
+    QList<QByteArray> table = {"+qt", "-doc", "test"};
+    while (table.size() < 300) {
+        table.append("flag" + QByteArray::number(table.size()));
+    }
+    table.append("qt");
+    return table;
+}
+
+/// Writes the header, up to the first category
+void writeHeader(QByteArray &out, uint64_t version, uint64_t categoryCount)
+{
+    out.append("eix\n");
+    writeNumber(out, version);
+    writeNumber(out, categoryCount);
+    writeNumber(out, 2);
+    writeString(out, "/var/db/repos/gentoo");
+    writeString(out, "gentoo");
+    writeString(out, "/var/db/repos/guru");
+    writeString(out, "guru");
+    writeTable(out, eapis);
+    writeTable(out, licenses);
+    writeTable(out, keywords);
+    writeTable(out, slots);
+    writeTable(out, iuseTable());
+    writeNumber(out, 7);
+    writeTable(out, depends);
+    writeTable(out, {});
+}
+
+/*!
+ * A small database: app-misc/hello with one version, and dev-qt/qtbase
+ * with two, the first masked by the profile and stable and the second in
+ * the guru repository. The description of hello is 255 bytes long, which
+ * is written as 0xFF 0x00.
+ */
+QByteArray testDatabase(uint64_t version = PortageEixReader::formatVersion)
+{
+    QByteArray out;
+    writeHeader(out, version, 2);
+
+    QByteArray hello;
+    writeVersion(hello, "2.12.1", 0, 0);
+    writeString(out, "app-misc");
+    writeNumber(out, 1);
+    writePackage(out, "hello", QByteArray(255, 'h'), {hello});
+
+    QByteArray qtbase67;
+    QByteArray qtbase68;
+    writeVersion(qtbase67, "6.7.2", 1, 0, 4, 1 | 2); // MASK_PROFILE
+    writeVersion(qtbase68, "6.8.0", 1, 1);
+    writeString(out, "dev-qt");
+    writeNumber(out, 1);
+    writePackage(
+        out, "qtbase", "Cross-platform framework", {qtbase67, qtbase68});
+    return out;
+}
+} // namespace
+
+class TestPortageEixReader : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPortageEixReader();
+    ~TestPortageEixReader();
+
+  private slots:
+    void initTestCase();
+    void init();
+    void test_numbers_data();
+    void test_numbers();
+    void test_read();
+    void test_installed();
+    void test_world();
+    void test_formatVersion();
+    void test_notEix();
+    void test_truncated();
+    void test_packageLength();
+    void test_trailingData();
+    void test_localSettings();
+    void benchmark_read();
+
+  private:
+    void writeFile(const QString &path, const QByteArray &contents);
+    PortageEixReader reader() const;
+
+  private:
+    QTemporaryDir dir;
+    QString eixFile;
+    QString configDir;
+    QString worldFile;
+    QString packageDatabaseRoot;
+};
+
+TestPortageEixReader::TestPortageEixReader()
+{
+}
+
+TestPortageEixReader::~TestPortageEixReader()
+{
+}
+
+void TestPortageEixReader::writeFile(const QString &path,
+                                     const QByteArray &contents)
+{
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(contents);
+}
+
+PortageEixReader TestPortageEixReader::reader() const
+{
+    return PortageEixReader(eixFile, configDir, worldFile, packageDatabaseRoot);
+}
+
+void TestPortageEixReader::initTestCase()
+{
+    QVERIFY(dir.isValid());
+    const QDir root(dir.path());
+    eixFile = root.filePath("portage.eix");
+    configDir = root.filePath("etc/portage");
+    worldFile = root.filePath("var/lib/portage/world");
+    packageDatabaseRoot = root.filePath("var/db/pkg");
+    QVERIFY(root.mkpath("etc/portage"));
+    QVERIFY(root.mkpath("var/lib/portage"));
+    QVERIFY(root.mkpath("var/db/pkg/dev-qt/qtbase-6.7.2"));
+}
+
+/// Each test starts with the test database and no settings or world file
+void TestPortageEixReader::init()
+{
+    writeFile(eixFile, testDatabase());
+    QDir(configDir).removeRecursively();
+    QVERIFY(QDir().mkpath(configDir));
+    QFile::remove(worldFile);
+}
+
+void TestPortageEixReader::test_numbers_data()
+{
+    QTest::addColumn<quint64>("value");
+    QTest::addColumn<QByteArray>("bytes");
+
+    QTest::newRow("0") << quint64(0) << QByteArray("\x00", 1);
+    QTest::newRow("0xFE") << quint64(0xFE) << QByteArray("\xFE");
+    QTest::newRow("0xFF") << quint64(0xFF) << QByteArray("\xFF\x00", 2);
+    QTest::newRow("0x100") << quint64(0x100) << QByteArray("\xFF\x01\x00", 3);
+    QTest::newRow("0xFF00") << quint64(0xFF00)
+                            << QByteArray("\xFF\xFF\x00\x00", 4);
+    QTest::newRow("0x123456") << quint64(0x123456)
+                              << QByteArray("\xFF\xFF\x12\x34\x56");
+}
+
+/*!
+ * Numbers are written as eix writes them, and read back: here, as the
+ * length of the name of the only category.
+ */
+void TestPortageEixReader::test_numbers()
+{
+    QFETCH(quint64, value);
+    QFETCH(QByteArray, bytes);
+
+    QByteArray out;
+    writeNumber(out, value);
+    QCOMPARE(out, bytes);
+
+    QByteArray database;
+    writeHeader(database, PortageEixReader::formatVersion, 1);
+    writeString(database, QByteArray(qsizetype(value), 'c'));
+    writeNumber(database, 0);
+    writeFile(eixFile, database);
+
+    eix_proto::Collection eix;
+    QVERIFY(reader().read(eix, {}));
+    QCOMPARE(quint64(eix.category(0).category().size()), value);
+}
+
+void TestPortageEixReader::test_read()
+{
+    eix_proto::Collection eix;
+    PortageEixReader eixReader = reader();
+    QVERIFY2(eixReader.read(eix, {}), qPrintable(eixReader.error()));
+    QVERIFY(eixReader.error().isEmpty());
+
+    QCOMPARE(eix.category_size(), 2);
+    QCOMPARE(eix.category(0).category(), "app-misc");
+    QCOMPARE(eix.category(1).category(), "dev-qt");
+
+    const auto &hello = eix.category(0).package(0);
+    QCOMPARE(hello.name(), "hello");
+    QCOMPARE(hello.description(), std::string(255, 'h'));
+    QCOMPARE(hello.homepage(), "https://example.org/hello");
+    QCOMPARE(hello.licenses(), "GPL-2 MIT");
+    QCOMPARE(hello.version_size(), 1);
+
+    const auto &qtbase = eix.category(1).package(0);
+    QCOMPARE(qtbase.name(), "qtbase");
+    QCOMPARE(qtbase.version_size(), 2);
+
+    const auto &ver = qtbase.version(0);
+    QCOMPARE(ver.id(), "6.7.2");
+    QCOMPARE(ver.eapi(), "8");
+    QCOMPARE(ver.slot(), "6/6.7");
+    QCOMPARE(ver.repository().repository(), "gentoo");
+    QCOMPARE(ver.keywords(), "amd64 ~arm64");
+    QCOMPARE(ver.iuse_plus_size(), 1);
+    QCOMPARE(ver.iuse_plus(0), "qt");
+    QCOMPARE(ver.iuse_minus_size(), 1);
+    QCOMPARE(ver.iuse_minus(0), "doc");
+    QCOMPARE(ver.iuse_size(), 1);
+    QCOMPARE(ver.iuse(0), "test");
+    QCOMPARE(ver.required_use(), "qt");
+    QCOMPARE(ver.depend(), "qt? ( dev-qt/qtbase:6 )");
+    QCOMPARE(ver.rdepend(), "dev-qt/qtbase:6");
+    QCOMPARE(ver.pdepend(), "");
+    QCOMPARE(ver.src_uri(), "https://example.org/6.7.2.tar.gz");
+    QVERIFY(!ver.has_installed());
+    QVERIFY(!ver.has_local_mask_flags());
+    QVERIFY(!ver.has_local_key_flags());
+
+    QCOMPARE(ver.system_mask_flags().mask_flag_size(), 1);
+    QCOMPARE(ver.system_mask_flags().mask_flag(0),
+             eix_proto::MaskFlags_MaskFlag_MASK_PROFILE);
+    QCOMPARE(ver.system_key_flags().key_flag_size(), 2);
+    QCOMPARE(ver.system_key_flags().key_flag(0),
+             eix_proto::KeyFlags_KeyFlag_STABLE);
+    QCOMPARE(ver.system_key_flags().key_flag(1),
+             eix_proto::KeyFlags_KeyFlag_ARCHSTABLE);
+    QCOMPARE(ver.properties().property_size(), 1);
+    QCOMPARE(ver.properties().property(0),
+             eix_proto::Properties_Property_LIVE);
+    QCOMPARE(ver.restrictions().restrict_size(), 2);
+    QCOMPARE(ver.restrictions().restrict(0),
+             eix_proto::Restrictions_Restrict_FETCH);
+    QCOMPARE(ver.restrictions().restrict(1),
+             eix_proto::Restrictions_Restrict_MIRROR);
+
+    const auto &guru = qtbase.version(1);
+    QCOMPARE(guru.id(), "6.8.0");
+    QCOMPARE(guru.repository().repository(), "guru");
+    QVERIFY(!guru.has_system_mask_flags());
+    QVERIFY(!guru.has_system_key_flags());
+}
+
+/// The versions in the package database are installed, dated by their
+/// directories
+void TestPortageEixReader::test_installed()
+{
+    const QDateTime modified =
+        QFileInfo(QDir(packageDatabaseRoot).filePath("dev-qt/qtbase-6.7.2"))
+            .lastModified();
+
+    eix_proto::Collection eix;
+    QVERIFY(reader().read(eix, {"dev-qt/qtbase-6.7.2"}));
+
+    const auto &qtbase = eix.category(1).package(0);
+    QVERIFY(qtbase.version(0).has_installed());
+    QCOMPARE(qint64(qtbase.version(0).installed().date()),
+             modified.toSecsSinceEpoch());
+    QVERIFY(!qtbase.version(1).has_installed());
+    QVERIFY(!eix.category(0).package(0).version(0).has_installed());
+}
+
+/// Only the installed versions in the world file's slots are marked
+void TestPortageEixReader::test_world()
+{
+    writeFile(worldFile, "# comment\napp-misc/hello\ndev-qt/qtbase:6\n");
+
+    const QStringList installed = {"app-misc/hello-2.12.1",
+                                   "dev-qt/qtbase-6.7.2"};
+    eix_proto::Collection eix;
+    QVERIFY(reader().read(eix, installed));
+
+    const auto &hello = eix.category(0).package(0).version(0);
+    QCOMPARE(hello.system_mask_flags().mask_flag_size(), 1);
+    QCOMPARE(hello.system_mask_flags().mask_flag(0),
+             eix_proto::MaskFlags_MaskFlag_WORLD);
+
+    const auto &qtbase = eix.category(1).package(0);
+    QCOMPARE(qtbase.version(0).system_mask_flags().mask_flag_size(), 2);
+    QCOMPARE(qtbase.version(0).system_mask_flags().mask_flag(1),
+             eix_proto::MaskFlags_MaskFlag_WORLD);
+    QVERIFY(!qtbase.version(1).has_system_mask_flags());
+
+    // Another slot isn't in the world set
+    writeFile(worldFile, "dev-qt/qtbase:5\n");
+    eix.Clear();
+    QVERIFY(reader().read(eix, {"dev-qt/qtbase-6.7.2"}));
+    QCOMPARE(eix.category(1)
+                 .package(0)
+                 .version(0)
+                 .system_mask_flags()
+                 .mask_flag_size(),
+             1);
+}
+
+/// A database written by another eix version is left to eix
+void TestPortageEixReader::test_formatVersion()
+{
+    writeFile(eixFile, testDatabase(PortageEixReader::formatVersion - 1));
+
+    eix_proto::Collection eix;
+    PortageEixReader eixReader = reader();
+    QVERIFY(!eixReader.read(eix, {}));
+    QVERIFY(eixReader.error().contains("format"));
+    QCOMPARE(eix.category_size(), 0);
+}
+
+void TestPortageEixReader::test_notEix()
+{
+    eix_proto::Collection eix;
+
+    writeFile(eixFile, "");
+    QVERIFY(!reader().read(eix, {}));
+
+    writeFile(eixFile, "not an eix database");
+    QVERIFY(!reader().read(eix, {}));
+
+    QFile::remove(eixFile);
+    QVERIFY(!reader().read(eix, {}));
+    QCOMPARE(eix.category_size(), 0);
+}
+
+/// However much of the database is missing, nothing is read
+void TestPortageEixReader::test_truncated()
+{
+    const QByteArray database = testDatabase();
+    for (qsizetype size = 0; size < database.size(); ++size) {
+        writeFile(eixFile, database.first(size));
+
+        eix_proto::Collection eix;
+        PortageEixReader eixReader = reader();
+        QVERIFY2(!eixReader.read(eix, {}), qPrintable(QString::number(size)));
+        QVERIFY(!eixReader.error().isEmpty());
+        QCOMPARE(eix.category_size(), 0);
+    }
+}
+
+/// A package with more to it than eix writes is a format mismatch
+void TestPortageEixReader::test_packageLength()
+{
+    QByteArray database;
+    writeHeader(database, PortageEixReader::formatVersion, 1);
+    writeString(database, "app-misc");
+    writeNumber(database, 1);
+
+    QByteArray pkg;
+    writePackage(pkg, "hello", "Hello", {});
+    pkg[0] = char(pkg[0] + 1);
+    pkg.append(char(0));
+    database.append(pkg);
+    writeFile(eixFile, database);
+
+    eix_proto::Collection eix;
+    PortageEixReader eixReader = reader();
+    QVERIFY(!eixReader.read(eix, {}));
+    QVERIFY(eixReader.error().contains("package length"));
+    QCOMPARE(eix.category_size(), 0);
+}
+
+void TestPortageEixReader::test_trailingData()
+{
+    writeFile(eixFile, testDatabase() + "x");
+
+    eix_proto::Collection eix;
+    QVERIFY(!reader().read(eix, {}));
+    QCOMPARE(eix.category_size(), 0);
+}
+
+void TestPortageEixReader::test_localSettings()
+{
+    const QDir config(configDir);
+    QVERIFY(!reader().hasLocalSettings());
+
+    // Settings that don't change the flags don't matter
+    writeFile(config.filePath("make.conf"),
+              "USE=\"qt\"\n# ACCEPT_KEYWORDS=x\n");
+    writeFile(config.filePath("package.use"), "app-misc/hello doc\n");
+    QVERIFY(config.mkpath("package.accept_keywords"));
+    QVERIFY(!reader().hasLocalSettings());
+
+    writeFile(config.filePath("package.accept_keywords/qt"),
+              "dev-qt/qtbase ~amd64\n");
+    QVERIFY(reader().hasLocalSettings());
+    QVERIFY(QFile::remove(config.filePath("package.accept_keywords/qt")));
+
+    writeFile(config.filePath("package.mask"), "dev-qt/qtbase\n");
+    QVERIFY(reader().hasLocalSettings());
+    QVERIFY(QFile::remove(config.filePath("package.mask")));
+
+    writeFile(config.filePath("make.conf"), "ACCEPT_KEYWORDS=\"~amd64\"\n");
+    QVERIFY(reader().hasLocalSettings());
+    QVERIFY(QFile::remove(config.filePath("make.conf")));
+
+    writeFile(QFileInfo(worldFile).dir().filePath("world_sets"), "@kde\n");
+    QVERIFY(reader().hasLocalSettings());
+    QVERIFY(QFile::remove(QFileInfo(worldFile).dir().filePath("world_sets")));
+    QVERIFY(!reader().hasLocalSettings());
+}
+
+/// A database about the size of the gentoo repository's
+void TestPortageEixReader::benchmark_read()
+{
+    constexpr int categoryCount = 170;
+    constexpr int packageCount = 120;
+
+    QByteArray database;
+    writeHeader(database, PortageEixReader::formatVersion, categoryCount);
+    QByteArray versions[3];
+    for (int verNumber = 0; verNumber < 3; ++verNumber) {
+        writeVersion(versions[verNumber],
+                     "1." + QByteArray::number(verNumber),
+                     0,
+                     0,
+                     0,
+                     1 | 2);
+    }
+    for (int catNumber = 0; catNumber < categoryCount; ++catNumber) {
+        writeString(database, "cat-" + QByteArray::number(catNumber));
+        writeNumber(database, packageCount);
+        for (int pkgNumber = 0; pkgNumber < packageCount; ++pkgNumber) {
+            writePackage(database,
+                         "pkg" + QByteArray::number(pkgNumber),
+                         "A package for the benchmark",
+                         {versions[0], versions[1], versions[2]});
+        }
+    }
+    writeFile(eixFile, database);
+
+    QBENCHMARK {
+        eix_proto::Collection eix;
+        QVERIFY(reader().read(eix, {}));
+        QCOMPARE(eix.category_size(), categoryCount);
+    }
+}
+
+QTEST_APPLESS_MAIN(TestPortageEixReader)
+
+#include "tst_testportageeixreader.moc"
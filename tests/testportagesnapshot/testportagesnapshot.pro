@@ -0,0 +1,22 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+TEMPLATE = app
+
+SOURCES +=  tst_testportagesnapshot.cpp \
+    ../../vizzyix/portagesnapshot.cpp
+
+INCLUDEPATH += ../../vizzyix
+
+HEADERS += \
+    ../../vizzyix/portagesnapshot.h
+
+DISTFILES += \
+    meson.build
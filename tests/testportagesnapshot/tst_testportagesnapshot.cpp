@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <QtTest>
+
+#include "portagesnapshot.h"
+
+class TestPortageSnapshot : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPortageSnapshot();
+    ~TestPortageSnapshot();
+
+  private slots:
+    void init();
+    void test_empty();
+    void test_roundTrip();
+    void test_sourceChanged_data();
+    void test_sourceChanged();
+    void test_sameAsSaved();
+    void test_discard();
+    void test_corrupt();
+
+  private:
+    void writeFile(const QString &name, const QByteArray &contents);
+    void saveSnapshot(const QByteArray &eixOutput,
+                      const QStringList &packageDatabase);
+    QString path(const QString &name) const;
+
+  private:
+    std::unique_ptr<QTemporaryDir> dir;
+    std::unique_ptr<PortageSnapshot> snapshot;
+};
+
+TestPortageSnapshot::TestPortageSnapshot()
+{
+}
+
+TestPortageSnapshot::~TestPortageSnapshot()
+{
+}
+
+void TestPortageSnapshot::init()
+{
+    dir.reset(new QTemporaryDir());
+    QVERIFY(dir->isValid());
+    writeFile("portage.eix", "eix database");
+    writeFile("emerge.log", "emerge log");
+    QVERIFY(QDir(dir->path()).mkdir("pkg"));
+
+    snapshot.reset(new PortageSnapshot(path("portage.eix"),
+                                       path("emerge.log"),
+                                       path("pkg"),
+                                       path("cache/portage.snapshot")));
+}
+
+void TestPortageSnapshot::writeFile(const QString &name,
+                                    const QByteArray &contents)
+{
+    QFile file(path(name));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(contents);
+}
+
+void TestPortageSnapshot::saveSnapshot(const QByteArray &eixOutput,
+                                       const QStringList &packageDatabase)
+{
+    snapshot->startRecording();
+    snapshot->record(eixOutput);
+    snapshot->setPackageDatabase(packageDatabase);
+    QVERIFY(snapshot->save());
+}
+
+QString TestPortageSnapshot::path(const QString &name) const
+{
+    return dir->filePath(name);
+}
+
+void TestPortageSnapshot::test_empty()
+{
+    QVERIFY(!snapshot->exists());
+    QVERIFY(!snapshot->isCurrent());
+    QVERIFY(!snapshot->map());
+    QVERIFY(!snapshot->save()); // not recording
+}
+
+void TestPortageSnapshot::test_roundTrip()
+{
+    snapshot->startRecording();
+    QVERIFY(snapshot->isRecording());
+    snapshot->record("hello ");
+    snapshot->record("world");
+    snapshot->setPackageDatabase(
+        {"dev-qt/qt-creator-12.4.3", "app-misc/eix-1"});
+    snapshot->setTables(QByteArray("tables\0with a nul", 17));
+    QVERIFY(snapshot->save());
+    QVERIFY(!snapshot->isRecording());
+
+    // A new object, as for the next run of the application
+    PortageSnapshot next(path("portage.eix"),
+                         path("emerge.log"),
+                         path("pkg"),
+                         path("cache/portage.snapshot"));
+    QVERIFY(next.exists());
+    QVERIFY(next.isCurrent());
+    QVERIFY(next.map());
+    QCOMPARE(next.eixOutput(), QByteArray("hello world"));
+    QCOMPARE(next.packageDatabase(),
+             QStringList({"dev-qt/qt-creator-12.4.3", "app-misc/eix-1"}));
+    QCOMPARE(next.tables(), QByteArray("tables\0with a nul", 17));
+    next.unmap();
+    QVERIFY(next.eixOutput().isEmpty());
+    QVERIFY(next.tables().isEmpty());
+}
+
+void TestPortageSnapshot::test_sourceChanged_data()
+{
+    QTest::addColumn<QString>("source");
+
+    QTest::newRow("eix database") << "portage.eix";
+    QTest::newRow("emerge log") << "emerge.log";
+    QTest::newRow("package database") << "pkg";
+}
+
+void TestPortageSnapshot::test_sourceChanged()
+{
+    QFETCH(QString, source);
+
+    saveSnapshot("output", {});
+    QVERIFY(snapshot->isCurrent());
+
+    // An install adds to the emerge log and the package database, and
+    // eix-update rewrites the eix database
+    QFileInfo info(path(source));
+    if (info.isDir()) {
+        QThread::msleep(20);
+        QVERIFY(QDir(path(source)).mkdir("dev-qt"));
+    } else {
+        QFile file(path(source));
+        QVERIFY(file.open(QIODevice::Append));
+        file.write("more");
+    }
+
+    // Out of date, but still there to be shown
+    QVERIFY(!snapshot->isCurrent());
+    QVERIFY(snapshot->exists());
+    QVERIFY(snapshot->map());
+    QCOMPARE(snapshot->eixOutput(), QByteArray("output"));
+    snapshot->unmap();
+}
+
+void TestPortageSnapshot::test_sameAsSaved()
+{
+    saveSnapshot("output", {"a/b-1"});
+
+    // The tables are made from the rest, so aren't compared
+    snapshot->startRecording();
+    snapshot->record("output");
+    snapshot->setPackageDatabase({"a/b-1"});
+    snapshot->setTables("tables");
+    QVERIFY(snapshot->sameAsSaved());
+
+    snapshot->setPackageDatabase({"a/b-2"});
+    QVERIFY(!snapshot->sameAsSaved());
+
+    snapshot->setPackageDatabase({"a/b-1"});
+    snapshot->record("more");
+    QVERIFY(!snapshot->sameAsSaved());
+}
+
+void TestPortageSnapshot::test_discard()
+{
+    saveSnapshot("first", {});
+
+    // A failed run must leave the previous snapshot alone
+    snapshot->startRecording();
+    snapshot->record("partial");
+    snapshot->setTables("partial tables");
+    snapshot->discard();
+    QVERIFY(!snapshot->save());
+    QVERIFY(snapshot->map());
+    QCOMPARE(snapshot->eixOutput(), QByteArray("first"));
+    QVERIFY(snapshot->tables().isEmpty());
+    snapshot->unmap();
+}
+
+void TestPortageSnapshot::test_corrupt()
+{
+    saveSnapshot("some output", {"a/b-1"});
+
+    // Cut short, e.g. disk full
+    QFile file(path("cache/portage.snapshot"));
+    QVERIFY(file.resize(file.size() - 1));
+    QVERIFY(!snapshot->exists());
+    QVERIFY(!snapshot->map());
+}
+
+QTEST_APPLESS_MAIN(TestPortageSnapshot)
+
+#include "tst_testportagesnapshot.moc"
@@ -0,0 +1,22 @@
+# SPDX-FileCopyrightText: None
+# SPDX-License-Identifier: CC0-1.0
+
+QT += testlib
+QT -= gui
+
+CONFIG += qt console warn_on depend_includepath testcase
+CONFIG -= app_bundle
+CONFIG += c++17
+
+TEMPLATE = app
+
+SOURCES +=  tst_testportagewatcher.cpp \
+    ../../vizzyix/portagewatcher.cpp
+
+INCLUDEPATH += ../../vizzyix
+
+HEADERS += \
+    ../../vizzyix/portagewatcher.h
+
+DISTFILES += \
+    meson.build
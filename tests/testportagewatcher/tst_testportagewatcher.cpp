@@ -0,0 +1,212 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "portagewatcher.h"
+
+class TestPortageWatcher : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestPortageWatcher();
+    ~TestPortageWatcher();
+
+  private slots:
+    void init();
+    void cleanup();
+    void test_start();
+    void test_packageAdded();
+    void test_batched();
+    void test_newCategory();
+    void test_eixDatabase();
+    void test_newEixDatabase();
+    void test_hold();
+
+  private:
+    void writeFile(const QString &name, const QByteArray &contents);
+    void makeDir(const QString &name);
+    QString path(const QString &name) const;
+
+  private:
+    /// Short, so the tests don't take long
+    static constexpr int batchDelay = 50;
+
+    std::unique_ptr<QTemporaryDir> dir;
+    std::unique_ptr<PortageWatcher> watcher;
+};
+
+TestPortageWatcher::TestPortageWatcher()
+{
+}
+
+TestPortageWatcher::~TestPortageWatcher()
+{
+}
+
+void TestPortageWatcher::init()
+{
+    dir.reset(new QTemporaryDir());
+    QVERIFY(dir->isValid());
+    writeFile("portage.eix", "eix database");
+    writeFile("emerge.log", "emerge log");
+    makeDir("pkg/dev-qt/qtbase-6.7.2");
+    makeDir("pkg/app-misc");
+
+    watcher.reset(new PortageWatcher(
+        path("portage.eix"), path("emerge.log"), path("pkg")));
+    watcher->setBatchDelay(batchDelay);
+    watcher->start();
+}
+
+void TestPortageWatcher::cleanup()
+{
+    watcher.reset();
+    dir.reset();
+}
+
+void TestPortageWatcher::writeFile(const QString &name,
+                                   const QByteArray &contents)
+{
+    QFile file(path(name));
+    QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+    file.write(contents);
+}
+
+void TestPortageWatcher::makeDir(const QString &name)
+{
+    QVERIFY(QDir(dir->path()).mkpath(name));
+}
+
+QString TestPortageWatcher::path(const QString &name) const
+{
+    return QDir(dir->path()).filePath(name);
+}
+
+void TestPortageWatcher::test_start()
+{
+    QVERIFY(watcher->isActive());
+    watcher->stop();
+    QVERIFY(!watcher->isActive());
+}
+
+void TestPortageWatcher::test_packageAdded()
+{
+    QSignalSpy eixChanged(watcher.get(), &PortageWatcher::eixDatabaseChanged);
+    QSignalSpy changed(watcher.get(), &PortageWatcher::packageDatabaseChanged);
+
+    makeDir("pkg/dev-qt/qtcharts-6.7.2");
+    QVERIFY(changed.wait());
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed[0][0].toStringList(), QStringList{"dev-qt"});
+    QCOMPARE(eixChanged.count(), 0);
+
+    QVERIFY(QDir(path("pkg/dev-qt")).rmdir("qtbase-6.7.2"));
+    QVERIFY(changed.wait());
+    QCOMPARE(changed[1][0].toStringList(), QStringList{"dev-qt"});
+}
+
+void TestPortageWatcher::test_batched()
+{
+    QSignalSpy changed(watcher.get(), &PortageWatcher::packageDatabaseChanged);
+
+    // As portage does it: a temporary directory, then the real one
+    makeDir("pkg/dev-qt/-MERGING-qtbase-6.8.0");
+    makeDir("pkg/dev-qt/qtbase-6.8.0");
+    QVERIFY(QDir(path("pkg/dev-qt")).rmdir("-MERGING-qtbase-6.8.0"));
+    QVERIFY(QDir(path("pkg/dev-qt")).rmdir("qtbase-6.7.2"));
+    makeDir("pkg/app-misc/screen-4.9.1");
+    writeFile("emerge.log", "emerge log\ncompleted emerge");
+
+    QVERIFY(changed.wait());
+    QTest::qWait(4 * batchDelay);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(changed[0][0].toStringList(),
+             (QStringList{"app-misc", "dev-qt"}));
+}
+
+void TestPortageWatcher::test_newCategory()
+{
+    QSignalSpy changed(watcher.get(), &PortageWatcher::packageDatabaseChanged);
+
+    makeDir("pkg/sys-libs");
+    QVERIFY(changed.wait());
+    QCOMPARE(changed[0][0].toStringList(), QStringList{"sys-libs"});
+
+    // The new category is watched too
+    makeDir("pkg/sys-libs/zlib-1.3.1");
+    QVERIFY(changed.wait());
+    QCOMPARE(changed[1][0].toStringList(), QStringList{"sys-libs"});
+
+    QVERIFY(QDir(path("pkg")).rmpath("sys-libs/zlib-1.3.1"));
+    QVERIFY(changed.wait());
+    QCOMPARE(changed[2][0].toStringList(), QStringList{"sys-libs"});
+}
+
+void TestPortageWatcher::test_eixDatabase()
+{
+    QSignalSpy eixChanged(watcher.get(), &PortageWatcher::eixDatabaseChanged);
+    QSignalSpy changed(watcher.get(), &PortageWatcher::packageDatabaseChanged);
+
+    writeFile("portage.eix", "new eix database");
+    QVERIFY(eixChanged.wait());
+    QCOMPARE(changed.count(), 0);
+
+    // Replaced rather than written in place
+    writeFile("portage.eix.new", "newer eix database");
+    QVERIFY(QFile::remove(path("portage.eix")));
+    QVERIFY(QFile::rename(path("portage.eix.new"), path("portage.eix")));
+    QVERIFY(eixChanged.wait());
+
+    // And it is still watched
+    QTest::qWait(4 * batchDelay);
+    const int count = eixChanged.count();
+    writeFile("portage.eix", "newest eix database");
+    QVERIFY(eixChanged.wait());
+    QCOMPARE(eixChanged.count(), count + 1);
+}
+
+void TestPortageWatcher::test_newEixDatabase()
+{
+    // No eix database yet, e.g. eix-update has never been run
+    QVERIFY(QFile::remove(path("portage.eix")));
+    watcher->start();
+    QSignalSpy eixChanged(watcher.get(), &PortageWatcher::eixDatabaseChanged);
+
+    // Something else in the directory isn't the eix database
+    writeFile("other.eix", "not the eix database");
+    QTest::qWait(4 * batchDelay);
+    QCOMPARE(eixChanged.count(), 0);
+
+    writeFile("portage.eix", "first eix database");
+    QVERIFY(eixChanged.wait());
+
+    // And from then on it is watched
+    QTest::qWait(4 * batchDelay);
+    const int count = eixChanged.count();
+    writeFile("portage.eix", "newer eix database");
+    QVERIFY(eixChanged.wait());
+    QCOMPARE(eixChanged.count(), count + 1);
+}
+
+void TestPortageWatcher::test_hold()
+{
+    QSignalSpy changed(watcher.get(), &PortageWatcher::packageDatabaseChanged);
+
+    watcher->hold();
+    makeDir("pkg/dev-qt/qtcharts-6.7.2");
+    QTest::qWait(4 * batchDelay);
+    QCOMPARE(changed.count(), 0);
+
+    watcher->release();
+    QVERIFY(changed.wait());
+    QCOMPARE(changed[0][0].toStringList(), QStringList{"dev-qt"});
+}
+
+QTEST_GUILESS_MAIN(TestPortageWatcher)
+
+#include "tst_testportagewatcher.moc"
@@ -0,0 +1,199 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+
+#include "eix.pb.h"
+#include "packagestore.h"
+#include "quickfilter.h"
+#include <fstream>
+
+class TestQuickFilter : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestQuickFilter();
+    ~TestQuickFilter();
+
+  private slots:
+    void initTestCase();
+    void test_construction();
+    void test_match();
+    void test_range();
+    void test_matchers();
+    void test_clear();
+    void benchmark_match();
+
+  private:
+    bool contains(int index, const QString &text) const;
+
+    eix_proto::Collection eix;
+    QStringList emptyVersionList;
+    PackageStore store;
+    QVector<int> all;
+};
+
+TestQuickFilter::TestQuickFilter()
+{
+}
+
+TestQuickFilter::~TestQuickFilter()
+{
+}
+
+void TestQuickFilter::initTestCase()
+{
+    std::fstream input(TESTDATA, std::ios::in | std::ios::binary);
+    if (!eix.ParseFromIstream(&input)) {
+        QFAIL("Failed to parse data file: " TESTDATA);
+    } else {
+        for (const auto &cat : eix.category()) {
+            for (const auto &pkg : cat.package()) {
+                all.append(
+                    store.addPackage(cat.category(), pkg, emptyVersionList));
+            }
+        }
+        QVERIFY(all.size() > 0);
+    }
+}
+
+void TestQuickFilter::test_construction()
+{
+    QuickFilter filter;
+    QCOMPARE(filter.size(), 0);
+    QCOMPARE(filter.matcher(), QuickFilter::bestMatcher());
+}
+
+void TestQuickFilter::test_match()
+{
+    QuickFilter filter;
+    filter.build(store, all);
+    QCOMPARE(filter.size(), all.size());
+
+    // The same as looking at each package in turn, whatever the case
+    std::vector<uint64_t> bitmap;
+    for (const QString text : {"qt", "QtCore", "library", "x", "zzzzzzzz"}) {
+        filter.match(text, 0, all.size(), bitmap);
+        for (int n = 0; n < all.size(); ++n) {
+            QCOMPARE(QuickFilter::isSet(bitmap, n), contains(all[n], text));
+        }
+    }
+
+    // The test data has dev-qt/qtcore
+    filter.match("QTCORE", 0, all.size(), bitmap);
+    int matches = 0;
+    for (int n = 0; n < all.size(); ++n) {
+        matches += QuickFilter::isSet(bitmap, n);
+    }
+    QVERIFY(matches > 0);
+
+    // No text matches everything, and no text matches across a line
+    filter.match("", 0, all.size(), bitmap);
+    for (int n = 0; n < all.size(); ++n) {
+        QVERIFY(QuickFilter::isSet(bitmap, n));
+    }
+    const QString name = QString::fromUtf8(store.name(all[0]).data(),
+                                           store.name(all[0]).size());
+    filter.match(name + "\n", 0, all.size(), bitmap);
+    for (uint64_t word : bitmap) {
+        QCOMPARE(word, uint64_t(0));
+    }
+}
+
+void TestQuickFilter::test_range()
+{
+    QuickFilter filter;
+    filter.build(store, all);
+
+    // Just some of the packages, numbered from the start of the range
+    std::vector<uint64_t> whole;
+    filter.match("qt", 0, all.size(), whole);
+    const int begin = all.size() / 3;
+    const int end = all.size() - 1;
+    std::vector<uint64_t> bitmap;
+    filter.match("qt", begin, end, bitmap);
+    QCOMPARE(int(bitmap.size()), (end - begin + 63) / 64);
+    for (int n = begin; n < end; ++n) {
+        QCOMPARE(QuickFilter::isSet(bitmap, n - begin),
+                 QuickFilter::isSet(whole, n));
+    }
+
+    // Nothing to look at
+    filter.match("qt", begin, begin, bitmap);
+    QVERIFY(bitmap.empty());
+}
+
+void TestQuickFilter::test_matchers()
+{
+    QuickFilter filter;
+    filter.build(store, all);
+
+    // Every matcher the processor can run finds the same packages
+    for (const QString text : {"q", "qt", "lib", "the qt", "zzzzzzzz"}) {
+        filter.setMatcher(QuickFilter::ScalarMatcher);
+        QCOMPARE(filter.matcher(), QuickFilter::ScalarMatcher);
+        std::vector<uint64_t> expected;
+        filter.match(text, 0, all.size(), expected);
+        for (int matcher = QuickFilter::Sse2Matcher;
+             matcher <= QuickFilter::bestMatcher();
+             ++matcher) {
+            filter.setMatcher(QuickFilter::Matcher(matcher));
+            QCOMPARE(int(filter.matcher()), matcher);
+            std::vector<uint64_t> bitmap;
+            filter.match(text, 0, all.size(), bitmap);
+            QCOMPARE(bitmap, expected);
+        }
+    }
+
+    // A matcher the processor can't run isn't used
+    filter.setMatcher(QuickFilter::Avx2Matcher);
+    QCOMPARE(filter.matcher(), QuickFilter::bestMatcher());
+}
+
+void TestQuickFilter::test_clear()
+{
+    QuickFilter filter;
+    filter.build(store, all);
+    filter.clear();
+    QCOMPARE(filter.size(), 0);
+
+    // It can be filled again
+    filter.build(store, all.mid(0, 1));
+    QCOMPARE(filter.size(), 1);
+}
+
+/*!
+ * A keystroke's worth of filtering: 20,000 packages (the test data, over and
+ * over), which has to take well under a frame.
+ */
+void TestQuickFilter::benchmark_match()
+{
+    constexpr int rowCount = 20000;
+    QVector<int> packages;
+    while (packages.size() < rowCount) {
+        packages.append(all[packages.size() % all.size()]);
+    }
+    QuickFilter filter;
+    filter.build(store, packages);
+
+    std::vector<uint64_t> bitmap;
+    QBENCHMARK {
+        filter.match("qtcor", 0, rowCount, bitmap);
+    }
+}
+
+/// Whether a package's name or description has the text, ignoring case
+bool TestQuickFilter::contains(int index, const QString &text) const
+{
+    std::string_view name = store.name(index);
+    std::string_view description = store.description(index);
+    return QString::fromUtf8(name.data(), name.size())
+               .contains(text, Qt::CaseInsensitive) ||
+           QString::fromUtf8(description.data(), description.size())
+               .contains(text, Qt::CaseInsensitive);
+}
+
+QTEST_APPLESS_MAIN(TestQuickFilter)
+
+#include "tst_testquickfilter.moc"
@@ -0,0 +1,245 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include "eix.pb.h"
+#include "searchindex.h"
+#include "snapshotimage.h"
+
+class TestSearchIndex : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestSearchIndex();
+    ~TestSearchIndex();
+
+  private slots:
+    void initTestCase();
+    void test_empty();
+    void test_locations();
+    void test_find_data();
+    void test_find();
+    void test_extend();
+    void test_saveRestore();
+    void test_largeTree();
+
+  private:
+    /// Entries found by checking every package, to compare with find()
+    std::vector<int> findByHand(const eix_proto::Collection &eix,
+                                const std::string &text) const;
+
+    static void makeLargeTree(eix_proto::Collection &eix);
+
+  private:
+    eix_proto::Collection small;
+    SearchIndex index;
+};
+
+TestSearchIndex::TestSearchIndex()
+{
+}
+
+TestSearchIndex::~TestSearchIndex()
+{
+}
+
+void TestSearchIndex::initTestCase()
+{
+    auto *cat = small.add_category();
+    cat->set_category("app-editors");
+    auto *pkg = cat->add_package();
+    pkg->set_name("vim");
+    pkg->set_description("Vim, an improved vi-style text editor");
+    pkg = cat->add_package();
+    pkg->set_name("emacs");
+    pkg->set_description("The extensible, customizable, self-documenting "
+                         "real-time display editor");
+
+    cat = small.add_category();
+    cat->set_category("dev-qt");
+    pkg = cat->add_package();
+    pkg->set_name("qtbase");
+    pkg->set_description("Cross-platform application development framework");
+    pkg = cat->add_package();
+    pkg->set_name("qt-creator");
+    pkg->set_description("Lightweight IDE for C++/QML development centering "
+                         "around Qt");
+    pkg = cat->add_package();
+    pkg->set_name("qtcharts");
+    pkg->set_description("Chart component library for the Qt6 framework");
+
+    index.build(small);
+}
+
+std::vector<int> TestSearchIndex::findByHand(const eix_proto::Collection &eix,
+                                             const std::string &text) const
+{
+    std::vector<int> result;
+    int entry = 0;
+    for (const auto &cat : eix.category()) {
+        for (const auto &pkg : cat.package()) {
+            std::string all =
+                cat.category() + "/" + pkg.name() + "\n" + pkg.description();
+            std::transform(all.begin(), all.end(), all.begin(), ::tolower);
+            if (all.find(text) != std::string::npos) {
+                result.push_back(entry);
+            }
+            ++entry;
+        }
+    }
+    return result;
+}
+
+void TestSearchIndex::test_empty()
+{
+    SearchIndex empty;
+    QVERIFY(empty.isEmpty());
+    QCOMPARE(empty.entryCount(), 0);
+    QVERIFY(empty.find("qt").empty());
+    QVERIFY(empty.find("qtbase").empty());
+}
+
+void TestSearchIndex::test_locations()
+{
+    QVERIFY(!index.isEmpty());
+    QCOMPARE(index.entryCount(), 5);
+    QCOMPARE(index.categoryNumber(1), 0);
+    QCOMPARE(index.packageNumber(1), 1);
+    QCOMPARE(index.categoryNumber(2), 1);
+    QCOMPARE(index.packageNumber(2), 0);
+    QCOMPARE(index.categoryNumber(4), 1);
+    QCOMPARE(index.packageNumber(4), 2);
+}
+
+void TestSearchIndex::test_find_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QList<int>>("expected");
+
+    QTest::newRow("everything") << "" << QList<int>{0, 1, 2, 3, 4};
+    QTest::newRow("one letter") << "v" << QList<int>{0, 2, 3, 4};
+    QTest::newRow("two letters") << "qt" << QList<int>{2, 3, 4};
+    QTest::newRow("trigram") << "edi" << QList<int>{0, 1};
+    QTest::newRow("name") << "qtbase" << QList<int>{2};
+    QTest::newRow("category") << "editors" << QList<int>{0, 1};
+    QTest::newRow("description") << "framework" << QList<int>{2, 4};
+    QTest::newRow("trigrams but not text") << "framedit" << QList<int>{};
+    QTest::newRow("unknown trigram") << "xyz" << QList<int>{};
+    QTest::newRow("longer than any") << "extensible-customizable-editor"
+                                     << QList<int>{};
+}
+
+void TestSearchIndex::test_find()
+{
+    QFETCH(QString, text);
+    QFETCH(QList<int>, expected);
+
+    // A fresh index each time, so that the last search isn't reused
+    SearchIndex fresh;
+    fresh.build(small);
+    const auto &found = fresh.find(text.toStdString());
+    QCOMPARE(QList<int>(found.begin(), found.end()), expected);
+}
+
+void TestSearchIndex::test_extend()
+{
+    // As if typed one letter at a time, then cut back and typed again
+    const std::vector<std::string> keys{
+        "f", "fr", "fra", "fram", "frame", "fra", "fr", "de", "dev", "devel"};
+    for (const auto &text : keys) {
+        QCOMPARE(index.find(text), findByHand(small, text));
+    }
+}
+
+void TestSearchIndex::test_saveRestore()
+{
+    SnapshotImage saved;
+    index.save(saved);
+
+    // Finds the same, without the eix data
+    SearchIndex restored;
+    SnapshotImage image(saved.bytes().constData(), saved.bytes().size());
+    QVERIFY(restored.restore(image));
+    QVERIFY(image.atEnd());
+    QCOMPARE(restored.entryCount(), index.entryCount());
+    for (int entry = 0; entry < index.entryCount(); ++entry) {
+        QCOMPARE(restored.categoryNumber(entry), index.categoryNumber(entry));
+        QCOMPARE(restored.packageNumber(entry), index.packageNumber(entry));
+    }
+    for (const std::string text : {"", "v", "qt", "edi", "framework"}) {
+        QCOMPARE(restored.find(text), findByHand(small, text));
+    }
+
+    // An index that was never built stays empty
+    SnapshotImage empty;
+    SearchIndex().save(empty);
+    SnapshotImage emptyImage(empty.bytes().constData(), empty.bytes().size());
+    QVERIFY(restored.restore(emptyImage));
+    QVERIFY(restored.isEmpty());
+
+    // Cut short, nothing is restored
+    SnapshotImage cut(saved.bytes().constData(), saved.bytes().size() - 1);
+    QVERIFY(!restored.restore(cut));
+    QVERIFY(restored.isEmpty());
+}
+
+void TestSearchIndex::test_largeTree()
+{
+    eix_proto::Collection large;
+    makeLargeTree(large);
+
+    QElapsedTimer timer;
+    timer.start();
+    SearchIndex bigIndex;
+    bigIndex.build(large);
+    qint64 buildTime = timer.nsecsElapsed() / 1000;
+    QCOMPARE(bigIndex.entryCount(), 20000);
+
+    const std::vector<std::string> keys{
+        "l", "li", "lib", "libr", "libra", "librar", "library", "qt", "kde"};
+    qint64 slowest = 0;
+    for (const auto &text : keys) {
+        timer.restart();
+        const auto &found = bigIndex.find(text);
+        slowest = std::max(slowest, timer.nsecsElapsed() / 1000);
+        QCOMPARE(found, findByHand(large, text));
+    }
+
+    qInfo() << "Index of" << bigIndex.entryCount() << "packages built in"
+            << buildTime << "us, slowest keystroke" << slowest << "us";
+}
+
+/// About the size of the full portage tree, with made up names
+void TestSearchIndex::makeLargeTree(eix_proto::Collection &eix)
+{
+    const std::vector<std::string> words{
+        "lib",   "qt",     "kde",  "python", "gtk",     "perl", "x11",
+        "media", "sound",  "font", "data",   "tools",   "net",  "crypt",
+        "xml",   "parser", "view", "daemon", "library", "core", "util"};
+    unsigned int seed = 1;
+    auto pick = [&]() -> const std::string & {
+        seed = seed * 1103515245 + 12345;
+        return words[(seed >> 16) % words.size()];
+    };
+
+    for (int catNumber = 0; catNumber < 160; ++catNumber) {
+        auto *cat = eix.add_category();
+        cat->set_category(pick() + "-" + pick());
+        for (int pkgNumber = 0; pkgNumber < 125; ++pkgNumber) {
+            auto *pkg = cat->add_package();
+            pkg->set_name(pick() + pick() + std::to_string(pkgNumber));
+            std::string description = "A " + pick();
+            for (int word = 0; word < 8; ++word) {
+                description += " " + pick();
+            }
+            pkg->set_description(description);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(TestSearchIndex)
+
+#include "tst_testsearchindex.moc"
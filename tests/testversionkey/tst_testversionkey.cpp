@@ -0,0 +1,249 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include <QtTest>
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "versionkey.h"
+
+class TestVersionKey : public QObject
+{
+    Q_OBJECT
+
+  public:
+    TestVersionKey();
+    ~TestVersionKey();
+
+  private slots:
+    void initTestCase();
+    void test_compare_data();
+    void test_compare();
+    void test_isValid_data();
+    void test_isValid();
+    void test_isLive();
+    void test_invalidKey();
+    void test_sort();
+    void benchmark_key();
+    void benchmark_sortKeys();
+    void benchmark_sortCompare();
+
+  private:
+    /// Versions like the ones in the eix data, for the benchmarks
+    std::vector<std::string> versions;
+};
+
+TestVersionKey::TestVersionKey()
+{
+}
+
+TestVersionKey::~TestVersionKey()
+{
+}
+
+void TestVersionKey::initTestCase()
+{
+    const char *suffixes[] = {"", "_alpha", "_beta2", "_pre20240101",
+                              "_rc1", "_p3", "-r1", "_rc2-r3"};
+    for (int n = 0; n < 20000; ++n) {
+        versions.push_back(std::to_string(n % 30) + "." +
+                           std::to_string(n % 7) + "." + std::to_string(n) +
+                           (n % 11 == 0 ? "b" : "") + suffixes[n % 8]);
+    }
+}
+
+/*!
+ * The conformance table: pairs of versions and how they compare, following
+ * the algorithms in section 3.3 of PMS.
+ */
+void TestVersionKey::test_compare_data()
+{
+    QTest::addColumn<QString>("first");
+    QTest::addColumn<QString>("second");
+    QTest::addColumn<int>("expected");
+
+    // Numeric components
+    QTest::newRow("equal") << "1.0" << "1.0" << 0;
+    QTest::newRow("number") << "2" << "10" << -1;
+    QTest::newRow("first leading zero") << "010" << "10" << 0;
+    QTest::newRow("more components") << "1.0" << "1.0.0" << -1;
+    QTest::newRow("later number") << "1.2.3" << "1.2.10" << -1;
+    QTest::newRow("fraction") << "1.01" << "1.1" << -1;
+    QTest::newRow("fraction digits") << "1.01" << "1.001" << 1;
+    QTest::newRow("fraction zeros") << "1.010" << "1.01" << 0;
+    QTest::newRow("zero fraction") << "1.0" << "1.00" << 0;
+    QTest::newRow("numbers") << "1.1" << "1.10" << -1;
+    QTest::newRow("long number")
+        << "1.99999999999999999999" << "1.100000000000000000000" << -1;
+
+    // Letters
+    QTest::newRow("letter") << "1.0a" << "1.0" << 1;
+    QTest::newRow("letters") << "1.0a" << "1.0b" << -1;
+    QTest::newRow("letter or component") << "1.0a" << "1.0.1" << -1;
+
+    // Suffixes
+    QTest::newRow("alpha") << "1.0_alpha" << "1.0" << -1;
+    QTest::newRow("alpha beta") << "1.0_alpha" << "1.0_beta" << -1;
+    QTest::newRow("beta pre") << "1.0_beta" << "1.0_pre" << -1;
+    QTest::newRow("pre rc") << "1.0_pre" << "1.0_rc" << -1;
+    QTest::newRow("rc") << "1.0_rc" << "1.0" << -1;
+    QTest::newRow("p") << "1.0" << "1.0_p" << -1;
+    QTest::newRow("suffix zero") << "1.0_p" << "1.0_p0" << 0;
+    QTest::newRow("suffix number") << "1.0_p1" << "1.0_p2" << -1;
+    QTest::newRow("suffix long number") << "1.0_p9" << "1.0_p10" << -1;
+    QTest::newRow("more suffixes") << "1.0_alpha_p" << "1.0_alpha" << 1;
+    QTest::newRow("more suffixes before")
+        << "1.0_alpha_rc" << "1.0_alpha" << -1;
+    QTest::newRow("suffix with number") << "1.0_alpha1" << "1.0_alpha" << 1;
+    QTest::newRow("letter and suffix") << "1.0a_alpha" << "1.0" << 1;
+    QTest::newRow("snapshot") << "1.0.0_pre20240101" << "1.0.0" << -1;
+
+    // Revisions
+    QTest::newRow("r0") << "1.0-r0" << "1.0" << 0;
+    QTest::newRow("revision") << "1.0-r1" << "1.0" << 1;
+    QTest::newRow("revision number") << "1.0-r2" << "1.0-r10" << -1;
+    QTest::newRow("revision last") << "1.0_rc1-r1" << "1.0-r1" << -1;
+    QTest::newRow("live") << "9999" << "39.0-r2" << 1;
+
+    // Anything that isn't a version comes after all those that are
+    QTest::newRow("invalid") << "bad" << "1.0" << 1;
+    QTest::newRow("invalid text") << "bad" << "worse" << -1;
+}
+
+void TestVersionKey::test_compare()
+{
+    QFETCH(QString, first);
+    QFETCH(QString, second);
+    QFETCH(int, expected);
+
+    const std::string a = first.toStdString();
+    const std::string b = second.toStdString();
+    const auto sign = [](int n) { return (n > 0) - (n < 0); };
+    QCOMPARE(sign(VersionKey::compare(a, b)), expected);
+    QCOMPARE(sign(VersionKey::compare(b, a)), -expected);
+
+    // The keys compare the same way, a byte at a time
+    const std::string keyA = VersionKey::key(a);
+    const std::string keyB = VersionKey::key(b);
+    int result = std::memcmp(
+        keyA.data(), keyB.data(), std::min(keyA.size(), keyB.size()));
+    if (result == 0) {
+        result = int(keyA.size()) - int(keyB.size());
+    }
+    QCOMPARE(sign(result), expected);
+}
+
+void TestVersionKey::test_isValid_data()
+{
+    QTest::addColumn<QString>("version");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("simple") << "1.0" << true;
+    QTest::newRow("everything") << "1.2.3b_rc2_p1-r4" << true;
+    QTest::newRow("suffixes") << "1.0_pre1_p" << true;
+    QTest::newRow("live") << "9999" << true;
+    QTest::newRow("empty") << "" << false;
+    QTest::newRow("letter first") << "a1" << false;
+    QTest::newRow("empty component") << "1..0" << false;
+    QTest::newRow("trailing dot") << "1.0." << false;
+    QTest::newRow("two letters") << "1.0ab" << false;
+    QTest::newRow("bad suffix") << "1.0_foo" << false;
+    QTest::newRow("empty suffix") << "1.0_" << false;
+    QTest::newRow("no revision number") << "1.0-r" << false;
+    QTest::newRow("bad revision") << "1.0-rr" << false;
+    QTest::newRow("after revision") << "1.0-r1a" << false;
+    QTest::newRow("upper case") << "1.0A" << false;
+}
+
+void TestVersionKey::test_isValid()
+{
+    QFETCH(QString, version);
+    QFETCH(bool, valid);
+
+    QCOMPARE(VersionKey::isValid(version.toStdString()), valid);
+}
+
+void TestVersionKey::test_isLive()
+{
+    QVERIFY(VersionKey::isLive("9999"));
+    QVERIFY(VersionKey::isLive("99999999"));
+    QVERIFY(VersionKey::isLive("6.8.9999"));
+    QVERIFY(VersionKey::isLive("9999-r1"));
+    QVERIFY(!VersionKey::isLive("999"));
+    QVERIFY(!VersionKey::isLive("39.0-r2"));
+    QVERIFY(!VersionKey::isLive("1.19999"));
+}
+
+void TestVersionKey::test_invalidKey()
+{
+    // Still a key, just not equal to any other
+    QVERIFY(!VersionKey::key("bad").empty());
+    QCOMPARE(VersionKey::key("bad"), VersionKey::key("bad"));
+    QVERIFY(VersionKey::key("bad") != VersionKey::key("bad2"));
+}
+
+void TestVersionKey::test_sort()
+{
+    std::vector<std::string> sorted = {"1.0_alpha",
+                                       "1.0_beta1",
+                                       "1.0_pre",
+                                       "1.0_rc2",
+                                       "1.0",
+                                       "1.0-r1",
+                                       "1.0_p1",
+                                       "1.0a",
+                                       "1.0.1",
+                                       "1.1",
+                                       "1.10",
+                                       "2",
+                                       "10"};
+    std::vector<std::string> reversed(sorted.rbegin(), sorted.rend());
+    std::sort(reversed.begin(),
+              reversed.end(),
+              [](const std::string &a, const std::string &b) {
+                  return VersionKey::key(a) < VersionKey::key(b);
+              });
+    QCOMPARE(reversed, sorted);
+}
+
+void TestVersionKey::benchmark_key()
+{
+    QBENCHMARK {
+        for (const auto &version : versions) {
+            VersionKey::key(version);
+        }
+    }
+}
+
+void TestVersionKey::benchmark_sortKeys()
+{
+    // The keys are made once, then only compared
+    std::vector<std::string> keys;
+    for (const auto &version : versions) {
+        keys.push_back(VersionKey::key(version));
+    }
+
+    QBENCHMARK {
+        std::vector<std::string> sorted(keys);
+        std::sort(sorted.begin(), sorted.end());
+    }
+}
+
+void TestVersionKey::benchmark_sortCompare()
+{
+    // For comparison: parsing the versions every time they are compared
+    QBENCHMARK {
+        std::vector<std::string> sorted(versions);
+        std::sort(sorted.begin(),
+                  sorted.end(),
+                  [](const std::string &a, const std::string &b) {
+                      return VersionKey::compare(a, b) < 0;
+                  });
+    }
+}
+
+QTEST_APPLESS_MAIN(TestVersionKey)
+
+#include "tst_testversionkey.moc"
@@ -4,19 +4,36 @@
 #include "applicationdata.h"
 
 #include <QDebug>
+#include <QDir>
+#include <QFileInfo>
 #include <QProcess>
+#include <QSet>
 #include <QTimer>
 #include <QtLogging>
-#include <fstream>
-#include <iostream>
+#include <algorithm>
+
+#include "portageeixreader.h"
+#include "snapshotimage.h"
 
 std::unique_ptr<ApplicationData> ApplicationData::_appData;
 
 /*!
- * Constructor doesn't need to do anything
+ * Constructor just starts with an empty set of eix data
  */
-ApplicationData::ApplicationData()
+ApplicationData::ApplicationData() : _generation(new LoadGeneration())
 {
+    connect(&_watcher,
+            &PortageWatcher::eixDatabaseChanged,
+            this,
+            &ApplicationData::onEixDatabaseChanged);
+    connect(&_watcher,
+            &PortageWatcher::packageDatabaseChanged,
+            this,
+            &ApplicationData::onPackageDatabaseChanged);
+    connect(&_eixParser,
+            &EixStreamParser::categoriesDecoded,
+            this,
+            &ApplicationData::onCategoriesDecoded);
 }
 
 /*!
@@ -34,117 +51,758 @@ ApplicationData *ApplicationData::data()
 /// Whether any filters are currently set
 bool ApplicationData::filters()
 {
-    return (selectionFilter() != SelectionFilter::All) || !search().isEmpty();
+    return _filter.isActive();
 }
 
-/// Sets the selection filter to the given value.
+/// Sets the selection filter to the given value, see applyFilters().
 void ApplicationData::setSelectionFilter(SelectionFilter filter)
 {
-    _selectionFilter = filter;
+    _filter.setSelection(filter);
 }
 
 /// Gets the current selection filter value.
 ApplicationData::SelectionFilter ApplicationData::selectionFilter()
 {
-    return _selectionFilter;
+    return _filter.selection();
 }
 
-/// Sets the search filter to the given string.
+/// Sets the search filter to the given string, see applyFilters().
 void ApplicationData::setSearch(const QString &search)
 {
-    _search = search;
+    _filter.setSearch(search);
 }
 
 /// Returns the current search filter.
 const QString ApplicationData::search()
 {
-    return _search;
+    return _filter.search();
+}
+
+/// Sets whether the search also looks at categories and descriptions.
+void ApplicationData::setSearchDescriptions(bool on)
+{
+    _filter.setSearchDescriptions(on);
+}
+
+/// Whether the search also looks at categories and descriptions.
+bool ApplicationData::searchDescriptions() const
+{
+    return _filter.searchDescriptions();
+}
+
+/*!
+ * Shows just the packages that pass the current filters. The full eix data
+ * is always loaded, so this works on what is already in memory and doesn't
+ * need eix to be run again.
+ */
+void ApplicationData::applyFilters()
+{
+    // The package list is brought up to date when the category tree is
+    // displayed
+    setupCategoryTreeModelData();
+}
+
+/*!
+ * Sets the text the package list is narrowed to: only the packages with it
+ * in their name or description are shown, ignoring case. This only applies
+ * to the package list, from the next setupPackageModelData(), and doesn't
+ * touch the eix data, so it is quick enough to do on every keystroke.
+ */
+void ApplicationData::setQuickFilter(const QString &text)
+{
+    _quickFilterText = text;
+}
+
+/// Returns the text the package list is narrowed to.
+const QString ApplicationData::quickFilter()
+{
+    return _quickFilterText;
+}
+
+/*!
+ * Sets the facets the packages must all have, e.g. installed and with an
+ * update, see applyFilters(). These narrow what the other filters pass,
+ * using the bitsets made when the data was loaded (see FacetIndex), so
+ * a change of facets doesn't need eix or a search.
+ */
+void ApplicationData::setFacets(const FacetIndex::Selection &facets)
+{
+    _facets = facets;
+}
+
+/// Returns the facets the packages must have.
+const FacetIndex::Selection &ApplicationData::facets() const
+{
+    return _facets;
+}
+
+/*!
+ * The repositories the packages are from, for the Repository facet (see
+ * FacetIndex::Selection::repository). Eix's main repository has no name.
+ * The list is made again with the package store, e.g. after a reload.
+ */
+const QStringList &ApplicationData::repositories() const
+{
+    return _facetIndex.repositories();
+}
+
+/*!
+ * The protobuf copy of the eix database. This is always the full list of
+ * packages; the filters are applied separately.
+ *
+ * The reference is only good until the next loadPortageData() call, which
+ * throws the whole collection away and starts a new one.
+ *
+ * The data shown from a snapshot doesn't need the eix data, so the eix
+ * output kept with it is only decoded here, the first time it is needed.
+ */
+eix_proto::Collection &ApplicationData::eix()
+{
+    if (_generation->isDeferred() &&
+        !_generation->decodeStream(lazyDecoding())) {
+        qWarning() << "Failed to decode the eix data from the snapshot";
+    }
+    return _generation->eix();
+}
+
+/*!
+ * Returns the package with all of its details decoded. In lazy mode only a
+ * summary of each package is decoded up front, and the rest is filled in
+ * the first time the package is asked for here.
+ */
+const eix_proto::Package &
+ApplicationData::packageDetails(const eix_proto::Package &pkg)
+{
+    return _generation->lazyDecoder().details(pkg);
+}
+
+/// Sets lazy mode, which takes effect at the next load
+void ApplicationData::setLazyDecoding(bool on)
+{
+    _lazyDecoding = on;
+}
+
+/// Whether package details are decoded when first needed
+bool ApplicationData::lazyDecoding() const
+{
+    return _lazyDecoding;
+}
+
+/*!
+ * Sets installed-only mode, which takes effect at the next load. Only the
+ * installed packages are shown, straight from the package database, and eix
+ * isn't run at all.
+ */
+void ApplicationData::setInstalledOnly(bool on)
+{
+    _installedOnly = on;
+}
+
+/// Whether only the installed packages are shown, without running eix
+bool ApplicationData::installedOnly() const
+{
+    return _installedOnly;
 }
 
 /*!
- * Parses the eix (protobuf format) output into the eix data,
- * extracts the package information from it and then uses this
- * to populate the display models.
+ * Completes the eix (protobuf format) data once the eix process has finished,
+ * extracts the package information from it and then uses this to populate
+ * the display models.
+ *
+ * Most of the categories will already have been decoded and added to the
+ * category tree while eix was running (see onEixOutput()), so 'data' is
+ * just the rest of the output.
  */
-void ApplicationData::parseEixData()
+void ApplicationData::parseEixData(const QByteArray &data)
 {
-    std::fstream input(_eixOutput->fileName().toStdString(),
-                       std::ios::in | std::ios::binary);
-    if (!eix.ParseFromIstream(&input)) {
+    addStreamedCategories(_eixParser.feed(data));
 
+    if (!_eixParser.finish()) {
         qWarning() << "Failed to parse EIX output";
-        eix.clear_category();
+        _snapshot.discard();
+        clearPackageModelData();
+        _generation->clear();
+        _loadComplete = false;
+        setupCategoryTreeModelData();
+        return;
     }
 
+    finishLoad(combinedPackageList.readPackageDatabase());
+}
+
+/*!
+ * Works out everything shown from the eix data once all of it has been
+ * loaded, given the package database entries it was loaded with.
+ */
+void ApplicationData::finishLoad(const QStringList &packageDatabase)
+{
     // Merge the data for installed packages and eix info together.
-    combinedPackageList.load(eix, search());
+    combinedPackageList.load(eix(), packageDatabase);
+    invalidateStore();
+    updateStore();
+    _searchIndex.build(eix());
+    _loadComplete = true;
+    saveSnapshot(packageDatabase);
 
+    // The facets, and the tree's facet counts, need the complete data.
+    // This signals for the MainWindow updates.
     setupCategoryTreeModelData();
 }
 
 /*!
- * Add the contents of the given category item into the package model.
+ * Shows the data from the last full load (see PortageSnapshot) without
+ * running eix or reading the package database. The package store, the
+ * merged package list, the facets and the search index are all read straight
+ * back from the mapped snapshot (see snapshotTables()), so nothing is
+ * decoded or worked out again.
+ *
+ * The eix output is kept, undecoded, for the details of the packages that
+ * are picked (see LoadGeneration::package()). It is only decoded as a whole
+ * if the eix data itself is needed, e.g. to follow an emerge.
+ *
+ * Returns false if there is no usable snapshot.
+ */
+bool ApplicationData::loadSnapshot()
+{
+    if (!_snapshot.map()) {
+        return false;
+    }
+
+    std::unique_ptr<PackageStore> store(new PackageStore);
+    const QByteArray tables = _snapshot.tables();
+    SnapshotImage image(tables.constData(), tables.size());
+    bool ok = store->restore(image) && combinedPackageList.restore(image) &&
+              _facetIndex.restore(image) && _searchIndex.restore(image) &&
+              image.atEnd();
+    ok = ok && _facetIndex.size() == store->size() &&
+         _searchIndex.entryCount() == store->size();
+    if (!ok) {
+        _snapshot.unmap();
+        qWarning() << "Snapshot could not be read, running eix";
+        _facetIndex.clear();
+        _searchIndex.clear();
+        startEixData();
+        return false;
+    }
+
+    // The mapping goes when the snapshot is next saved, so the eix output
+    // is copied
+    const QByteArray eixOutput = _snapshot.eixOutput();
+    _generation->setStream(QByteArray(eixOutput.constData(), eixOutput.size()));
+    _snapshot.unmap();
+
+    LoadGeneration *generation = _generation.get();
+    store->setDetailsSource(
+        [generation](int catNumber,
+                     int pkgNumber) -> const eix_proto::Package & {
+            return generation->package(catNumber, pkgNumber);
+        });
+    _store = std::move(store);
+    _storeStale = false;
+    _loadComplete = true;
+
+    emit eixRunning(true);
+
+    _repositoryIndex.load();
+    lastLoadTime = QDateTime::currentDateTime();
+    setupCategoryTreeModelData();
+
+    emit eixRunning(false);
+    return true;
+}
+
+/*!
+ * The tables that let the next run show the data on display without
+ * decoding or merging anything (see loadSnapshot()): the package store, the
+ * merged package list (with its installed versions and zombies), the facets
+ * and the search index, one after another.
+ */
+QByteArray ApplicationData::snapshotTables()
+{
+    updateStore();
+    SnapshotImage image;
+    _store->save(image);
+    combinedPackageList.save(image);
+    _facetIndex.save(image);
+    _searchIndex.save(image);
+    return image.bytes();
+}
+
+/*!
+ * Saves the snapshot being recorded, if there is one, with the tables for
+ * the data just loaded from it.
+ */
+void ApplicationData::saveSnapshot(const QStringList &packageDatabase)
+{
+    if (!_snapshot.isRecording()) {
+        return;
+    }
+    _snapshot.setPackageDatabase(packageDatabase);
+    _snapshot.setTables(snapshotTables());
+    _snapshot.save();
+}
+
+/*!
+ * Whether there is any data on display, without decoding the eix output
+ * kept from a snapshot (see eix()).
+ */
+bool ApplicationData::hasData() const
+{
+    return _generation->isDeferred() || _generation->eix().category_size() > 0;
+}
+
+/*!
+ * Shows just the installed packages, made from the package database rather
+ * than eix (see PackageMetadataTable). Only the package directories that
+ * have changed since the last load are read again, so this is also how the
+ * display follows an emerge in installed-only mode.
+ */
+void ApplicationData::loadInstalledData()
+{
+    emit eixRunning(true);
+
+    std::unique_ptr<LoadGeneration> installed(
+        new LoadGeneration(_generation->number() + 1));
+    QStringList packageDatabase = combinedPackageList.readPackageDatabase();
+    _installedTable.update(packageDatabase);
+    _installedTable.fillCollection(installed->eix());
+
+    // As for a refresh, the package list may still point into the old data
+    _previousGeneration = std::move(_generation);
+    _generation = std::move(installed);
+    lastLoadTime = QDateTime::currentDateTime();
+    _searchIndex.build(eix());
+    _filterCache.clear();
+
+    combinedPackageList.load(eix(), packageDatabase);
+    invalidateStore();
+    _loadComplete = true;
+    setupCategoryTreeModelData();
+
+    emit eixRunning(false);
+}
+
+/*!
+ * Reads the eix data again to bring an out of date snapshot up to date. If
+ * the eix database can be read directly (see readEixDatabase()), that is
+ * done straight away. Otherwise a full eix run is started in the background,
+ * and the data on display is left alone while it runs; see finishRefresh().
+ *
+ * shown:
+ *     Whether the run is signalled with eixRunning() like a full load, e.g.
+ *     for a reload the user asked for
+ */
+void ApplicationData::startRefresh(bool shown)
+{
+    _refreshShown = shown;
+    std::unique_ptr<LoadGeneration> refreshed(
+        new LoadGeneration(_generation->number() + 1));
+    _snapshot.startRecording();
+
+    const QStringList packageDatabase =
+        combinedPackageList.readPackageDatabase();
+    if (readEixDatabase(*refreshed, packageDatabase)) {
+        applyRefresh(std::move(refreshed), packageDatabase);
+        if (shown) {
+            emit eixRunning(false);
+        }
+        return;
+    }
+
+    _refreshGeneration = std::move(refreshed);
+    _eixParser.reset(&_refreshGeneration->eix(),
+                     lazyDecoding() ? &_refreshGeneration->lazyDecoder()
+                                    : nullptr);
+    startEix({"--proto"});
+}
+
+/*!
+ * Completes a background refresh once eix has finished (see
+ * applyRefresh()).
+ *
+ * ok:
+ *     Whether eix ran successfully
+ */
+void ApplicationData::finishRefresh(bool ok)
+{
+    std::unique_ptr<LoadGeneration> refreshed(std::move(_refreshGeneration));
+
+    if (ok) {
+        _eixParser.feed(readEixOutput());
+        ok = _eixParser.finish();
+    }
+    if (!ok) {
+        qWarning() << "Failed to refresh the portage data, showing snapshot";
+        _eixParser.reset(nullptr);
+        _snapshot.discard();
+        return;
+    }
+
+    applyRefresh(std::move(refreshed),
+                 combinedPackageList.readPackageDatabase());
+}
+
+/*!
+ * Shows the refreshed eix data. If it and the package database give exactly
+ * what the snapshot already had, only the snapshot's timestamps are
+ * updated. Otherwise the new data replaces the data on display.
+ */
+void ApplicationData::applyRefresh(std::unique_ptr<LoadGeneration> refreshed,
+                                   const QStringList &packageDatabase)
+{
+    _snapshot.setPackageDatabase(packageDatabase);
+    if (_snapshot.sameAsSaved()) {
+        // The tables on display are still the right ones
+        _eixParser.reset(nullptr);
+        _snapshot.setTables(snapshotTables());
+        _snapshot.save();
+        return;
+    }
+
+    // The package list points into the eix data on display until it has been
+    // updated from the new data, so that is kept for now
+    _previousGeneration = std::move(_generation);
+    _generation = std::move(refreshed);
+    lastLoadTime = QDateTime::currentDateTime();
+    finishLoad(packageDatabase);
+}
+
+/// Reads whatever eix has written so far, keeping a copy for the snapshot
+QByteArray ApplicationData::readEixOutput()
+{
+    QByteArray output = _eixProcess->readAllStandardOutput();
+    _snapshot.record(output);
+    return output;
+}
+
+/*!
+ * Adds the last 'count' categories of the eix data to the category tree,
+ * which is already on display.
+ */
+void ApplicationData::addStreamedCategories(int count)
+{
+    const int firstCategory = eix().category_size() - count;
+    filterPackages(firstCategory);
+
+    for (int catNumber = firstCategory; catNumber < eix().category_size();
+         ++catNumber) {
+        const auto &packages = _filteredPackages[catNumber];
+        if (!packages.empty()) {
+            categoryTreeModel.addCategory(
+                catNumber,
+                QString::fromStdString(eix().category(catNumber).category()),
+                static_cast<int>(packages.size()));
+        }
+    }
+}
+
+/*!
+ * Works out which packages pass the filters, for the eix categories from
+ * firstCategory on. The lists for earlier categories are kept.
+ *
+ * Once the eix data is complete, the packages are filtered by what the
+ * package store has for them, so the eix data isn't needed. A search only
+ * looks at the packages that the search index says contain the search text,
+ * and the results for the whole of the data are kept in _filterCache, so
+ * going back to a recent filter doesn't need any searching at all.
+ */
+void ApplicationData::filterPackages(int firstCategory)
+{
+    _layoutStale = true;
+
+    const bool complete = firstCategory == 0 && _loadComplete;
+    if (!complete) {
+        _filteredPackages.resize(eix().category_size());
+        for (int catNumber = firstCategory; catNumber < eix().category_size();
+             ++catNumber) {
+            _filteredPackages[catNumber] =
+                _filter.matchingPackages(eix().category(catNumber));
+        }
+        return;
+    }
+
+    _filterCache.setGeneration(_generation->number());
+    if (const auto *cached = _filterCache.find(_filter)) {
+        _filteredPackages = *cached;
+        return;
+    }
+
+    updateStore();
+    _filteredPackages.resize(_store->categoryCount());
+    for (auto &packages : _filteredPackages) {
+        packages.clear();
+    }
+    auto passes = [this](int catNumber, int pkgNumber) {
+        const int index = _store->index(catNumber, pkgNumber);
+        return _filter.matches(_store->category(index),
+                               _store->name(index),
+                               _store->description(index),
+                               _store->installed(index),
+                               _store->world(index));
+    };
+    if (!_filter.pattern().empty()) {
+        for (int entry : _searchIndex.find(_filter.pattern())) {
+            const int catNumber = _searchIndex.categoryNumber(entry);
+            const int pkgNumber = _searchIndex.packageNumber(entry);
+            if (passes(catNumber, pkgNumber)) {
+                _filteredPackages[catNumber].push_back(pkgNumber);
+            }
+        }
+    } else {
+        for (int catNumber = 0; catNumber < _store->categoryCount();
+             ++catNumber) {
+            auto &packages = _filteredPackages[catNumber];
+            for (int pkgNumber = 0; pkgNumber < _store->categorySize(catNumber);
+                 ++pkgNumber) {
+                if (passes(catNumber, pkgNumber)) {
+                    packages.push_back(pkgNumber);
+                }
+            }
+        }
+    }
+
+    _filterCache.insert(_filter, _filteredPackages);
+}
+
+/*!
+ * Narrows the packages that pass the filters to those with the chosen
+ * facets (see setFacets()). The packages that pass are made into a bitset
+ * over the package store, which is then ANDed with each facet's bitset; the
+ * result is kept in _facetRows for the facet counts, and the lists of
+ * packages are cut down to match.
+ *
+ * This needs the package store, so is only done once the eix data is
+ * complete.
+ */
+void ApplicationData::applyFacets()
+{
+    updateStore();
+    _facetRows.assign((_store->size() + 63) / 64, 0);
+    for (int catNumber = 0; catNumber < _store->categoryCount(); ++catNumber) {
+        for (int pkgNumber : _filteredPackages[catNumber]) {
+            FacetIndex::set(_facetRows, _store->index(catNumber, pkgNumber));
+        }
+    }
+    if (_facets.isEmpty()) {
+        return;
+    }
+
+    _facetIndex.narrow(_facets, _facetRows);
+    for (int catNumber = 0; catNumber < _store->categoryCount(); ++catNumber) {
+        auto &packages = _filteredPackages[catNumber];
+        const int begin = _store->index(catNumber, 0);
+        packages.erase(std::remove_if(packages.begin(),
+                                      packages.end(),
+                                      [&](int pkgNumber) {
+                                          return !FacetIndex::isSet(
+                                              _facetRows, begin + pkgNumber);
+                                      }),
+                       packages.end());
+    }
+}
+
+/*!
+ * Lays out the packages that pass the filters in one flat list, in category
+ * tree order, so that the packages under any node of the tree are a range of
+ * the list. Each node is given its range (see
+ * CategoryTreeItem::setPackageRange()), so showing a node, even "All" or a
+ * container like "dev", doesn't need to look at the tree or the packages.
+ *
+ * This is done once for each change to the tree or the filters, when the
+ * package list is next shown, which is straight after a load. The package
+ * store is brought up to date first, so that is when the packages' summaries
+ * are worked out (in parallel, see PackageStore::addCategories()).
+ */
+void ApplicationData::layOutPackages()
+{
+    updateStore();
+    _packageLayout.clear();
+    layOutCategory(categoryTreeModel.allItem());
+    _quickFilter.build(*_store, _packageLayout);
+    _layoutStale = false;
+}
+
+/*!
+ * Adds the packages of the given category tree node to the package layout,
+ * along with the packages of any child nodes.
  * Note that an example of a container category could be "dev", which
  * has sub-categories called "dev-lib", "dev-util", etc. The sub-categories
- * are not classed as containers, but they do have packages. All of the
- * packages under the given category (and any subcategories) are added to
- * the model.
+ * are not classed as containers, but they do have packages.
  */
-void ApplicationData::addCategory(CategoryTreeItem *catItem)
+void ApplicationData::layOutCategory(CategoryTreeItem *catItem)
 {
+    const int begin = _packageLayout.size();
     if (catItem->isContainer()) {
         // Recurse into child nodes
         for (int child = 0; child < catItem->childCount(); ++child) {
-            addCategory(catItem->child(child));
+            layOutCategory(catItem->child(child));
         }
-    } else {
-        const auto &cat = eix.category(catItem->categoryNumber());
-        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
-            VersionMap zombieList = combinedPackageList.zombieVersions(
-                cat.category(),
-                cat.package(pkgNumber).name());
-            packageReportModel.addPackage(cat.category(),
-                                          cat.package(pkgNumber),
-                                          zombieList);
+    } else if (catItem->categoryNumber() <
+               static_cast<int>(_filteredPackages.size())) {
+        // (The check is for a tree node that is about to be updated)
+        const int catNumber = catItem->categoryNumber();
+        for (int pkgNumber : _filteredPackages[catNumber]) {
+            _packageLayout.append(_store->index(catNumber, pkgNumber));
         }
     }
+    catItem->setPackageRange(begin, _packageLayout.size());
 }
 
 /*!
- * Loads all the data that has been parsed from the eix protobuf output
- * into the data model for the category tree.
+ * The name of an eix category, from the package store once the eix data is
+ * complete (so a snapshot's eix output doesn't have to be decoded for it).
+ * The store has to be up to date, see updateStore().
  */
-void ApplicationData::setupCategoryTreeModelData()
+QString ApplicationData::categoryName(int catNumber)
 {
-    // Decode the eix data
-    categoryTreeModel.startUpdate();
-    categoryTreeModel.clear();
+    if (!_loadComplete) {
+        return QString::fromStdString(eix().category(catNumber).category());
+    }
+    const std::string_view name = _store->categoryName(catNumber);
+    return QString::fromUtf8(name.data(), static_cast<qsizetype>(name.size()));
+}
 
-    for (int catNumber = 0; catNumber < eix.category_size(); ++catNumber) {
-        const auto &catRef = eix.category(catNumber);
-        QString categoryName = catRef.category().c_str();
-        categoryTreeModel.addCategory(catNumber,
-                                      categoryName,
-                                      catRef.package_size());
+/*!
+ * Brings the package store up to date with the eix data, adding any
+ * categories that have arrived since it was made and then sorting it again
+ * (see PackageStore::sortPackages()) and working out the facets of its
+ * packages (see FacetIndex). If the data has changed
+ * (see invalidateStore()) a new store is made, and the old one is kept
+ * until the package list no longer refers to it.
+ *
+ * A store read back from a snapshot already has everything, and the eix
+ * output kept with it isn't decoded.
+ */
+void ApplicationData::updateStore()
+{
+    if (!_storeStale && _generation->isDeferred()) {
+        return;
     }
+    if (_storeStale) {
+        if (!_previousStore) {
+            _previousStore = std::move(_store);
+        }
+        _store.reset(new PackageStore);
+        _storeStale = false;
+    }
+    if (_store->categoryCount() < eix().category_size()) {
+        _store->addCategories(eix(), combinedPackageList);
+        _store->sortPackages();
+        _facetIndex.build(*_store);
+    }
+}
 
-    categoryTreeModel.endUpdate();
+/// Marks the package store as out of date, e.g. after a reload
+void ApplicationData::invalidateStore()
+{
+    _storeStale = true;
+    _layoutStale = true;
+}
+
+/*!
+ * Loads all the data that has been parsed from the eix protobuf output
+ * into the data model for the category tree. Only the categories and
+ * packages that pass the filters and have the chosen facets are included.
+ * Once the eix data is complete, everything comes from the package store,
+ * and each category is given the number of its packages with each facet, by
+ * a popcount over its range of the store (see FacetIndex::count()); the
+ * containers add these up.
+ *
+ * The tree is updated in place (see CategoryTreeModel::updateCategories()),
+ * so only the categories that have changed since it was last set up are
+ * redrawn.
+ *
+ * notify:
+ *     Whether to signal that the category model is complete
+ */
+void ApplicationData::setupCategoryTreeModelData(bool notify)
+{
+    const bool complete = _loadComplete;
+    if (complete) {
+        updateStore();
+    }
+    filterPackages(0);
+    if (complete) {
+        applyFacets();
+    }
+
+    QVector<CategoryTreeModel::CategoryEntry> categories;
+    const int categoryCount = static_cast<int>(_filteredPackages.size());
+    for (int catNumber = 0; catNumber < categoryCount; ++catNumber) {
+        const auto &packages = _filteredPackages[catNumber];
+        if (!packages.empty()) {
+            FacetIndex::Counts counts{};
+            if (complete) {
+                const int begin = _store->index(catNumber, 0);
+                const int end = begin + _store->categorySize(catNumber);
+                counts = _facetIndex.count(
+                    _facetRows, begin, end, _facets.repository);
+            }
+            categories.append({static_cast<uint>(catNumber),
+                               categoryName(catNumber),
+                               packages.size(),
+                               counts});
+        }
+    }
+    categoryTreeModel.updateCategories(categories);
 
     // emit signal (for MainWindow updates)
-    emit categoryModelUpdated();
+    if (notify) {
+        emit categoryModelUpdated();
+    }
 }
 
 /*!
  * Loads the package model with packages from the given category item tree.
- * This can be a top level category, or a second level category.
+ * This can be a top level category, or a second level category. The packages
+ * are just the node's range of the package layout (see layOutPackages()),
+ * narrowed by the quick filter if there is one (see setQuickFilter()).
+ *
+ * The model is updated in place (see PackageReportModel::updatePackages()),
+ * so showing the same category again after a reload only redraws the
+ * packages that have changed.
  */
 void ApplicationData::setupPackageModelData(CategoryTreeItem *catItem)
+{
+    if (_layoutStale) {
+        layOutPackages();
+    }
+    const int begin = catItem->packageBegin();
+    const int end = catItem->packageEnd();
+    QVector<int> packages;
+    if (_quickFilterText.isEmpty()) {
+        packages = QVector<int>(_packageLayout.cbegin() + begin,
+                                _packageLayout.cbegin() + end);
+    } else {
+        _quickFilter.match(_quickFilterText, begin, end, _quickFilterRows);
+        for (int n = begin; n < end; ++n) {
+            if (QuickFilter::isSet(_quickFilterRows, n - begin)) {
+                packages.append(_packageLayout[n]);
+            }
+        }
+    }
+    packageReportModel.updatePackages(_store.get(), packages);
+
+    // Nothing refers to the data from before a refresh any more
+    _previousStore.reset();
+    _previousGeneration.reset();
+}
+
+/// Empties the package model, which has to be done before its eix data goes
+void ApplicationData::clearPackageModelData()
 {
     packageReportModel.startUpdate();
     packageReportModel.clear();
-
-    addCategory(catItem);
     packageReportModel.endUpdate();
+    _store->clear();
+    _storeStale = false;
+    _packageLayout.clear();
+    _quickFilter.clear();
+    _facetIndex.clear();
+    _facetRows.clear();
+    _layoutStale = true;
+    _previousStore.reset();
+    _previousGeneration.reset();
 }
 
 QString ApplicationData::findRepositoryPath(const QString &name) const
@@ -153,61 +811,115 @@ QString ApplicationData::findRepositoryPath(const QString &name) const
 }
 
 /*!
- * Runs "eix --proto" in a separate process
+ * Loads the full package tree from the eix database. The filters are applied
+ * afterwards, in memory (see applyFilters()).
+ *
+ * If the database can be read directly (see readEixDatabase()), it is, and
+ * the display is updated straight away. Otherwise "eix --proto" is run in a
+ * separate process.
+ *
+ * The 'proto' data is read from the process output as it is written, and
+ * each category is decoded, on another thread, and added to the category
+ * tree as soon as it has arrived (onEixOutput(), onCategoriesDecoded()).
+ * This does not wait for the command to complete; it signals onEixFinished()
+ * if the process runs and completes, or onEixError() if it failed to start.
  *
- * This uses eix to generate the 'proto' data into a temporary file. It does
- * not wait for the command to complete; it signals onEixFinished() if the
- * process runs and completes, or onEixError() if it failed to start.
+ * If eix succeeds, the rest of the eix data is loaded, the portage installed
+ * pkg database is read and merged in, and then the display is updated.
  *
- * If eix succeeds, the eix data is loaded, the portage installed pkg database
- * is read and merged in, and then the display is updated.
+ * If there is a snapshot of the last load, that is shown instead, straight
+ * away. If any of the files it was made from have changed, the eix data is
+ * then read again to refresh it (see startRefresh()).
+ *
+ * If there is already data on display, i.e. this is a reload, the eix data
+ * is read the same way as for a refresh, and only the rows that have changed
+ * are updated when it is done.
+ *
+ * From the first load on, the eix and package databases are watched, and the
+ * display follows any changes to them without another reload (see
+ * onEixDatabaseChanged() and onPackageDatabaseChanged()).
+ *
+ * In installed-only mode, or if eix isn't installed, the installed packages
+ * are read from the package database instead (see loadInstalledData()).
+ *
+ * Calling this while eix is still running stops it and starts again.
  */
 void ApplicationData::loadPortageData()
 {
-    // TODO: check the executable exists, if not then popup and terminate
-
-    emit eixRunning(true);
+    // A load that is already running is superseded by this one
+    cancelEix();
 
-    _repositoryIndex.load();
+    // Watching starts before anything is read, so no change is missed
+    if (!_watcher.isActive()) {
+        _watcher.start();
+    }
 
-    // Create the temporary file for the protobuf data. All we want is the
-    // name because its going to be written by the eix process, but to get
-    // that, it's necessary to open the temp file. It will be closed when
-    // eixOutput is destroyed.
-    _eixOutput = new QTemporaryFile();
-    _eixOutput->open();
+    // Without eix, the installed packages can still be shown
+    if (!installedOnly() && !QFileInfo::exists(eixApp)) {
+        qWarning() << eixApp << "not found, showing installed packages only";
+        setInstalledOnly(true);
+    }
+    if (installedOnly()) {
+        _repositoryIndex.load();
+        loadInstalledData();
+        return;
+    }
 
-    _eixProcess = new QProcess;
-    QStringList eix_params = {"--proto"};
+    // With data already on display, eix is run in the background and the
+    // display is updated in place when it is done, so that only what has
+    // changed is redrawn.
+    if (hasData()) {
+        emit eixRunning(true);
+        _repositoryIndex.load();
+        startRefresh(true);
+        return;
+    }
 
-    if (filters()) {
-        switch (selectionFilter()) {
+    // The package list points into the eix data, so it has to be emptied
+    // before the eix data is thrown away.
+    clearPackageModelData();
 
-        default:
-            break;
+    startEixData();
 
-        case SelectionFilter::All:
-            break;
+    if (loadSnapshot()) {
+        if (!_snapshot.isCurrent()) {
+            startRefresh();
+        }
+        return;
+    }
 
-        case SelectionFilter::Installed:
-            eix_params << "-I";
-            break;
+    emit eixRunning(true);
 
-        case SelectionFilter::World:
-            eix_params << "--world";
-            break;
-        }
+    _repositoryIndex.load();
 
-        if (!search().isEmpty()) {
-            // The searchbox validation only allows dashes, letters, digits. It
-            // does not allow dashes to be doubled. If the search text starts
-            // with "-", need to quote with "--" prefix
-            QString leader(search().startsWith("-") ? "--" : "");
-            eix_params << leader + search();
-        }
+    _snapshot.startRecording();
+    const QStringList packageDatabase =
+        combinedPackageList.readPackageDatabase();
+    if (readEixDatabase(*_generation, packageDatabase)) {
+        lastLoadTime = QDateTime::currentDateTime();
+        finishLoad(packageDatabase);
+        emit eixRunning(false);
+        return;
     }
+    startEix({"--proto"});
+}
 
-    _eixProcess->setStandardOutputFile(_eixOutput->fileName());
+/*!
+ * Starts the eix process. Its output and completion are handled by
+ * onEixOutput(), onEixFinished() and onEixError().
+ *
+ * Changes to the portage data are held back until eix is done, as the eix
+ * data can't be changed while it is being read in.
+ */
+void ApplicationData::startEix(const QStringList &eix_params)
+{
+    _watcher.hold();
+    _eixProcess = new QProcess;
+
+    connect(_eixProcess,
+            &QProcess::readyReadStandardOutput,
+            this,
+            &ApplicationData::onEixOutput);
 
     // These signals get triggered by either the process completing, or by not
     // starting. Docs are not really clear on this, but experimentally it seems
@@ -226,21 +938,122 @@ void ApplicationData::loadPortageData()
     _eixProcess->start(ApplicationData::eixApp, eix_params);
 }
 
+/*!
+ * Stops eix, if it is running, and throws away whatever it has written. A
+ * background refresh leaves the data on display alone; for a full load, the
+ * categories that had already arrived are dropped as well.
+ */
+void ApplicationData::cancelEix()
+{
+    if (_eixProcess == nullptr) {
+        return;
+    }
+
+    _eixProcess->disconnect(this);
+    _eixProcess->kill();
+    cleanupEixProcess(false);
+    _eixParser.reset(nullptr);
+    _snapshot.discard();
+
+    if (_refreshGeneration) {
+        _refreshGeneration.reset();
+    } else {
+        clearPackageModelData();
+        _generation->clear();
+        _loadComplete = false;
+    }
+}
+
+/*!
+ * Starts a new, empty, generation of eix data for the parser to fill in,
+ * and empties the category tree to match.
+ */
+void ApplicationData::startEixData()
+{
+    // Dropping the old generation frees all of the old eix data at once
+    _generation.reset(new LoadGeneration(_generation->number() + 1));
+    _eixParser.reset(&eix(),
+                     lazyDecoding() ? &_generation->lazyDecoder() : nullptr);
+    _searchIndex.clear();
+    _loadComplete = false;
+    setupCategoryTreeModelData(false);
+}
+
+/*!
+ * Reads the eix database straight into 'generation', with the installed
+ * versions marked from the package database entries, without running eix
+ * (see PortageEixReader). The protobuf form of the data is recorded for the
+ * snapshot, as eix's output would be.
+ *
+ * Returns false, leaving the generation empty, if eix has to be run instead:
+ * the database is in a format that can't be read here, or eix would apply
+ * local settings to it.
+ */
+bool ApplicationData::readEixDatabase(LoadGeneration &generation,
+                                      const QStringList &packageDatabase)
+{
+    PortageEixReader reader(
+        portageEixFile, portageConfigDir, worldFile, packageDatabaseRoot);
+    if (reader.hasLocalSettings()) {
+        return false;
+    }
+    if (!reader.read(generation.eix(), packageDatabase)) {
+        qWarning() << "Running eix, the eix database can't be read directly:"
+                   << reader.error();
+        return false;
+    }
+
+    if (_snapshot.isRecording()) {
+        _snapshot.record(
+            QByteArray::fromStdString(generation.eix().SerializeAsString()));
+    }
+    return true;
+}
+
 /*!
  * Called to cleanup after the eix process has completed.
  * For successful run, this happens after the data has been parsed.
  *
- * Emits a signal to let interested parties know the process is done.
+ * notify:
+ *     Whether to signal to let interested parties know the process is done.
+ *     Background refreshes don't signal.
  */
-void ApplicationData::cleanupEixProcess()
+void ApplicationData::cleanupEixProcess(bool notify)
 {
     delete _eixProcess;
     _eixProcess = nullptr;
+    _watcher.release();
 
-    delete _eixOutput;
-    _eixOutput = nullptr;
+    if (notify) {
+        emit eixRunning(false);
+    }
+}
 
-    emit eixRunning(false);
+/*!
+ * Called whenever eix has written some more output. Any categories that are
+ * now complete are decoded in the background (see onCategoriesDecoded()),
+ * and the ones already decoded are shown in the category tree straight
+ * away, unless this is a background refresh.
+ */
+void ApplicationData::onEixOutput()
+{
+    int count = _eixParser.feed(readEixOutput());
+    if (!_refreshGeneration) {
+        addStreamedCategories(count);
+    }
+}
+
+/*!
+ * Called when more categories have been decoded, in the background, from
+ * what eix has written. They are added to the eix data and, unless this is a
+ * background refresh, shown in the category tree straight away.
+ */
+void ApplicationData::onCategoriesDecoded()
+{
+    const int count = _eixParser.collect();
+    if (count > 0 && !_refreshGeneration) {
+        addStreamedCategories(count);
+    }
 }
 
 /*!
@@ -250,9 +1063,15 @@ void ApplicationData::cleanupEixProcess()
  */
 void ApplicationData::onEixFinished(int exitCode, QProcess::ExitStatus)
 {
+    if (_refreshGeneration) {
+        finishRefresh(exitCode == 0);
+        cleanupEixProcess(_refreshShown);
+        return;
+    }
+
     if (exitCode == 0) {
         lastLoadTime = QDateTime::currentDateTime();
-        parseEixData();
+        parseEixData(readEixOutput());
     } else {
         // Eix is reporting an error of some sort. It returns 1 if there is no
         // match, but don't know how specific that error code is. Going to treat
@@ -262,7 +1081,10 @@ void ApplicationData::onEixFinished(int exitCode, QProcess::ExitStatus)
 
         qCritical() << "Calling eix returned error code:" << exitCode;
 
-        eix.clear_category();
+        _snapshot.discard();
+        clearPackageModelData();
+        _generation->clear();
+        _loadComplete = false;
         setupCategoryTreeModelData();
     }
 
@@ -279,8 +1101,121 @@ void ApplicationData::onEixError(QProcess::ProcessError error)
     // eix is not installed.
     qCritical() << "Failed to run eix, error code:" << error;
 
-    eix.clear_category();
+    if (_refreshGeneration) {
+        finishRefresh(false);
+        cleanupEixProcess(_refreshShown);
+        return;
+    }
+
+    _snapshot.discard();
+    clearPackageModelData();
+    _generation->clear();
+    _loadComplete = false;
     setupCategoryTreeModelData();
 
     cleanupEixProcess();
 }
+
+/*!
+ * The eix database has been rewritten, e.g. by eix-update after a sync. The
+ * new data is read in the background, and the display is updated in place
+ * with whatever has changed. If there was no eix database to show before,
+ * e.g. eix-update had never been run, it is loaded now.
+ */
+void ApplicationData::onEixDatabaseChanged()
+{
+    if (installedOnly()) {
+        return;
+    }
+
+    // The load under way will see the change
+    if (_eixProcess != nullptr) {
+        return;
+    }
+    if (!hasData()) {
+        loadPortageData();
+        return;
+    }
+
+    startRefresh();
+}
+
+/*!
+ * Packages have been installed or removed in the given categories, e.g. by
+ * a running emerge. Only those categories of the package database are read
+ * again, and the display is updated in place; eix isn't run.
+ */
+void ApplicationData::onPackageDatabaseChanged(const QStringList &categories)
+{
+    if (installedOnly()) {
+        loadInstalledData();
+        return;
+    }
+    if (_eixProcess != nullptr || !hasData()) {
+        return;
+    }
+
+    QStringList packageDatabase =
+        combinedPackageList.readPackageDatabase(categories);
+    markInstalled(categories, packageDatabase);
+    combinedPackageList.reloadCategories(eix(), categories, packageDatabase);
+    invalidateStore();
+
+    // The installed and world filters may give something different now
+    _filterCache.clear();
+    setupCategoryTreeModelData();
+}
+
+/*!
+ * Brings the installed details of the eix data, for the given categories,
+ * into line with the package database, as eix itself would on its next run.
+ * A version that has just been installed is dated by its package directory.
+ *
+ * A package that changes is fully decoded first (see packageDetails()), as
+ * decoding it later would bring back the old details.
+ */
+void ApplicationData::markInstalled(const QStringList &categories,
+                                    const QStringList &packageDatabase)
+{
+    const QSet<QString> installed(packageDatabase.cbegin(),
+                                  packageDatabase.cend());
+    const QDir root(packageDatabaseRoot);
+
+    for (int catNumber = 0; catNumber < eix().category_size(); ++catNumber) {
+        auto *cat = eix().mutable_category(catNumber);
+        const QString categoryName = QString::fromStdString(cat->category());
+        if (!categories.contains(categoryName)) {
+            continue;
+        }
+
+        for (int pkgNumber = 0; pkgNumber < cat->package_size(); ++pkgNumber) {
+            auto *pkg = cat->mutable_package(pkgNumber);
+            const QString prefix =
+                categoryName + "/" + QString::fromStdString(pkg->name()) + "-";
+
+            auto isInstalled = [&](const eix_proto::Version &ver) {
+                return installed.contains(prefix +
+                                          QString::fromStdString(ver.id()));
+            };
+            if (std::all_of(pkg->version().begin(),
+                            pkg->version().end(),
+                            [&](const auto &ver) {
+                                return ver.has_installed() == isInstalled(ver);
+                            })) {
+                continue;
+            }
+
+            packageDetails(*pkg);
+            for (auto &ver : *pkg->mutable_version()) {
+                if (!isInstalled(ver)) {
+                    ver.clear_installed();
+                } else if (!ver.has_installed()) {
+                    QFileInfo versionDir(root.filePath(
+                        prefix + QString::fromStdString(ver.id())));
+                    ver.mutable_installed()->set_date(
+                        versionDir.lastModified().toSecsSinceEpoch());
+                }
+            }
+        }
+    }
+}
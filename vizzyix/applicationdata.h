@@ -6,13 +6,23 @@
 #include <QDateTime>
 #include <QObject>
 #include <QProcess>
-#include <QTemporaryFile>
 
 #include "categorytreemodel.h"
 #include "combinedpackagelist.h"
 #include "eix.pb.h"
+#include "eixstreamparser.h"
+#include "facetindex.h"
+#include "filtercache.h"
+#include "loadgeneration.h"
+#include "packagefilter.h"
+#include "packagemetadatatable.h"
 #include "packagereportmodel.h"
+#include "packagestore.h"
+#include "portagesnapshot.h"
+#include "portagewatcher.h"
+#include "quickfilter.h"
 #include "repositoryindex.h"
+#include "searchindex.h"
 
 class ApplicationData : public QObject
 {
@@ -25,7 +35,7 @@ class ApplicationData : public QObject
     static ApplicationData *data();
 
     /// Defines the main filter types
-    enum SelectionFilter { All, Installed, World };
+    typedef PackageFilter::Selection SelectionFilter;
 
     void setFilters(bool on);
     bool filters();
@@ -33,9 +43,23 @@ class ApplicationData : public QObject
     SelectionFilter selectionFilter();
     void setSearch(const QString &search = "");
     const QString search();
-
-    void parseEixData();
-    void setupCategoryTreeModelData();
+    void setSearchDescriptions(bool on);
+    bool searchDescriptions() const;
+    void applyFilters();
+    void setQuickFilter(const QString &text = "");
+    const QString quickFilter();
+    void setFacets(const FacetIndex::Selection &facets);
+    const FacetIndex::Selection &facets() const;
+    const QStringList &repositories() const;
+
+    eix_proto::Collection &eix();
+    const eix_proto::Package &packageDetails(const eix_proto::Package &pkg);
+    void setLazyDecoding(bool on);
+    bool lazyDecoding() const;
+    void setInstalledOnly(bool on);
+    bool installedOnly() const;
+    void parseEixData(const QByteArray &data);
+    void setupCategoryTreeModelData(bool notify = true);
     void setupPackageModelData(CategoryTreeItem *catItem);
     QString findRepositoryPath(const QString &name) const;
 
@@ -44,6 +68,8 @@ class ApplicationData : public QObject
     static constexpr auto emergeLogFile = "/var/log/emerge.log";
     static constexpr auto portageEixFile = "/var/cache/eix/portage.eix";
     static constexpr auto reposConfFile = "/etc/portage/repos.conf";
+    static constexpr auto portageConfigDir = "/etc/portage";
+    static constexpr auto worldFile = "/var/lib/portage/world";
     static constexpr auto packageDatabaseRoot = "/var/db/pkg";
     static constexpr auto defaultRepositoryName = "";
 
@@ -51,10 +77,6 @@ class ApplicationData : public QObject
     /// When the eix database was last loaded into memory
     QDateTime lastLoadTime;
 
-    /// The protobuf copy of the eix database.
-    /// This may be filtered, i.e. not contain the full list of packages
-    eix_proto::Collection eix;
-
     /// A list of all known packages, generated from the eix data
     /// and overlaid with the package database (installed packages)
     CombinedPackageList combinedPackageList{packageDatabaseRoot};
@@ -73,29 +95,142 @@ class ApplicationData : public QObject
     void loadPortageData();
 
   private:
-    void cleanupEixProcess();
-    void addCategory(CategoryTreeItem *catItem);
+    void startEixData();
+    bool readEixDatabase(LoadGeneration &generation,
+                         const QStringList &packageDatabase);
+    void finishLoad(const QStringList &packageDatabase);
+    void startEix(const QStringList &eix_params);
+    void cancelEix();
+    void cleanupEixProcess(bool notify = true);
+    bool loadSnapshot();
+    QByteArray snapshotTables();
+    void saveSnapshot(const QStringList &packageDatabase);
+    bool hasData() const;
+    void loadInstalledData();
+    void startRefresh(bool shown = false);
+    void finishRefresh(bool ok);
+    void applyRefresh(std::unique_ptr<LoadGeneration> refreshed,
+                      const QStringList &packageDatabase);
+    QByteArray readEixOutput();
+    void layOutPackages();
+    void layOutCategory(CategoryTreeItem *catItem);
+    QString categoryName(int catNumber);
+    void updateStore();
+    void invalidateStore();
+    void clearPackageModelData();
+    void addStreamedCategories(int count);
+    void filterPackages(int firstCategory);
+    void applyFacets();
+    void markInstalled(const QStringList &categories,
+                       const QStringList &packageDatabase);
 
   private slots:
+    void onEixOutput();
+    void onCategoriesDecoded();
     void onEixFinished(int exitCode, QProcess::ExitStatus);
     void onEixError(QProcess::ProcessError error);
+    void onEixDatabaseChanged();
+    void onPackageDatabaseChanged(const QStringList &categories);
 
   private:
+    /// The protobuf copy of the eix database, see eix().
+    /// Replaced as a whole each time the data is reloaded. When the data
+    /// comes from a snapshot, this just keeps the eix output until the eix
+    /// data is needed (see LoadGeneration::setStream()).
+    std::unique_ptr<LoadGeneration> _generation;
+
     /// Manages the list of known repositories and their locations
     RepositoryIndex _repositoryIndex;
 
-    /// The current search filter string
-    QString _search{""};
+    /// The top level filter and the search filter string
+    PackageFilter _filter;
+
+    /// For each eix category, the numbers of the packages that pass _filter
+    std::vector<std::vector<int>> _filteredPackages;
+
+    /// Finds the packages containing the search text, once eix has loaded
+    SearchIndex _searchIndex;
+
+    /// Whether all of the data has been loaded, so that the package store,
+    /// the search index and the facets are complete. Until then, while eix
+    /// is still streaming, the filters work on the eix data as it arrives.
+    bool _loadComplete{false};
+
+    /// The results of recent filters, for the eix data on display
+    FilterCache _filterCache;
 
-    /// The top level filter
-    SelectionFilter _selectionFilter{All};
+    /// Whether package details are only decoded when first needed
+    bool _lazyDecoding{true};
+
+    /// Whether only the installed packages are shown, without running eix
+    bool _installedOnly{false};
+
+    /// What the package database says about the installed packages, for
+    /// installed-only mode
+    PackageMetadataTable _installedTable{packageDatabaseRoot};
 
     /// The handle for the eix process
     QProcess *_eixProcess = nullptr;
 
-    /// Somewhere to catch the output from the eix process.
-    /// The content of the file is protobuf data.
-    QTemporaryFile *_eixOutput = nullptr;
+    /// Decodes the protobuf output from the eix process as it arrives
+    EixStreamParser _eixParser;
+
+    /// The data from the last full load, shown at startup
+    PortageSnapshot _snapshot{portageEixFile,
+                              emergeLogFile,
+                              packageDatabaseRoot};
+
+    /// Notices when the eix database or the package database change
+    PortageWatcher _watcher{portageEixFile, emergeLogFile, packageDatabaseRoot};
+
+    /// The new eix data while a background refresh is running, else null
+    std::unique_ptr<LoadGeneration> _refreshGeneration;
+
+    /// Whether the background refresh was started by a reload
+    bool _refreshShown{false};
+
+    /// The eix data from before a refresh, kept until the package list no
+    /// longer refers to it (see setupPackageModelData())
+    std::unique_ptr<LoadGeneration> _previousGeneration;
+
+    /// What the package list shows for each package, see updateStore()
+    std::unique_ptr<PackageStore> _store{new PackageStore};
+
+    /// The package store from before the data changed, kept (like
+    /// _previousGeneration) until the package list no longer refers to it
+    std::unique_ptr<PackageStore> _previousStore;
+
+    /// Whether the package store has to be made again
+    bool _storeStale{false};
+
+    /// The packages that pass the filters, as indexes into the package
+    /// store, laid out in category tree order so that the packages of each
+    /// tree node are a range (see layOutPackages())
+    QVector<int> _packageLayout;
+
+    /// Whether the package layout has to be made again
+    bool _layoutStale{true};
+
+    /// The names and descriptions of the packages in the package layout,
+    /// for the quick filter (see setQuickFilter())
+    QuickFilter _quickFilter;
+
+    /// The text the package list is narrowed to, if any
+    QString _quickFilterText;
+
+    /// Which packages of the package list pass the quick filter
+    std::vector<uint64_t> _quickFilterRows;
+
+    /// Which packages of the package store have each facet, made with the
+    /// store (see updateStore())
+    FacetIndex _facetIndex;
+
+    /// The facets the packages must have, see setFacets()
+    FacetIndex::Selection _facets;
+
+    /// The packages that pass the filters and the facets, as a bitset over
+    /// the package store (see applyFacets())
+    std::vector<uint64_t> _facetRows;
 
     /// The single instance of this class.
     /// The unique_ptr ensures the object is properly disposed.
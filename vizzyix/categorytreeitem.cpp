@@ -3,24 +3,38 @@
 
 #include "categorytreeitem.h"
 
+#include <QHash>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/*!
+ * The nodes of a tree, other than the root: blocks of nodes, filled in
+ * order, and the nodes that have been removed from the tree, to be reused.
+ * Also each node's children by name, see findChild().
+ */
+struct CategoryTreeItem::Arena {
+    /// How many nodes are allocated at a time
+    static constexpr int blockSize = 256;
+
+    /// The tree's root, which owns the arena
+    CategoryTreeItem *root = nullptr;
+
+    std::vector<std::unique_ptr<CategoryTreeItem[]>> blocks;
+    int blockUsed = blockSize;
+    std::vector<CategoryTreeItem *> freeItems;
+
+    /// (parent, name) -> child
+    QHash<std::pair<const CategoryTreeItem *, QString>, CategoryTreeItem *>
+        names;
+};
+
 /*!
  * Private constructor to ensure that the appropriate factory is used to create
  * new instances, thereby ensuring the parent field is always set correctly.
- *
- * Constructs an instance of the class. All field values are provided by the
- * matching parameters.
- *
- * data:
- *     The object's data. It's a vector of variant because that's what Qt uses
- *     for data models, so it's easier this way.
- *
- * parentItem:
- *    The parent of this object; this value is only null for a root node. The
- *    parent owns this object and is responsible for managing the lifetime.
+ * The fields are filled in when the node is added to a tree.
  */
-CategoryTreeItem::CategoryTreeItem(const QVector<QVariant> &data,
-                                   CategoryTreeItem *parentItem)
-    : _itemData(data), _parentItem(parentItem)
+CategoryTreeItem::CategoryTreeItem()
 {
 }
 
@@ -35,15 +49,24 @@ CategoryTreeItem::CategoryTreeItem(const QVector<QVariant> &data,
  */
 CategoryTreeItem *CategoryTreeItem::newRootItem(const QVector<QVariant> &data)
 {
-    return new CategoryTreeItem(data);
+    auto root = new CategoryTreeItem();
+    root->_arena = new Arena;
+    root->_arena->root = root;
+    root->setFields(data);
+    return root;
 }
 
 /*!
- * Destructor, releases all child items.
+ * Destructor. Only the root is ever deleted, which releases all the other
+ * items along with the arena.
  */
 CategoryTreeItem::~CategoryTreeItem()
 {
-    freeChildItems();
+    if (_arena && _arena->root == this) {
+        Arena *arena = _arena;
+        arena->root = nullptr;
+        delete arena;
+    }
 }
 
 /*!
@@ -57,8 +80,12 @@ CategoryTreeItem::~CategoryTreeItem()
  * each of it's children.
  */
 CategoryTreeItem::CategoryTreeItem(const CategoryTreeItem &other)
-    : _childItems(other._childItems), _itemData(other._itemData),
-      _parentItem(other._parentItem)
+    : _childItems(other._childItems), _name(other._name),
+      _packageCount(other._packageCount),
+      _categoryNumber(other._categoryNumber), _row(other._row),
+      _parentItem(other._parentItem), _arena(other._arena),
+      _packageBegin(other._packageBegin), _packageEnd(other._packageEnd),
+      _facetCounts(other._facetCounts)
 {
 }
 
@@ -97,18 +124,75 @@ CategoryTreeItem &CategoryTreeItem::operator=(CategoryTreeItem &)
  */
 CategoryTreeItem *CategoryTreeItem::appendChild(const QVector<QVariant> &data)
 {
-    auto newChild = new CategoryTreeItem(data, this);
-    _childItems.append(newChild);
+    return insertChild(_childItems.count(), data);
+}
+
+/*!
+ * A factory routine which creates a new child node at the given position.
+ * Adds a new child item with the given data to this object, before the
+ * child that is currently at that row.
+ *
+ * row:
+ *     Where the new child goes, 0 to childCount()
+ *
+ * data:
+ *     A list of variants providing the data for the new child
+ *
+ * Returns:
+ *     A pointer to the new child item
+ */
+CategoryTreeItem *CategoryTreeItem::insertChild(int row,
+                                                const QVector<QVariant> &data)
+{
+    auto newChild = newItem(data);
+    _childItems.insert(row, newChild);
+    renumberChildren(row, _childItems.count() - 1);
+    addName(newChild);
     return newChild;
 }
 
+/*!
+ * Deletes the child item at the given row, and all of its children.
+ *
+ * row:
+ *     The index of the child to be removed
+ */
+void CategoryTreeItem::removeChild(int row)
+{
+    if (row >= 0 && row < _childItems.count()) {
+        CategoryTreeItem *item = _childItems.takeAt(row);
+        removeName(item);
+        item->freeItem();
+        renumberChildren(row, _childItems.count() - 1);
+    }
+}
+
+/*!
+ * Moves a child item to another row. The children in between shift up or
+ * down by one.
+ *
+ * from:
+ *     The current row of the child
+ *
+ * to:
+ *     The row the child ends up at
+ */
+void CategoryTreeItem::moveChild(int from, int to)
+{
+    _childItems.move(from, to);
+    renumberChildren(qMin(from, to), qMax(from, to));
+}
+
 /*!
  * Frees all child nodes belonging to this object
  * All of the child items are deleted, and the list is emptied.
  */
 void CategoryTreeItem::freeChildItems()
 {
-    qDeleteAll(_childItems);
+    for (CategoryTreeItem *item : std::as_const(_childItems)) {
+        _arena->names.remove({this, item->_name});
+        item->freeItem();
+    }
     _childItems.clear();
 }
 
@@ -154,7 +238,7 @@ int CategoryTreeItem::childCount() const
  */
 int CategoryTreeItem::columnCount() const
 {
-    return _itemData.count();
+    return ColumnCount;
 }
 
 /*!
@@ -170,9 +254,16 @@ int CategoryTreeItem::columnCount() const
  */
 QVariant CategoryTreeItem::data(int column) const
 {
-    if (column < 0 || column >= _itemData.size())
+    switch (column) {
+    case Column::Name:
+        return _name;
+    case Column::PkgCount:
+        return _packageCount;
+    case Column::CatIndex:
+        return _categoryNumber;
+    default:
         return QVariant();
-    return _itemData.at(column);
+    }
 }
 
 /*!
@@ -187,25 +278,32 @@ QVariant CategoryTreeItem::data(int column) const
  */
 void CategoryTreeItem::setData(int column, const QVariant value)
 {
-    if (column >= 0 && column < _itemData.size()) {
-        _itemData[column] = value;
+    switch (column) {
+    case Column::Name:
+        setName(value.toString());
+        break;
+    case Column::PkgCount:
+        setPackageCount(value.toUInt());
+        break;
+    case Column::CatIndex:
+        setCategoryNumber(value.toInt());
+        break;
+    default:
+        break;
     }
 }
 
 /*!
  * Gets the object's row number within the parent.
- * The row number is the object's index in the parent's child list.
+ * The row number is the object's index in the parent's child list, which is
+ * kept up to date as children are added, removed and moved.
  *
  * Return:
  *     The row number
  */
 int CategoryTreeItem::row() const
 {
-    if (_parentItem)
-        return _parentItem->_childItems.indexOf(
-            const_cast<CategoryTreeItem *>(this));
-
-    return 0;
+    return _row;
 }
 
 /*!
@@ -221,10 +319,16 @@ CategoryTreeItem *CategoryTreeItem::parentItem() const
     return _parentItem;
 }
 
+/// Returns the name shown for this item, e.g. "dev" or "qt"
+const QString &CategoryTreeItem::name() const
+{
+    return _name;
+}
+
 /// Returns the number of packages owned by this item
 uint CategoryTreeItem::packageCount() const
 {
-    return data(CategoryTreeItem::Column::PkgCount).toInt();
+    return _packageCount;
 }
 
 /*!
@@ -235,7 +339,7 @@ uint CategoryTreeItem::packageCount() const
  */
 void CategoryTreeItem::setPackageCount(uint pkgCount)
 {
-    setData(CategoryTreeItem::Column::PkgCount, QVariant::fromValue(pkgCount));
+    _packageCount = pkgCount;
 }
 
 /*!
@@ -263,11 +367,66 @@ bool CategoryTreeItem::isContainer() const
  */
 int CategoryTreeItem::categoryNumber() const
 {
-    return data(Column::CatIndex).toInt();
+    return _categoryNumber;
+}
+
+/*!
+ * Sets the category number of this node, see categoryNumber().
+ *
+ * catNumber:
+ *     The index of the category in the eix data, or -1 for a container
+ */
+void CategoryTreeItem::setCategoryNumber(int catNumber)
+{
+    _categoryNumber = catNumber;
+}
+
+/*!
+ * Sets where this node's packages are in the package layout, i.e. the
+ * list of all the packages that pass the filters, laid out in tree order
+ * (see ApplicationData::layOutPackages()).
+ *
+ * begin, end:
+ *     The first package of the node, and the one after its last package
+ */
+void CategoryTreeItem::setPackageRange(int begin, int end)
+{
+    _packageBegin = begin;
+    _packageEnd = end;
+}
+
+/// Where this node's packages start in the package layout
+int CategoryTreeItem::packageBegin() const
+{
+    return _packageBegin;
+}
+
+/// Where this node's packages end in the package layout (one past the last)
+int CategoryTreeItem::packageEnd() const
+{
+    return _packageEnd;
+}
+
+/// How many of this node's packages have each facet, see FacetIndex
+const FacetIndex::Counts &CategoryTreeItem::facetCounts() const
+{
+    return _facetCounts;
+}
+
+/*!
+ * Sets how many of this node's packages have each facet.
+ *
+ * counts:
+ *     The counts, in FacetIndex::Facet order
+ */
+void CategoryTreeItem::setFacetCounts(const FacetIndex::Counts &counts)
+{
+    _facetCounts = counts;
 }
 
 /*!
  * Looks for the given name in child list and returns the child.
+ * If two children have the same name, this is the one added first.
  *
  * childName:
  *     The name to search for
@@ -277,11 +436,101 @@ int CategoryTreeItem::categoryNumber() const
  */
 CategoryTreeItem *CategoryTreeItem::findChild(const QString &childName) const
 {
-    QVariant required = childName;
-    for (int r = 0; r < childCount(); ++r) {
-        auto c = child(r);
-        if (c->data(Column::Name) == required)
-            return c;
+    return _arena->names.value({this, childName}, nullptr);
+}
+
+/*!
+ * Takes a node from the arena, reusing one that was removed from the tree
+ * if there is one, as a new child of this one. The caller puts it in the
+ * child list.
+ */
+CategoryTreeItem *CategoryTreeItem::newItem(const QVector<QVariant> &data)
+{
+    CategoryTreeItem *item;
+    if (!_arena->freeItems.empty()) {
+        item = _arena->freeItems.back();
+        _arena->freeItems.pop_back();
+    } else {
+        if (_arena->blockUsed == Arena::blockSize) {
+            _arena->blocks.emplace_back(new CategoryTreeItem[Arena::blockSize]);
+            _arena->blockUsed = 0;
+        }
+        item = &_arena->blocks.back()[_arena->blockUsed++];
+    }
+    item->_arena = _arena;
+    item->_parentItem = this;
+    item->setFields(data);
+    return item;
+}
+
+/*!
+ * Gives this node, and everything under it, back to the arena. It has
+ * already been taken out of its parent's child list.
+ */
+void CategoryTreeItem::freeItem()
+{
+    freeChildItems();
+    _childItems.squeeze();
+    _name.clear();
+    _parentItem = nullptr;
+    _packageBegin = 0;
+    _packageEnd = 0;
+    _facetCounts.fill(0);
+    _arena->freeItems.push_back(this);
+}
+
+/// Sets the column fields from a list of variants, see appendChild()
+void CategoryTreeItem::setFields(const QVector<QVariant> &data)
+{
+    _name = data.value(Column::Name).toString();
+    _packageCount = data.value(Column::PkgCount).toUInt();
+    _categoryNumber = data.value(Column::CatIndex).toInt();
+}
+
+/// Renames this node, keeping its parent's names up to date
+void CategoryTreeItem::setName(const QString &name)
+{
+    if (_parentItem) {
+        _parentItem->removeName(this);
+        _name = name;
+        _parentItem->addName(this);
+    } else {
+        _name = name;
+    }
+}
+
+/// Adds a child to the names, unless there already is one of the same name
+void CategoryTreeItem::addName(CategoryTreeItem *child)
+{
+    const std::pair<const CategoryTreeItem *, QString> key(this, child->_name);
+    if (!_arena->names.contains(key)) {
+        _arena->names.insert(key, child);
+    }
+}
+
+/*!
+ * Takes a child out of the names. If another child has the same name, that
+ * one can be found instead.
+ */
+void CategoryTreeItem::removeName(CategoryTreeItem *child)
+{
+    const std::pair<const CategoryTreeItem *, QString> key(this, child->_name);
+    if (_arena->names.value(key) != child) {
+        return;
+    }
+    _arena->names.remove(key);
+    for (CategoryTreeItem *other : std::as_const(_childItems)) {
+        if (other != child && other->_name == child->_name) {
+            _arena->names.insert(key, other);
+            break;
+        }
+    }
+}
+
+/// Brings the row numbers of the children from row from to row to up to date
+void CategoryTreeItem::renumberChildren(int from, int to)
+{
+    for (int row = from; row <= to; ++row) {
+        _childItems[row]->_row = row;
     }
-    return nullptr;
 }
@@ -3,9 +3,23 @@
 
 #pragma once
 
+#include <QString>
 #include <QVariant>
 #include <QVector>
 
+#include "facetindex.h"
+
+/*! class CategoryTreeItem
+ *
+ * A node of the category tree. The nodes of a tree are kept together in an
+ * arena owned by the root (see newRootItem()), a few hundred to a block, so
+ * building the tree is a handful of allocations and a node removed from the
+ * tree is reused for the next one added.
+ *
+ * Each node keeps its fields as they are, its row in its parent, and the
+ * arena keeps a hash of each node's children by name, so finding a node's
+ * row, parent or named child doesn't have to search.
+ */
 class CategoryTreeItem
 {
   public:
@@ -21,6 +35,9 @@ class CategoryTreeItem
 
   public:
     CategoryTreeItem *appendChild(const QVector<QVariant> &data);
+    CategoryTreeItem *insertChild(int row, const QVector<QVariant> &data);
+    void removeChild(int row);
+    void moveChild(int from, int to);
     void freeChildItems();
 
     CategoryTreeItem *child(int row) const;
@@ -31,29 +48,62 @@ class CategoryTreeItem
     int row() const;
     CategoryTreeItem *parentItem() const;
 
+    const QString &name() const;
     uint packageCount() const;
     void setPackageCount(uint pkgCount);
     bool isContainer() const;
     int categoryNumber() const;
+    void setCategoryNumber(int catNumber);
+    void setPackageRange(int begin, int end);
+    int packageBegin() const;
+    int packageEnd() const;
+    const FacetIndex::Counts &facetCounts() const;
+    void setFacetCounts(const FacetIndex::Counts &counts);
 
     CategoryTreeItem *findChild(const QString &childName) const;
 
     /// Enum for the column names
-    enum Column { Name, PkgCount, CatIndex };
+    enum Column { Name, PkgCount, CatIndex, ColumnCount };
 
   private:
+    struct Arena;
+
     // Hidden to disallow instances being be created on stack
-    explicit CategoryTreeItem(const QVector<QVariant> &data,
-                              CategoryTreeItem *parentItem = nullptr);
+    CategoryTreeItem();
 
+    CategoryTreeItem *newItem(const QVector<QVariant> &data);
+    void freeItem();
+    void setFields(const QVector<QVariant> &data);
+    void setName(const QString &name);
+    void addName(CategoryTreeItem *child);
+    void removeName(CategoryTreeItem *child);
+    void renumberChildren(int from, int to);
+
+  private:
     /// List of child nodes for this item
     QVector<CategoryTreeItem *> _childItems;
 
-    /// Data for each column
-    QVector<QVariant> _itemData;
+    /// The column data: the name shown, the number of packages, and the
+    /// eix category number (-1 for a container)
+    QString _name;
+    uint _packageCount{0};
+    int _categoryNumber{0};
+
+    /// This node's index in the parent's child list
+    int _row{0};
 
     /// Reference to the parent item - nullptr for root, or another
     /// CategoryTreeItem
     // TODO - parentItem should be const but there are complications with that
-    CategoryTreeItem *_parentItem;
+    CategoryTreeItem *_parentItem{nullptr};
+
+    /// Where the tree's nodes are kept, shared by all of them
+    Arena *_arena{nullptr};
+
+    /// The node's packages in the package layout, see setPackageRange()
+    int _packageBegin{0};
+    int _packageEnd{0};
+
+    /// How many of the node's packages have each facet
+    FacetIndex::Counts _facetCounts{};
 };
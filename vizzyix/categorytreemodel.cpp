@@ -4,7 +4,38 @@
 #include "categorytreemodel.h"
 
 #include <QDebug>
+#include <QHash>
+#include <QSet>
 #include <QtLogging>
+#include <utility>
+
+namespace
+{
+/// The column titles
+const char *const columnTitles[] = {
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Categories"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Pkgs"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Idx")};
+
+/// What the facets are called, in FacetIndex::Facet order
+const char *const facetTitles[] = {
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Installed"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "World"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "In a set"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "System"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Installed unstable"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Zombies"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "Updates"),
+    QT_TRANSLATE_NOOP("CategoryTreeModel", "In the repository")};
+
+/// Adds the facet counts of a category to a running total
+void addCounts(FacetIndex::Counts &total, const FacetIndex::Counts &counts)
+{
+    for (size_t facet = 0; facet < total.size(); ++facet) {
+        total[facet] += counts[facet];
+    }
+}
+} // namespace
 
 /*!
  * Creates the column titles and a top level node called "All".
@@ -14,8 +45,7 @@ CategoryTreeModel::CategoryTreeModel(QObject *)
     // The tree model always contains the root node (headers), and a child of
     // this which is the visible root of all the categories.
 
-    _rootItem = CategoryTreeItem::newRootItem(
-        {tr("Categories"), tr("Pkgs"), tr("Idx")});
+    _rootItem = CategoryTreeItem::newRootItem({tr("Categories"), 0, -1});
 
     _allItem = _rootItem->appendChild({tr("All"), 0, -1});
 }
@@ -30,19 +60,23 @@ CategoryTreeModel::~CategoryTreeModel()
 
 /*!
  * Given a model index and role, this returns the data for the associated
- * column. It only responds to DisplayRole, returning blanks otherwise.
+ * column. It only responds to DisplayRole, and to ToolTipRole with the
+ * node's facet counts (see facetToolTip()), returning blanks otherwise.
  */
 QVariant CategoryTreeModel::data(const QModelIndex &index, int role) const
 {
     if (!index.isValid())
         return QVariant();
 
-    if (role != Qt::DisplayRole)
-        return QVariant();
-
     const CategoryTreeItem *item =
         static_cast<CategoryTreeItem *>(index.internalPointer());
 
+    if (role == Qt::ToolTipRole)
+        return facetToolTip(item);
+
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
     return item->data(index.column());
 }
 
@@ -62,7 +96,7 @@ QVariant CategoryTreeModel::headerData(int section,
 {
     if (orientation == Qt::Horizontal && role == Qt::DisplayRole &&
         section >= 0 && section < columnCount()) {
-        return _rootItem->data(section);
+        return tr(columnTitles[section]);
     }
 
     return QVariant();
@@ -139,11 +173,13 @@ int CategoryTreeModel::columnCount(const QModelIndex &parent) const
 void CategoryTreeModel::startUpdate()
 {
     beginResetModel();
+    _resetting = true;
 }
 
 /// Reattach model after updating contents
 void CategoryTreeModel::endUpdate()
 {
+    _resetting = false;
     endResetModel();
 }
 
@@ -153,10 +189,151 @@ void CategoryTreeModel::endUpdate()
  * categoryName: - the name of the category, which by convention usually
  * contains one dash \param categorySize - number of packages in the category,
  * 1+
+ *
+ * This can be called between startUpdate() and endUpdate() to load the whole
+ * tree in one go, or on its own to add a category to a tree that is already
+ * on show, e.g. while the eix output is still arriving. In the second case the
+ * views are told about each new row and each changed package count.
  */
 void CategoryTreeModel::addCategory(const uint categoryIndex,
                                     const QString &categoryName,
                                     const size_t categorySize)
+{
+    QString part1;
+    QString part2;
+    bool splitName =
+        splitCategoryName(categoryIndex, categoryName, part1, part2);
+
+    if (!splitName) {
+        QVector<QVariant> node;
+        node << part1 << QVariant::fromValue(categorySize)
+             << QVariant::fromValue(categoryIndex);
+
+        (void)appendItem(_allItem, node);
+    } else {
+        CategoryTreeItem *top = _allItem->findChild(part1);
+        if (!top) {
+            QVector<QVariant> topNode;
+            topNode << part1 << 0 << -1;
+
+            top = appendItem(_allItem, topNode);
+        }
+
+        QVector<QVariant> node;
+        node << part2 << QVariant::fromValue(categorySize)
+             << QVariant::fromValue(categoryIndex);
+
+        (void)appendItem(top, node);
+        top->setPackageCount(top->packageCount() + categorySize);
+        packageCountChanged(top);
+    }
+    _allItem->setPackageCount(_allItem->packageCount() + categorySize);
+    packageCountChanged(_allItem);
+}
+
+/*!
+ * Brings the tree into line with the given list of eix categories, without
+ * a model reset. The nodes already in the tree are matched up with the new
+ * ones by name, and the views are only told about the rows that were
+ * removed, inserted or moved, and the package counts that changed. This
+ * keeps the selection, the expanded nodes and the scroll position.
+ *
+ * categories:
+ *     The categories to show, in order; see addCategory() for the fields
+ */
+void CategoryTreeModel::updateCategories(
+    const QVector<CategoryEntry> &categories)
+{
+    // Work out what the tree should look like, in one pass
+    QVector<TreeNode> nodes;
+    QHash<QString, int> containers;
+    size_t total = 0;
+    FacetIndex::Counts totalCounts{};
+    for (const CategoryEntry &category : categories) {
+        QString part1;
+        QString part2;
+        int categoryIndex = static_cast<int>(category.categoryIndex);
+        if (!splitCategoryName(
+                category.categoryIndex, category.categoryName, part1, part2)) {
+            nodes.append({part1,
+                          categoryIndex,
+                          category.categorySize,
+                          category.facetCounts,
+                          {}});
+        } else {
+            auto top = containers.constFind(part1);
+            if (top == containers.cend()) {
+                top = containers.insert(part1, nodes.size());
+                nodes.append({part1, -1, 0, {}, {}});
+            }
+            TreeNode &container = nodes[*top];
+            container.children.append({part2,
+                                       categoryIndex,
+                                       category.categorySize,
+                                       category.facetCounts,
+                                       {}});
+            container.packageCount += category.categorySize;
+            addCounts(container.facetCounts, category.facetCounts);
+        }
+        total += category.categorySize;
+        addCounts(totalCounts, category.facetCounts);
+    }
+
+    updateChildren(_allItem, nodes);
+
+    if (_allItem->packageCount() != total) {
+        _allItem->setPackageCount(static_cast<uint>(total));
+        packageCountChanged(_allItem);
+    }
+    if (_allItem->facetCounts() != totalCounts) {
+        _allItem->setFacetCounts(totalCounts);
+        facetCountsChanged(_allItem);
+    }
+}
+
+/// Clear the tree data - leave the root item (headers) and the "All" item
+void CategoryTreeModel::clear()
+{
+    _allItem->freeChildItems();
+    _allItem->setPackageCount(0);
+    _allItem->setFacetCounts({});
+}
+
+const CategoryTreeItem *CategoryTreeModel::allItem() const
+{
+    return _allItem;
+}
+
+CategoryTreeItem *CategoryTreeModel::allItem()
+{
+    return _allItem;
+}
+
+/// What a facet is called, e.g. for its count in the tooltips
+QString CategoryTreeModel::facetTitle(FacetIndex::Facet facet)
+{
+    return tr(facetTitles[facet]);
+}
+
+/*!
+ * Sets what the Repository facet is called in the tooltips, e.g. the name of
+ * the repository the package list is narrowed to. With no title, the
+ * Repository facet isn't shown.
+ */
+void CategoryTreeModel::setRepositoryTitle(const QString &title)
+{
+    _repositoryTitle = title;
+}
+
+/*!
+ * Splits an eix category name into the container name and the name within
+ * the container, e.g. "dev-qt" into "dev" and "qt". Returns false if there
+ * is no dash (e.g. "virtual"), when part1 is the whole name.
+ */
+bool CategoryTreeModel::splitCategoryName(uint categoryIndex,
+                                          const QString &categoryName,
+                                          QString &part1,
+                                          QString &part2) const
 {
     // There should be one or two parts to the name, i.e. one dash
     // Generally it's just "virtual" with one part.
@@ -165,8 +342,8 @@ void CategoryTreeModel::addCategory(const uint categoryIndex,
     int dashPos = categoryName.indexOf('-');
     bool splitName = (dashPos >= 0);
 
-    QString part1 = splitName ? categoryName.sliced(0, dashPos) : categoryName;
-    QString part2 = splitName ? categoryName.sliced(dashPos + 1) : "";
+    part1 = splitName ? categoryName.sliced(0, dashPos) : categoryName;
+    part2 = splitName ? categoryName.sliced(dashPos + 1) : "";
 
     if (categoryName == "")
         qWarning() << "(addCategory) blank category name at index"
@@ -184,39 +361,206 @@ void CategoryTreeModel::addCategory(const uint categoryIndex,
         }
     }
 
-    if (!splitName) {
-        QVector<QVariant> node;
-        node << part1 << QVariant::fromValue(categorySize)
-             << QVariant::fromValue(categoryIndex);
+    return splitName;
+}
 
-        (void)_allItem->appendChild(node);
-    } else {
-        CategoryTreeItem *top = _allItem->findChild(part1);
-        if (!top) {
-            QVector<QVariant> topNode;
-            topNode << part1 << 0 << -1;
+/// Makes a model index for the given tree item (invalid for the root)
+QModelIndex CategoryTreeModel::itemIndex(CategoryTreeItem *item,
+                                         int column) const
+{
+    if (item == _rootItem)
+        return QModelIndex();
+
+    return createIndex(item->row(), column, item);
+}
+
+/*!
+ * Appends a child to the given parent item. Outside of a reset, the views are
+ * told that a row is being inserted.
+ */
+CategoryTreeItem *CategoryTreeModel::appendItem(CategoryTreeItem *parentItem,
+                                                const QVector<QVariant> &data)
+{
+    return insertItem(parentItem, parentItem->childCount(), data);
+}
+
+/*!
+ * Inserts a child into the given parent item at the given row. Outside of a
+ * reset, the views are told that a row is being inserted.
+ */
+CategoryTreeItem *CategoryTreeModel::insertItem(CategoryTreeItem *parentItem,
+                                                int row,
+                                                const QVector<QVariant> &data)
+{
+    if (_resetting)
+        return parentItem->insertChild(row, data);
+
+    beginInsertRows(itemIndex(parentItem), row, row);
+    CategoryTreeItem *child = parentItem->insertChild(row, data);
+    endInsertRows();
+    return child;
+}
+
+/// Removes a child, and everything under it, telling the views
+void CategoryTreeModel::removeItem(CategoryTreeItem *parentItem, int row)
+{
+    if (_resetting) {
+        parentItem->removeChild(row);
+        return;
+    }
+
+    beginRemoveRows(itemIndex(parentItem), row, row);
+    parentItem->removeChild(row);
+    endRemoveRows();
+}
+
+/// Moves a child to another row of the same parent, telling the views
+void CategoryTreeModel::moveItem(CategoryTreeItem *parentItem, int from, int to)
+{
+    if (_resetting) {
+        parentItem->moveChild(from, to);
+        return;
+    }
+
+    // The views want the row the item goes in front of, before the move
+    QModelIndex parentIndex = itemIndex(parentItem);
+    beginMoveRows(
+        parentIndex, from, from, parentIndex, to > from ? to + 1 : to);
+    parentItem->moveChild(from, to);
+    endMoveRows();
+}
+
+/*!
+ * Makes the children of parentItem match the given nodes, in order. Children
+ * that match a node (same name, both containers or both categories) are
+ * kept and updated; the rest are removed, and any missing nodes inserted.
+ */
+void CategoryTreeModel::updateChildren(CategoryTreeItem *parentItem,
+                                       const QVector<TreeNode> &nodes)
+{
+    auto sameNode = [](const CategoryTreeItem *item, const TreeNode &node) {
+        return item->isContainer() == (node.categoryIndex < 0) &&
+               item->name() == node.name;
+    };
+
+    // The children that are no longer wanted
+    QSet<std::pair<QString, bool>> wanted;
+    wanted.reserve(nodes.size());
+    for (const TreeNode &node : nodes) {
+        wanted.insert({node.name, node.categoryIndex < 0});
+    }
+    for (int row = parentItem->childCount() - 1; row >= 0; --row) {
+        const CategoryTreeItem *item = parentItem->child(row);
+        if (!wanted.contains({item->name(), item->isContainer()})) {
+            removeItem(parentItem, row);
+        }
+    }
 
-            top = _allItem->appendChild(topNode);
+    for (int row = 0; row < nodes.size(); ++row) {
+        const TreeNode &node = nodes[row];
+
+        // Normally the child is already in the right place, or can be found
+        // by name; otherwise (a container and a category of the same name)
+        // look for it
+        int from = row;
+        const CategoryTreeItem *named = parentItem->findChild(node.name);
+        if (named && named->row() >= row && sameNode(named, node)) {
+            from = named->row();
+        }
+        while (from < parentItem->childCount() &&
+               !sameNode(parentItem->child(from), node)) {
+            ++from;
         }
 
-        QVector<QVariant> node;
-        node << part2 << QVariant::fromValue(categorySize)
-             << QVariant::fromValue(categoryIndex);
+        CategoryTreeItem *item;
+        if (from == parentItem->childCount()) {
+            QVector<QVariant> data;
+            data << node.name << QVariant::fromValue(node.packageCount)
+                 << node.categoryIndex;
+            item = insertItem(parentItem, row, data);
+        } else {
+            if (from != row) {
+                moveItem(parentItem, from, row);
+            }
+            item = parentItem->child(row);
+        }
+        updateItem(item, node);
+    }
 
-        (void)top->appendChild(node);
-        top->setPackageCount(top->packageCount() + categorySize);
+    // Only left if a name was repeated
+    while (parentItem->childCount() > nodes.size()) {
+        removeItem(parentItem, parentItem->childCount() - 1);
     }
-    _allItem->setPackageCount(_allItem->packageCount() + categorySize);
 }
 
-/// Clear the tree data - leave the root item (headers) and the "All" item
-void CategoryTreeModel::clear()
+/*!
+ * Updates the package count, category number and facet counts of an item,
+ * and the children of a container, telling the views about anything that
+ * changed.
+ */
+void CategoryTreeModel::updateItem(CategoryTreeItem *item, const TreeNode &node)
 {
-    _allItem->freeChildItems();
-    _allItem->setData(CategoryTreeItem::Column::PkgCount, 0);
+    if (item->packageCount() != node.packageCount ||
+        item->categoryNumber() != node.categoryIndex) {
+        item->setPackageCount(static_cast<uint>(node.packageCount));
+        item->setCategoryNumber(node.categoryIndex);
+        if (!_resetting) {
+            emit dataChanged(
+                itemIndex(item, CategoryTreeItem::Column::PkgCount),
+                itemIndex(item, CategoryTreeItem::Column::CatIndex),
+                {Qt::DisplayRole});
+        }
+    }
+
+    if (node.categoryIndex < 0) {
+        updateChildren(item, node.children);
+    }
+
+    if (item->facetCounts() != node.facetCounts) {
+        item->setFacetCounts(node.facetCounts);
+        facetCountsChanged(item);
+    }
 }
 
-const CategoryTreeItem *CategoryTreeModel::allItem() const
+/// Outside of a reset, tells the views the package count of item has changed
+void CategoryTreeModel::packageCountChanged(CategoryTreeItem *item)
 {
-    return _allItem;
+    if (_resetting)
+        return;
+
+    QModelIndex countIndex =
+        itemIndex(item, CategoryTreeItem::Column::PkgCount);
+    emit dataChanged(countIndex, countIndex, {Qt::DisplayRole});
+}
+
+/// Outside of a reset, tells the views the facet counts of item have changed
+void CategoryTreeModel::facetCountsChanged(CategoryTreeItem *item)
+{
+    if (_resetting)
+        return;
+
+    emit dataChanged(itemIndex(item, CategoryTreeItem::Column::Name),
+                     itemIndex(item, CategoryTreeItem::Column::CatIndex),
+                     {Qt::ToolTipRole});
+}
+
+/*!
+ * The tooltip for a node: how many of its packages have each facet, one
+ * facet to a line. The Repository facet is only shown if it has a title
+ * (see setRepositoryTitle()).
+ */
+QString CategoryTreeModel::facetToolTip(const CategoryTreeItem *item) const
+{
+    QStringList lines;
+    for (int facet = 0; facet < FacetIndex::Repository; ++facet) {
+        lines.append(tr("%1: %2")
+                         .arg(facetTitle(FacetIndex::Facet(facet)))
+                         .arg(item->facetCounts()[facet]));
+    }
+    if (!_repositoryTitle.isEmpty()) {
+        lines.append(tr("%1: %2")
+                         .arg(_repositoryTitle)
+                         .arg(item->facetCounts()[FacetIndex::Repository]));
+    }
+    return lines.join('\n');
 }
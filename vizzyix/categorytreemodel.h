@@ -11,6 +11,14 @@ class CategoryTreeModel : public QAbstractItemModel
 {
     Q_OBJECT
   public:
+    /// One eix category to be shown in the tree, see updateCategories()
+    struct CategoryEntry {
+        uint categoryIndex;
+        QString categoryName;
+        size_t categorySize;
+        FacetIndex::Counts facetCounts;
+    };
+
     explicit CategoryTreeModel(QObject *parent = nullptr);
     ~CategoryTreeModel();
 
@@ -31,11 +39,51 @@ class CategoryTreeModel : public QAbstractItemModel
     void addCategory(const uint categoryIndex,
                      const QString &categoryName,
                      const size_t categorySize);
+    void updateCategories(const QVector<CategoryEntry> &categories);
     void clear();
 
     const CategoryTreeItem *allItem() const;
+    CategoryTreeItem *allItem();
+
+    static QString facetTitle(FacetIndex::Facet facet);
+    void setRepositoryTitle(const QString &title);
+
+  private:
+    /// What a node of the tree should hold, see updateCategories()
+    struct TreeNode {
+        QString name;
+        int categoryIndex;
+        size_t packageCount;
+        FacetIndex::Counts facetCounts;
+        QVector<TreeNode> children;
+    };
+
+    bool splitCategoryName(uint categoryIndex,
+                           const QString &categoryName,
+                           QString &part1,
+                           QString &part2) const;
+    QModelIndex itemIndex(CategoryTreeItem *item, int column = 0) const;
+    CategoryTreeItem *appendItem(CategoryTreeItem *parentItem,
+                                 const QVector<QVariant> &data);
+    CategoryTreeItem *insertItem(CategoryTreeItem *parentItem,
+                                 int row,
+                                 const QVector<QVariant> &data);
+    void removeItem(CategoryTreeItem *parentItem, int row);
+    void moveItem(CategoryTreeItem *parentItem, int from, int to);
+    void updateChildren(CategoryTreeItem *parentItem,
+                        const QVector<TreeNode> &nodes);
+    void updateItem(CategoryTreeItem *item, const TreeNode &node);
+    void packageCountChanged(CategoryTreeItem *item);
+    void facetCountsChanged(CategoryTreeItem *item);
+    QString facetToolTip(const CategoryTreeItem *item) const;
 
   private:
     CategoryTreeItem *_rootItem;
     CategoryTreeItem *_allItem;
+
+    /// What the Repository facet's count is called, if it is counted
+    QString _repositoryTitle;
+
+    /// Set between startUpdate() and endUpdate(), when the views are detached
+    bool _resetting{false};
 };
@@ -3,17 +3,20 @@
 
 #include "combinedpackagelist.h"
 #include "combinedpackageinfo.h"
+#include "snapshotimage.h"
+#include "versionkey.h"
 
 #include <QDebug>
 #include <QDir>
 #include <QMap>
-#include <QRegularExpression>
+#include <algorithm>
+#include <string_view>
 
 #include "eix.pb.h"
 
 /// Constructor just saves the package directory
 CombinedPackageList::CombinedPackageList(const QString &pkgDir)
-    : _pkgDirectory(pkgDir)
+    : _pkgDirectory(pkgDir), _scanner(pkgDir)
 {
 }
 
@@ -23,41 +26,211 @@ CombinedPackageList::CombinedPackageList(const QString &pkgDir)
  * Builds a list of any that are installed but not in the eix data,
  * called zombies here.
  */
+void CombinedPackageList::load(const eix_proto::Collection &eix)
+{
+    load(eix, readPackageDatabase());
+}
+
+/*!
+ * As above, but with a list of the package database contents that has
+ * already been read (see readPackageDatabase()).
+ */
 void CombinedPackageList::load(const eix_proto::Collection &eix,
-                               const QString &searchText)
+                               const QStringList &packageDatabase)
 {
+    std::vector<VersionRecord> eixRecords;
+    std::vector<VersionRecord> pkgRecords;
     clear();
-    readEixData(eix);
-    readPortagePackageDatabase(searchText);
-    identifyZombies();
+    readEixData(eix, eixRecords);
+    addPackageDatabase(packageDatabase, pkgRecords);
+    build(eixRecords, pkgRecords);
+}
+
+/*!
+ * Lists the installed package directories in the portage package database,
+ * as "category/package-version", e.g. "dev-qt/qt-creator-12.4.3".
+ */
+QStringList CombinedPackageList::readPackageDatabase()
+{
+    return _scanner.scan();
+}
+
+/// As above, but just for the given categories, e.g. "dev-qt"
+QStringList
+CombinedPackageList::readPackageDatabase(const QStringList &categories)
+{
+    return _scanner.scan(categories);
+}
+
+/*!
+ * Replaces what is known about the given categories, e.g. after packages in
+ * them have been installed or removed. The eix data for the rest of the
+ * categories is not looked at again.
+ *
+ * packageDatabase:
+ *     The package database contents for those categories, see
+ *     readPackageDatabase()
+ */
+void CombinedPackageList::reloadCategories(const eix_proto::Collection &eix,
+                                           const QStringList &categories,
+                                           const QStringList &packageDatabase)
+{
+    std::vector<StringPool::Id> reloaded;
+    for (const auto &categoryName : categories) {
+        reloaded.push_back(_names.add(categoryName.toStdString()));
+    }
+
+    // Everything known about the other categories is kept as it is
+    std::vector<VersionRecord> eixRecords;
+    std::vector<VersionRecord> pkgRecords;
+    for (const auto &entry : _packages) {
+        if (std::find(reloaded.begin(), reloaded.end(), entry.category) ==
+            reloaded.end()) {
+            for (uint32_t i = 0; i < entry.versionCount; ++i) {
+                const auto &ver = _versions[entry.firstVersion + i];
+                const VersionRecord record{
+                    entry.category, entry.package, ver.key, ver.version};
+                if (ver.origin & EixData) {
+                    eixRecords.push_back(record);
+                }
+                if (ver.origin & PkgData) {
+                    pkgRecords.push_back(record);
+                }
+            }
+        }
+    }
+
+    for (const auto &cat : eix.category()) {
+        if (std::find(reloaded.begin(),
+                      reloaded.end(),
+                      _names.find(cat.category())) != reloaded.end()) {
+            readEixCategory(cat, eixRecords);
+        }
+    }
+    addPackageDatabase(packageDatabase, pkgRecords);
+    build(eixRecords, pkgRecords);
+}
+
+/*!
+ * Writes the merged lists to a snapshot: the names, the packages and their
+ * versions (with the databases each is in), the zombie version names and the
+ * hash table.
+ */
+void CombinedPackageList::save(SnapshotImage &image) const
+{
+    _names.save(image);
+    image.write(_packages);
+    image.write(_versions);
+    image.write(uint64_t(_zombieVersionNames.size()));
+    for (const auto &names : _zombieVersionNames) {
+        image.write(names);
+    }
+    image.write(_slots);
 }
 
 /*!
- * Checks the zombie list to see if this category/package is a zombie
- * TODO - surely zombies should have versions?
+ * Reads back the lists written by save(), replacing what was there, without
+ * merging anything again. Returns false, leaving the lists empty, if the
+ * image doesn't hold them all.
  */
+bool CombinedPackageList::restore(SnapshotImage &image)
+{
+    clear();
+    uint64_t zombies = 0;
+    bool ok = _names.restore(image) && image.read(_packages) &&
+              image.read(_versions) && image.read(zombies) &&
+              zombies <= _packages.size();
+    if (ok) {
+        _zombieVersionNames.resize(zombies);
+        for (auto &names : _zombieVersionNames) {
+            ok = ok && image.read(names);
+        }
+    }
+    ok = ok && image.read(_slots);
+
+    // Everything has to refer to something that is there
+    const auto names = static_cast<StringPool::Id>(_names.size());
+    for (const auto &entry : _packages) {
+        ok = ok && entry.category < names && entry.package < names &&
+             entry.firstVersion <= _versions.size() &&
+             entry.versionCount <= _versions.size() - entry.firstVersion &&
+             entry.zombie >= -1 && entry.zombie < static_cast<int>(zombies);
+    }
+    for (const auto &ver : _versions) {
+        ok = ok && ver.key < names && ver.version < names;
+    }
+    ok = ok && (_packages.empty() ||
+                (_slots.size() >= _packages.size() * 2 &&
+                 (_slots.size() & (_slots.size() - 1)) == 0));
+    for (uint32_t slot : _slots) {
+        ok = ok && slot <= _packages.size();
+    }
+    if (!ok) {
+        clear();
+    }
+    return ok;
+}
+
+/// Checks whether any version of this category/package is a zombie
 bool CombinedPackageList::isZombie(const std::string &categoryName,
                                    const std::string &packageName) const
 {
-    return _zombies.contains(
-        CategoryPackageName(QString::fromStdString(categoryName),
-                            QString::fromStdString(packageName)));
+    return zombieIndex(categoryName, packageName) >= 0;
+}
+
+/*!
+ * Returns the index of the package's zombie versions (see
+ * zombieVersionNames()), or -1 if it doesn't have any.
+ */
+int CombinedPackageList::zombieIndex(const std::string &categoryName,
+                                     const std::string &packageName) const
+{
+    const PackageEntry *entry = findPackage(categoryName, packageName);
+    return entry == nullptr ? -1 : entry->zombie;
+}
+
+/*!
+ * The names of the zombie versions of a package, in version order, from the
+ * index given by zombieIndex(). The list is made when the data is loaded,
+ * so copies of it share the data.
+ */
+const QStringList &CombinedPackageList::zombieVersionNames(int index) const
+{
+    return _zombieVersionNames[index];
 }
 
 /*!
- * Returns the version map (list of versions) for given category/package.
+ * Returns the version map (list of versions) of the zombie versions of the
+ * given category/package, with where they are in the package database.
  * This is empty if this is not a zombie.
  */
-VersionMap CombinedPackageList::zombieVersions(const std::string &categoryName,
-                                               const std::string &packageName)
+VersionMap
+CombinedPackageList::zombieVersions(const std::string &categoryName,
+                                    const std::string &packageName) const
 {
-    CategoryPackageName target(QString::fromStdString(categoryName),
-                               QString::fromStdString(packageName));
     VersionMap result;
 
-    auto lookup = _zombies.find(target);
-    if (lookup != _zombies.end()) {
-        return _packages[target];
+    const PackageEntry *entry = findPackage(categoryName, packageName);
+    if (entry == nullptr || entry->zombie < 0) {
+        return result;
+    }
+
+    const QString categoryPath = QString::fromStdString(categoryName) + "/" +
+                                 QString::fromStdString(packageName) + "-";
+    for (uint32_t i = 0; i < entry->versionCount; ++i) {
+        const auto &ver = _versions[entry->firstVersion + i];
+        if (ver.origin != PkgData) {
+            continue;
+        }
+        const std::string_view id = _names.str(ver.version);
+        const QString versionName =
+            QString::fromUtf8(id.data(), static_cast<qsizetype>(id.size()));
+
+        CombinedPackageInfo info(
+            versionName, _pkgDirectory.filePath(categoryPath + versionName));
+        info.setEixDb(false);
+        info.setPkgDb(true);
+        result.insert(versionName, info);
     }
     return result;
 }
@@ -66,17 +239,31 @@ VersionMap CombinedPackageList::zombieVersions(const std::string &categoryName,
 QStringList CombinedPackageList::zombieList() const
 {
     QStringList result;
-    foreach (auto pair, _zombies.values()) {
-        result.append(pair.first + "/" + pair.second);
+    for (const auto &entry : _packages) {
+        if (entry.zombie >= 0) {
+            std::string name(_names.str(entry.category));
+            name += '/';
+            name += _names.str(entry.package);
+            result.append(QString::fromStdString(name));
+        }
     }
     return result;
 }
 
+/// The number of packages with an installed version
+int CombinedPackageList::packageCount() const
+{
+    return static_cast<int>(_packages.size());
+}
+
 /// Empties the lists of packages and zombies
 void CombinedPackageList::clear()
 {
+    _names.clear();
     _packages.clear();
-    _zombies.clear();
+    _versions.clear();
+    _zombieVersionNames.clear();
+    _slots.clear();
 }
 
 /*!
@@ -86,61 +273,37 @@ void CombinedPackageList::clear()
  * list. The eix database gets updated when the application starts and whenever
  * search filter is changed
  */
-void CombinedPackageList::readEixData(const eix_proto::Collection &eix)
+void CombinedPackageList::readEixData(const eix_proto::Collection &eix,
+                                      std::vector<VersionRecord> &records)
 {
     for (int catNumber = 0; catNumber < eix.category_size(); ++catNumber) {
-        const auto &cat = eix.category(catNumber);
-
-        QString categoryName = QString::fromStdString(cat.category());
-
-        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
-            const auto &pkg = cat.package(pkgNumber);
+        readEixCategory(eix.category(catNumber), records);
+    }
+}
 
-            QString packageName = QString::fromStdString(pkg.name());
+/// Adds the installed packages of one eix category to the list
+void CombinedPackageList::readEixCategory(const eix_proto::Category &cat,
+                                          std::vector<VersionRecord> &records)
+{
+    StringPool::Id category = StringPool::npos;
 
-            // qDebug() << ">>>" << categoryName + "/" + packageName << "<<<";
+    for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
+        const auto &pkg = cat.package(pkgNumber);
+        StringPool::Id package = StringPool::npos;
 
-            for (int verNumber = 0; verNumber < pkg.version_size();
-                 ++verNumber) {
-                const auto &ver = pkg.version(verNumber);
+        for (int verNumber = 0; verNumber < pkg.version_size(); ++verNumber) {
+            const auto &ver = pkg.version(verNumber);
 
-                if (ver.has_installed()) {
-                    addVersion(categoryName,
-                               packageName,
-                               QString::fromStdString(ver.id()),
-                               DataOrigin::EixData);
+            if (ver.has_installed()) {
+                // Most packages aren't installed, so the names are only
+                // interned for the ones that are
+                if (category == StringPool::npos) {
+                    category = _names.add(cat.category());
                 }
-
-                // See what we have
-                /*
-                qDebug() << "   Version : " << ver.id();
-                qDebug() << "   Keywords: " << ver.keywords();
-                if (ver.has_keywords_effective()) {
-                    qDebug() << "   Effective Keywords: "
-                             << ver.keywords_effective().value();
+                if (package == StringPool::npos) {
+                    package = _names.add(pkg.name());
                 }
-                if (ver.has_local_mask_flags()) {
-                    qDebug()
-                        << "   Local Mask Flags: "
-                        << EixProtoHelper::toQString(ver.local_mask_flags());
-                }
-                if (ver.has_system_mask_flags()) {
-                    qDebug()
-                        << "   System Mask Flags: "
-                        << EixProtoHelper::toQString(ver.system_mask_flags());
-                }
-                if (ver.has_local_key_flags()) {
-                    qDebug()
-                        << "   Local Key Flags: "
-                        << EixProtoHelper::toQString(ver.local_key_flags());
-                }
-                if (ver.has_system_key_flags()) {
-                    qDebug()
-                        << "   System Key Flags: "
-                        << EixProtoHelper::toQString(ver.system_key_flags());
-                }
-                qDebug() << "   Depend" << ver.depend();
-                */
+                records.push_back(makeRecord(category, package, ver.id()));
             }
         }
     }
@@ -148,74 +311,59 @@ void CombinedPackageList::readEixData(const eix_proto::Collection &eix)
 
 /*!
  * This should be called whenever the EIX data has been read in.
- * It scans the package list for all the installed packages, and merges them
- * into the packages list.
- *
- * If there are search filters, just update existing entries.
- *
- * TODO - the filter thing is going to cause problems with zombies
- *      - if a cat/pack has been removed from portage, it's zombie will be
- *        ignored.
+ * It goes through the list of installed packages from the package database,
+ * and merges them into the packages list.
  */
-void CombinedPackageList::readPortagePackageDatabase(const QString &searchText)
+void CombinedPackageList::addPackageDatabase(
+    const QStringList &packageDatabase, std::vector<VersionRecord> &records)
 {
-    foreach (const auto categoryInfo,
-             _pkgDirectory.entryInfoList(QDir::NoDotAndDotDot | QDir::Dirs)) {
-
-        // e.g. /var/db/pkg/dev-qt
-
-        QDir categoryDir = categoryInfo.absoluteFilePath();
-
-        QString categoryName = categoryInfo.fileName();
-
-        foreach (const auto packageInfo,
-                 categoryDir.entryInfoList(QDir::NoDotAndDotDot | QDir::Dirs)) {
-
-            // Now extract just the 'base filename' of this directory from the
-            // path and then split this into package name and version. The name
-            // has one or more hyphens, dividing it into fields. The version is
-            // from the first field starting with a digit. So it should be easy,
-            // right?
-            // e.g. "qt-creator-12.4.3" -> ("qt-creator", "12.4.3")
-
-            QString filename = packageInfo.fileName();
-
-            int posver = filename.indexOf(QRegularExpression("\\-\\d"));
-            if (posver < 0) {
-                qCritical()
-                    << "CombinedPackageList::readPortagePackageDatabase:"
-                    << filename << "**** No version found";
-            } else {
-                QString packageName = filename.sliced(0, posver);
-                QString packageVersion = filename.sliced(posver + 1);
-
-                // The only filter need to check is the search text,
-                // the select all/installed/world don't affect pkgdb
-                // items:
-                //   - all : n/a, pkgdb are always installed
-                //   - installed : pkgdb by definition are installed
-                //   - world : pkgdb are installed and eix will set type
-                bool include =
-                    searchText.isEmpty() ||
-                    packageName.contains(searchText, Qt::CaseInsensitive);
-
-                if (include) {
-                    addVersion(categoryName,
-                               packageName,
-                               packageVersion,
-                               DataOrigin::PkgData,
-                               packageInfo.absoluteFilePath());
-                }
-            }
+    for (const auto &entry : packageDatabase) {
+        const std::string path = entry.toStdString();
+        const size_t slash = path.find('/');
+        if (slash == std::string::npos) {
+            continue;
+        }
+        const std::string_view categoryName(path.data(), slash);
+
+        // Now split the directory name into package name and version. The
+        // name may have fields that start with digits too, so the version
+        // has to be found from the end, as PMS defines it.
+        // e.g. "font-adobe-100dpi-1.0.4" -> ("font-adobe-100dpi", "1.0.4")
+
+        const std::string_view filename =
+            std::string_view(path).substr(slash + 1);
+        std::string_view packageName;
+        std::string_view version;
+
+        if (!PackageDatabaseScanner::splitPackageDir(
+                filename, packageName, version)) {
+            qCritical() << "CombinedPackageList::addPackageDatabase:"
+                        << entry << "**** No version found";
+        } else {
+            records.push_back(makeRecord(
+                _names.add(categoryName), _names.add(packageName), version));
         }
     }
 }
 
+/// Makes a record of a version, with its sort key
+CombinedPackageList::VersionRecord
+CombinedPackageList::makeRecord(StringPool::Id category,
+                                StringPool::Id package,
+                                std::string_view version)
+{
+    return {category,
+            package,
+            _names.add(VersionKey::key(version)),
+            _names.add(version)};
+}
+
 /*!
- * Create a list of zombie packages.
+ * Lays out the packages and their versions from the records of each
+ * database, and finds the zombies.
  *
- * An installed package is a zombie if it is present in the pkg database
- * but not known in the eix database.
+ * An installed package version is a zombie if it is present in the pkg
+ * database but not known in the eix database.
  *
  * One way this can happen if you've installed new packages but not run
  * eix-update.
@@ -233,55 +381,144 @@ void CombinedPackageList::readPortagePackageDatabase(const QString &searchText)
  *         -- ELSE eix won't say anything about it
  * This means it's an obsolete package (version) - this should
  * probably be uninstalled.
+ *
+ * Both lists of records are sorted, then merged in one pass: a version in
+ * both is added once, and one only in the pkg database is a zombie. They are
+ * sorted by the category and package ids, which only need to keep each
+ * package's versions together, and then by version key.
  */
-void CombinedPackageList::identifyZombies()
+void CombinedPackageList::build(std::vector<VersionRecord> &eixRecords,
+                                std::vector<VersionRecord> &pkgRecords)
 {
-    _zombies.clear();
-
-    foreach (auto &packageKey, _packages.keys()) {
-        auto versionList = _packages[packageKey];
+    const auto before = [this](const VersionRecord &a,
+                               const VersionRecord &b) {
+        if (a.category != b.category) {
+            return a.category < b.category;
+        }
+        if (a.package != b.package) {
+            return a.package < b.package;
+        }
+        return a.key != b.key && _names.str(a.key) < _names.str(b.key);
+    };
+    std::sort(eixRecords.begin(), eixRecords.end(), before);
+    std::sort(pkgRecords.begin(), pkgRecords.end(), before);
 
-        foreach (auto versionName, versionList.keys()) {
-            auto versionItem = versionList[versionName];
-            if (versionItem.inPkgDb() && !versionItem.inEixDb()) {
-                _zombies.insert(packageKey);
-            }
+    _packages.clear();
+    _versions.clear();
+    _zombieVersionNames.clear();
+    _versions.reserve(eixRecords.size() + pkgRecords.size());
+
+    auto eixRecord = eixRecords.cbegin();
+    auto pkgRecord = pkgRecords.cbegin();
+    const auto eixEnd = eixRecords.cend();
+    const auto pkgEnd = pkgRecords.cend();
+    while (eixRecord != eixEnd || pkgRecord != pkgEnd) {
+        if (pkgRecord == pkgEnd ||
+            (eixRecord != eixEnd && before(*eixRecord, *pkgRecord))) {
+            addVersion(*eixRecord++, EixData);
+        } else if (eixRecord == eixEnd || before(*pkgRecord, *eixRecord)) {
+            addVersion(*pkgRecord, PkgData);
+            addZombieVersion(pkgRecord++->version);
+        } else {
+            addVersion(*eixRecord++, EixData | PkgData);
+            ++pkgRecord;
         }
     }
+
+    makeSlots();
 }
 
 /*!
- * Adds a category/package/version to the version list. May also merge
- * into an existing entry.
+ * Adds a version to the end of _versions, and a package for it to the end
+ * of _packages if it is the first version of the package. The same version
+ * from the same database again (e.g. from two repositories, or written
+ * differently) is only added once.
  */
-void CombinedPackageList::addVersion(const QString &categoryName,
-                                     const QString &packageName,
-                                     const QString &versionName,
-                                     CombinedPackageList::DataOrigin origin,
-                                     const QString &packagePath)
+void CombinedPackageList::addVersion(const VersionRecord &record,
+                                     uint8_t origin)
 {
-    auto key = QPair<QString, QString>(categoryName, packageName);
+    if (_packages.empty() || _packages.back().category != record.category ||
+        _packages.back().package != record.package) {
+        _packages.push_back({record.category,
+                             record.package,
+                             static_cast<uint32_t>(_versions.size()),
+                             0,
+                             -1});
+    }
+    if (_packages.back().versionCount > 0 &&
+        _versions.back().key == record.key) {
+        _versions.back().origin |= origin;
+    } else {
+        _versions.push_back({record.key, record.version, origin});
+        ++_packages.back().versionCount;
+    }
+}
 
-    auto catpkg = _packages.find(key);
-    if (catpkg == _packages.end()) {
-        catpkg = _packages.insert(key, VersionMap());
+/// Adds a zombie version to the last package
+void CombinedPackageList::addZombieVersion(StringPool::Id version)
+{
+    PackageEntry &entry = _packages.back();
+    if (entry.zombie < 0) {
+        entry.zombie = static_cast<int>(_zombieVersionNames.size());
+        _zombieVersionNames.emplace_back();
     }
-    auto &versionList = catpkg.value();
-
-    auto versionItem = versionList.find(versionName);
-    if (versionItem == versionList.end()) {
-        versionItem =
-            versionList.insert(versionName,
-                               CombinedPackageInfo(versionName, packagePath));
-    } else if (!packagePath.isEmpty()) {
-        versionItem.value().setVersionDir(QDir(packagePath));
+
+    const std::string_view id = _names.str(version);
+    _zombieVersionNames[entry.zombie].append(
+        QString::fromUtf8(id.data(), static_cast<qsizetype>(id.size())));
+}
+
+/// Makes the hash table for finding the packages
+void CombinedPackageList::makeSlots()
+{
+    size_t slotCount = 1024;
+    while (slotCount < _packages.size() * 2) {
+        slotCount *= 2;
     }
-    switch (origin) {
-    case DataOrigin::EixData:
-        versionItem.value().setEixDb(true);
-        break;
-    case DataOrigin::PkgData:
-        versionItem.value().setPkgDb(true);
-        break;
+    _slots.assign(slotCount, 0);
+    const size_t mask = slotCount - 1;
+    for (uint32_t index = 0; index < _packages.size(); ++index) {
+        size_t slot =
+            packageHash(_packages[index].category, _packages[index].package) &
+            mask;
+        while (_slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        _slots[slot] = index + 1;
+    }
+}
+
+/// Finds a package from its names, or returns null if it isn't installed
+const CombinedPackageList::PackageEntry *
+CombinedPackageList::findPackage(const std::string &categoryName,
+                                 const std::string &packageName) const
+{
+    if (_packages.empty()) {
+        return nullptr;
+    }
+
+    const StringPool::Id category = _names.find(categoryName);
+    const StringPool::Id package = _names.find(packageName);
+    if (category == StringPool::npos || package == StringPool::npos) {
+        return nullptr;
     }
+
+    const size_t mask = _slots.size() - 1;
+    for (size_t slot = packageHash(category, package) & mask;
+         _slots[slot] != 0;
+         slot = (slot + 1) & mask) {
+        const PackageEntry &entry = _packages[_slots[slot] - 1];
+        if (entry.category == category && entry.package == package) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+/// Mixes the two ids, so that neighbouring ids are spread over the table
+size_t CombinedPackageList::packageHash(StringPool::Id category,
+                                        StringPool::Id package)
+{
+    const uint64_t key = uint64_t(category) << 32 | package;
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ull) >> 32);
 }
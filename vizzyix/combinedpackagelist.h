@@ -5,17 +5,42 @@
 
 #include <QDir>
 #include <QMap>
-#include <QPair>
-#include <QSet>
 #include <QString>
 #include <QStringList>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
 
 #include "combinedpackageinfo.h"
 #include "eix.pb.h"
+#include "packagedatabasescanner.h"
+#include "stringpool.h"
+
+class SnapshotImage;
 
-typedef QPair<QString, QString> CategoryPackageName;
 typedef QMap<QString, CombinedPackageInfo> VersionMap;
 
+/*! class CombinedPackageList
+ *
+ * The installed versions of each package, merged from the eix data and the
+ * package database, and the zombies: packages with a version in the package
+ * database that eix doesn't know is installed.
+ *
+ * The category, package and version names are interned (see StringPool) as
+ * they are read, and everything else works on the ids. The versions of all
+ * the packages are kept in one flat array.
+ *
+ * The versions from each database are sorted by their sort keys (see
+ * VersionKey), then merged in one pass, which also finds the zombie versions.
+ * So a package's versions are in version order, and versions are matched up
+ * by what they mean rather than how they are written. The names of each
+ * package's zombie versions are made then, once, for the display to share
+ * (see zombieIndex()).
+ *
+ * The merged lists can be saved to a snapshot and read back as they are
+ * (see save() and restore()), without the eix data or the package database.
+ */
 class CombinedPackageList
 {
   public:
@@ -24,42 +49,101 @@ class CombinedPackageList
     CombinedPackageList(const CombinedPackageList &) = delete;
     CombinedPackageList &operator=(CombinedPackageList &) = delete;
 
-    void load(const eix_proto::Collection &eix, const QString &searchText);
+    void load(const eix_proto::Collection &eix);
+    void load(const eix_proto::Collection &eix,
+              const QStringList &packageDatabase);
+    QStringList readPackageDatabase();
+    QStringList readPackageDatabase(const QStringList &categories);
+    void reloadCategories(const eix_proto::Collection &eix,
+                          const QStringList &categories,
+                          const QStringList &packageDatabase);
+    void save(SnapshotImage &image) const;
+    bool restore(SnapshotImage &image);
 
     bool isZombie(const std::string &categoryName,
                   const std::string &packageName) const;
+    int zombieIndex(const std::string &categoryName,
+                    const std::string &packageName) const;
+    const QStringList &zombieVersionNames(int index) const;
     VersionMap zombieVersions(const std::string &categoryName,
-                              const std::string &packageName);
+                              const std::string &packageName) const;
     QStringList zombieList() const;
+    int packageCount() const;
 
   private:
-    /// Type to identify where this entry comes from
-    enum DataOrigin { EixData, PkgData };
+    /// Type to identify where this entry comes from (bits, as a version may
+    /// be in both)
+    enum DataOrigin { EixData = 1, PkgData = 2 };
+
+    /// One version of a package, from one of the databases, while loading
+    struct VersionRecord {
+        StringPool::Id category;
+        StringPool::Id package;
+        StringPool::Id key;
+        StringPool::Id version;
+    };
+
+    /// A package, and where its versions are in _versions
+    struct PackageEntry {
+        StringPool::Id category;
+        StringPool::Id package;
+        uint32_t firstVersion;
+        uint32_t versionCount;
+
+        /// Index into _zombieVersionNames, or -1 if it isn't a zombie
+        int zombie;
+    };
+
+    /// A version of a package, and which databases it is in
+    struct VersionEntry {
+        StringPool::Id key;
+        StringPool::Id version;
+        uint8_t origin;
+    };
 
     void clear();
-    void readEixData(const eix_proto::Collection &eix);
-    void readPortagePackageDatabase(const QString &searchText);
-    void identifyZombies();
+    void readEixData(const eix_proto::Collection &eix,
+                     std::vector<VersionRecord> &records);
+    void readEixCategory(const eix_proto::Category &cat,
+                         std::vector<VersionRecord> &records);
+    void addPackageDatabase(const QStringList &packageDatabase,
+                            std::vector<VersionRecord> &records);
+    VersionRecord makeRecord(StringPool::Id category,
+                             StringPool::Id package,
+                             std::string_view version);
+    void build(std::vector<VersionRecord> &eixRecords,
+               std::vector<VersionRecord> &pkgRecords);
+    void addVersion(const VersionRecord &record, uint8_t origin);
+    void addZombieVersion(StringPool::Id version);
+    void makeSlots();
 
-    void addVersion(const QString &categoryName,
-                    const QString &packageName,
-                    const QString &versionName,
-                    DataOrigin origin,
-                    const QString &packagePath = QString());
+    const PackageEntry *findPackage(const std::string &categoryName,
+                                    const std::string &packageName) const;
+    static size_t packageHash(StringPool::Id category, StringPool::Id package);
 
   private:
     /// The root directory of the package database, i.e. /var/db/pkg
     const QDir _pkgDirectory;
 
-    /*!
-     * The key is the category + package name, e.g. "dev-qt" + "qt-creator".
-     * The value is a map of installed versions of the package
-     */
-    QMap<CategoryPackageName, VersionMap> _packages;
+    /// Reads the package database
+    PackageDatabaseScanner _scanner;
+
+    /// The category, package and version names and version keys, by id
+    StringPool _names;
+
+    /// The packages, sorted by category and package id
+    std::vector<PackageEntry> _packages;
+
+    /// The versions of all the packages, each package's together
+    std::vector<VersionEntry> _versions;
+
+    /// The names of the zombie versions of each zombie package
+    std::vector<QStringList> _zombieVersionNames;
 
     /*!
-     * Category and package name of each zombie.
-     * TODO - surely zombie's have version numbers!
+     * Finds a package from its category and package ids: an open addressing
+     * hash table of indexes into _packages, plus 1 (0 is an empty slot).
+     * The size is a power of two, and at most half the slots are used.
      */
-    QSet<CategoryPackageName> _zombies;
+    std::vector<uint32_t> _slots;
 };
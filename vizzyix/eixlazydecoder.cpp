@@ -0,0 +1,282 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "eixlazydecoder.h"
+
+#include <QDebug>
+#include <QtLogging>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "eix.pb.h"
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace
+{
+/// Whether the tag is for a length-delimited field with the given number
+bool isField(uint32_t tag, int fieldNumber)
+{
+    return WireFormatLite::GetTagFieldNumber(tag) == fieldNumber &&
+           WireFormatLite::GetTagWireType(tag) ==
+               WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+}
+} // namespace
+
+/// Constructor, starts empty
+EixLazyDecoder::EixLazyDecoder() : _locatedCategories(0)
+{
+}
+
+/// Forgets all of the categories
+void EixLazyDecoder::clear()
+{
+    _categories.clear();
+    _locations.clear();
+    _locatedCategories = 0;
+}
+
+/*!
+ * Decodes the summary fields of the category from its protobuf bytes, and
+ * copies the bytes into 'source' for decoding package details later on
+ * (see setSource()).
+ *
+ * This doesn't touch any decoder, so it may be called from several threads
+ * at once.
+ *
+ * Returns false if the data can't be decoded.
+ */
+bool EixLazyDecoder::decodeSummary(int catNumber,
+                                   eix_proto::Category *category,
+                                   const uint8_t *data,
+                                   int length,
+                                   CategorySource &source)
+{
+    source.bytes = QByteArray(reinterpret_cast<const char *>(data), length);
+    source.packages.clear();
+
+    const auto *bytes =
+        reinterpret_cast<const uint8_t *>(source.bytes.constData());
+    CodedInputStream input(bytes, length);
+
+    category->Clear();
+
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        if (isField(tag, eix_proto::Category::kCategoryFieldNumber)) {
+            if (!WireFormatLite::ReadString(&input,
+                                            category->mutable_category())) {
+                return false;
+            }
+        } else if (isField(tag, eix_proto::Category::kPackageFieldNumber)) {
+            int pkgLength;
+            if (!input.ReadVarintSizeAsInt(&pkgLength)) {
+                return false;
+            }
+            int start = input.CurrentPosition();
+            auto limit = input.PushLimit(pkgLength);
+
+            eix_proto::Package *pkg = category->add_package();
+            if (!decodePackageSummary(input, pkg)) {
+                return false;
+            }
+            input.PopLimit(limit);
+
+            source.packages.push_back({pkg, catNumber, start, pkgLength, false});
+        } else if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+
+    return input.ConsumedEntireMessage();
+}
+
+/*!
+ * Keeps the source of a category, from decodeSummary(), so that its
+ * packages can be fully decoded later on. Any source the category already
+ * had is replaced.
+ */
+void EixLazyDecoder::setSource(int catNumber, CategorySource &&source)
+{
+    if (catNumber < _locatedCategories) {
+        // Simplest to start the lookup table again
+        _locations.clear();
+        _locatedCategories = 0;
+    }
+    if (catNumber >= static_cast<int>(_categories.size())) {
+        _categories.resize(catNumber + 1);
+    }
+    _categories[catNumber] = std::move(source);
+}
+
+/*!
+ * Whether the package has only been partly decoded. Packages that this
+ * decoder doesn't know about are assumed to be complete.
+ */
+bool EixLazyDecoder::isSummary(const eix_proto::Package &pkg)
+{
+    PackageSource *source = findSource(pkg);
+    return source != nullptr && !source->decoded;
+}
+
+/*!
+ * Makes sure the package is fully decoded, and returns it. The package
+ * object is filled in where it is, so references to it stay good.
+ */
+const eix_proto::Package &EixLazyDecoder::details(const eix_proto::Package &pkg)
+{
+    PackageSource *source = findSource(pkg);
+    if (source != nullptr && !source->decoded) {
+        const QByteArray &bytes = _categories[source->catNumber].bytes;
+
+        if (!source->package->ParseFromArray(bytes.constData() + source->start,
+                                             source->length)) {
+            qWarning() << "Failed to decode details for package"
+                       << pkg.name().c_str();
+        }
+        source->decoded = true;
+    }
+    return pkg;
+}
+
+/// The number of bytes of raw eix data being kept for later
+qsizetype EixLazyDecoder::retainedBytes() const
+{
+    qsizetype total = 0;
+    for (const auto &category : _categories) {
+        total += category.bytes.size();
+    }
+    return total;
+}
+
+/*!
+ * Decodes the fields of a package that are needed for the package list.
+ * The input is limited to the package's bytes.
+ */
+bool EixLazyDecoder::decodePackageSummary(CodedInputStream &input,
+                                          eix_proto::Package *pkg)
+{
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        if (isField(tag, eix_proto::Package::kNameFieldNumber)) {
+            if (!WireFormatLite::ReadString(&input, pkg->mutable_name())) {
+                return false;
+            }
+        } else if (isField(tag, eix_proto::Package::kDescriptionFieldNumber)) {
+            if (!WireFormatLite::ReadString(&input,
+                                            pkg->mutable_description())) {
+                return false;
+            }
+        } else if (isField(tag, eix_proto::Package::kVersionFieldNumber)) {
+            int verLength;
+            if (!input.ReadVarintSizeAsInt(&verLength)) {
+                return false;
+            }
+            auto limit = input.PushLimit(verLength);
+            if (!decodeVersionSummary(input, pkg->add_version())) {
+                return false;
+            }
+            input.PopLimit(limit);
+        } else if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+    return input.ConsumedEntireMessage();
+}
+
+/*!
+ * Decodes the fields of a version that are needed for the package list: the
+ * id, whether (and when) it is installed, the mask and key flags used to
+ * work out the install type and stability, and the repository (for the
+ * facets, see FacetIndex).
+ */
+bool EixLazyDecoder::decodeVersionSummary(CodedInputStream &input,
+                                          eix_proto::Version *ver)
+{
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        bool ok;
+        if (isField(tag, eix_proto::Version::kIdFieldNumber)) {
+            ok = WireFormatLite::ReadString(&input, ver->mutable_id());
+        } else if (isField(tag, eix_proto::Version::kInstalledFieldNumber)) {
+            int length;
+            ok = input.ReadVarintSizeAsInt(&length);
+            if (ok) {
+                auto limit = input.PushLimit(length);
+                ok = decodeInstalledSummary(input, ver->mutable_installed());
+                input.PopLimit(limit);
+            }
+        } else if (isField(tag,
+                           eix_proto::Version::kRepositoryFieldNumber)) {
+            ok = WireFormatLite::ReadMessage(&input,
+                                             ver->mutable_repository());
+        } else if (isField(tag,
+                           eix_proto::Version::kLocalMaskFlagsFieldNumber)) {
+            ok = WireFormatLite::ReadMessage(&input,
+                                             ver->mutable_local_mask_flags());
+        } else if (isField(tag,
+                           eix_proto::Version::kSystemMaskFlagsFieldNumber)) {
+            ok = WireFormatLite::ReadMessage(&input,
+                                             ver->mutable_system_mask_flags());
+        } else if (isField(tag,
+                           eix_proto::Version::kLocalKeyFlagsFieldNumber)) {
+            ok = WireFormatLite::ReadMessage(&input,
+                                             ver->mutable_local_key_flags());
+        } else if (isField(tag,
+                           eix_proto::Version::kSystemKeyFlagsFieldNumber)) {
+            ok = WireFormatLite::ReadMessage(&input,
+                                             ver->mutable_system_key_flags());
+        } else {
+            ok = WireFormatLite::SkipField(&input, tag);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return input.ConsumedEntireMessage();
+}
+
+/// Only the install date is needed, the USE flags are left for later
+bool EixLazyDecoder::decodeInstalledSummary(CodedInputStream &input,
+                                            eix_proto::Installed *installed)
+{
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        if (tag == WireFormatLite::MakeTag(
+                       eix_proto::Installed::kDateFieldNumber,
+                       WireFormatLite::WIRETYPE_VARINT)) {
+            uint64_t date;
+            if (!input.ReadVarint64(&date)) {
+                return false;
+            }
+            installed->set_date(static_cast<int64_t>(date));
+        } else if (!WireFormatLite::SkipField(&input, tag)) {
+            return false;
+        }
+    }
+    return input.ConsumedEntireMessage();
+}
+
+/*!
+ * Looks up where the package came from. Categories decoded since the last
+ * lookup are added to the table first.
+ */
+EixLazyDecoder::PackageSource *
+EixLazyDecoder::findSource(const eix_proto::Package &pkg)
+{
+    const int categoryCount = static_cast<int>(_categories.size());
+    for (; _locatedCategories < categoryCount; ++_locatedCategories) {
+        auto &packages = _categories[_locatedCategories].packages;
+        for (int pkgNumber = 0; pkgNumber < static_cast<int>(packages.size());
+             ++pkgNumber) {
+            _locations.insert(packages[pkgNumber].package,
+                              qMakePair(_locatedCategories, pkgNumber));
+        }
+    }
+
+    const QPair<int, int> location = _locations.value(&pkg, qMakePair(-1, -1));
+    if (location.first < 0) {
+        return nullptr;
+    }
+    return &_categories[location.first].packages[location.second];
+}
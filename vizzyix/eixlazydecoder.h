@@ -0,0 +1,79 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <google/protobuf/io/coded_stream.h>
+#include <vector>
+
+#include "eix.pb.h"
+
+/*! class EixLazyDecoder
+ *
+ * Decodes eix categories in two stages.
+ *
+ * To begin with, only the fields needed for the category tree and the package
+ * list are decoded: package names and descriptions, and the version ids,
+ * install details and mask/key flags. Everything else (homepage, licenses, USE
+ * flags, keywords, dependencies, ...) is left in the raw protobuf bytes,
+ * which are kept. A package is fully decoded, in place, the first time its
+ * details are asked for.
+ */
+class EixLazyDecoder
+{
+  public:
+    EixLazyDecoder();
+
+    EixLazyDecoder(const EixLazyDecoder &) = delete;
+    EixLazyDecoder &operator=(EixLazyDecoder &) = delete;
+
+    /// Where a package's full data is, within its category's bytes
+    struct PackageSource {
+        eix_proto::Package *package;
+        int catNumber;
+        int start;
+        int length;
+        bool decoded;
+    };
+
+    /// The raw bytes of a category and the location of each of its packages
+    struct CategorySource {
+        QByteArray bytes;
+        std::vector<PackageSource> packages;
+    };
+
+    void clear();
+    static bool decodeSummary(int catNumber,
+                              eix_proto::Category *category,
+                              const uint8_t *data,
+                              int length,
+                              CategorySource &source);
+    void setSource(int catNumber, CategorySource &&source);
+    bool isSummary(const eix_proto::Package &pkg);
+    const eix_proto::Package &details(const eix_proto::Package &pkg);
+    qsizetype retainedBytes() const;
+
+  private:
+    static bool
+    decodePackageSummary(google::protobuf::io::CodedInputStream &input,
+                         eix_proto::Package *pkg);
+    static bool
+    decodeVersionSummary(google::protobuf::io::CodedInputStream &input,
+                         eix_proto::Version *ver);
+    static bool decodeInstalledSummary(
+        google::protobuf::io::CodedInputStream &input,
+        eix_proto::Installed *installed);
+    PackageSource *findSource(const eix_proto::Package &pkg);
+
+  private:
+    /// One entry per category, in eix order
+    std::vector<CategorySource> _categories;
+
+    /// Finds the source of a package from the package object
+    QHash<const eix_proto::Package *, QPair<int, int>> _locations;
+
+    /// The number of categories that have been added to _locations
+    int _locatedCategories;
+};
@@ -0,0 +1,293 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "eixstreamparser.h"
+
+#include <QDebug>
+#include <QtLogging>
+#include <atomic>
+#include <climits>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "eix.pb.h"
+#include "eixlazydecoder.h"
+
+using google::protobuf::internal::WireFormatLite;
+
+/// Constructor, the collection can also be given later with reset()
+EixStreamParser::EixStreamParser(eix_proto::Collection *eix)
+    : _eix(eix), _lazy(nullptr), _failed(false),
+      _nextNumber(eix != nullptr ? eix->category_size() : 0), _collected(0),
+      _notified(false)
+{
+}
+
+/// Destructor waits for any categories still being decoded
+EixStreamParser::~EixStreamParser()
+{
+    discard();
+}
+
+/*!
+ * Starts a new stream. Any partial data from the previous stream is thrown
+ * away, along with any of its categories still being decoded, and decoded
+ * categories will be added to the given collection.
+ *
+ * With a lazy decoder, only the category summaries are decoded.
+ */
+void EixStreamParser::reset(eix_proto::Collection *eix, EixLazyDecoder *lazy)
+{
+    discard();
+    _eix = eix;
+    _lazy = lazy;
+    _pending.clear();
+    _failed = false;
+    _nextNumber = eix != nullptr ? eix->category_size() : 0;
+}
+
+/*!
+ * Finds the complete categories in the data received so far and starts
+ * decoding them in the background. Only the unfinished tail is kept for the
+ * next call; the categories are decoded straight from the receive buffer.
+ *
+ * Returns the number of categories added to the collection by this call,
+ * as for collect(). The categories from this call are usually still being
+ * decoded, and are added by a later call.
+ */
+int EixStreamParser::feed(const QByteArray &data)
+{
+    if (_failed || _eix == nullptr) {
+        return 0;
+    }
+
+    // Assignment just shares the data, so the common case (nothing pending)
+    // does not copy anything.
+    if (_pending.isEmpty()) {
+        _pending = data;
+    } else {
+        _pending.append(data);
+    }
+
+    auto batch = std::make_shared<Batch>();
+    const auto *buffer = reinterpret_cast<const uint8_t *>(_pending.constData());
+    qsizetype consumed = split(buffer, _pending.size(), batch->spans);
+    if (!batch->spans.empty()) {
+        // The batch shares the received data, and the pending data becomes
+        // a copy of the tail
+        batch->buffer = _pending;
+        _pending = _pending.mid(consumed);
+        startDecoding(batch);
+    }
+
+    return collect();
+}
+
+/*!
+ * Adds the categories that have been decoded to the collection, in eix
+ * order: a category is only added once all of the categories before it
+ * have been.
+ *
+ * Returns the number of categories added. If a category fails to decode,
+ * it and all of the categories after it are dropped.
+ */
+int EixStreamParser::collect()
+{
+    _notified = false;
+
+    int added = 0;
+    while (!_batches.empty()) {
+        Batch &batch = *_batches.front();
+        const int count = static_cast<int>(batch.spans.size());
+        for (; _collected < count; ++_collected, ++added) {
+            const int state = batch.states[_collected];
+            if (state == Decoding) {
+                return added;
+            }
+            if (state == Failed) {
+                qWarning() << "Failed to parse EIX category at offset"
+                           << batch.spans[_collected].start;
+                _failed = true;
+                discard();
+                return added;
+            }
+
+            _eix->mutable_category()->AddAllocated(
+                batch.categories[_collected]);
+            batch.categories[_collected] = nullptr;
+            if (_lazy != nullptr) {
+                _lazy->setSource(batch.firstNumber + _collected,
+                                 std::move(batch.sources[_collected]));
+            }
+        }
+        _batches.pop_front();
+        _collected = 0;
+    }
+    return added;
+}
+
+/*!
+ * Waits for all of the categories found so far to be decoded, and adds them
+ * to the collection. Returns the number of categories added.
+ */
+int EixStreamParser::wait()
+{
+    _pool.waitForDone();
+    return collect();
+}
+
+/*!
+ * Called when the stream has ended. Waits for the last categories to be
+ * decoded and adds them (see wait()). Returns true if all of the data was
+ * decoded, or false if the stream failed or stopped part way through a
+ * category.
+ */
+bool EixStreamParser::finish()
+{
+    wait();
+    bool ok = !_failed && _pending.isEmpty();
+    if (!_pending.isEmpty()) {
+        qWarning() << "EIX output ended with" << _pending.size()
+                   << "undecoded bytes";
+    }
+    _pending.clear();
+    return ok;
+}
+
+/// Whether the stream could not be decoded
+bool EixStreamParser::failed() const
+{
+    return _failed;
+}
+
+/// Sets the most threads to use for decoding (1 decodes one at a time)
+void EixStreamParser::setThreadCount(int threads)
+{
+    _pool.setMaxThreadCount(threads);
+}
+
+/*!
+ * Scans the buffer for complete category sub-messages, without decoding
+ * them, and records where each one is in 'spans'.
+ *
+ * Returns the number of bytes covered by the complete categories.
+ */
+qsizetype EixStreamParser::split(const uint8_t *buffer,
+                                 qsizetype size,
+                                 std::vector<CategorySpan> &spans)
+{
+    static const uint32_t categoryTag =
+        WireFormatLite::MakeTag(eix_proto::Collection::kCategoryFieldNumber,
+                                WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+
+    qsizetype consumed = 0;
+
+    while (consumed < size) {
+        google::protobuf::io::CodedInputStream input(buffer + consumed,
+                                                     size - consumed);
+
+        // A tag or length that is cut short reads as a failure, which just
+        // means waiting for more data.
+        uint32_t tag = input.ReadTag();
+        if (tag == 0) {
+            break;
+        }
+        if (tag != categoryTag) {
+            qWarning() << "Unexpected field in eix output, tag" << tag;
+            _failed = true;
+            break;
+        }
+
+        uint32_t length;
+        if (!input.ReadVarint32(&length) || length > INT_MAX) {
+            break;
+        }
+
+        qsizetype start = consumed + input.CurrentPosition();
+        if (size - start < static_cast<qsizetype>(length)) {
+            break;
+        }
+
+        spans.push_back({start, static_cast<int>(length)});
+        consumed = start + length;
+    }
+
+    return consumed;
+}
+
+/*!
+ * Starts decoding the categories of a batch on the thread pool, one task per
+ * category, so that a few very large categories do not hold up the rest.
+ * Each category is decoded into an object of its own, on the collection's
+ * arena if it has one, which collect() adds to the collection.
+ */
+void EixStreamParser::startDecoding(const std::shared_ptr<Batch> &batch)
+{
+    const int count = static_cast<int>(batch->spans.size());
+    batch->firstNumber = _nextNumber;
+    _nextNumber += count;
+    batch->lazy = _lazy != nullptr;
+
+    google::protobuf::Arena *arena = _eix->GetArena();
+    batch->categories.resize(count);
+    for (auto &category : batch->categories) {
+        category =
+            google::protobuf::Arena::CreateMessage<eix_proto::Category>(arena);
+    }
+    if (batch->lazy) {
+        batch->sources.resize(count);
+    }
+    batch->states.reset(new std::atomic<int>[count]);
+    for (int n = 0; n < count; ++n) {
+        batch->states[n] = Decoding;
+    }
+
+    _batches.push_back(batch);
+    for (int n = 0; n < count; ++n) {
+        _pool.start([this, batch, n]() { decodeCategory(*batch, n); });
+    }
+}
+
+/*!
+ * Decodes a category of a batch, on a thread of the pool, and signals that
+ * there is something to collect (unless that has already been signalled).
+ */
+void EixStreamParser::decodeCategory(Batch &batch, int n)
+{
+    const CategorySpan &span = batch.spans[n];
+    const auto *data =
+        reinterpret_cast<const uint8_t *>(batch.buffer.constData()) +
+        span.start;
+    eix_proto::Category *category = batch.categories[n];
+    const bool ok =
+        batch.lazy ? EixLazyDecoder::decodeSummary(batch.firstNumber + n,
+                                                   category,
+                                                   data,
+                                                   span.length,
+                                                   batch.sources[n])
+                   : category->ParseFromArray(data, span.length);
+    batch.states[n] = ok ? Decoded : Failed;
+
+    if (!_notified.exchange(true)) {
+        emit categoriesDecoded();
+    }
+}
+
+/*!
+ * Stops decoding, waiting for any categories that have been started, and
+ * throws away the categories that haven't been added to the collection.
+ */
+void EixStreamParser::discard()
+{
+    _pool.clear();
+    _pool.waitForDone();
+    for (const auto &batch : _batches) {
+        for (eix_proto::Category *category : batch->categories) {
+            if (category != nullptr && category->GetArena() == nullptr) {
+                delete category;
+            }
+        }
+    }
+    _batches.clear();
+    _collected = 0;
+}
@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QObject>
+#include <QThreadPool>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "eix.pb.h"
+#include "eixlazydecoder.h"
+
+/*! class EixStreamParser
+ *
+ * Decodes the output of "eix --proto" while it is still being written.
+ *
+ * The eix Collection message is just a list of length-delimited category
+ * sub-messages, so each category can be parsed as soon as all of its bytes
+ * have arrived. Incomplete trailing data is held back until the next chunk.
+ *
+ * Each chunk is scanned once, on the calling thread, to find where the
+ * complete categories start and end. The categories are then decoded on the
+ * thread pool, in the background, so the calling thread can go back to
+ * reading eix's output while they are decoded. Each read from the pipe
+ * usually brings at most a category or so, and the categories of successive
+ * reads are decoded side by side, so decoding keeps up with eix on as many
+ * cores as there are.
+ *
+ * Decoded categories are added to the collection by collect(), on the
+ * calling thread, in the order eix wrote them, so category numbers are the
+ * same as for a serial parse. categoriesDecoded() is signalled when there are
+ * some to collect.
+ *
+ * If a lazy decoder is given, categories are only decoded as far as the
+ * package list needs, and the lazy decoder keeps the rest for later.
+ */
+class EixStreamParser : public QObject
+{
+    Q_OBJECT
+
+  public:
+    explicit EixStreamParser(eix_proto::Collection *eix = nullptr);
+    ~EixStreamParser();
+
+    void reset(eix_proto::Collection *eix, EixLazyDecoder *lazy = nullptr);
+    int feed(const QByteArray &data);
+    int collect();
+    int wait();
+    bool finish();
+    bool failed() const;
+    void setThreadCount(int threads);
+
+  signals:
+    /// Some categories have been decoded, and collect() will add them to the
+    /// collection. This is signalled from a decoding thread.
+    void categoriesDecoded();
+
+  private:
+    /// Where a complete category sits in the receive buffer
+    struct CategorySpan {
+        qsizetype start;
+        int length;
+    };
+
+    /// How far a category of a batch has got
+    enum State { Decoding, Decoded, Failed };
+
+    /// The complete categories found by one feed(), decoded in the background
+    struct Batch {
+        /// The received data the categories are in
+        QByteArray buffer;
+
+        /// Where each category is in the buffer
+        std::vector<CategorySpan> spans;
+
+        /// The category number of the first category
+        int firstNumber;
+
+        /// Whether only the summaries are decoded (see EixLazyDecoder)
+        bool lazy;
+
+        /// The decoded categories, until they are added to the collection
+        std::vector<eix_proto::Category *> categories;
+
+        /// What the lazy decoder keeps of each category
+        std::vector<EixLazyDecoder::CategorySource> sources;
+
+        /// The State of each category
+        std::unique_ptr<std::atomic<int>[]> states;
+    };
+
+    qsizetype split(const uint8_t *buffer,
+                    qsizetype size,
+                    std::vector<CategorySpan> &spans);
+    void startDecoding(const std::shared_ptr<Batch> &batch);
+    void decodeCategory(Batch &batch, int n);
+    void discard();
+
+  private:
+    /// Where the decoded categories are added
+    eix_proto::Collection *_eix;
+
+    /// Decodes the summary of each category, if set, instead of all of it
+    EixLazyDecoder *_lazy;
+
+    /// Bytes received but not yet decoded (a partial category)
+    QByteArray _pending;
+
+    /// Set if the data could not be decoded
+    bool _failed;
+
+    /// The category number for the next complete category found
+    int _nextNumber;
+
+    /// The batches whose categories haven't all been added yet, in order
+    std::deque<std::shared_ptr<Batch>> _batches;
+
+    /// How many categories of the first batch have been added
+    int _collected;
+
+    /// Whether categoriesDecoded() has been signalled since the last
+    /// collect()
+    std::atomic<bool> _notified;
+
+    /// Threads for decoding categories in parallel
+    QThreadPool _pool;
+};
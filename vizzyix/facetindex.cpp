@@ -0,0 +1,261 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "facetindex.h"
+
+#include <QHash>
+#include <algorithm>
+#include <climits>
+
+#include "eixprotohelper.h"
+#include "packagestore.h"
+#include "snapshotimage.h"
+
+/// Whether no facets are picked, when narrow() leaves every package
+bool FacetIndex::Selection::isEmpty() const
+{
+    return facets == 0 && repository < 0;
+}
+
+bool FacetIndex::Selection::operator==(const Selection &other) const
+{
+    return facets == other.facets && repository == other.repository;
+}
+
+bool FacetIndex::Selection::operator!=(const Selection &other) const
+{
+    return !(*this == other);
+}
+
+/// Constructor makes an empty index
+FacetIndex::FacetIndex()
+{
+}
+
+/*!
+ * Works out which of the store's packages have each facet, replacing what
+ * was there. This looks at each package's versions once.
+ */
+void FacetIndex::build(const PackageStore &store)
+{
+    typedef PackageReportItem::Marker Marker;
+
+    clear();
+    _size = store.size();
+    const size_t words = (_size + 63) / 64;
+    for (auto &bits : _bits) {
+        bits.assign(words, 0);
+    }
+
+    QHash<QString, int> repositoryNumbers;
+    std::string lastName;
+    int lastNumber = -1;
+    for (int index = 0; index < _size; ++index) {
+        if (store.installed(index)) {
+            set(_bits[Installed], index);
+        }
+        switch (store.marker(index)) {
+        case Marker::WorldMarker:
+            set(_bits[World], index);
+            break;
+        case Marker::WorldSetMarker:
+            set(_bits[Set], index);
+            break;
+        case Marker::SystemMarker:
+            set(_bits[System], index);
+            break;
+        default:
+            break;
+        }
+        if (!store.zombieVersions(index).isEmpty()) {
+            set(_bits[Zombie], index);
+        }
+        if (store.updateAvailable(index)) {
+            set(_bits[HasUpdate], index);
+        }
+
+        for (const auto &ver : store.packageDetails(index).version()) {
+            if (ver.has_installed() && !EixProtoHelper::isStable(ver)) {
+                set(_bits[UnstableInstalled], index);
+            }
+
+            // Most versions are from the same repository as the last one
+            const std::string &name = ver.repository().repository();
+            if (lastNumber < 0 || name != lastName) {
+                const QString key = QString::fromStdString(name);
+                auto found = repositoryNumbers.constFind(key);
+                if (found == repositoryNumbers.cend()) {
+                    found = repositoryNumbers.insert(key, _repositories.size());
+                    _repositories.append(key);
+                    _repositoryBits.emplace_back(words, 0);
+                }
+                lastName = name;
+                lastNumber = *found;
+            }
+            set(_repositoryBits[lastNumber], index);
+        }
+    }
+}
+
+/// Empties the index
+void FacetIndex::clear()
+{
+    _size = 0;
+    for (auto &bits : _bits) {
+        bits.clear();
+    }
+    _repositories.clear();
+    _repositoryBits.clear();
+}
+
+/// Writes the index to a snapshot
+void FacetIndex::save(SnapshotImage &image) const
+{
+    image.write(uint64_t(_size));
+    for (const auto &bits : _bits) {
+        image.write(bits);
+    }
+    image.write(_repositories);
+    image.write(_repositoryBits);
+}
+
+/*!
+ * Reads back an index written by save(), replacing what was there. Returns
+ * false, leaving the index empty, if the image doesn't hold a whole index.
+ */
+bool FacetIndex::restore(SnapshotImage &image)
+{
+    clear();
+    uint64_t size = 0;
+    bool ok = image.read(size) && size <= INT_MAX;
+    for (auto &bits : _bits) {
+        ok = ok && image.read(bits) && bits.size() == (size + 63) / 64;
+    }
+    ok = ok && image.read(_repositories) && image.read(_repositoryBits) &&
+         _repositoryBits.size() == size_t(_repositories.size());
+    for (const auto &bits : _repositoryBits) {
+        ok = ok && bits.size() == (size + 63) / 64;
+    }
+    if (!ok) {
+        clear();
+        return false;
+    }
+    _size = static_cast<int>(size);
+    return true;
+}
+
+/// The number of packages in the index
+int FacetIndex::size() const
+{
+    return _size;
+}
+
+/// The repositories the packages are from, see Selection::repository
+const QStringList &FacetIndex::repositories() const
+{
+    return _repositories;
+}
+
+/*!
+ * Whether the package at 'index' in the store has the facet. For the
+ * Repository facet, this is whether it has a version from the given
+ * repository.
+ */
+bool FacetIndex::has(int index, Facet facet, int repository) const
+{
+    const std::vector<uint64_t> &facetBits = bits(facet, repository);
+    return !facetBits.empty() && isSet(facetBits, index);
+}
+
+/*!
+ * Narrows a set of packages (bit n set for the package at index n in the
+ * store) to those that have every facet in the selection.
+ */
+void FacetIndex::narrow(const Selection &selection,
+                        std::vector<uint64_t> &rows) const
+{
+    for (int facet = 0; facet <= Repository; ++facet) {
+        if (facet == Repository ? selection.repository < 0
+                                : !(selection.facets & (1u << facet))) {
+            continue;
+        }
+        const std::vector<uint64_t> &facetBits =
+            bits(Facet(facet), selection.repository);
+        for (size_t word = 0; word < rows.size(); ++word) {
+            rows[word] &= word < facetBits.size() ? facetBits[word] : 0;
+        }
+    }
+}
+
+/*!
+ * How many of a set of packages (as for narrow()) from index begin up to
+ * end have each facet. The Repository count is for the given repository,
+ * or 0 for none.
+ */
+FacetIndex::Counts FacetIndex::count(const std::vector<uint64_t> &rows,
+                                     int begin,
+                                     int end,
+                                     int repository) const
+{
+    Counts counts{};
+    for (int facet = 0; facet < FacetCount; ++facet) {
+        counts[facet] =
+            popcount(rows, bits(Facet(facet), repository), begin, end);
+    }
+    return counts;
+}
+
+/// Sets bit n of a bitmap
+void FacetIndex::set(std::vector<uint64_t> &bitmap, int n)
+{
+    bitmap[n / 64] |= uint64_t(1) << (n % 64);
+}
+
+/// Whether bit n of a bitmap is set
+bool FacetIndex::isSet(const std::vector<uint64_t> &bitmap, int n)
+{
+    return (bitmap[n / 64] >> (n % 64)) & 1;
+}
+
+/// The bitset for a facet, which is empty for no repository
+const std::vector<uint64_t> &FacetIndex::bits(Facet facet,
+                                              int repository) const
+{
+    static const std::vector<uint64_t> none;
+    if (facet != Repository) {
+        return _bits[facet];
+    }
+    return repository >= 0 && repository < int(_repositoryBits.size())
+               ? _repositoryBits[repository]
+               : none;
+}
+
+/// The number of bits from begin up to end that are set in both bitmaps
+uint FacetIndex::popcount(const std::vector<uint64_t> &first,
+                          const std::vector<uint64_t> &second,
+                          int begin,
+                          int end)
+{
+    const int words = int(std::min(first.size(), second.size()));
+    end = std::min(end, words * 64);
+    if (begin >= end) {
+        return 0;
+    }
+
+    // The words at each end only count from begin, and up to end
+    const int firstWord = begin / 64;
+    const int lastWord = (end - 1) / 64;
+    const uint64_t firstMask = ~uint64_t(0) << (begin % 64);
+    const uint64_t lastMask = ~uint64_t(0) >> (63 - (end - 1) % 64);
+    if (firstWord == lastWord) {
+        return __builtin_popcountll(first[firstWord] & second[firstWord] &
+                                    firstMask & lastMask);
+    }
+    uint count =
+        __builtin_popcountll(first[firstWord] & second[firstWord] & firstMask);
+    for (int word = firstWord + 1; word < lastWord; ++word) {
+        count += __builtin_popcountll(first[word] & second[word]);
+    }
+    return count + __builtin_popcountll(first[lastWord] & second[lastWord] &
+                                        lastMask);
+}
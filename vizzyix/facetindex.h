@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+class PackageStore;
+class SnapshotImage;
+
+/*! class FacetIndex
+ *
+ * The facets the package list can be narrowed by (installed, world, has an
+ * update, from some repository, ...), as one bitset per facet over the
+ * packages of a PackageStore, made once per load (see build()).
+ *
+ * A set of packages is also a bitset over the store, so narrowing it to the
+ * packages with some facets is a bitwise AND with each (see narrow()), and
+ * counting the packages of a category with each facet is a popcount over
+ * the category's range of the store (see count()). Neither looks at the eix
+ * data, and nor does reading a saved index back (see restore()).
+ */
+class FacetIndex
+{
+  public:
+    /*!
+     * The facets. World, Set and System are as the Installed column's
+     * marker shows them, and Repository is a package with a version from
+     * the repository picked in the Selection.
+     */
+    enum Facet {
+        Installed,
+        World,
+        Set,
+        System,
+        UnstableInstalled,
+        Zombie,
+        HasUpdate,
+        Repository,
+        FacetCount
+    };
+
+    /// The number of packages with each facet
+    typedef std::array<uint, FacetCount> Counts;
+
+    /// Which facets the packages must all have, see narrow()
+    struct Selection {
+        /// A bit (1 << facet) for each facet but Repository
+        uint facets{0};
+
+        /// The number of the repository (see repositories()), or -1 for any
+        int repository{-1};
+
+        bool isEmpty() const;
+        bool operator==(const Selection &other) const;
+        bool operator!=(const Selection &other) const;
+    };
+
+    FacetIndex();
+
+    FacetIndex(const FacetIndex &) = delete;
+    FacetIndex &operator=(FacetIndex &) = delete;
+
+    void build(const PackageStore &store);
+    void clear();
+    void save(SnapshotImage &image) const;
+    bool restore(SnapshotImage &image);
+    int size() const;
+
+    const QStringList &repositories() const;
+    bool has(int index, Facet facet, int repository = -1) const;
+
+    void narrow(const Selection &selection, std::vector<uint64_t> &rows) const;
+    Counts count(const std::vector<uint64_t> &rows,
+                 int begin,
+                 int end,
+                 int repository = -1) const;
+
+    static void set(std::vector<uint64_t> &bitmap, int n);
+    static bool isSet(const std::vector<uint64_t> &bitmap, int n);
+
+  private:
+    const std::vector<uint64_t> &bits(Facet facet, int repository) const;
+    static uint popcount(const std::vector<uint64_t> &first,
+                         const std::vector<uint64_t> &second,
+                         int begin,
+                         int end);
+
+  private:
+    /// The number of packages in the store the index was built from
+    int _size{0};
+
+    /// The packages with each facet but Repository, by store index
+    std::array<std::vector<uint64_t>, Repository> _bits;
+
+    /// The names of the repositories, in the order first seen, with an
+    /// empty name for eix's main repository
+    QStringList _repositories;
+
+    /// The packages with a version from each repository
+    std::vector<std::vector<uint64_t>> _repositoryBits;
+};
@@ -0,0 +1,106 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "filtercache.h"
+
+/// Constructor, the cache starts empty
+FilterCache::FilterCache(qsizetype budget)
+    : _budget(budget), _generation(0), _bytes(0)
+{
+}
+
+/// Drops all of the results if they are for a different load generation
+void FilterCache::setGeneration(quint64 generation)
+{
+    if (generation != _generation) {
+        clear();
+        _generation = generation;
+    }
+}
+
+/*!
+ * Returns the result for the filter, or null if it isn't known. The result
+ * is only good until the next insert() or clear().
+ */
+const FilterCache::Result *FilterCache::find(const PackageFilter &filter)
+{
+    auto entry = _index.find(filterKey(filter));
+    if (entry == _index.end()) {
+        return nullptr;
+    }
+
+    // Now the most recently used
+    _entries.splice(_entries.begin(), _entries, entry.value());
+    return &_entries.front().result;
+}
+
+/*!
+ * Adds the result for a filter, dropping the least recently used results
+ * if that goes over the budget. A result bigger than the whole budget isn't
+ * kept.
+ */
+void FilterCache::insert(const PackageFilter &filter, const Result &result)
+{
+    const QString key = filterKey(filter);
+    auto existing = _index.find(key);
+    if (existing != _index.end()) {
+        _bytes -= existing.value()->bytes;
+        _entries.erase(existing.value());
+        _index.erase(existing);
+    }
+
+    const qsizetype bytes = resultBytes(result);
+    if (bytes > _budget) {
+        return;
+    }
+
+    while (_bytes + bytes > _budget) {
+        _bytes -= _entries.back().bytes;
+        _index.remove(_entries.back().key);
+        _entries.pop_back();
+    }
+
+    _entries.push_front({key, result, bytes});
+    _index.insert(key, _entries.begin());
+    _bytes += bytes;
+}
+
+/// Drops all of the results
+void FilterCache::clear()
+{
+    _entries.clear();
+    _index.clear();
+    _bytes = 0;
+}
+
+/// The number of results being kept
+int FilterCache::count() const
+{
+    return static_cast<int>(_entries.size());
+}
+
+/// Roughly how much memory the results take
+qsizetype FilterCache::bytes() const
+{
+    return _bytes;
+}
+
+/// Everything about a filter that changes which packages pass it
+QString FilterCache::filterKey(const PackageFilter &filter)
+{
+    return QStringLiteral("%1%2%3")
+        .arg(int(filter.selection()))
+        .arg(filter.searchDescriptions() ? QStringLiteral("d")
+                                         : QStringLiteral("n"))
+        .arg(filter.search());
+}
+
+/// The memory taken by a result, including the list for each category
+qsizetype FilterCache::resultBytes(const Result &result)
+{
+    qsizetype bytes = sizeof(Result) + result.size() * sizeof(result[0]);
+    for (const auto &packages : result) {
+        bytes += packages.size() * sizeof(int);
+    }
+    return bytes;
+}
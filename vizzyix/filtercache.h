@@ -0,0 +1,72 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+#include <list>
+#include <vector>
+
+#include "packagefilter.h"
+
+/*! class FilterCache
+ *
+ * Remembers the packages that passed recent filters, so going back to a
+ * filter that was used before doesn't mean working it out again. A result
+ * is the list of matching package numbers for each eix category, as kept by
+ * ApplicationData.
+ *
+ * The least recently used results are dropped to keep within a memory
+ * budget. The results are only good for one load of the eix data, so they
+ * are all dropped when the load generation changes (see setGeneration()).
+ */
+class FilterCache
+{
+  public:
+    /// For each eix category, the numbers of the matching packages
+    typedef std::vector<std::vector<int>> Result;
+
+    explicit FilterCache(qsizetype budget = defaultBudget);
+
+    FilterCache(const FilterCache &) = delete;
+    FilterCache &operator=(FilterCache &) = delete;
+
+    void setGeneration(quint64 generation);
+    const Result *find(const PackageFilter &filter);
+    void insert(const PackageFilter &filter, const Result &result);
+    void clear();
+    int count() const;
+    qsizetype bytes() const;
+
+  public:
+    /// Enough for a few dozen filters over the full portage tree
+    static constexpr qsizetype defaultBudget = 4 * 1024 * 1024;
+
+  private:
+    struct Entry {
+        QString key;
+        Result result;
+        qsizetype bytes;
+    };
+
+    static QString filterKey(const PackageFilter &filter);
+    static qsizetype resultBytes(const Result &result);
+
+  private:
+    /// The most memory the results may take
+    const qsizetype _budget;
+
+    /// The load generation the results are for
+    quint64 _generation;
+
+    /// The results, most recently used first
+    std::list<Entry> _entries;
+
+    /// Finds the entry for a filter key
+    QHash<QString, std::list<Entry>::iterator> _index;
+
+    /// The memory taken by the results
+    qsizetype _bytes;
+};
@@ -0,0 +1,225 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "loadgeneration.h"
+
+#include <QDebug>
+#include <QtLogging>
+#include <climits>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+#include "eix.pb.h"
+#include "eixstreamparser.h"
+
+using google::protobuf::io::CodedInputStream;
+using google::protobuf::internal::WireFormatLite;
+
+namespace
+{
+/*!
+ * Finds the length-delimited fields with the given number in some protobuf
+ * bytes, without decoding them, and adds where each one is to 'spans'.
+ * Other fields are skipped. Returns false if the bytes can't be read.
+ */
+template <typename Span>
+bool findFields(const char *data,
+                qsizetype offset,
+                int length,
+                int fieldNumber,
+                std::vector<Span> &spans)
+{
+    const uint32_t fieldTag = WireFormatLite::MakeTag(
+        fieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+    CodedInputStream input(reinterpret_cast<const uint8_t *>(data + offset),
+                           length);
+    uint32_t tag;
+    while ((tag = input.ReadTag()) != 0) {
+        if (tag != fieldTag) {
+            if (!WireFormatLite::SkipField(&input, tag)) {
+                return false;
+            }
+            continue;
+        }
+        int fieldLength;
+        if (!input.ReadVarintSizeAsInt(&fieldLength)) {
+            return false;
+        }
+        spans.push_back({offset + input.CurrentPosition(), fieldLength});
+        if (!input.Skip(fieldLength)) {
+            return false;
+        }
+    }
+    return input.ConsumedEntireMessage();
+}
+} // namespace
+
+/// Creates an empty eix collection on a new arena
+LoadGeneration::LoadGeneration(quint64 number)
+    : _number(number), _arena(arenaOptions()),
+      _eix(google::protobuf::Arena::CreateMessage<eix_proto::Collection>(
+          &_arena))
+{
+}
+
+/// Returns the sequence number of this load
+quint64 LoadGeneration::number() const
+{
+    return _number;
+}
+
+/// Returns the eix data for this load
+eix_proto::Collection &LoadGeneration::eix()
+{
+    return *_eix;
+}
+
+/// Returns the eix data for this load
+const eix_proto::Collection &LoadGeneration::eix() const
+{
+    return *_eix;
+}
+
+/// Returns the decoder holding the package details not decoded yet
+EixLazyDecoder &LoadGeneration::lazyDecoder()
+{
+    return _lazyDecoder;
+}
+
+/*!
+ * Keeps the eix output for this load without decoding it, e.g. when the
+ * package list has been read back from a snapshot. The eix data stays empty
+ * until decodeStream() is called, but package() can be used straight away.
+ */
+void LoadGeneration::setStream(const QByteArray &stream)
+{
+    _stream = stream;
+    _categorySpans.clear();
+    _packageSpans.clear();
+    _packages.clear();
+}
+
+/// Whether there is eix output that hasn't been decoded, see setStream()
+bool LoadGeneration::isDeferred() const
+{
+    return !_stream.isEmpty();
+}
+
+/*!
+ * Returns a package with all of its details, by eix category and package
+ * number. If the eix output hasn't been decoded, just this package is
+ * decoded from it the first time it is asked for. The reference stays good
+ * for as long as the generation.
+ */
+const eix_proto::Package &LoadGeneration::package(int catNumber, int pkgNumber)
+{
+    if (!isDeferred()) {
+        return _lazyDecoder.details(
+            _eix->category(catNumber).package(pkgNumber));
+    }
+
+    const QPair<int, int> key(catNumber, pkgNumber);
+    if (eix_proto::Package *pkg = _packages.value(key)) {
+        return *pkg;
+    }
+
+    if (!findPackages(catNumber) || pkgNumber < 0 ||
+        pkgNumber >= static_cast<int>(_packageSpans[catNumber].size())) {
+        qWarning() << "No package" << pkgNumber << "in category" << catNumber;
+        return eix_proto::Package::default_instance();
+    }
+    const Span &span = _packageSpans[catNumber][pkgNumber];
+    auto *pkg =
+        google::protobuf::Arena::CreateMessage<eix_proto::Package>(&_arena);
+    if (!pkg->ParseFromArray(_stream.constData() + span.start, span.length)) {
+        qWarning() << "Failed to decode details for package" << pkgNumber
+                   << "in category" << catNumber;
+    }
+    _packages.insert(key, pkg);
+    return *pkg;
+}
+
+/*!
+ * Decodes the eix output kept by setStream() into the eix data, as a load
+ * would (lazily or not), and drops the output. Packages already returned by
+ * package() stay where they are.
+ *
+ * Returns false if the output could not be decoded.
+ */
+bool LoadGeneration::decodeStream(bool lazy)
+{
+    EixStreamParser parser;
+    parser.reset(_eix, lazy ? &_lazyDecoder : nullptr);
+    parser.feed(_stream);
+    const bool ok = parser.finish();
+    setStream(QByteArray());
+    return ok;
+}
+
+/// Throws away the eix data, e.g. after a failed load
+void LoadGeneration::clear()
+{
+    _eix->clear_category();
+    _lazyDecoder.clear();
+    setStream(QByteArray());
+}
+
+/// Returns the number of bytes allocated for the eix data so far
+quint64 LoadGeneration::spaceUsed() const
+{
+    return _arena.SpaceUsed();
+}
+
+/*!
+ * The arena settings. A full tree is tens of MB of small objects, so the
+ * blocks start large and grow quickly; the defaults start at a few hundred
+ * bytes and stop growing at 8k, which means thousands of separate blocks.
+ */
+google::protobuf::ArenaOptions LoadGeneration::arenaOptions()
+{
+    google::protobuf::ArenaOptions options;
+    options.start_block_size = 64 * 1024;
+    options.max_block_size = 4 * 1024 * 1024;
+    return options;
+}
+
+/// Finds where each category is in the eix output, the first time only
+bool LoadGeneration::findCategories()
+{
+    if (!_categorySpans.empty()) {
+        return true;
+    }
+    if (_stream.size() > INT_MAX ||
+        !findFields(_stream.constData(),
+                    0,
+                    static_cast<int>(_stream.size()),
+                    eix_proto::Collection::kCategoryFieldNumber,
+                    _categorySpans)) {
+        _categorySpans.clear();
+        return false;
+    }
+    _packageSpans.resize(_categorySpans.size());
+    return true;
+}
+
+/// Finds where each package of a category is, the first time only
+bool LoadGeneration::findPackages(int catNumber)
+{
+    if (!findCategories() || catNumber < 0 ||
+        catNumber >= static_cast<int>(_categorySpans.size())) {
+        return false;
+    }
+    std::vector<Span> &packages = _packageSpans[catNumber];
+    if (packages.empty()) {
+        const Span &category = _categorySpans[catNumber];
+        if (!findFields(_stream.constData(),
+                        category.start,
+                        category.length,
+                        eix_proto::Category::kPackageFieldNumber,
+                        packages)) {
+            packages.clear();
+            return false;
+        }
+    }
+    return true;
+}
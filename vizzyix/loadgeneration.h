@@ -0,0 +1,89 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QPair>
+#include <QtGlobal>
+#include <google/protobuf/arena.h>
+#include <vector>
+
+#include "eix.pb.h"
+#include "eixlazydecoder.h"
+
+/*! class LoadGeneration
+ *
+ * Owns the eix data from one load of the portage data (one eix run).
+ *
+ * The eix Collection and all of its categories, packages, versions and
+ * strings are allocated on a single protobuf arena. The arena grabs memory in
+ * a few large blocks, and throwing the generation away frees them all in one
+ * go instead of deleting each message separately.
+ *
+ * When the eix data is decoded lazily, the generation also keeps the raw bytes
+ * for the package details, in its lazy decoder.
+ *
+ * A generation shown from a snapshot doesn't need the eix data decoded at
+ * all, as everything the package list shows was saved with it. It just keeps
+ * the eix output (see setStream()), and decodes a package from it when its
+ * details are asked for (see package()). The whole stream is only decoded if
+ * the eix data itself is needed (see decodeStream()).
+ */
+class LoadGeneration
+{
+  public:
+    explicit LoadGeneration(quint64 number = 0);
+
+    LoadGeneration(const LoadGeneration &) = delete;
+    LoadGeneration &operator=(LoadGeneration &) = delete;
+
+    quint64 number() const;
+    eix_proto::Collection &eix();
+    const eix_proto::Collection &eix() const;
+    EixLazyDecoder &lazyDecoder();
+    void setStream(const QByteArray &stream);
+    bool isDeferred() const;
+    const eix_proto::Package &package(int catNumber, int pkgNumber);
+    bool decodeStream(bool lazy);
+    void clear();
+    quint64 spaceUsed() const;
+
+  private:
+    /// Where a message sits in _stream
+    struct Span {
+        qsizetype start;
+        int length;
+    };
+
+    static google::protobuf::ArenaOptions arenaOptions();
+    bool findCategories();
+    bool findPackages(int catNumber);
+
+  private:
+    /// Sequence number, counts up for each load
+    const quint64 _number;
+
+    /// Holds all of the memory for the eix data
+    google::protobuf::Arena _arena;
+
+    /// The eix data, allocated on the arena (the arena owns it)
+    eix_proto::Collection *_eix;
+
+    /// Raw bytes for the packages that have not been fully decoded yet
+    EixLazyDecoder _lazyDecoder;
+
+    /// The eix output while it hasn't been decoded, see setStream()
+    QByteArray _stream;
+
+    /// Where each category is in _stream, found on first use
+    std::vector<Span> _categorySpans;
+
+    /// Where each package of each category is, found when the category is
+    /// first used
+    std::vector<std::vector<Span>> _packageSpans;
+
+    /// The packages decoded from _stream so far, allocated on the arena
+    QHash<QPair<int, int>, eix_proto::Package *> _packages;
+};
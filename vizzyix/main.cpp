@@ -1,9 +1,11 @@
 // SPDX-FileCopyrightText: 2020 Bill Binder <dxtwjb@gmail.com>
 // SPDX-License-Identifier: GPL-2.0-only
 
+#include "applicationdata.h"
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
 
 int main(int argc, char *argv[])
 {
@@ -13,6 +15,17 @@ int main(int argc, char *argv[])
 
     QApplication a(argc, argv);
     a.setWindowIcon(QIcon(":/app/images/eyeball.png"));
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption installedOnly(
+        "installed-only",
+        "Show just the installed packages, from the package database, "
+        "without running eix.");
+    parser.addOption(installedOnly);
+    parser.process(a);
+    ApplicationData::data()->setInstalledOnly(parser.isSet(installedOnly));
+
     MainWindow w;
     w.show();
     return a.exec();
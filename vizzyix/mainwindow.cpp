@@ -5,17 +5,20 @@
 
 #include <QDateTime>
 #include <QDebug>
+#include <QFontMetrics>
 #include <QLabel>
 #include <QMessageBox>
 #include <QProcess>
 #include <QStandardItemModel>
 #include <QTextBrowser>
 #include <QTimer>
+#include <QToolButton>
 #include <QtLogging>
 
 #include "aboutdialog.h"
 #include "eix.pb.h"
 #include "eixprotohelper.h"
+#include "packagelistdelegate.h"
 #include "searchboxvalidator.h"
 #include "ui_mainwindow.h"
 
@@ -74,6 +77,37 @@ MainWindow::MainWindow(QWidget *parent)
             this,
             &MainWindow::onSelectWorld);
 
+    // Toolbar - facets, which narrow the selection further. Any number of
+    // them can be picked, plus one repository (the list of repositories is
+    // only known once the data has loaded, see updateRepositoryMenu()).
+
+    _facetMenu = new QMenu(tr("Facets"), this);
+    for (int facet = 0; facet < FacetIndex::Repository; ++facet) {
+        QAction *action = _facetMenu->addAction(
+            CategoryTreeModel::facetTitle(FacetIndex::Facet(facet)));
+        action->setCheckable(true);
+        connect(action, &QAction::toggled, this, &MainWindow::onFacetsChanged);
+        _facetActions.append(action);
+    }
+    _facetMenu->addSeparator();
+    _repositoryMenu = _facetMenu->addMenu(tr("Repository"));
+    _repositoryGroup = new QActionGroup(this);
+    _repositoryGroup->setExclusive(true);
+    connect(_repositoryGroup,
+            &QActionGroup::triggered,
+            this,
+            &MainWindow::onFacetsChanged);
+    updateRepositoryMenu();
+
+    _facetMenu->menuAction()->setToolTip(
+        tr("Only show the packages with all of the chosen facets; the "
+           "categories show how many of their packages have each facet"));
+    ui->toolBar->addAction(_facetMenu->menuAction());
+    if (auto *button = qobject_cast<QToolButton *>(
+            ui->toolBar->widgetForAction(_facetMenu->menuAction()))) {
+        button->setPopupMode(QToolButton::InstantPopup);
+    }
+
     // Database & models
 
     connect(this,
@@ -105,21 +139,55 @@ MainWindow::MainWindow(QWidget *parent)
 
     QLabel *searchLabel = new QLabel(" Search: ");
 
+    // Live search: the package list follows the search box as it is typed in,
+    // once typing pauses, and descriptions are searched as well
+    _liveSearchAction = new QAction(tr("As you type"), this);
+    _liveSearchAction->setCheckable(true);
+    _liveSearchAction->setChecked(true);
+    _liveSearchAction->setToolTip(
+        tr("Search package names, categories and descriptions as you type"));
+    connect(_liveSearchAction,
+            &QAction::toggled,
+            this,
+            &MainWindow::onLiveSearch);
+    ApplicationData::data()->setSearchDescriptions(true);
+
+    _searchTimer.setSingleShot(true);
+    _searchTimer.setInterval(liveSearchDelay);
+    connect(&_searchTimer, &QTimer::timeout, this, &MainWindow::onSearchText);
+    connect(_searchBox,
+            &QLineEdit::textChanged,
+            this,
+            &MainWindow::onSearchEdited);
+
     ui->toolBar->addSeparator();
     ui->toolBar->addWidget(searchLabel);
     ui->toolBar->addWidget(_searchBox);
+    ui->toolBar->addAction(_liveSearchAction);
+
+    // Package list - quick filter, narrows the list as it is typed in
+
+    connect(ui->packageFilterBox,
+            &QLineEdit::textChanged,
+            this,
+            &MainWindow::onQuickFilterEdited);
 
     // Assign all the models, they have all been constructed complete/empty
 
     ui->categoryTree->setModel(&ApplicationData::data()->categoryTreeModel);
-    _packageProxyModel.setSourceModel(
-        &ApplicationData::data()->packageReportModel);
-    ui->packageListView->setModel(&_packageProxyModel);
+    ui->packageListView->setModel(&ApplicationData::data()->packageReportModel);
+    ui->packageListView->sortByColumn(PackageReportItem::Column::Name,
+                                      Qt::AscendingOrder);
 
     QFont boldFont(ui->packageListView->font());
     boldFont.setWeight(QFont::Bold);
     PackageReportItem::setBoldFont(boldFont);
 
+    // The package list is painted straight from the package store
+    auto *packageDelegate = new PackageListDelegate(ui->packageListView);
+    packageDelegate->setFonts(ui->packageListView->font(), boldFont);
+    ui->packageListView->setItemDelegate(packageDelegate);
+
     _detailsDialog = new DetailsDialog(this);
     connect(this,
             &MainWindow::showEbuild,
@@ -161,12 +229,38 @@ void MainWindow::adjustCategoryTreeColumns()
 /*!
  * Adjust the icon colummn and package name column sizes of the category tree
  * view to fit content. It's a bit arbitrary, but whatever.
+ *
+ * The version columns are sized to fit their text, going by a sample of the
+ * packages rather than all of them (most of which the view hasn't fetched).
  */
 void MainWindow::adjustPackageTableColumns()
 {
     ui->packageListView->setColumnWidth(PackageReportItem::Column::Installed,
                                         24);
     ui->packageListView->setColumnWidth(PackageReportItem::Column::Name, 170);
+
+    const PackageReportModel &model =
+        ApplicationData::data()->packageReportModel;
+    if (model.store() == nullptr) {
+        return;
+    }
+    const QVector<int> sample = model.samplePackages(columnSampleSize);
+    // The bold font of the installed packages is the wider
+    const QFontMetrics metrics(PackageReportItem::boldFont().value<QFont>());
+    for (int column : {PackageReportItem::Column::InstalledVersion,
+                       PackageReportItem::Column::AvailableVersion}) {
+        int width = metrics.horizontalAdvance(
+            model.headerData(column, Qt::Horizontal).toString());
+        for (int index : sample) {
+            width = qMax(width,
+                         metrics.horizontalAdvance(
+                             model.store()
+                                 ->data(index, column, Qt::DisplayRole)
+                                 .toString()));
+        }
+        ui->packageListView->setColumnWidth(
+            column, width + 2 * metrics.averageCharWidth());
+    }
 }
 
 /*!
@@ -190,9 +284,18 @@ void MainWindow::displayCategoryTree()
             &MainWindow::onCategorySelected,
             Qt::UniqueConnection);
 
-    ui->categoryTree->setCurrentIndex(allNode);
+    QModelIndex current = ui->categoryTree->currentIndex();
+    if (current.isValid()) {
+        // A category was already picked, e.g. while eix was running or before
+        // a reload, so the selection will not change. Bring its package list
+        // up to date, keeping the package selection where possible.
+        showCategory(current, false);
+    } else {
+        ui->categoryTree->setCurrentIndex(allNode);
+    }
 
     adjustCategoryTreeColumns();
+    updateRepositoryMenu();
 }
 /*!
  * Add event to a QLineEdit widget to react to 'clear' being pressed
@@ -367,109 +470,35 @@ void MainWindow::showPackageDetails(const PackageReportItem &item)
 }
 
 /*!
- * Checks whether the database files and loaded database are consistent.
- * It does this by comparing the various data file dates. It may report,
- * via a dialog, that eix-update needs to be run - can't do this by itself.
+ * Checks that there is an eix database to show. It may report, via a
+ * dialog, that eix-update needs to be run - can't do this by itself.
+ *
+ * Nothing else needs checking: changes to the eix database (e.g. from
+ * eix-update) and to the package database (e.g. from emerge) are followed
+ * in the background as they happen (see PortageWatcher), and that includes
+ * the eix database turning up once eix-update has made it.
  *
- * Returns false if the portage data needs to be reloaded from scratch.
+ * Returns false if there is no eix database.
  */
 bool MainWindow::isDataConsistent()
 {
-    bool result{true};
-
-    // Date of emerge log file is used to determine time of last install.
-    QFileInfo emergeLogFile(ApplicationData::emergeLogFile);
-
-    // Date of portage.eix file is used to determine the last time
-    // eix-update was run
+    // The EIX file can be generated by the user running eix-update
     QFileInfo portageEixFile(ApplicationData::portageEixFile);
-
-    // The date of the timestamp.chk file is used to determine the last gentoo
-    // repo sync time.
-    QString timestampFile =
-        QStringLiteral("%1/metadata/timestamp.chk")
-            .arg(ApplicationData::data()->findRepositoryPath(
-                ApplicationData::defaultRepositoryName));
-    QFileInfo syncTimestampFile(timestampFile);
-
-    if (!emergeLogFile.exists()) {
-        // There is no emerge.log file!
-
-        // TODO - this should pop up a message and exit
-        qCritical() << emergeLogFile.absoluteFilePath() << "does not exist";
-        result = false;
-    } else if (!syncTimestampFile.exists()) {
-        // The Gentoo repository has never been sync'd!
-
-        // TODO - this should pop up a message and exit
-        qCritical() << syncTimestampFile.absoluteFilePath() << "does not exist";
-        result = false;
-    } else if (!portageEixFile.exists()) {
-        // The EIX file can be generated by the user running eix-update
-
-        qWarning() << portageEixFile.absoluteFilePath() << "does not exist";
-
-        QMessageBox::warning(
-            this,
-            QStringLiteral("Eix database does not exist"),
-            QStringLiteral("Please run \"eix-update\" in a "
-                           "console \n"
-                           "and then select menu option \"File | "
-                           "Reload EIX Database\"\n"
-                           "to show the data.\n"
-                           "\n"
-                           ""));
-        result = false;
-    } else {
-        // All the necessary files exist to determine when things happened
-        // so lets check they happened in the right order.
-
-        QDateTime lastEmerge = emergeLogFile.lastModified();
-        QDateTime lastEixUpdate = portageEixFile.lastModified();
-        QDateTime lastSync = syncTimestampFile.lastModified();
-
-        if (lastEmerge > lastEixUpdate || lastSync > lastEixUpdate) {
-
-            // Needed the last EIX update to be after last sync or emerge
-            // action. It's not, so ask user to run eix-update now.
-
-            // qDebug() << "Last emerge: " << lastEmerge;
-            // qDebug() << "Last EIX Update: " << lastEixUpdate;
-            qDebug() << "Last Sync: " << lastSync;
-            QMessageBox::warning(
-                this,
-                QStringLiteral("Eix database is out of date"),
-                QStringLiteral("Please run \"eix-update\" in a "
-                               "console to get the latest data\n"
-                               "and then select menu option \"File | "
-                               "Reload EIX Database\"\n"
-                               "to show the new data.\n"
-                               "\n"
-                               ""));
-            result = false;
-        } else if (ApplicationData::data()->lastLoadTime < lastEixUpdate) {
-
-            // Also needed the last data read to be after the last EIX update.
-            //
-            // This shouldn't be a problem since a search will always
-            // do a download, and we're here because of search.
-
-            qWarning() << "A \"can't happen\" just happened!";
-            qDebug() << "Last load: " << ApplicationData::data()->lastLoadTime;
-            qDebug() << "Last EIX Update: " << lastEixUpdate;
-            QMessageBox::warning(this,
-                                 QStringLiteral("Eix database has changed"),
-                                 QStringLiteral("Please "
-                                                "select menu option \"File | "
-                                                "Reload EIX Database\"\n"
-                                                "to show the new data.\n"
-                                                "\n"
-                                                ""));
-            result = false;
-        }
+    if (portageEixFile.exists()) {
+        return true;
     }
 
-    return result;
+    qWarning() << portageEixFile.absoluteFilePath() << "does not exist";
+
+    QMessageBox::warning(
+        this,
+        QStringLiteral("Eix database does not exist"),
+        QStringLiteral("Please run \"eix-update\" in a console.\n"
+                       "The packages will be shown as soon as it has "
+                       "finished.\n"
+                       "\n"
+                       ""));
+    return false;
 }
 
 /// Show the About... dialog
@@ -481,18 +510,23 @@ void MainWindow::aboutVizzyix()
 }
 
 /*!
- * Disables some form controls while eix is running
- * - turn off the Form|Reload option
- * - prevent changes to search text
+ * Called when eix starts and stops. The form controls are left enabled: the
+ * filters and search work on whatever has been loaded so far, and a reload
+ * just stops eix and starts it again.
+ *
+ * The category tree is filled in while eix is running, so the "All" node is
+ * expanded straight away to show the categories as they arrive.
+ *
+ * An installed-only load doesn't use eix, so the eix database isn't checked
+ * after it.
  */
 void MainWindow::onEixRunning(bool running)
 {
-    ui->actionReload->setEnabled(!running);
-    if (_searchBox != nullptr) {
-        _searchBox->setEnabled(!running);
-    }
-
-    if (!running) {
+    if (running) {
+        ui->categoryTree->hideColumn(CategoryTreeItem::Column::CatIndex);
+        ui->categoryTree->setExpanded(ui->categoryTree->model()->index(0, 0),
+                                      true);
+    } else if (!ApplicationData::data()->installedOnly()) {
         isDataConsistent();
     }
 }
@@ -505,36 +539,51 @@ void MainWindow::onCategorySelected(const QItemSelection &selected,
 {
     const QModelIndexList &list = selected.indexes();
     if (list.length() == 1) {
+        showCategory(list[0], true);
+    } else {
+        qCritical() << "onCategorySelected :" << list.length()
+                    << "items selected - should not happen";
+    }
+}
 
-        _packageProxyModel.setSortCaseSensitivity(Qt::CaseInsensitive);
-
-        // This is from the demo implementation of a tree model. Just as well
-        // really, because it would have taken a long time to figure it out from
-        // the docs.
-        CategoryTreeItem *item =
-            static_cast<CategoryTreeItem *>(list[0].internalPointer());
-
-        ApplicationData::data()->setupPackageModelData(item);
-
-        _packageProxyModel.sort(PackageReportItem::Column::Name);
+/*!
+ * Fills the package list with the packages of the given category tree node.
+ *
+ * firstPackage:
+ *     Whether to select the first package. Otherwise the current package is
+ *     kept, if it is still in the list.
+ */
+void MainWindow::showCategory(const QModelIndex &index, bool firstPackage)
+{
+    // This is from the demo implementation of a tree model. Just as well
+    // really, because it would have taken a long time to figure it out from
+    // the docs.
+    CategoryTreeItem *item =
+        static_cast<CategoryTreeItem *>(index.internalPointer());
 
-        // Don't really want this armed till something is there. The final flag,
-        // UniqueConnection, means there will only be one connection no matter
-        // how many times this bit runs...
-        connect(ui->packageListView->selectionModel(),
-                QOverload<const QItemSelection &, const QItemSelection &>::of(
-                    &QItemSelectionModel::selectionChanged),
-                this,
-                &MainWindow::onPackageSelected,
-                Qt::UniqueConnection);
+    // The model keeps the packages in the order of the sorted column
+    ApplicationData::data()->setupPackageModelData(item);
 
-        ui->packageListView->setCurrentIndex(_packageProxyModel.index(0, 0));
-        adjustPackageTableColumns();
+    // Don't really want this armed till something is there. The final flag,
+    // UniqueConnection, means there will only be one connection no matter
+    // how many times this bit runs...
+    connect(ui->packageListView->selectionModel(),
+            QOverload<const QItemSelection &, const QItemSelection &>::of(
+                &QItemSelectionModel::selectionChanged),
+            this,
+            &MainWindow::onPackageSelected,
+            Qt::UniqueConnection);
 
+    QModelIndex currentPackage = ui->packageListView->currentIndex();
+    if (firstPackage || !currentPackage.isValid()) {
+        ui->packageListView->setCurrentIndex(
+            ApplicationData::data()->packageReportModel.index(0, 0));
     } else {
-        qCritical() << "onCategorySelected :" << list.length()
-                    << "items selected - should not happen";
+        // Same package, but its details may have changed
+        onPackageSelected(QItemSelection(currentPackage, currentPackage),
+                          QItemSelection());
     }
+    adjustPackageTableColumns();
 }
 
 /*!
@@ -546,11 +595,12 @@ void MainWindow::onPackageSelected(const QItemSelection &selected,
     const QModelIndexList &list = selected.indexes();
     if (list.length() > 0) {
 
-        // The QModelIndex is for the sort proxy, so it needs to be translated
-        // to an index for the base package model.
         const PackageReportItem &item =
             ApplicationData::data()->packageReportModel.packageItem(
-                _packageProxyModel.mapToSource(list[0]).row());
+                list[0].row());
+
+        // Only a summary of the package may have been decoded so far
+        ApplicationData::data()->packageDetails(item.packageDetails());
 
         showPackageDetails(item);
 
@@ -565,7 +615,7 @@ void MainWindow::onSelectAll()
 {
     ApplicationData::data()->setSelectionFilter(
         ApplicationData::SelectionFilter::All);
-    emit loadPortageData();
+    ApplicationData::data()->applyFilters();
 }
 
 /// Select all installed packages to be displayed
@@ -573,7 +623,7 @@ void MainWindow::onSelectInstalled()
 {
     ApplicationData::data()->setSelectionFilter(
         ApplicationData::SelectionFilter::Installed);
-    emit loadPortageData();
+    ApplicationData::data()->applyFilters();
 }
 
 /// Select all world packages to be displayed
@@ -581,14 +631,122 @@ void MainWindow::onSelectWorld()
 {
     ApplicationData::data()->setSelectionFilter(
         ApplicationData::SelectionFilter::World);
-    emit loadPortageData();
+    ApplicationData::data()->applyFilters();
+}
+
+/*!
+ * Makes the Repository menu of the facets match the repositories of the data
+ * on display, e.g. after a load. The repository that was picked stays
+ * picked, if it is still there; otherwise any repository will do.
+ */
+void MainWindow::updateRepositoryMenu()
+{
+    QStringList repositories = ApplicationData::data()->repositories();
+    if (!_repositoryMenu->isEmpty() && repositories == _menuRepositories) {
+        return;
+    }
+    _menuRepositories = repositories;
+
+    QVariant picked;
+    if (QAction *checked = _repositoryGroup->checkedAction()) {
+        picked = checked->data();
+    }
+    // The actions belong to the menu, and leave the group as they go
+    _repositoryMenu->clear();
+
+    QAction *any = _repositoryMenu->addAction(tr("Any repository"));
+    any->setCheckable(true);
+    any->setChecked(true);
+    _repositoryGroup->addAction(any);
+    _repositoryMenu->addSeparator();
+
+    // Eix leaves the main repository unnamed
+    repositories.sort();
+    for (const QString &name : repositories) {
+        QAction *action = _repositoryMenu->addAction(
+            name.isEmpty() ? tr("Main repository") : name);
+        action->setCheckable(true);
+        action->setData(name);
+        action->setChecked(picked.isValid() && picked.toString() == name);
+        _repositoryGroup->addAction(action);
+    }
+
+    // The repository's number may be different in the new data
+    if (picked.isValid()) {
+        onFacetsChanged();
+    }
+}
+
+/*!
+ * A facet has been picked or dropped, so narrow the category tree and the
+ * package list to match. The facets were worked out when the data was
+ * loaded, so this doesn't run eix.
+ */
+void MainWindow::onFacetsChanged()
+{
+    FacetIndex::Selection facets;
+    for (int facet = 0; facet < _facetActions.size(); ++facet) {
+        if (_facetActions[facet]->isChecked()) {
+            facets.facets |= 1u << facet;
+        }
+    }
+    QString repositoryTitle;
+    QAction *repository = _repositoryGroup->checkedAction();
+    if (repository && repository->data().isValid()) {
+        facets.repository = ApplicationData::data()->repositories().indexOf(
+            repository->data().toString());
+        repositoryTitle = repository->text();
+    }
+
+    if (facets != ApplicationData::data()->facets()) {
+        ApplicationData::data()->categoryTreeModel.setRepositoryTitle(
+            repositoryTitle);
+        ApplicationData::data()->setFacets(facets);
+        ApplicationData::data()->applyFilters();
+    }
 }
 
 /// Apply a search filter for package names
 void MainWindow::onSearchText()
 {
+    _searchTimer.stop();
     ApplicationData::data()->setSearch(_searchBox->text());
-    emit loadPortageData();
+    ApplicationData::data()->applyFilters();
+}
+
+/// The search text has changed; in live mode, search once typing pauses
+void MainWindow::onSearchEdited()
+{
+    if (_liveSearchAction->isChecked() &&
+        _searchBox->text() != ApplicationData::data()->search()) {
+        _searchTimer.start();
+    }
+}
+
+/*!
+ * The quick filter text has changed, so narrow the package list of the
+ * current category to match. This doesn't touch the category tree.
+ */
+void MainWindow::onQuickFilterEdited(const QString &text)
+{
+    ApplicationData::data()->setQuickFilter(text);
+    QModelIndex current = ui->categoryTree->currentIndex();
+    if (current.isValid()) {
+        showCategory(current, false);
+    }
+}
+
+/*!
+ * Switches live search on or off. Live search also looks at the categories
+ * and descriptions, so the search is applied again.
+ */
+void MainWindow::onLiveSearch(bool on)
+{
+    ApplicationData::data()->setSearchDescriptions(on);
+    if (!ApplicationData::data()->search().isEmpty() ||
+        !_searchBox->text().isEmpty()) {
+        onSearchText();
+    }
 }
 
 /*!
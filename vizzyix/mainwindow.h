@@ -8,9 +8,12 @@
 #include <QItemSelection>
 #include <QLineEdit>
 #include <QMainWindow>
-#include <QSortFilterProxyModel>
+#include <QMenu>
 #include <QStandardItemModel>
 #include <QString>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
 
 #include "detailsdialog.h"
 #include "htmlgenerator.h"
@@ -56,7 +59,9 @@ class MainWindow : public QMainWindow
     void adjustPackageTableColumns();
     void displayCategoryTree();
     void fixupLineClearButton(QLineEdit *lineEdit);
+    void showCategory(const QModelIndex &index, bool firstPackage);
     void showPackageDetails(const PackageReportItem &item);
+    void updateRepositoryMenu();
     bool isDataConsistent();
 
   private slots:
@@ -70,6 +75,10 @@ class MainWindow : public QMainWindow
     void onSelectInstalled();
     void onSelectWorld();
     void onSearchText();
+    void onSearchEdited();
+    void onLiveSearch(bool on);
+    void onQuickFilterEdited(const QString &text);
+    void onFacetsChanged();
     void onClickedVersion(const QModelIndex &index);
     void aboutQt();
 
@@ -84,12 +93,6 @@ class MainWindow : public QMainWindow
      */
     DetailsDialog *_detailsDialog;
 
-    /*!
-     * Data model for the package list table view. Using a sort filter to
-     * make it easy to sort the columms by their values.
-     */
-    QSortFilterProxyModel _packageProxyModel;
-
     /// Builds the content of the summary section
     HtmlGenerator _htmlDescription;
 
@@ -99,4 +102,33 @@ class MainWindow : public QMainWindow
     /// Keep a reference to the search filter box. Needed because it gets
     /// accessed throughout.
     QLineEdit *_searchBox = nullptr;
+
+    /// Whether the search is run as the text is typed (checked), or when
+    /// Return is pressed. Owned by this window.
+    QAction *_liveSearchAction = nullptr;
+
+    /// The facets the packages can be narrowed by, on the toolbar. Owned by
+    /// this window, as are the menu's actions.
+    QMenu *_facetMenu = nullptr;
+
+    /// A checkable action for each facet but Repository, in
+    /// FacetIndex::Facet order
+    QVector<QAction *> _facetActions;
+
+    /// Picks the repository for the Repository facet, with each action's
+    /// data the repository's name (none for any repository)
+    QMenu *_repositoryMenu = nullptr;
+    QActionGroup *_repositoryGroup = nullptr;
+
+    /// The repositories listed in _repositoryMenu
+    QStringList _menuRepositories;
+
+    /// Holds back a live search until typing pauses
+    QTimer _searchTimer;
+
+    /// How long typing has to pause for before a live search, ms
+    static constexpr int liveSearchDelay = 150;
+
+    /// How many packages the version columns are sized by
+    static constexpr int columnSampleSize = 200;
 };
@@ -0,0 +1,213 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "packagedatabasescanner.h"
+#include "versionkey.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+/// The record getdents64() fills in for each directory entry
+struct LinuxDirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+/// Enough for a few hundred entries per call
+constexpr size_t direntBufferSize = 32 * 1024;
+} // namespace
+
+/// Constructor just saves the root directory
+PackageDatabaseScanner::PackageDatabaseScanner(const QString &root)
+    : _root(root.toStdString()), _lastScanTime(0)
+{
+}
+
+/*!
+ * Lists all of the installed package directories, sorted by category and
+ * then by directory name. Portage's temporary directories (e.g.
+ * "-MERGING-qt-creator-12.4.3", while it is being installed) and hidden
+ * directories are left out.
+ */
+QStringList PackageDatabaseScanner::scan()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QStringList result;
+    std::vector<std::string> categories;
+    int rootFd = open(_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0 || !readDirectory(rootFd, ".", categories)) {
+        qWarning() << "(PackageDatabaseScanner) can't read"
+                   << QString::fromStdString(_root);
+    } else {
+        std::sort(categories.begin(), categories.end());
+        result = scanCategories(rootFd, categories);
+    }
+    if (rootFd >= 0) {
+        close(rootFd);
+    }
+
+    _lastScanTime = timer.nsecsElapsed() / 1000;
+    return result;
+}
+
+/// As above, but just for the given categories, e.g. "dev-qt"
+QStringList PackageDatabaseScanner::scan(const QStringList &categories)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QStringList result;
+    int rootFd = open(_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd >= 0) {
+        std::vector<std::string> names;
+        for (const auto &category : categories) {
+            names.push_back(category.toStdString());
+        }
+        result = scanCategories(rootFd, names);
+        close(rootFd);
+    }
+
+    _lastScanTime = timer.nsecsElapsed() / 1000;
+    return result;
+}
+
+/// Sets the most threads to use for reading (1 reads serially)
+void PackageDatabaseScanner::setThreadCount(int threads)
+{
+    _pool.setMaxThreadCount(threads);
+}
+
+/// How long the last scan took, in microseconds
+qint64 PackageDatabaseScanner::lastScanTime() const
+{
+    return _lastScanTime;
+}
+
+/*!
+ * Reads the given category directories, in parallel, and returns their
+ * package directories in the same order as the categories.
+ */
+QStringList PackageDatabaseScanner::scanCategories(
+    int rootFd, const std::vector<std::string> &categories)
+{
+    const int count = static_cast<int>(categories.size());
+    std::vector<QStringList> found(count);
+    std::atomic<int> next{0};
+
+    auto worker = [&]() {
+        std::vector<std::string> packages;
+        for (int n = next++; n < count; n = next++) {
+            packages.clear();
+            if (!readDirectory(rootFd, categories[n].c_str(), packages)) {
+                continue; // e.g. removed since the root was read
+            }
+            std::sort(packages.begin(), packages.end());
+
+            const QString prefix = QString::fromStdString(categories[n]) + "/";
+            for (const auto &package : packages) {
+                if (package[0] != '-') {
+                    found[n].append(prefix + QString::fromStdString(package));
+                }
+            }
+        }
+    };
+
+    int helpers = qMin(count, _pool.maxThreadCount()) - 1;
+    for (int n = 0; n < helpers; ++n) {
+        _pool.start(worker);
+    }
+    worker();
+    _pool.waitForDone();
+
+    QStringList result;
+    for (const auto &packages : found) {
+        result.append(packages);
+    }
+    return result;
+}
+
+/*!
+ * Lists the directories in a directory, opened relative to dirFd. Hidden
+ * names (including "." and "..") are left out.
+ *
+ * Some file systems (e.g. some NFS servers) don't give the file types; those
+ * entries are taken to be directories rather than stat'ing them, as nothing
+ * else is expected in the package database.
+ *
+ * Returns false if the directory can't be read.
+ */
+bool PackageDatabaseScanner::readDirectory(int dirFd,
+                                           const char *path,
+                                           std::vector<std::string> &names)
+{
+    int fd = openat(dirFd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    alignas(LinuxDirent64) char buffer[direntBufferSize];
+    bool ok = true;
+    for (;;) {
+        long size = syscall(SYS_getdents64, fd, buffer, sizeof(buffer));
+        if (size <= 0) {
+            ok = size == 0;
+            break;
+        }
+        for (long pos = 0; pos < size;) {
+            const auto *entry =
+                reinterpret_cast<const LinuxDirent64 *>(buffer + pos);
+            pos += entry->d_reclen;
+
+            if (entry->d_name[0] == '.' ||
+                (entry->d_type != DT_DIR && entry->d_type != DT_UNKNOWN)) {
+                continue;
+            }
+            names.emplace_back(entry->d_name);
+        }
+    }
+
+    close(fd);
+    return ok;
+}
+
+/*!
+ * Splits a package directory name into the package name and the version, as
+ * PMS (the Package Manager Specification) defines them. The version is the
+ * last hyphen-separated part that is a valid version (see VersionKey), along
+ * with the revision (e.g. "-r1") if there is one. The name may also have
+ * parts that start with digits, e.g. "font-adobe-100dpi-1.0.4".
+ *
+ * Returns false if there is no valid version.
+ */
+bool PackageDatabaseScanner::splitPackageDir(std::string_view dirName,
+                                             std::string_view &name,
+                                             std::string_view &version)
+{
+    size_t dash = dirName.rfind('-');
+    if (dash != std::string_view::npos && dash > 0 &&
+        !VersionKey::isValid(dirName.substr(dash + 1))) {
+        // It may be the revision, with the version before it
+        dash = dirName.rfind('-', dash - 1);
+    }
+    if (dash == std::string_view::npos || dash == 0 ||
+        !VersionKey::isValid(dirName.substr(dash + 1))) {
+        return false;
+    }
+
+    name = dirName.substr(0, dash);
+    version = dirName.substr(dash + 1);
+    return true;
+}
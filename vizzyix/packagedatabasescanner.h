@@ -0,0 +1,59 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtGlobal>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/*! class PackageDatabaseScanner
+ *
+ * Lists the installed package directories in the portage package database
+ * (/var/db/pkg), as "category/package-version".
+ *
+ * The category directories are read in parallel, straight from the kernel
+ * with getdents64(); the file types come with the names, so nothing is
+ * stat'ed. That matters most on a cold cache or a network file system,
+ * where each stat can be a round trip.
+ *
+ * Nothing is logged; how long a scan took is kept for lastScanTime().
+ */
+class PackageDatabaseScanner
+{
+  public:
+    explicit PackageDatabaseScanner(const QString &root);
+
+    PackageDatabaseScanner(const PackageDatabaseScanner &) = delete;
+    PackageDatabaseScanner &operator=(PackageDatabaseScanner &) = delete;
+
+    QStringList scan();
+    QStringList scan(const QStringList &categories);
+    void setThreadCount(int threads);
+    qint64 lastScanTime() const;
+
+    static bool splitPackageDir(std::string_view dirName,
+                                std::string_view &name,
+                                std::string_view &version);
+
+  private:
+    QStringList scanCategories(int rootFd,
+                               const std::vector<std::string> &categories);
+    static bool readDirectory(int dirFd,
+                              const char *path,
+                              std::vector<std::string> &names);
+
+  private:
+    /// The root of the package database, e.g. /var/db/pkg
+    const std::string _root;
+
+    /// How long the last scan took, in microseconds
+    qint64 _lastScanTime;
+
+    /// Threads for reading the category directories in parallel
+    QThreadPool _pool;
+};
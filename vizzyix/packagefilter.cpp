@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "packagefilter.h"
+
+#include <algorithm>
+#include <cctype>
+
+#include "eixprotohelper.h"
+
+namespace
+{
+/// Case insensitive comparison of a name character with a lower case one
+bool sameLetter(char a, char b)
+{
+    return std::tolower(static_cast<unsigned char>(a)) ==
+           static_cast<unsigned char>(b);
+}
+} // namespace
+
+/// Constructor, the default filter matches everything
+PackageFilter::PackageFilter(Selection selection, const QString &search)
+    : _selection(selection), _anchorStart(false), _anchorEnd(false),
+      _searchDescriptions(false)
+{
+    setSearch(search);
+}
+
+/// The main filter
+PackageFilter::Selection PackageFilter::selection() const
+{
+    return _selection;
+}
+
+/// Sets the main filter
+void PackageFilter::setSelection(Selection selection)
+{
+    _selection = selection;
+}
+
+/// The search text, as given to setSearch()
+const QString &PackageFilter::search() const
+{
+    return _search;
+}
+
+/// Sets the search text, an empty string matches all names
+void PackageFilter::setSearch(const QString &search)
+{
+    _search = search;
+
+    QString pattern = search;
+    _anchorStart = pattern.startsWith('^');
+    _anchorEnd = pattern.endsWith('$');
+    while (pattern.startsWith('^')) {
+        pattern.remove(0, 1);
+    }
+    while (pattern.endsWith('$')) {
+        pattern.chop(1);
+    }
+    _pattern = pattern.toLower().toStdString();
+}
+
+/// The search text without anchors, in lower case
+const std::string &PackageFilter::pattern() const
+{
+    return _pattern;
+}
+
+/// Whether the category and description are searched as well as the name
+bool PackageFilter::searchDescriptions() const
+{
+    return _searchDescriptions;
+}
+
+/*!
+ * Sets whether search text without anchors is also looked for in the
+ * category name and the package description.
+ */
+void PackageFilter::setSearchDescriptions(bool on)
+{
+    _searchDescriptions = on;
+}
+
+/// Whether any filtering is done at all
+bool PackageFilter::isActive() const
+{
+    return _selection != All || !_search.isEmpty();
+}
+
+/// Whether the package, in the given category, passes the filter
+bool PackageFilter::matches(const eix_proto::Category &category,
+                            const eix_proto::Package &package) const
+{
+    return matchesSelection(package) &&
+           matchesText(category.category(),
+                       package.name(),
+                       package.description());
+}
+
+/*!
+ * Whether a package passes the filter, given its fields: the category name,
+ * package name and description, and whether it is installed and in the
+ * world file or a set (as for isInstalled() and isWorld()).
+ */
+bool PackageFilter::matches(std::string_view category,
+                            std::string_view name,
+                            std::string_view description,
+                            bool installed,
+                            bool world) const
+{
+    if ((_selection == Installed && !installed) ||
+        (_selection == World && !world)) {
+        return false;
+    }
+    return matchesText(category, name, description);
+}
+
+/// Whether the package passes the main filter
+bool PackageFilter::matchesSelection(const eix_proto::Package &package) const
+{
+    switch (_selection) {
+    case Installed:
+        return isInstalled(package);
+    case World:
+        return isWorld(package);
+    case All:
+        break;
+    }
+    return true;
+}
+
+/// The numbers of the packages in the category that pass the filter
+std::vector<int>
+PackageFilter::matchingPackages(const eix_proto::Category &category) const
+{
+    std::vector<int> result;
+    result.reserve(category.package_size());
+    for (int pkgNumber = 0; pkgNumber < category.package_size(); ++pkgNumber) {
+        if (matches(category, category.package(pkgNumber))) {
+            result.push_back(pkgNumber);
+        }
+    }
+    return result;
+}
+
+/// Whether any version of the package is installed, as for "eix -I"
+bool PackageFilter::isInstalled(const eix_proto::Package &package)
+{
+    for (int verNumber = 0; verNumber < package.version_size(); ++verNumber) {
+        if (package.version(verNumber).has_installed()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/*!
+ * Whether the package is in the world file, a world set or the system set,
+ * as for "eix --world" (see EixProtoHelper::classifyInstallType()).
+ */
+bool PackageFilter::isWorld(const eix_proto::Package &package)
+{
+    for (int verNumber = 0; verNumber < package.version_size(); ++verNumber) {
+        if (EixProtoHelper::classifyInstallType(package.version(verNumber)) !=
+            eix_proto::MaskFlags_MaskFlag_UNKNOWN) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Whether the package's text matches the search text
+bool PackageFilter::matchesText(std::string_view category,
+                                std::string_view name,
+                                std::string_view description) const
+{
+    if (matchesName(name)) {
+        return true;
+    }
+    return _searchDescriptions && !_anchorStart && !_anchorEnd &&
+           (contains(category) || contains(description));
+}
+
+/// Whether the package name matches the search text
+bool PackageFilter::matchesName(std::string_view name) const
+{
+    if (_pattern.empty()) {
+        return true;
+    }
+    if (name.size() < _pattern.size()) {
+        return false;
+    }
+
+    if (_anchorStart && _anchorEnd && name.size() != _pattern.size()) {
+        return false;
+    }
+
+    auto patternSize = static_cast<std::ptrdiff_t>(_pattern.size());
+    if (_anchorStart) {
+        return std::equal(name.begin(),
+                          name.begin() + patternSize,
+                          _pattern.begin(),
+                          sameLetter);
+    }
+    if (_anchorEnd) {
+        return std::equal(
+            name.end() - patternSize, name.end(), _pattern.begin(), sameLetter);
+    }
+    return contains(name);
+}
+
+/// Whether the text contains the pattern anywhere, ignoring case
+bool PackageFilter::contains(std::string_view text) const
+{
+    return std::search(text.begin(),
+                       text.end(),
+                       _pattern.begin(),
+                       _pattern.end(),
+                       sameLetter) != text.end();
+}
@@ -0,0 +1,85 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QString>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "eix.pb.h"
+
+/*! class PackageFilter
+ *
+ * Picks out the packages that match the main filter (all, installed or
+ * world) and the search text, from a full set of eix data. This gives the
+ * same packages as running eix with "-I", "--world" and the search pattern,
+ * without running eix again.
+ *
+ * The search text is what SearchBoxValidator allows: letters, digits and
+ * dashes, optionally anchored with "^" and/or "$". It is matched against the
+ * package name, ignoring case. With setSearchDescriptions(), text without
+ * anchors is also looked for in the category name and the description.
+ *
+ * A package can also be given by its fields, e.g. from a PackageStore, so
+ * filtering doesn't need the eix data at all.
+ */
+class PackageFilter
+{
+  public:
+    /// Defines the main filter types
+    enum Selection { All, Installed, World };
+
+    explicit PackageFilter(Selection selection = All,
+                           const QString &search = QString());
+
+    Selection selection() const;
+    void setSelection(Selection selection);
+    const QString &search() const;
+    void setSearch(const QString &search);
+    const std::string &pattern() const;
+    bool searchDescriptions() const;
+    void setSearchDescriptions(bool on);
+    bool isActive() const;
+
+    bool matches(const eix_proto::Category &category,
+                 const eix_proto::Package &package) const;
+    bool matches(std::string_view category,
+                 std::string_view name,
+                 std::string_view description,
+                 bool installed,
+                 bool world) const;
+    std::vector<int>
+    matchingPackages(const eix_proto::Category &category) const;
+
+    static bool isInstalled(const eix_proto::Package &package);
+    static bool isWorld(const eix_proto::Package &package);
+
+  private:
+    bool matchesSelection(const eix_proto::Package &package) const;
+    bool matchesText(std::string_view category,
+                     std::string_view name,
+                     std::string_view description) const;
+    bool matchesName(std::string_view name) const;
+    bool contains(std::string_view text) const;
+
+  private:
+    /// The main filter
+    Selection _selection;
+
+    /// The search text as given
+    QString _search;
+
+    /// The search text without anchors, in lower case
+    std::string _pattern;
+
+    /// Whether the name has to start with the pattern ("^")
+    bool _anchorStart;
+
+    /// Whether the name has to end with the pattern ("$")
+    bool _anchorEnd;
+
+    /// Whether the category and description are searched as well
+    bool _searchDescriptions;
+};
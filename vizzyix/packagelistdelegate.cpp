@@ -0,0 +1,170 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "packagelistdelegate.h"
+
+#include <QApplication>
+#include <QFontMetrics>
+#include <QIcon>
+#include <QPainter>
+#include <QStyle>
+
+/// Constructor sets how many strings are kept laid out
+PackageListDelegate::PackageListDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+    for (auto &cache : _shapedText) {
+        cache.setMaxCost(shapedTextCount);
+    }
+}
+
+/*!
+ * Sets the fonts for the packages that aren't installed, and for those that
+ * are (see PackageReportItem::boldFont()). Any text laid out in the old
+ * fonts is thrown away.
+ */
+void PackageListDelegate::setFonts(const QFont &font, const QFont &boldFont)
+{
+    _font = font;
+    _boldFont = boldFont;
+    for (auto &cache : _shapedText) {
+        cache.clear();
+    }
+}
+
+/*!
+ * Paints a cell the way QStyledItemDelegate would, but with the text and
+ * icon taken straight from the package store.
+ */
+void PackageListDelegate::paint(QPainter *painter,
+                                const QStyleOptionViewItem &option,
+                                const QModelIndex &index) const
+{
+    const auto *model = qobject_cast<const PackageReportModel *>(index.model());
+    if (!model || !model->store()) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+    const PackageStore &store = *model->store();
+    const int package = model->packageIndex(index.row());
+
+    const QWidget *widget = option.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    const int margin =
+        style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, widget) + 1;
+    const QRect rect = option.rect.adjusted(margin, 0, -margin, 0);
+
+    // The background, and the highlight if the row is selected
+    style->drawPrimitive(
+        QStyle::PE_PanelItemViewItem, &option, painter, widget);
+
+    if (index.column() == PackageReportItem::Column::Installed) {
+        const PackageReportItem::Marker marker = store.marker(package);
+        if (marker != PackageReportItem::NoMarker) {
+            const QSize size = option.decorationSize;
+            const QPixmap &atlas =
+                markerAtlas(size, painter->device()->devicePixelRatioF());
+            const qreal ratio = atlas.devicePixelRatio();
+            painter->drawPixmap(
+                QRectF(rect.left(),
+                       rect.top() + (rect.height() - size.height()) / 2,
+                       size.width(),
+                       size.height()),
+                atlas,
+                QRectF(marker * size.width() * ratio,
+                       0,
+                       size.width() * ratio,
+                       size.height() * ratio));
+        }
+    } else {
+        const QString &text = store.text(package, index.column());
+        if (!text.isEmpty()) {
+            const bool bold = store.installed(package);
+            const QPalette::ColorGroup group =
+                !(option.state & QStyle::State_Enabled) ? QPalette::Disabled
+                : option.state & QStyle::State_Active   ? QPalette::Normal
+                                                        : QPalette::Inactive;
+            const QPalette::ColorRole role =
+                option.state & QStyle::State_Selected
+                    ? QPalette::HighlightedText
+                    : QPalette::Text;
+            painter->save();
+            painter->setPen(option.palette.color(group, role));
+            painter->setFont(bold ? _boldFont : _font);
+
+            // The text as laid out before, unless it has to be cut short
+            const QStaticText *shaped = shapedText(text, bold);
+            if (shaped->size().width() <= rect.width()) {
+                painter->drawStaticText(
+                    QPointF(rect.left(),
+                            rect.top() +
+                                (rect.height() - shaped->size().height()) / 2),
+                    *shaped);
+            } else {
+                const QFontMetrics metrics(painter->font());
+                painter->drawText(rect,
+                                  Qt::AlignLeft | Qt::AlignVCenter,
+                                  metrics.elidedText(text,
+                                                     option.textElideMode,
+                                                     rect.width()));
+            }
+            painter->restore();
+        }
+    }
+
+    if (option.state & QStyle::State_HasFocus) {
+        QStyleOptionFocusRect focus;
+        focus.QStyleOption::operator=(option);
+        focus.backgroundColor = option.palette.color(
+            option.state & QStyle::State_Selected ? QPalette::Highlight
+                                                  : QPalette::Window);
+        style->drawPrimitive(
+            QStyle::PE_FrameFocusRect, &focus, painter, widget);
+    }
+}
+
+/*!
+ * The marker icons (see PackageReportItem::markerIcon()) at the given size,
+ * side by side, with a gap where NoMarker would be. This is made the first
+ * time, and again if the size or the screen's pixel ratio changes.
+ */
+const QPixmap &PackageListDelegate::markerAtlas(const QSize &size,
+                                                qreal pixelRatio) const
+{
+    typedef PackageReportItem::Marker Marker;
+
+    const QSize atlasSize(size.width() * Marker::MarkerCount, size.height());
+    if (_markerAtlas.size() != atlasSize * pixelRatio ||
+        _markerAtlas.devicePixelRatio() != pixelRatio) {
+        QPixmap atlas(atlasSize * pixelRatio);
+        atlas.setDevicePixelRatio(pixelRatio);
+        atlas.fill(Qt::transparent);
+
+        QPainter painter(&atlas);
+        for (int marker = Marker::NoMarker + 1; marker < Marker::MarkerCount;
+             ++marker) {
+            PackageReportItem::markerIcon(static_cast<Marker>(marker))
+                .value<QIcon>()
+                .paint(&painter,
+                       QRect(QPoint(marker * size.width(), 0), size));
+        }
+        painter.end();
+        _markerAtlas = atlas;
+    }
+    return _markerAtlas;
+}
+
+/// The text laid out in the font for installed packages, or the other one
+const QStaticText *PackageListDelegate::shapedText(const QString &text,
+                                                   bool bold) const
+{
+    QCache<QString, QStaticText> &cache = _shapedText[bold];
+    QStaticText *shaped = cache.object(text);
+    if (!shaped) {
+        shaped = new QStaticText(text);
+        shaped->setTextFormat(Qt::PlainText);
+        shaped->prepare(QTransform(), bold ? _boldFont : _font);
+        cache.insert(text, shaped);
+    }
+    return shaped;
+}
@@ -0,0 +1,57 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QCache>
+#include <QFont>
+#include <QPixmap>
+#include <QStaticText>
+#include <QString>
+#include <QStyledItemDelegate>
+
+#include "packagereportmodel.h"
+
+/*! class PackageListDelegate
+ *
+ * Paints the cells of the package list straight from the package store,
+ * rather than asking the model for each cell's text, font and icon as
+ * QVariants (as QStyledItemDelegate does).
+ *
+ * The Installed column's icons are drawn from one pixmap holding them all,
+ * made once. The text is laid out once and kept (see QStaticText), for the
+ * most recently drawn strings, and only laid out again when it has to be
+ * elided to fit.
+ *
+ * Anything that isn't from a PackageReportModel is left to
+ * QStyledItemDelegate.
+ */
+class PackageListDelegate : public QStyledItemDelegate
+{
+  public:
+    explicit PackageListDelegate(QObject *parent = nullptr);
+
+    void setFonts(const QFont &font, const QFont &boldFont);
+
+    void paint(QPainter *painter,
+               const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+
+  private:
+    const QPixmap &markerAtlas(const QSize &size, qreal pixelRatio) const;
+    const QStaticText *shapedText(const QString &text, bool bold) const;
+
+  private:
+    /// How many strings are kept laid out, for each font
+    static constexpr int shapedTextCount = 4096;
+
+    /// The fonts for packages that aren't installed, and that are
+    QFont _font;
+    QFont _boldFont;
+
+    /// Every marker icon, side by side in PackageReportItem::Marker order
+    mutable QPixmap _markerAtlas;
+
+    /// Strings as laid out in _font, and in _boldFont
+    mutable QCache<QString, QStaticText> _shapedText[2];
+};
@@ -0,0 +1,381 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "packagemetadatatable.h"
+#include "packagedatabasescanner.h"
+#include "versionkey.h"
+
+#include <QDebug>
+#include <QElapsedTimer>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fcntl.h>
+#include <map>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+/// The file each text column is read from
+const char *const columnFiles[] = {
+    "SLOT", "repository", "USE", "IUSE", "DESCRIPTION"};
+
+/// How many package directories a worker takes at a time
+constexpr int batchSize = 64;
+
+/// Splits a list of flags, e.g. the USE file, into its words
+std::vector<std::string_view> words(std::string_view text)
+{
+    std::vector<std::string_view> result;
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(' ', pos);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        if (end > pos) {
+            result.push_back(text.substr(pos, end - pos));
+        }
+        pos = end + 1;
+    }
+    return result;
+}
+} // namespace
+
+/// Constructor just saves the root directory
+PackageMetadataTable::PackageMetadataTable(const QString &root)
+    : _root(root.toStdString()), _columns(new Columns), _lastReadCount(0),
+      _lastUpdateTime(0)
+{
+}
+
+/*!
+ * Brings the table into line with the given package directories (e.g. from
+ * PackageDatabaseScanner::scan()), in the same order. Directories that
+ * haven't been modified since the last update keep their old rows; the rest
+ * are read in parallel, a batch at a time.
+ */
+void PackageMetadataTable::update(const QStringList &packageDirs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int count = static_cast<int>(packageDirs.size());
+    std::vector<std::string> dirs;
+    dirs.reserve(count);
+    for (const auto &dir : packageDirs) {
+        dirs.push_back(dir.toStdString());
+    }
+
+    std::vector<RowData> rows(count);
+    std::atomic<int> next{0};
+    std::atomic<int> readCount{0};
+    int rootFd = open(_root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (rootFd < 0) {
+        qWarning() << "(PackageMetadataTable) can't read"
+                   << QString::fromStdString(_root);
+    } else {
+        auto worker = [&]() {
+            for (int first = next.fetch_add(batchSize); first < count;
+                 first = next.fetch_add(batchSize)) {
+                const int last = std::min(first + batchSize, count);
+                for (int n = first; n < last; ++n) {
+                    if (readRow(rootFd, dirs[n], rows[n])) {
+                        ++readCount;
+                    }
+                }
+            }
+        };
+
+        const int batches = (count + batchSize - 1) / batchSize;
+        const int helpers = qMin(batches, _pool.maxThreadCount()) - 1;
+        for (int n = 0; n < helpers; ++n) {
+            _pool.start(worker);
+        }
+        worker();
+        _pool.waitForDone();
+        close(rootFd);
+    }
+
+    auto columns = std::make_unique<Columns>();
+    for (int n = 0; n < count; ++n) {
+        addRow(*columns, dirs[n], rows[n]);
+    }
+    _columns = std::move(columns);
+
+    _lastReadCount = readCount;
+    _lastUpdateTime = timer.nsecsElapsed() / 1000;
+}
+
+/// Empties the table, so the next update reads everything
+void PackageMetadataTable::clear()
+{
+    _columns = std::make_unique<Columns>();
+}
+
+/*!
+ * Adds the installed packages to an (empty) eix collection, as eix itself
+ * would have them: categories and packages in name order, each version
+ * marked as installed, with the versions in order.
+ *
+ * Only what the package database knows is filled in. In particular there
+ * are no keyword flags, as those depend on the portage configuration.
+ */
+void PackageMetadataTable::fillCollection(eix_proto::Collection &eix) const
+{
+    // category -> package -> (version key, row)
+    typedef std::vector<std::pair<std::string, int>> VersionList;
+    std::map<std::string_view, std::map<std::string_view, VersionList>> tree;
+
+    for (int row = 0; row < rowCount(); ++row) {
+        std::string_view dir = _columns->strings.str(_columns->packageDir[row]);
+        const size_t slash = dir.find('/');
+        std::string_view name;
+        std::string_view version;
+        if (slash == std::string_view::npos ||
+            !PackageDatabaseScanner::splitPackageDir(
+                dir.substr(slash + 1), name, version)) {
+            continue;
+        }
+        tree[dir.substr(0, slash)][name].emplace_back(VersionKey::key(version),
+                                                      row);
+    }
+
+    for (auto &[categoryName, packages] : tree) {
+        auto *category = eix.add_category();
+        category->set_category(std::string(categoryName));
+
+        for (auto &[packageName, versions] : packages) {
+            std::sort(versions.begin(), versions.end());
+
+            auto *pkg = category->add_package();
+            pkg->set_name(std::string(packageName));
+            pkg->set_description(
+                std::string(text(versions.back().second, Description)));
+
+            const size_t versionStart = categoryName.size() +
+                                        packageName.size() + 2; // "/" and "-"
+            for (const auto &[key, row] : versions) {
+                auto *ver = pkg->add_version();
+                std::string_view dir =
+                    _columns->strings.str(_columns->packageDir[row]);
+                ver->set_id(std::string(dir.substr(versionStart)));
+                ver->set_slot(std::string(text(row, Slot)));
+                ver->mutable_repository()->set_repository(
+                    std::string(text(row, Repository)));
+
+                // IUSE has the default of each flag, USE the actual setting
+                auto *installed = ver->mutable_installed();
+                installed->set_date(buildTime(row));
+                const auto enabled = words(text(row, Use));
+                for (auto flag : words(text(row, Iuse))) {
+                    const char prefix = flag[0];
+                    if (prefix == '+' || prefix == '-') {
+                        flag.remove_prefix(1);
+                    }
+                    const std::string flagName(flag);
+                    if (prefix == '+') {
+                        ver->add_iuse_plus(flagName);
+                    } else if (prefix == '-') {
+                        ver->add_iuse_minus(flagName);
+                    } else {
+                        ver->add_iuse(flagName);
+                    }
+
+                    if (std::find(enabled.begin(), enabled.end(), flag) !=
+                        enabled.end()) {
+                        installed->add_use_enabled(flagName);
+                    } else {
+                        installed->add_use_disabled(flagName);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// The number of package directories in the table
+int PackageMetadataTable::rowCount() const
+{
+    return static_cast<int>(_columns->packageDir.size());
+}
+
+/// The row of a package directory, e.g. "dev-qt/qtbase-6.7.2", or -1
+int PackageMetadataTable::find(const QString &packageDir) const
+{
+    StringPool::Id id = _columns->strings.find(packageDir.toStdString());
+    return id == StringPool::npos ? -1 : _columns->rows.value(id, -1);
+}
+
+/// The package directory of a row, e.g. "dev-qt/qtbase-6.7.2"
+QString PackageMetadataTable::packageDir(int row) const
+{
+    std::string_view dir = _columns->strings.str(_columns->packageDir[row]);
+    return QString::fromUtf8(dir.data(), dir.size());
+}
+
+/// The text of a row's column, empty if the file is missing
+std::string_view PackageMetadataTable::text(int row, Column column) const
+{
+    return _columns->strings.str(_columns->text[column][row]);
+}
+
+/// The installed size (SIZE), in bytes
+qint64 PackageMetadataTable::installedSize(int row) const
+{
+    return _columns->installedSize[row];
+}
+
+/// When the package was built (BUILD_TIME), in seconds since the epoch
+qint64 PackageMetadataTable::buildTime(int row) const
+{
+    return _columns->buildTime[row];
+}
+
+/// Portage's install counter (COUNTER), larger for later installs
+qint64 PackageMetadataTable::counter(int row) const
+{
+    return _columns->counter[row];
+}
+
+/// Sets the most threads to use for reading (1 reads serially)
+void PackageMetadataTable::setThreadCount(int threads)
+{
+    _pool.setMaxThreadCount(threads);
+}
+
+/// The number of directories the last update actually read
+int PackageMetadataTable::lastReadCount() const
+{
+    return _lastReadCount;
+}
+
+/// How long the last update took, in microseconds
+qint64 PackageMetadataTable::lastUpdateTime() const
+{
+    return _lastUpdateTime;
+}
+
+/*!
+ * Fills in a row for a package directory, unless the old one can be kept
+ * (i.e. the directory hasn't been modified since it was read). Runs on the
+ * worker threads, so only reads the old table.
+ *
+ * Returns true if the directory was read.
+ */
+bool PackageMetadataTable::readRow(int rootFd,
+                                   const std::string &packageDir,
+                                   RowData &row) const
+{
+    struct stat info;
+    if (fstatat(rootFd, packageDir.c_str(), &info, 0) != 0) {
+        row.oldRow = -1;
+        row.modified = -1;
+        return false; // e.g. removed since the scan; the row is left empty
+    }
+    row.modified = info.st_mtim.tv_sec * 1000000000LL + info.st_mtim.tv_nsec;
+
+    StringPool::Id id = _columns->strings.find(packageDir);
+    row.oldRow = id == StringPool::npos ? -1 : _columns->rows.value(id, -1);
+    if (row.oldRow >= 0 && _columns->modified[row.oldRow] == row.modified) {
+        return false;
+    }
+    row.oldRow = -1;
+
+    int dirFd =
+        openat(rootFd, packageDir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirFd < 0) {
+        return false;
+    }
+    for (int column = 0; column < ColumnCount; ++column) {
+        readFile(dirFd, columnFiles[column], row.text[column]);
+    }
+    std::string number;
+    row.installedSize = readFile(dirFd, "SIZE", number) ? toNumber(number) : 0;
+    row.buildTime = readFile(dirFd, "BUILD_TIME", number) ? toNumber(number)
+                                                          : 0;
+    row.counter = readFile(dirFd, "COUNTER", number) ? toNumber(number) : 0;
+    close(dirFd);
+    return true;
+}
+
+/// Adds a row to the new table, copying the old row if it was kept
+void PackageMetadataTable::addRow(Columns &columns,
+                                  const std::string &packageDir,
+                                  const RowData &row) const
+{
+    const int rowNumber = static_cast<int>(columns.packageDir.size());
+    const StringPool::Id dirId = columns.strings.add(packageDir);
+    columns.packageDir.push_back(dirId);
+    columns.rows.insert(dirId, rowNumber);
+    columns.modified.push_back(row.modified);
+
+    if (row.oldRow >= 0) {
+        const Columns &old = *_columns;
+        for (int column = 0; column < ColumnCount; ++column) {
+            columns.text[column].push_back(columns.strings.add(
+                old.strings.str(old.text[column][row.oldRow])));
+        }
+        columns.installedSize.push_back(old.installedSize[row.oldRow]);
+        columns.buildTime.push_back(old.buildTime[row.oldRow]);
+        columns.counter.push_back(old.counter[row.oldRow]);
+    } else {
+        for (int column = 0; column < ColumnCount; ++column) {
+            columns.text[column].push_back(
+                columns.strings.add(row.text[column]));
+        }
+        columns.installedSize.push_back(row.installedSize);
+        columns.buildTime.push_back(row.buildTime);
+        columns.counter.push_back(row.counter);
+    }
+}
+
+/*!
+ * Reads one of the small files in a package directory, without the trailing
+ * newline (or any other trailing white space). The contents are left empty
+ * if there is no such file.
+ *
+ * Returns false if the file can't be read.
+ */
+bool PackageMetadataTable::readFile(int dirFd,
+                                    const char *name,
+                                    std::string &contents)
+{
+    contents.clear();
+    int fd = openat(dirFd, name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    char buffer[4096];
+    bool ok = true;
+    for (;;) {
+        ssize_t size = read(fd, buffer, sizeof(buffer));
+        if (size <= 0) {
+            ok = size == 0;
+            break;
+        }
+        contents.append(buffer, size);
+    }
+    close(fd);
+
+    while (!contents.empty() &&
+           isspace(static_cast<unsigned char>(contents.back()))) {
+        contents.pop_back();
+    }
+    return ok;
+}
+
+/// Reads a whole number, e.g. from the COUNTER file; 0 if there isn't one
+qint64 PackageMetadataTable::toNumber(const std::string &digits)
+{
+    qint64 value = 0;
+    for (char c : digits) {
+        if (c < '0' || c > '9') {
+            break;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
@@ -0,0 +1,108 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtGlobal>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "eix.pb.h"
+#include "stringpool.h"
+
+/*! class PackageMetadataTable
+ *
+ * What the portage package database (/var/db/pkg) says about each installed
+ * package version: the small files portage leaves in each package directory
+ * (SLOT, USE, IUSE, SIZE, BUILD_TIME, repository, COUNTER and DESCRIPTION).
+ * These are up to date as soon as an emerge has finished, unlike the eix
+ * data.
+ *
+ * The table is kept by column: one array per field, with a row for each
+ * package directory. The text is interned (see StringPool), so e.g. each
+ * repository name is only stored once.
+ *
+ * The package directories are read in parallel, a batch at a time. Each
+ * directory's modification time is kept, and a directory that hasn't
+ * changed since the last update isn't read again (portage replaces the
+ * whole directory when it reinstalls a package).
+ */
+class PackageMetadataTable
+{
+  public:
+    /// The text columns, each read from the file of the same name
+    enum Column { Slot, Repository, Use, Iuse, Description, ColumnCount };
+
+    explicit PackageMetadataTable(const QString &root);
+
+    PackageMetadataTable(const PackageMetadataTable &) = delete;
+    PackageMetadataTable &operator=(PackageMetadataTable &) = delete;
+
+    void update(const QStringList &packageDirs);
+    void clear();
+    void fillCollection(eix_proto::Collection &eix) const;
+
+    int rowCount() const;
+    int find(const QString &packageDir) const;
+    QString packageDir(int row) const;
+    std::string_view text(int row, Column column) const;
+    qint64 installedSize(int row) const;
+    qint64 buildTime(int row) const;
+    qint64 counter(int row) const;
+
+    void setThreadCount(int threads);
+    int lastReadCount() const;
+    qint64 lastUpdateTime() const;
+
+  private:
+    /// One package directory's metadata, as read by a worker thread
+    struct RowData {
+        int oldRow = -1;
+        qint64 modified = -1;
+        std::string text[ColumnCount];
+        qint64 installedSize = 0;
+        qint64 buildTime = 0;
+        qint64 counter = 0;
+    };
+
+    /// The table itself, replaced as a whole by each update
+    struct Columns {
+        StringPool strings;
+        std::vector<StringPool::Id> packageDir;
+        std::vector<StringPool::Id> text[ColumnCount];
+        std::vector<qint64> installedSize;
+        std::vector<qint64> buildTime;
+        std::vector<qint64> counter;
+        std::vector<qint64> modified;
+        QHash<StringPool::Id, int> rows;
+    };
+
+    bool readRow(int rootFd, const std::string &packageDir, RowData &row) const;
+    void addRow(Columns &columns,
+                const std::string &packageDir,
+                const RowData &row) const;
+    static bool readFile(int dirFd, const char *name, std::string &contents);
+    static qint64 toNumber(const std::string &digits);
+
+  private:
+    /// The root of the package database, e.g. /var/db/pkg
+    const std::string _root;
+
+    /// The metadata of each package directory
+    std::unique_ptr<Columns> _columns;
+
+    /// The number of directories actually read by the last update
+    int _lastReadCount;
+
+    /// How long the last update took, in microseconds
+    qint64 _lastUpdateTime;
+
+    /// Threads for reading the package directories in parallel
+    QThreadPool _pool;
+};
@@ -4,6 +4,7 @@
 #include "packagereportitem.h"
 #include "combinedpackagelist.h"
 #include "eixprotohelper.h"
+#include "versionkey.h"
 
 #include <QBrush>
 #include <QDebug>
@@ -38,7 +39,7 @@ void PackageReportItem::setBoldFont(QFont font)
 
 PackageReportItem::PackageReportItem(const std::string &catName,
                                      const eix_proto::Package &pkg,
-                                     VersionMap &zombies)
+                                     const QStringList &zombies)
     : _packageDetails(&pkg), _catName(catName), _zombieVersions(zombies)
 {
     cacheValues();
@@ -47,7 +48,10 @@ PackageReportItem::PackageReportItem(const std::string &catName,
 PackageReportItem::PackageReportItem(const PackageReportItem &item)
     : _packageDetails(item._packageDetails), _catName(item._catName),
       _installType(item._installType), _isInstalled(item._isInstalled),
-      _versions(item._versions), _zombieVersions(item._zombieVersions)
+      _versions(item._versions), _marker(item._marker),
+      _display(item._display), _installedSortKey(item._installedSortKey),
+      _availableSortKey(item._availableSortKey),
+      _zombieVersions(item._zombieVersions)
 {
 }
 
@@ -66,6 +70,10 @@ void swap(PackageReportItem &first, PackageReportItem &second)
     swap(first._installType, second._installType);
     swap(first._isInstalled, second._isInstalled);
     first._versions.swap(second._versions);
+    swap(first._marker, second._marker);
+    first._display.swap(second._display);
+    first._installedSortKey.swap(second._installedSortKey);
+    first._availableSortKey.swap(second._availableSortKey);
     first._zombieVersions.swap(second._zombieVersions);
 }
 
@@ -74,6 +82,17 @@ QVariant PackageReportItem::data(int colNumber, int role) const
     if (colNumber < 0 || colNumber >= columnCount())
         return QVariant();
 
+    if (role == SortRole) {
+        switch (colNumber) {
+        case Column::InstalledVersion:
+            return QVariant::fromValue(_installedSortKey);
+        case Column::AvailableVersion:
+            return QVariant::fromValue(_availableSortKey);
+        default:
+            return data(colNumber, dataRole(colNumber));
+        }
+    }
+
     if (role == Qt::FontRole && installed()) {
         return boldFont();
     }
@@ -81,51 +100,29 @@ QVariant PackageReportItem::data(int colNumber, int role) const
     if (dataRole(colNumber) != role)
         return QVariant();
 
-    switch (colNumber) {
-    case Column::Installed:
-        if (installed()) {
-            switch (installType()) {
-            case eix_proto::MaskFlags_MaskFlag_WORLD:
-                return QVariant(
-                    QIcon(":/pkgtable/images/installed-world-marker.png"));
-            case eix_proto::MaskFlags_MaskFlag_WORLD_SETS:
-                return QVariant(
-                    QIcon(":/pkgtable/images/installed-world-set-marker.png"));
-            case eix_proto::MaskFlags_MaskFlag_MASK_SYSTEM:
-                return QVariant(
-                    QIcon(":/pkgtable/images/installed-system-marker.png"));
-            default:
-                return QVariant(
-                    QIcon(":/pkgtable/images/installed-marker.png"));
-            }
-        } else if (installType() != eix_proto::MaskFlags_MaskFlag_UNKNOWN) {
-            // I don't think this can happen, but I want to see if it does.
-            return QVariant(QIcon(":/pkgtable/images/world-only-marker.png"));
-
-        } else {
-            return QVariant();
-        }
-
-    case Column::Name:
-        return QVariant::fromValue(
-            QString::fromStdString(packageDetails().name()));
-
-    case Column::InstalledVersion:
-        return QVariant::fromValue(_versions.join(", "));
-
-    case Column::AvailableVersion:
-        return QVariant::fromValue(highestVersionName());
-
-    case Column::Description:
-        return QVariant::fromValue(
-            QString::fromStdString(packageDetails().description()));
-
-    default:
-        return QVariant();
+    if (colNumber == Column::Installed) {
+        return markerIcon(_marker);
     }
+    return _display[colNumber];
 }
 
-Qt::ItemDataRole PackageReportItem::dataRole(int colNumber) const
+/*!
+ * The icons for the Installed column. Each is made the first time it is
+ * needed and then shared by all of the rows that show it.
+ */
+const QVariant &PackageReportItem::markerIcon(Marker marker)
+{
+    static const QVariant icons[MarkerCount] = {
+        QVariant(),
+        QVariant(QIcon(":/pkgtable/images/installed-marker.png")),
+        QVariant(QIcon(":/pkgtable/images/installed-world-marker.png")),
+        QVariant(QIcon(":/pkgtable/images/installed-world-set-marker.png")),
+        QVariant(QIcon(":/pkgtable/images/installed-system-marker.png")),
+        QVariant(QIcon(":/pkgtable/images/world-only-marker.png"))};
+    return icons[marker];
+}
+
+Qt::ItemDataRole PackageReportItem::dataRole(int colNumber)
 {
     return _role[colNumber];
 }
@@ -155,11 +152,17 @@ bool PackageReportItem::installed() const
     return _isInstalled;
 }
 
+/// Which icon the Installed column shows
+PackageReportItem::Marker PackageReportItem::marker() const
+{
+    return _marker;
+}
+
 QStringList PackageReportItem::versionNames() const
 {
     if (!_zombieVersions.empty()) {
         QStringList result(_versions);
-        foreach (QString ver, _zombieVersions.keys()) {
+        foreach (QString ver, _zombieVersions) {
             result.append(ver + "**");
         }
         return result;
@@ -169,52 +172,40 @@ QStringList PackageReportItem::versionNames() const
 
 QString PackageReportItem::highestVersionName() const
 {
-    QString foundVersion("");
-    auto versionIndex = packageDetails().version_size() - 1;
-    auto lowestLiveIndex = -1;
-    while (versionIndex >= 0) {
-        const auto &ver = packageDetails().version(versionIndex);
-        // Live builds start with 3 or more nines. Not really interested in
-        // these except as a last resort if there is nothing else.
-        if (ver.id().rfind("999", 0) == std::string::npos) {
-            foundVersion = QString::fromStdString(ver.id());
-            if (!EixProtoHelper::isStable(ver)) {
-                foundVersion = "~" + foundVersion;
-            }
-            // For checking the tests
-            // foundVersion = QStringLiteral("%1-(%2/%3)")
-            //                   .arg(foundVersion)
-            //                   .arg(versionIndex)
-            //                   .arg(packageDetails().version_size());
-            break;
-        } else {
-            lowestLiveIndex = versionIndex;
-        }
-        versionIndex--;
-    }
-
-    if (foundVersion.isEmpty() && lowestLiveIndex >= 0) {
-        const auto &ver = packageDetails().version(lowestLiveIndex);
-        foundVersion = QString::fromStdString(ver.id());
-        if (!EixProtoHelper::isStable(ver)) {
-            foundVersion = "~" + foundVersion;
-        }
-    }
-
-    return foundVersion;
+    return _display[Column::AvailableVersion].toString();
 }
 
-// Some values are needed for redraws but are not straightforward to
-// work out. Determine these upfront (in the constructor) and cache
-// them.
+// Everything that is needed for redraws is worked out upfront (in the
+// constructor) and cached, so the view's many data() calls don't convert
+// or search anything. Each version's sort key is made once, here, to find
+// the highest versions; eix's order isn't relied on.
 void PackageReportItem::cacheValues()
 {
     auto resultInstalled = false;
     auto resultInstallType = eix_proto::MaskFlags_MaskFlag_UNKNOWN;
 
+    // Live builds are only interesting as a last resort if there is nothing
+    // else
+    std::string highestKey;
+    std::string highestLiveKey;
+    std::string installedKey;
+    int highestLive = -1;
+    int highestVersion = -1;
+
     for (int vn = 0; vn < packageDetails().version_size(); ++vn) {
         bool versionInstalled = false;
         const eix_proto::Version &ver = packageDetails().version(vn);
+        const std::string key = VersionKey::key(ver.id());
+
+        if (VersionKey::isLive(ver.id())) {
+            if (highestLive < 0 || key > highestLiveKey) {
+                highestLive = vn;
+                highestLiveKey = key;
+            }
+        } else if (highestVersion < 0 || key > highestKey) {
+            highestVersion = vn;
+            highestKey = key;
+        }
 
         // Installed means the software is installed. If so, "world" means
         // the software was pulled in from the world file or world set,
@@ -233,15 +224,70 @@ void PackageReportItem::cacheValues()
                 outVersion = QStringLiteral("(~)%1").arg(outVersion);
             }
             _versions.append(outVersion);
+
+            if (key > installedKey) {
+                installedKey = key;
+            }
         }
     }
 
+    if (highestVersion < 0) {
+        highestVersion = highestLive;
+        highestKey = highestLiveKey;
+    }
+    _installedSortKey = QByteArray::fromStdString(installedKey);
+    _availableSortKey = QByteArray::fromStdString(highestKey);
+
     _isInstalled = resultInstalled;   // i.e. are any versions installed
     _installType = resultInstallType; // for the 'highest' version installed
                                       // (TODO: return a list?)
+
+    if (!_isInstalled) {
+        // I don't think this can happen, but I want to see if it does.
+        _marker = _installType != eix_proto::MaskFlags_MaskFlag_UNKNOWN
+                      ? WorldOnlyMarker
+                      : NoMarker;
+    } else if (_installType == eix_proto::MaskFlags_MaskFlag_WORLD) {
+        _marker = WorldMarker;
+    } else if (_installType == eix_proto::MaskFlags_MaskFlag_WORLD_SETS) {
+        _marker = WorldSetMarker;
+    } else if (_installType == eix_proto::MaskFlags_MaskFlag_MASK_SYSTEM) {
+        _marker = SystemMarker;
+    } else {
+        _marker = InstalledMarker;
+    }
+
+    QString highestName;
+    if (highestVersion >= 0) {
+        const auto &ver = packageDetails().version(highestVersion);
+        highestName = QString::fromStdString(ver.id());
+        if (!EixProtoHelper::isStable(ver)) {
+            highestName = "~" + highestName;
+        }
+    }
+
+    _display.resize(columnCount());
+    _display[Column::Name] = QString::fromStdString(packageDetails().name());
+    _display[Column::InstalledVersion] = _versions.join(", ");
+    _display[Column::AvailableVersion] = highestName;
+    _display[Column::Description] =
+        QString::fromStdString(packageDetails().description());
 }
 
 const eix_proto::Package &PackageReportItem::packageDetails() const
 {
     return *_packageDetails;
 }
+
+/*!
+ * Whether the two items show the same thing in every column, e.g. the same
+ * package from two loads of the eix data when nothing about it has changed.
+ */
+bool PackageReportItem::sameDisplay(const PackageReportItem &other) const
+{
+    return _catName == other._catName && _marker == other._marker &&
+           _installType == other._installType &&
+           _isInstalled == other._isInstalled &&
+           _zombieVersions == other._zombieVersions &&
+           _display == other._display;
+}
@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include <QByteArray>
 #include <QFont>
 #include <QStringList>
 #include <QVariant>
@@ -15,7 +16,7 @@ class PackageReportItem
   public:
     explicit PackageReportItem(const std::string &catName,
                                const eix_proto::Package &pkg,
-                               VersionMap &zombies);
+                               const QStringList &zombies);
 
     PackageReportItem(const PackageReportItem &item);
     friend void swap(PackageReportItem &first, PackageReportItem &second);
@@ -26,7 +27,7 @@ class PackageReportItem
     static void setBoldFont(QFont font);
 
     QVariant data(int colNumber, int dataRole) const;
-    Qt::ItemDataRole dataRole(int colNumber) const;
+    static Qt::ItemDataRole dataRole(int colNumber);
 
     std::string category() const;
     std::string name() const;
@@ -36,6 +37,11 @@ class PackageReportItem
     QStringList versionNames() const;
     QString highestVersionName() const;
     const eix_proto::Package &packageDetails() const;
+    bool sameDisplay(const PackageReportItem &other) const;
+
+    /// The role the package list is sorted by: a version key (see
+    /// VersionKey) for the version columns, otherwise the displayed text
+    static constexpr int SortRole = Qt::UserRole;
 
     /// There's an enum value for each column in the package report
     enum Column {
@@ -46,6 +52,20 @@ class PackageReportItem
         Description
     };
 
+    /// The icon in the Installed column
+    enum Marker {
+        NoMarker,
+        InstalledMarker,
+        WorldMarker,
+        WorldSetMarker,
+        SystemMarker,
+        WorldOnlyMarker,
+        MarkerCount
+    };
+
+    Marker marker() const;
+    static const QVariant &markerIcon(Marker marker);
+
   private:
     void cacheValues();
 
@@ -71,6 +91,18 @@ class PackageReportItem
     /// Package versions, in ascending order
     QStringList _versions;
 
-    /// Versions of this package that are zombies
-    VersionMap _zombieVersions;
+    /// The icon shown in the Installed column
+    Marker _marker;
+
+    /// What each column displays, made once so data() is just a lookup
+    /// (the Installed column's icon is shared, see markerIcon())
+    QVector<QVariant> _display;
+
+    /// Sort keys of the highest installed version and the highest version
+    QByteArray _installedSortKey;
+    QByteArray _availableSortKey;
+
+    /// Versions of this package that are zombies (shared with
+    /// CombinedPackageList)
+    QStringList _zombieVersions;
 };
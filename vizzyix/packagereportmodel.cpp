@@ -2,9 +2,16 @@
 // SPDX-License-Identifier: GPL-2.0-only
 
 #include "packagereportmodel.h"
-#include "combinedpackagelist.h"
 
+#include <algorithm>
 #include <iostream>
+#include <unordered_map>
+
+namespace
+{
+/// How many more rows the views are given at a time, see fetchMore()
+constexpr int fetchBatchSize = 256;
+} // namespace
 
 PackageReportModel::PackageReportModel(QObject *)
 {
@@ -16,7 +23,7 @@ QVariant PackageReportModel::data(const QModelIndex &idx, int role) const
         return QVariant();
 
     if (idx.row() < rowCount() && idx.column() < columnCount()) {
-        return _packages[idx.row()].data(idx.column(), role);
+        return _store->data(_packages[idx.row()], idx.column(), role);
     }
 
     return QVariant();
@@ -61,9 +68,10 @@ QVariant PackageReportModel::headerData(int section,
     return QVariant();
 }
 
+/// The number of rows the views have been given so far, see fetchMore()
 int PackageReportModel::rowCount(const QModelIndex &idx) const
 {
-    return idx.isValid() ? 0 : _packages.size();
+    return idx.isValid() ? 0 : _fetched;
 }
 
 int PackageReportModel::columnCount(const QModelIndex &idx) const
@@ -71,6 +79,66 @@ int PackageReportModel::columnCount(const QModelIndex &idx) const
     return idx.isValid() ? 0 : PackageReportItem::columnCount();
 }
 
+/// Whether there are packages the views haven't been given yet
+bool PackageReportModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && _fetched < _packages.size();
+}
+
+/*!
+ * Gives the views the next batch of rows. The views ask for more when they
+ * are scrolled to the end of the rows they have, so however many packages
+ * there are, e.g. for "All", the views only have to deal with the rows that
+ * have been looked at.
+ */
+void PackageReportModel::fetchMore(const QModelIndex &parent)
+{
+    if (!parent.isValid()) {
+        fetchRows(_fetched + fetchBatchSize);
+    }
+}
+
+/*!
+ * Sorts the rows by a column, e.g. when its header is clicked, and keeps
+ * them sorted when they are updated. The store has already worked out the
+ * order (see PackageStore::sortPackages()), so nothing is compared here.
+ *
+ * The views keep the same number of rows, which now show the first
+ * packages in the new order.
+ */
+void PackageReportModel::sort(int column, Qt::SortOrder order)
+{
+    _sortColumn = column;
+    _sortOrder = order;
+    if (_store == nullptr) {
+        return;
+    }
+
+    QVector<int> sorted(_packages);
+    _store->sort(sorted, column, order);
+    if (sorted == _packages) {
+        return;
+    }
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // The selection and current row follow their packages, unless they are
+    // now past the rows the views have (index() is invalid there)
+    std::unordered_map<int, int> newRow;
+    for (int row = sorted.size() - 1; row >= 0; --row) {
+        newRow[sorted[row]] = row;
+    }
+    const QModelIndexList oldIndexes = persistentIndexList();
+    for (const auto &oldIndex : oldIndexes) {
+        changePersistentIndex(
+            oldIndex,
+            index(newRow[_packages[oldIndex.row()]], oldIndex.column()));
+    }
+    _packages = sorted;
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
 void PackageReportModel::startUpdate()
 {
     beginResetModel();
@@ -81,19 +149,283 @@ void PackageReportModel::endUpdate()
     endResetModel();
 }
 
-void PackageReportModel::addPackage(const std::string &catName,
-                                    const eix_proto::Package &package,
-                                    VersionMap &zombies)
+/*!
+ * Replaces the packages in the model with the given packages from 'store',
+ * usually without a model reset. Rows are matched up by package (by category
+ * and package name, if 'store' is from another load), and the views are
+ * only told about the rows that were removed, inserted or moved, and the
+ * rows that now show something different. This keeps the selection and the
+ * scroll position, e.g. when the data is reloaded. A list that is mostly new
+ * is given to the views with a reset instead.
+ *
+ * Only the rows the views have been given so far are signalled (see
+ * fetchMore()), and the views always have at least the first batch.
+ *
+ * If the model is sorted (see sort()), the packages are put in that order
+ * first, otherwise the rows are in the order given.
+ *
+ * The model refers to the new store afterwards, not the one it had before.
+ * The previous store (and its eix data) has to be kept until then. The list
+ * is left empty.
+ */
+void PackageReportModel::updatePackages(const PackageStore *store,
+                                        QVector<int> &packages)
 {
-    _packages.append(PackageReportItem(catName, package, zombies));
+    store->sort(packages, _sortColumn, _sortOrder);
+
+    // Where each row's package is in the new store, or -1 if it is no longer
+    // wanted. Within a load the rows are matched up by index, and only a new
+    // load needs the names.
+    QVector<int> newIndex(_packages.size(), -1);
+    if (store == _store) {
+        std::vector<bool> wanted(store->size());
+        for (int index : packages) {
+            wanted[index] = true;
+        }
+        for (int row = 0; row < _packages.size(); ++row) {
+            if (wanted[_packages[row]]) {
+                newIndex[row] = _packages[row];
+            }
+        }
+    } else if (!_packages.isEmpty()) {
+        std::unordered_map<std::string, int> wanted;
+        for (int index : packages) {
+            wanted.emplace(packageKey(store, index), index);
+        }
+        for (int row = 0; row < _packages.size(); ++row) {
+            auto found = wanted.find(packageKey(_store, _packages[row]));
+            if (found != wanted.end()) {
+                newIndex[row] = found->second;
+            }
+        }
+    }
+
+    // A list that is mostly new, e.g. another category, just replaces the
+    // rows, so the views only get the first batch of them
+    const int kept = static_cast<int>(
+        std::count_if(newIndex.cbegin(), newIndex.cend(), [](int index) {
+            return index >= 0;
+        }));
+    if (kept > 0 && kept * 2 < packages.size()) {
+        beginResetModel();
+        _store = store;
+        _packages = packages;
+        _fetched = qMin(fetchBatchSize, _packages.size());
+        endResetModel();
+        packages.clear();
+        return;
+    }
+
+    // The rows that are no longer wanted, a block at a time
+    for (int last = _packages.size() - 1; last >= 0; --last) {
+        if (newIndex[last] >= 0) {
+            continue;
+        }
+        int first = last;
+        while (first > 0 && newIndex[first - 1] < 0) {
+            --first;
+        }
+        removePackages(first, last);
+        newIndex.remove(first, last - first + 1);
+        last = first;
+    }
+
+    // The rows that are left are switched over to the new store, noting the
+    // ones that will look different
+    std::vector<bool> present(store->size());
+    QVector<bool> changed(_packages.size());
+    for (int row = 0; row < _packages.size(); ++row) {
+        changed[row] =
+            store != _store &&
+            !_store->sameDisplay(_packages[row], *store, newIndex[row]);
+        _packages[row] = newIndex[row];
+        present[newIndex[row]] = true;
+    }
+    _store = store;
+
+    for (int row = 0; row < packages.size(); ++row) {
+        if (!present[packages[row]]) {
+            // New rows, a block at a time
+            int last = row;
+            while (last + 1 < packages.size() && !present[packages[last + 1]]) {
+                ++last;
+            }
+            insertPackages(row, packages.mid(row, last - row + 1));
+            changed.insert(row, last - row + 1, false);
+            row = last;
+            continue;
+        }
+
+        // Normally the row is already in the right place
+        int from = row;
+        while (from < _packages.size() && _packages[from] != packages[row]) {
+            ++from;
+        }
+        if (from == _packages.size()) {
+            // A repeat of a package that has already been placed
+            insertPackages(row, {packages[row]});
+            changed.insert(row, false);
+            continue;
+        }
+        if (from != row) {
+            movePackage(from, row);
+            changed.move(from, row);
+        }
+    }
+
+    // Only left if a package was repeated
+    if (_packages.size() > packages.size()) {
+        removePackages(packages.size(), _packages.size() - 1);
+        changed.resize(packages.size());
+    }
+
+    // The rows that look different, a block at a time
+    for (int first = 0; first < changed.size(); ++first) {
+        if (changed[first]) {
+            int last = first;
+            while (last + 1 < changed.size() && changed[last + 1]) {
+                ++last;
+            }
+            packagesChanged(first, last);
+            first = last;
+        }
+    }
+
+    // The views always have the first batch of rows
+    fetchRows(fetchBatchSize);
+
+    packages.clear();
 }
 
 void PackageReportModel::clear()
 {
     _packages.clear();
+    _fetched = 0;
+    _store = nullptr;
+}
+
+/// Where the packages come from, or null if there are none
+const PackageStore *PackageReportModel::store() const
+{
+    return _store;
+}
+
+/// The index in store() of the package in a row
+int PackageReportModel::packageIndex(int row) const
+{
+    return _packages[row];
 }
 
-const PackageReportItem &PackageReportModel::packageItem(int n)
+/*!
+ * Up to 'count' of the packages, spread evenly through the list, including
+ * the rows the views haven't fetched yet. This is enough to size the
+ * columns by, without looking at every package.
+ */
+QVector<int> PackageReportModel::samplePackages(int count) const
 {
-    return _packages[n];
+    if (_packages.size() <= count) {
+        return _packages;
+    }
+    QVector<int> sample;
+    sample.reserve(count);
+    for (int n = 0; n < count; ++n) {
+        sample.append(_packages[static_cast<qint64>(n) * _packages.size() /
+                                count]);
+    }
+    return sample;
+}
+
+/// The package in a row, e.g. to show its details
+PackageReportItem PackageReportModel::packageItem(int n) const
+{
+    return _store->item(_packages[n]);
+}
+
+/// The key that matches up rows from two loads in updatePackages():
+/// "category/name"
+std::string PackageReportModel::packageKey(const PackageStore *store,
+                                           int index)
+{
+    return std::string(store->category(index)) + '/' +
+           std::string(store->name(index));
+}
+
+/// Tells the views that the given rows show something different
+void PackageReportModel::packagesChanged(int first, int last)
+{
+    last = qMin(last, _fetched - 1);
+    if (first <= last) {
+        emit dataChanged(index(first, 0), index(last, columnCount() - 1));
+    }
+}
+
+/*!
+ * Gives the views the rows up to 'count' (or all of them, if there are
+ * fewer), if they don't have them already.
+ */
+void PackageReportModel::fetchRows(int count)
+{
+    count = qMin(count, _packages.size());
+    if (count > _fetched) {
+        beginInsertRows(QModelIndex(), _fetched, count - 1);
+        _fetched = count;
+        endInsertRows();
+    }
+}
+
+/*!
+ * Removes the packages in the given rows, telling the views about the ones
+ * they have been given.
+ */
+void PackageReportModel::removePackages(int first, int last)
+{
+    const int fetchedLast = qMin(last, _fetched - 1);
+    if (first <= fetchedLast) {
+        beginRemoveRows(QModelIndex(), first, fetchedLast);
+        _packages.remove(first, last - first + 1);
+        _fetched -= fetchedLast - first + 1;
+        endRemoveRows();
+    } else {
+        _packages.remove(first, last - first + 1);
+    }
+}
+
+/*!
+ * Inserts packages before the given row. The views are only told about
+ * them if the row is among the ones they have; otherwise they are fetched
+ * later, like the rest of the rows past the end.
+ */
+void PackageReportModel::insertPackages(int row, const QVector<int> &packages)
+{
+    if (row < _fetched) {
+        beginInsertRows(QModelIndex(), row, row + packages.size() - 1);
+        _packages.insert(row, packages.size(), 0);
+        std::copy(packages.cbegin(), packages.cend(), _packages.begin() + row);
+        _fetched += packages.size();
+        endInsertRows();
+    } else {
+        _packages.insert(row, packages.size(), 0);
+        std::copy(packages.cbegin(), packages.cend(), _packages.begin() + row);
+    }
+}
+
+/*!
+ * Moves a package back to an earlier row, as far as the views can see: a
+ * move within the rows they have, a new row if it comes from past the end,
+ * or nothing at all.
+ */
+void PackageReportModel::movePackage(int from, int to)
+{
+    if (from < _fetched) {
+        beginMoveRows(QModelIndex(), from, from, QModelIndex(), to);
+        _packages.move(from, to);
+        endMoveRows();
+    } else if (to < _fetched) {
+        beginInsertRows(QModelIndex(), to, to);
+        _packages.move(from, to);
+        ++_fetched;
+        endInsertRows();
+    } else {
+        _packages.move(from, to);
+    }
 }
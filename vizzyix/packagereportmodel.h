@@ -9,9 +9,8 @@
 #include <QVariant>
 #include <QVector>
 
-#include "combinedpackagelist.h"
-#include "eix.pb.h"
 #include "packagereportitem.h"
+#include "packagestore.h"
 
 class PackageReportModel : public QAbstractTableModel
 {
@@ -24,15 +23,38 @@ class PackageReportModel : public QAbstractTableModel
                         int role = Qt::DisplayRole) const override;
     int rowCount(const QModelIndex &parent = QModelIndex()) const override;
     int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
 
     void startUpdate();
     void endUpdate();
-    void addPackage(const std::string &catName,
-                    const eix_proto::Package &package,
-                    VersionMap &zombies);
+    void updatePackages(const PackageStore *store, QVector<int> &packages);
     void clear();
-    const PackageReportItem &packageItem(int n);
+    const PackageStore *store() const;
+    int packageIndex(int row) const;
+    QVector<int> samplePackages(int count) const;
+    PackageReportItem packageItem(int n) const;
 
   private:
-    QVector<PackageReportItem> _packages;
+    static std::string packageKey(const PackageStore *store, int index);
+    void packagesChanged(int first, int last);
+    void fetchRows(int count);
+    void removePackages(int first, int last);
+    void insertPackages(int row, const QVector<int> &packages);
+    void movePackage(int from, int to);
+
+  private:
+    /// Where the packages come from (owned by ApplicationData)
+    const PackageStore *_store = nullptr;
+
+    /// The index in _store of the package in each row
+    QVector<int> _packages;
+
+    /// How many of the rows the views have been given (see fetchMore())
+    int _fetched = 0;
+
+    /// The column the rows are sorted by (-1 leaves them as they are given)
+    int _sortColumn = -1;
+    Qt::SortOrder _sortOrder = Qt::AscendingOrder;
 };
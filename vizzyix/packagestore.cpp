@@ -0,0 +1,721 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "packagestore.h"
+
+#include <algorithm>
+#include <atomic>
+#include <numeric>
+
+#include "eixprotohelper.h"
+#include "snapshotimage.h"
+
+namespace
+{
+/// The different ids in a column, in id order
+std::vector<StringPool::Id> distinctIds(
+    const std::vector<StringPool::Id> &column)
+{
+    std::vector<StringPool::Id> ids(column);
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+/*!
+ * Gives each package its place in a column's order, from the column's
+ * different ids in order. Packages with the same id get the same rank.
+ */
+std::vector<uint32_t> ranks(const std::vector<StringPool::Id> &column,
+                            const std::vector<StringPool::Id> &sortedIds,
+                            size_t idCount)
+{
+    std::vector<uint32_t> idRank(idCount);
+    for (size_t rank = 0; rank < sortedIds.size(); ++rank) {
+        idRank[sortedIds[rank]] = static_cast<uint32_t>(rank);
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(column.size());
+    for (StringPool::Id id : column) {
+        result.push_back(idRank[id]);
+    }
+    return result;
+}
+
+/*!
+ * Puts the packages in order by their ranks, with a counting sort. Packages
+ * with the same rank are left in the order they have in 'order'.
+ */
+std::vector<int> orderBy(const std::vector<uint32_t> &ranks,
+                         size_t rankCount,
+                         const std::vector<int> &order)
+{
+    std::vector<int> start(rankCount + 1);
+    for (uint32_t rank : ranks) {
+        ++start[rank + 1];
+    }
+    std::partial_sum(start.begin(), start.end(), start.begin());
+
+    std::vector<int> result(order.size());
+    for (int index : order) {
+        result[start[ranks[index]]++] = index;
+    }
+    return result;
+}
+} // namespace
+
+/// Constructor just starts with no packages
+PackageStore::PackageStore() : _versionStart{0}, _categoryStart{0}
+{
+}
+
+/*!
+ * Adds all of the packages of the next eix category, with their zombie
+ * versions from the combined package list.
+ */
+void PackageStore::addCategory(const eix_proto::Category &category,
+                               const CombinedPackageList &combined)
+{
+    const QStringList noZombies;
+    for (const auto &pkg : category.package()) {
+        const int zombie =
+            combined.zombieIndex(category.category(), pkg.name());
+        addPackage(category.category(),
+                   pkg,
+                   zombie < 0 ? noZombies
+                              : combined.zombieVersionNames(zombie));
+    }
+    _categoryStart.push_back(size());
+    _categoryName.push_back(addText(category.category()));
+}
+
+/*!
+ * Adds all of the eix categories that aren't in the store yet, i.e. from
+ * categoryCount() on, as addCategory() would. The packages' summaries are
+ * worked out in parallel, a category at a time, and then added in order.
+ */
+void PackageStore::addCategories(const eix_proto::Collection &eix,
+                                 const CombinedPackageList &combined)
+{
+    const int firstCategory = categoryCount();
+    const int count = eix.category_size() - firstCategory;
+    if (count <= 0) {
+        return;
+    }
+
+    // The icons are shared by all of the packages, so they are made here
+    PackageReportItem::markerIcon(PackageReportItem::NoMarker);
+
+    std::vector<std::vector<Summary>> summaries(count);
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        const QStringList noZombies;
+        for (int n = next++; n < count; n = next++) {
+            const auto &category = eix.category(firstCategory + n);
+            summaries[n].reserve(category.package_size());
+            for (const auto &pkg : category.package()) {
+                const int zombie =
+                    combined.zombieIndex(category.category(), pkg.name());
+                const QStringList &zombies =
+                    zombie < 0 ? noZombies
+                               : combined.zombieVersionNames(zombie);
+                summaries[n].push_back(
+                    summarise(category.category(), pkg, zombies));
+            }
+        }
+    };
+
+    const int helpers = qMin(count, _pool.maxThreadCount()) - 1;
+    for (int n = 0; n < helpers; ++n) {
+        _pool.start(worker);
+    }
+    worker();
+    _pool.waitForDone();
+
+    for (int n = 0; n < count; ++n) {
+        const auto &category = eix.category(firstCategory + n);
+        for (int pkgNumber = 0; pkgNumber < category.package_size();
+             ++pkgNumber) {
+            addSummary(category.category(),
+                       category.package(pkgNumber),
+                       summaries[n][pkgNumber]);
+        }
+        _categoryStart.push_back(size());
+        _categoryName.push_back(addText(category.category()));
+    }
+}
+
+/// Adds a package, and returns its index
+int PackageStore::addPackage(const std::string &catName,
+                             const eix_proto::Package &pkg,
+                             const QStringList &zombies)
+{
+    return addSummary(catName, pkg, summarise(catName, pkg, zombies));
+}
+
+/// Sets the most threads to use for addCategories() (1 works serially)
+void PackageStore::setThreadCount(int threads)
+{
+    _pool.setMaxThreadCount(threads);
+}
+
+/// Empties the store
+void PackageStore::clear()
+{
+    _strings.clear();
+    _text.clear();
+    _keys.clear();
+    _keyBytes.clear();
+    _details.clear();
+    _detailsSource = nullptr;
+    _category.clear();
+    _name.clear();
+    _description.clear();
+    _installedText.clear();
+    _availableText.clear();
+    _installedKey.clear();
+    _availableKey.clear();
+    _flags.clear();
+    _versionStart.assign(1, 0);
+    _zombieStart.clear();
+    _versions.clear();
+    _categoryStart.assign(1, 0);
+    _categoryName.clear();
+    _sortOrder.clear();
+}
+
+/*!
+ * Works out the order of all of the packages by each column, for sort().
+ * This is done once the packages have been added, so the sorting is only
+ * done once for each load.
+ *
+ * The text columns are in order ignoring case, using the case folded text as
+ * the collation key, and the version columns are in order by their version
+ * keys (see PackageReportItem::SortRole). Each different string only has its
+ * key made and compared once. Packages that are the same in a column are left
+ * in name order, and packages with the same name in category order.
+ */
+void PackageStore::sortPackages()
+{
+    typedef PackageReportItem::Column Column;
+    _sortOrder.assign(PackageReportItem::columnCount(), std::vector<int>());
+
+    auto textRanks = [&](const std::vector<StringPool::Id> &column) {
+        std::vector<StringPool::Id> ids = distinctIds(column);
+        std::vector<QString> keys;
+        keys.reserve(ids.size());
+        for (StringPool::Id id : ids) {
+            keys.push_back(_text[id].toCaseFolded());
+        }
+        std::vector<size_t> byKey(ids.size());
+        std::iota(byKey.begin(), byKey.end(), 0);
+        std::stable_sort(byKey.begin(), byKey.end(), [&](size_t a, size_t b) {
+            return keys[a] < keys[b];
+        });
+
+        std::vector<StringPool::Id> sortedIds;
+        sortedIds.reserve(ids.size());
+        for (size_t n : byKey) {
+            sortedIds.push_back(ids[n]);
+        }
+        return ranks(column, sortedIds, _text.size());
+    };
+    auto keyRanks = [&](const std::vector<StringPool::Id> &column) {
+        std::vector<StringPool::Id> ids = distinctIds(column);
+        std::sort(ids.begin(),
+                  ids.end(),
+                  [&](StringPool::Id a, StringPool::Id b) {
+                      return _keys.str(a) < _keys.str(b);
+                  });
+        return ranks(column, ids, _keyBytes.size());
+    };
+
+    std::vector<int> storeOrder(size());
+    std::iota(storeOrder.begin(), storeOrder.end(), 0);
+    _sortOrder[Column::Name] =
+        orderBy(textRanks(_name), _text.size(), storeOrder);
+
+    const std::vector<int> &nameOrder = _sortOrder[Column::Name];
+    _sortOrder[Column::Description] =
+        orderBy(textRanks(_description), _text.size(), nameOrder);
+    _sortOrder[Column::InstalledVersion] =
+        orderBy(keyRanks(_installedKey), _keyBytes.size(), nameOrder);
+    _sortOrder[Column::AvailableVersion] =
+        orderBy(keyRanks(_availableKey), _keyBytes.size(), nameOrder);
+
+    std::vector<uint32_t> markers;
+    markers.reserve(_flags.size());
+    for (uint8_t flags : _flags) {
+        markers.push_back(flags & markerMask);
+    }
+    _sortOrder[Column::Installed] =
+        orderBy(markers, PackageReportItem::MarkerCount, nameOrder);
+}
+
+/*!
+ * Sorts a list of packages by a column, by picking them out of the order
+ * worked out by sortPackages(), which must have been called since the last
+ * packages were added. A package that is in the list more than once keeps
+ * its repeats together.
+ */
+void PackageStore::sort(QVector<int> &packages,
+                        int column,
+                        Qt::SortOrder order) const
+{
+    if (column < 0 || column >= static_cast<int>(_sortOrder.size()) ||
+        packages.size() < 2) {
+        return;
+    }
+    const std::vector<int> &sorted = _sortOrder[column];
+    Q_ASSERT(static_cast<int>(sorted.size()) == size());
+
+    std::vector<int> count(size());
+    for (int index : packages) {
+        ++count[index];
+    }
+
+    int row = 0;
+    const int last = static_cast<int>(sorted.size()) - 1;
+    for (int n = 0; n <= last && row < packages.size(); ++n) {
+        const int index = sorted[order == Qt::AscendingOrder ? n : last - n];
+        for (int repeat = count[index]; repeat > 0; --repeat) {
+            packages[row++] = index;
+        }
+    }
+}
+
+/*!
+ * Writes the whole store to a snapshot: the text, the columns and the sort
+ * orders. The eix data isn't included; see setDetailsSource().
+ */
+void PackageStore::save(SnapshotImage &image) const
+{
+    _strings.save(image);
+    _keys.save(image);
+    for (const auto *column : {&_category,
+                               &_name,
+                               &_description,
+                               &_installedText,
+                               &_availableText,
+                               &_installedKey,
+                               &_availableKey,
+                               &_versions,
+                               &_categoryName}) {
+        image.write(*column);
+    }
+    image.write(_flags);
+    image.write(_versionStart);
+    image.write(_zombieStart);
+    image.write(_categoryStart);
+    image.write(_sortOrder);
+}
+
+/*!
+ * Reads back a store written by save(), replacing what was there. The
+ * columns are copied out of the image as they are, and the only work done
+ * is making a QString (or QByteArray) of each different string.
+ *
+ * The store has no eix data until setDetailsSource() is called. Returns
+ * false, leaving the store empty, if the image doesn't hold a whole store.
+ */
+bool PackageStore::restore(SnapshotImage &image)
+{
+    clear();
+    bool ok = _strings.restore(image) && _keys.restore(image);
+    for (auto *column : {&_category,
+                         &_name,
+                         &_description,
+                         &_installedText,
+                         &_availableText,
+                         &_installedKey,
+                         &_availableKey,
+                         &_versions,
+                         &_categoryName}) {
+        ok = ok && image.read(*column);
+    }
+    ok = ok && image.read(_flags) && image.read(_versionStart) &&
+         image.read(_zombieStart) && image.read(_categoryStart) &&
+         image.read(_sortOrder);
+
+    // The columns all have to be there, for every package and category
+    const size_t packages = _name.size();
+    for (const auto *column : {&_category,
+                               &_description,
+                               &_installedText,
+                               &_availableText,
+                               &_installedKey,
+                               &_availableKey}) {
+        ok = ok && column->size() == packages;
+    }
+    ok = ok && _flags.size() == packages && _zombieStart.size() == packages &&
+         _versionStart.size() == packages + 1 &&
+         _versionStart.back() == _versions.size() &&
+         !_categoryStart.empty() &&
+         _categoryName.size() == _categoryStart.size() - 1 &&
+         _categoryStart.back() == static_cast<int>(packages);
+    for (size_t n = 0; ok && n < packages; ++n) {
+        ok = _zombieStart[n] >= _versionStart[n] &&
+             _zombieStart[n] <= _versionStart[n + 1];
+    }
+    ok = ok && _categoryStart[0] == 0;
+    for (size_t n = 1; ok && n < _categoryStart.size(); ++n) {
+        ok = _categoryStart[n - 1] <= _categoryStart[n];
+    }
+
+    // And everything they refer to
+    auto below = [&](const auto &column, int limit) {
+        return std::all_of(column.begin(), column.end(), [&](auto value) {
+            return static_cast<size_t>(value) < static_cast<size_t>(limit);
+        });
+    };
+    for (const auto *column : {&_category,
+                               &_name,
+                               &_description,
+                               &_installedText,
+                               &_availableText,
+                               &_versions,
+                               &_categoryName}) {
+        ok = ok && below(*column, _strings.size());
+    }
+    ok = ok && below(_installedKey, _keys.size()) &&
+         below(_availableKey, _keys.size());
+    for (const auto &order : _sortOrder) {
+        ok = ok && order.size() == packages && below(order, size());
+    }
+    if (!ok) {
+        clear();
+        return false;
+    }
+
+    makeStrings();
+    return true;
+}
+
+/*!
+ * Sets where the eix data comes from for a restored store (see restore()),
+ * e.g. the eix output kept with the snapshot.
+ */
+void PackageStore::setDetailsSource(const DetailsSource &source)
+{
+    _detailsSource = source;
+}
+
+/// The number of packages in the store
+int PackageStore::size() const
+{
+    return static_cast<int>(_name.size());
+}
+
+/// The number of categories added by addCategory()
+int PackageStore::categoryCount() const
+{
+    return static_cast<int>(_categoryStart.size()) - 1;
+}
+
+/// The name of a category added by addCategory(), e.g. "dev-qt"
+std::string_view PackageStore::categoryName(int catNumber) const
+{
+    return _strings.str(_categoryName[catNumber]);
+}
+
+/// The number of packages in a category added by addCategory()
+int PackageStore::categorySize(int catNumber) const
+{
+    return _categoryStart[catNumber + 1] - _categoryStart[catNumber];
+}
+
+/// The index of a package, by its eix category and package numbers
+int PackageStore::index(int catNumber, int pkgNumber) const
+{
+    return _categoryStart[catNumber] + pkgNumber;
+}
+
+/*!
+ * The same as PackageReportItem::data(), for the package at 'index', but
+ * without working anything out.
+ */
+QVariant PackageStore::data(int index, int column, int role) const
+{
+    typedef PackageReportItem::Column Column;
+
+    if (column < 0 || column >= PackageReportItem::columnCount())
+        return QVariant();
+
+    if (role == PackageReportItem::SortRole) {
+        switch (column) {
+        case Column::InstalledVersion:
+            return _keyBytes[_installedKey[index]];
+        case Column::AvailableVersion:
+            return _keyBytes[_availableKey[index]];
+        default:
+            return data(index, column, PackageReportItem::dataRole(column));
+        }
+    }
+
+    if (role == Qt::FontRole && installed(index)) {
+        return PackageReportItem::boldFont();
+    }
+
+    if (PackageReportItem::dataRole(column) != role)
+        return QVariant();
+
+    switch (column) {
+    case Column::Installed:
+        return PackageReportItem::markerIcon(marker(index));
+    default:
+        return text(index, column);
+    }
+}
+
+/*!
+ * The text a column shows, without going through a QVariant (e.g. for
+ * painting). The Installed column shows an icon instead, see marker().
+ */
+const QString &PackageStore::text(int index, int column) const
+{
+    typedef PackageReportItem::Column Column;
+    static const QString none;
+
+    switch (column) {
+    case Column::Name:
+        return _text[_name[index]];
+    case Column::InstalledVersion:
+        return _text[_installedText[index]];
+    case Column::AvailableVersion:
+        return _text[_availableText[index]];
+    case Column::Description:
+        return _text[_description[index]];
+    default:
+        return none;
+    }
+}
+
+/// The icon the Installed column shows, see PackageReportItem::markerIcon()
+PackageReportItem::Marker PackageStore::marker(int index) const
+{
+    return static_cast<PackageReportItem::Marker>(_flags[index] & markerMask);
+}
+
+/// The package's category name, e.g. "dev-qt"
+std::string_view PackageStore::category(int index) const
+{
+    return _strings.str(_category[index]);
+}
+
+/// The package name, e.g. "qtbase"
+std::string_view PackageStore::name(int index) const
+{
+    return _strings.str(_name[index]);
+}
+
+/// The package description
+std::string_view PackageStore::description(int index) const
+{
+    return _strings.str(_description[index]);
+}
+
+/*!
+ * The eix data for the package. For a restored store, this is got from the
+ * DetailsSource, by the package's category and package numbers.
+ */
+const eix_proto::Package &PackageStore::packageDetails(int index) const
+{
+    if (!_details.empty()) {
+        return *_details[index];
+    }
+    const int catNumber = static_cast<int>(
+        std::upper_bound(_categoryStart.begin(), _categoryStart.end(), index) -
+        _categoryStart.begin() - 1);
+    return _detailsSource(catNumber, index - _categoryStart[catNumber]);
+}
+
+/// Whether any versions of the package are installed
+bool PackageStore::installed(int index) const
+{
+    return (_flags[index] & installedFlag) != 0;
+}
+
+/// Whether the package is in the world file or a set (see worldFlag)
+bool PackageStore::world(int index) const
+{
+    return (_flags[index] & worldFlag) != 0;
+}
+
+/*!
+ * Whether the package is installed and has a higher version available than
+ * the highest installed one, going by the version sort keys
+ */
+bool PackageStore::updateAvailable(int index) const
+{
+    return installed(index) &&
+           _keyBytes[_availableKey[index]] > _keyBytes[_installedKey[index]];
+}
+
+/// The same as PackageReportItem::versionNames()
+QStringList PackageStore::versionNames(int index) const
+{
+    QStringList result;
+    for (uint32_t n = _versionStart[index]; n < _versionStart[index + 1];
+         ++n) {
+        result.append(n < _zombieStart[index] ? _text[_versions[n]]
+                                              : _text[_versions[n]] + "**");
+    }
+    return result;
+}
+
+/// The package's zombie versions (see CombinedPackageList)
+QStringList PackageStore::zombieVersions(int index) const
+{
+    QStringList result;
+    for (uint32_t n = _zombieStart[index]; n < _versionStart[index + 1];
+         ++n) {
+        result.append(_text[_versions[n]]);
+    }
+    return result;
+}
+
+/// A PackageReportItem for the package, e.g. to show its details
+PackageReportItem PackageStore::item(int index) const
+{
+    return PackageReportItem(std::string(category(index)),
+                             packageDetails(index),
+                             zombieVersions(index));
+}
+
+/*!
+ * Whether the package at 'index' shows the same thing in every column as
+ * the one at 'otherIndex' in another store, e.g. the same package from two
+ * loads of the eix data when nothing about it has changed.
+ */
+bool PackageStore::sameDisplay(int index,
+                               const PackageStore &other,
+                               int otherIndex) const
+{
+    auto sameText = [&](const std::vector<StringPool::Id> &column,
+                        const std::vector<StringPool::Id> &otherColumn) {
+        return _strings.str(column[index]) ==
+               other._strings.str(otherColumn[otherIndex]);
+    };
+    return _flags[index] == other._flags[otherIndex] &&
+           sameText(_category, other._category) &&
+           sameText(_name, other._name) &&
+           sameText(_description, other._description) &&
+           sameText(_installedText, other._installedText) &&
+           sameText(_availableText, other._availableText) &&
+           versionNames(index) == other.versionNames(otherIndex);
+}
+
+/*!
+ * Works out what a package shows, with a PackageReportItem. This only reads
+ * its arguments, so packages can be summarised in parallel.
+ */
+PackageStore::Summary PackageStore::summarise(const std::string &catName,
+                                              const eix_proto::Package &pkg,
+                                              const QStringList &zombies)
+{
+    typedef PackageReportItem::Column Column;
+    const PackageReportItem item(catName, pkg, zombies);
+
+    Summary summary;
+    summary.installedText =
+        item.data(Column::InstalledVersion, Qt::DisplayRole).toString();
+    summary.availableText = item.highestVersionName();
+    summary.installedKey =
+        item.data(Column::InstalledVersion, PackageReportItem::SortRole)
+            .toByteArray();
+    summary.availableKey =
+        item.data(Column::AvailableVersion, PackageReportItem::SortRole)
+            .toByteArray();
+    summary.flags = (item.installed() ? installedFlag : 0) |
+                    static_cast<uint8_t>(item.marker());
+    for (const auto &ver : pkg.version()) {
+        if (EixProtoHelper::classifyInstallType(ver) !=
+            eix_proto::MaskFlags_MaskFlag_UNKNOWN) {
+            summary.flags |= worldFlag;
+            break;
+        }
+    }
+
+    // The installed versions come first in versionNames(), then the zombies
+    summary.installedVersions = item.versionNames();
+    summary.installedVersions.resize(summary.installedVersions.size() -
+                                     zombies.size());
+    summary.zombies = zombies;
+    return summary;
+}
+
+/// Adds a package's summary to the columns, and returns its index
+int PackageStore::addSummary(const std::string &catName,
+                             const eix_proto::Package &pkg,
+                             const Summary &summary)
+{
+    _details.push_back(&pkg);
+    _category.push_back(addText(catName));
+    _name.push_back(addText(pkg.name()));
+    _description.push_back(addText(pkg.description()));
+    _installedText.push_back(addText(summary.installedText));
+    _availableText.push_back(addText(summary.availableText));
+    _installedKey.push_back(addKey(summary.installedKey));
+    _availableKey.push_back(addKey(summary.availableKey));
+    _flags.push_back(summary.flags);
+
+    for (const auto &version : summary.installedVersions) {
+        _versions.push_back(addText(version));
+    }
+    _zombieStart.push_back(static_cast<uint32_t>(_versions.size()));
+    for (const auto &zombie : summary.zombies) {
+        _versions.push_back(addText(zombie));
+    }
+    _versionStart.push_back(static_cast<uint32_t>(_versions.size()));
+
+    return size() - 1;
+}
+
+/// Interns some text, converting it to a QString if it is new
+StringPool::Id PackageStore::addText(std::string_view text)
+{
+    const StringPool::Id id = _strings.add(text);
+    if (id == static_cast<StringPool::Id>(_text.size())) {
+        _text.append(QString::fromUtf8(text.data(), text.size()));
+    }
+    return id;
+}
+
+/// As above, for text that is already a QString
+StringPool::Id PackageStore::addText(const QString &text)
+{
+    const StringPool::Id id = _strings.add(text.toStdString());
+    if (id == static_cast<StringPool::Id>(_text.size())) {
+        _text.append(text);
+    }
+    return id;
+}
+
+/// Makes the QStrings and QByteArrays of a restored store's text and keys
+void PackageStore::makeStrings()
+{
+    _text.clear();
+    _text.reserve(_strings.size());
+    for (int id = 0; id < _strings.size(); ++id) {
+        const std::string_view text = _strings.str(id);
+        _text.append(QString::fromUtf8(text.data(), text.size()));
+    }
+    _keyBytes.clear();
+    _keyBytes.reserve(_keys.size());
+    for (int id = 0; id < _keys.size(); ++id) {
+        const std::string_view key = _keys.str(id);
+        _keyBytes.append(QByteArray(key.data(), key.size()));
+    }
+}
+
+/// Interns a version sort key
+StringPool::Id PackageStore::addKey(const QByteArray &key)
+{
+    const StringPool::Id id =
+        _keys.add(std::string_view(key.constData(), key.size()));
+    if (id == static_cast<StringPool::Id>(_keyBytes.size())) {
+        _keyBytes.append(key);
+    }
+    return id;
+}
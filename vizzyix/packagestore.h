@@ -0,0 +1,181 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVariant>
+#include <QVector>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "combinedpackagelist.h"
+#include "eix.pb.h"
+#include "packagereportitem.h"
+#include "stringpool.h"
+
+class SnapshotImage;
+
+/*! class PackageStore
+ *
+ * What the package list shows for each package, made once per load and
+ * shared by the models. A package is just an index into the store.
+ *
+ * The store is kept by column, one array per field, so each package takes a
+ * few dozen bytes. All of the text (names, descriptions, version labels) is
+ * interned, and each distinct string is converted to a QString once, so
+ * data() only has to look things up.
+ *
+ * Packages are added a category at a time, in eix order, so the packages of
+ * a category are next to each other; see index(). What each package shows
+ * is worked out by a PackageReportItem, in parallel when a whole load is
+ * added (see addCategories()).
+ *
+ * Once the packages have been added, the order of all of them by each column
+ * is worked out (see sortPackages()), so any list of packages can be sorted
+ * by picking it out of that order, without comparing anything.
+ *
+ * A whole store can be saved to a snapshot and read back (see save() and
+ * restore()), which gives the same columns without the eix data. The eix
+ * data for a package is then got from a DetailsSource when it is asked for.
+ */
+class PackageStore
+{
+  public:
+    /// Gives the eix data for a package, by eix category and package number
+    typedef std::function<const eix_proto::Package &(int catNumber,
+                                                     int pkgNumber)>
+        DetailsSource;
+
+    PackageStore();
+
+    PackageStore(const PackageStore &) = delete;
+    PackageStore &operator=(PackageStore &) = delete;
+
+    void addCategory(const eix_proto::Category &category,
+                     const CombinedPackageList &combined);
+    void addCategories(const eix_proto::Collection &eix,
+                       const CombinedPackageList &combined);
+    int addPackage(const std::string &catName,
+                   const eix_proto::Package &pkg,
+                   const QStringList &zombies);
+    void clear();
+    void sortPackages();
+    void sort(QVector<int> &packages, int column, Qt::SortOrder order) const;
+
+    void setThreadCount(int threads);
+
+    void save(SnapshotImage &image) const;
+    bool restore(SnapshotImage &image);
+    void setDetailsSource(const DetailsSource &source);
+
+    int size() const;
+    int categoryCount() const;
+    std::string_view categoryName(int catNumber) const;
+    int categorySize(int catNumber) const;
+    int index(int catNumber, int pkgNumber) const;
+
+    QVariant data(int index, int column, int role) const;
+    const QString &text(int index, int column) const;
+    PackageReportItem::Marker marker(int index) const;
+    std::string_view category(int index) const;
+    std::string_view name(int index) const;
+    std::string_view description(int index) const;
+    const eix_proto::Package &packageDetails(int index) const;
+    bool installed(int index) const;
+    bool world(int index) const;
+    bool updateAvailable(int index) const;
+    QStringList versionNames(int index) const;
+    QStringList zombieVersions(int index) const;
+    PackageReportItem item(int index) const;
+    bool sameDisplay(int index,
+                     const PackageStore &other,
+                     int otherIndex) const;
+
+  private:
+    /// What a package shows, as worked out by a PackageReportItem
+    struct Summary {
+        QString installedText;
+        QString availableText;
+        QByteArray installedKey;
+        QByteArray availableKey;
+        uint8_t flags = 0;
+        QStringList installedVersions;
+        QStringList zombies;
+    };
+
+    static Summary summarise(const std::string &catName,
+                             const eix_proto::Package &pkg,
+                             const QStringList &zombies);
+    int addSummary(const std::string &catName,
+                   const eix_proto::Package &pkg,
+                   const Summary &summary);
+    StringPool::Id addText(std::string_view text);
+    StringPool::Id addText(const QString &text);
+    StringPool::Id addKey(const QByteArray &key);
+    void makeStrings();
+
+  private:
+    /// Set in _flags for a package with an installed version
+    static constexpr uint8_t installedFlag = 0x80;
+
+    /// Set in _flags for a package in the world file or a set, as for
+    /// PackageFilter::isWorld()
+    static constexpr uint8_t worldFlag = 0x40;
+
+    /// The part of _flags that holds the Installed column's marker
+    static constexpr uint8_t markerMask = 0x0f;
+
+    /// All of the text, interned, and the same as QStrings (by id)
+    StringPool _strings;
+    QVector<QString> _text;
+
+    /// The version sort keys, interned, and the same as QByteArrays (by id)
+    StringPool _keys;
+    QVector<QByteArray> _keyBytes;
+
+    /// The eix data for each package, unless the store was restored
+    std::vector<const eix_proto::Package *> _details;
+
+    /// Where the eix data comes from for a restored store
+    DetailsSource _detailsSource;
+
+    /// Text ids for each package
+    std::vector<StringPool::Id> _category;
+    std::vector<StringPool::Id> _name;
+    std::vector<StringPool::Id> _description;
+    std::vector<StringPool::Id> _installedText;
+    std::vector<StringPool::Id> _availableText;
+
+    /// Sort key ids for each package (see PackageReportItem::SortRole)
+    std::vector<StringPool::Id> _installedKey;
+    std::vector<StringPool::Id> _availableKey;
+
+    /// installedFlag, worldFlag and the marker, for each package
+    std::vector<uint8_t> _flags;
+
+    /// Each package's versions are _versions[_versionStart[n]] up to
+    /// _versions[_versionStart[n + 1]], with the zombies from
+    /// _zombieStart[n] on
+    std::vector<uint32_t> _versionStart;
+    std::vector<uint32_t> _zombieStart;
+    std::vector<StringPool::Id> _versions;
+
+    /// Where each category added by addCategory() starts, plus the end
+    std::vector<int> _categoryStart;
+
+    /// The text id of each category's name
+    std::vector<StringPool::Id> _categoryName;
+
+    /// Every package, in order by each column (see sortPackages())
+    std::vector<std::vector<int>> _sortOrder;
+
+    /// Threads for working out the packages' summaries in parallel
+    QThreadPool _pool;
+};
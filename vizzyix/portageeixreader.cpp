@@ -0,0 +1,605 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "portageeixreader.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace
+{
+/// What starts every eix database
+constexpr char magic[] = "eix\n";
+
+/// The settings that change what eix says is masked or stable
+const char *const localSettingFiles[] = {"package.mask",
+                                         "package.unmask",
+                                         "package.accept_keywords",
+                                         "package.keywords"};
+
+/*!
+ * Calls 'add' with each flag set in 'bits', where bit n is the flag with the
+ * value n + 1 (eix and its protobuf output number the flags the same way).
+ * Returns false if a bit is set past the last flag.
+ */
+template <typename Flag, typename Add>
+bool decodeFlags(uint64_t bits, Flag lastFlag, Add add)
+{
+    const int flagCount = static_cast<int>(lastFlag);
+    if ((bits >> flagCount) != 0) {
+        return false;
+    }
+    for (int bit = 0; bit < flagCount; ++bit) {
+        if ((bits & (uint64_t(1) << bit)) != 0) {
+            add(static_cast<Flag>(bit + 1));
+        }
+    }
+    return true;
+}
+
+/// Whether a file or directory is there and has something in it
+bool hasContents(const QString &path)
+{
+    const QFileInfo info(path);
+    if (info.isDir()) {
+        return !QDir(path).isEmpty(QDir::Files | QDir::Dirs |
+                                   QDir::NoDotAndDotDot);
+    }
+    return info.exists() && info.size() > 0;
+}
+} // namespace
+
+/// Constructor just saves where everything is
+PortageEixReader::PortageEixReader(const QString &eixFile,
+                                   const QString &configDir,
+                                   const QString &worldFile,
+                                   const QString &packageDatabaseRoot)
+    : _eixFile(eixFile), _configDir(configDir), _worldFile(worldFile),
+      _packageDatabaseRoot(packageDatabaseRoot), _data(nullptr), _size(0),
+      _position(0), _categoryCount(0), _savedFields(0)
+{
+}
+
+/*!
+ * Reads the eix database into 'eix', which should be empty, and marks the
+ * versions that are installed, given the package database entries (see
+ * CombinedPackageList::readPackageDatabase()).
+ *
+ * Returns false, leaving 'eix' empty, if the database can't be read as it
+ * is, e.g. it was written by another eix version; error() says why. The
+ * local settings aren't looked at, so check hasLocalSettings() first.
+ */
+bool PortageEixReader::read(eix_proto::Collection &eix,
+                            const QStringList &packageDatabase)
+{
+    _error.clear();
+
+    QFile file(_eixFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        _error = file.errorString();
+        return false;
+    }
+    if (file.size() < qint64(sizeof(magic) - 1)) {
+        _error = "not an eix database";
+        return false;
+    }
+    uchar *mapped = file.map(0, file.size());
+    if (mapped == nullptr) {
+        _error = file.errorString();
+        return false;
+    }
+    _data = mapped;
+    _size = file.size();
+    _position = 0;
+
+    bool ok = readHeader();
+    for (uint64_t catNumber = 0; ok && catNumber < _categoryCount;
+         ++catNumber) {
+        ok = readCategory(*eix.add_category());
+    }
+    ok = ok && (_position == _size || fail("end of file"));
+
+    // The tables point into the mapping
+    file.unmap(mapped);
+    _data = nullptr;
+    for (auto *table :
+         {&_repositories, &_eapis, &_licenses, &_keywords, &_slots, &_iuse,
+          &_depends}) {
+        table->clear();
+    }
+
+    if (!ok) {
+        eix.clear_category();
+        return false;
+    }
+
+    markInstalled(eix, packageDatabase);
+    markWorld(eix);
+    return true;
+}
+
+/// Why the last read() failed
+const QString &PortageEixReader::error() const
+{
+    return _error;
+}
+
+/*!
+ * Whether there are local settings that eix would apply to what it reads
+ * from the database: package masks, unmasks or keywords, keywords in
+ * make.conf, or world sets.
+ */
+bool PortageEixReader::hasLocalSettings() const
+{
+    const QDir configDir(_configDir);
+    for (const char *name : localSettingFiles) {
+        if (hasContents(configDir.filePath(name))) {
+            return true;
+        }
+    }
+
+    QFile makeConf(configDir.filePath("make.conf"));
+    if (makeConf.open(QIODevice::ReadOnly)) {
+        static const QRegularExpression acceptKeywords(
+            "^\\s*(export\\s+)?ACCEPT_KEYWORDS\\s*=",
+            QRegularExpression::MultilineOption);
+        if (acceptKeywords.match(QString::fromUtf8(makeConf.readAll()))
+                .hasMatch()) {
+            return true;
+        }
+    }
+
+    return hasContents(QFileInfo(_worldFile).dir().filePath("world_sets"));
+}
+
+/*!
+ * Reads a number: one 0xFF for each byte past the first, then the bytes,
+ * most significant first, with a first byte of 0xFF written as 0x00.
+ */
+bool PortageEixReader::readNumber(uint64_t &value)
+{
+    int extra = 0;
+    while (_position < _size && _data[_position] == 0xFF) {
+        ++extra;
+        ++_position;
+    }
+    if (_position == _size) {
+        return fail("number");
+    }
+
+    value = _data[_position++];
+    int rest = extra;
+    if (value == 0 && extra > 0) {
+        value = 0xFF;
+        --rest;
+    }
+    if (rest >= int(sizeof(value)) || rest > _size - _position) {
+        return fail("number");
+    }
+    for (; rest > 0; --rest) {
+        value = (value << 8) | _data[_position++];
+    }
+    return true;
+}
+
+/// Reads a count of things that take at least 'minimumSize' bytes each
+bool PortageEixReader::readCount(uint64_t &count, uint64_t minimumSize)
+{
+    if (!readNumber(count)) {
+        return false;
+    }
+    if (count > uint64_t(_size - _position) / minimumSize) {
+        return fail("count");
+    }
+    return true;
+}
+
+/// Reads a string, which is left in the mapped database
+bool PortageEixReader::readString(std::string_view &text)
+{
+    uint64_t length;
+    if (!readNumber(length)) {
+        return false;
+    }
+    if (length > uint64_t(_size - _position)) {
+        return fail("string");
+    }
+    text = std::string_view(reinterpret_cast<const char *>(_data + _position),
+                            length);
+    _position += length;
+    return true;
+}
+
+/// Reads a string table
+bool PortageEixReader::readTable(StringTable &table)
+{
+    uint64_t count;
+    if (!readCount(count)) {
+        return false;
+    }
+    table.resize(count);
+    for (auto &text : table) {
+        if (!readString(text)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Reads the number of a string in a string table
+bool PortageEixReader::readIndex(const StringTable &table,
+                                 std::string_view &text)
+{
+    uint64_t index;
+    if (!readNumber(index)) {
+        return false;
+    }
+    if (index >= table.size()) {
+        return fail("string number");
+    }
+    text = table[index];
+    return true;
+}
+
+/// Reads a list of words from a string table
+bool PortageEixReader::readWords(const StringTable &table, StringTable &words)
+{
+    uint64_t count;
+    if (!readCount(count)) {
+        return false;
+    }
+    words.resize(count);
+    for (auto &word : words) {
+        if (!readIndex(table, word)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Reads a list of words from a string table, as one string
+bool PortageEixReader::readWords(const StringTable &table, std::string &text)
+{
+    uint64_t count;
+    if (!readCount(count)) {
+        return false;
+    }
+    text.clear();
+    for (uint64_t wordNumber = 0; wordNumber < count; ++wordNumber) {
+        std::string_view word;
+        if (!readIndex(table, word)) {
+            return false;
+        }
+        if (wordNumber > 0) {
+            text += ' ';
+        }
+        text += word;
+    }
+    return true;
+}
+
+/// Reads everything before the first category, checking the format version
+bool PortageEixReader::readHeader()
+{
+    const qsizetype magicSize = sizeof(magic) - 1;
+    if (_size < magicSize || std::memcmp(_data, magic, magicSize) != 0) {
+        _error = "not an eix database";
+        return false;
+    }
+    _position = magicSize;
+
+    uint64_t version;
+    if (!readNumber(version)) {
+        return false;
+    }
+    if (version != formatVersion) {
+        _error = QString("eix database format %1, only %2 can be read")
+                     .arg(version)
+                     .arg(formatVersion);
+        return false;
+    }
+
+    // Each category is at least its name and package count
+    if (!readCount(_categoryCount, 2)) {
+        return false;
+    }
+
+    uint64_t repositoryCount;
+    if (!readCount(repositoryCount, 2)) {
+        return false;
+    }
+    _repositories.resize(repositoryCount);
+    for (auto &name : _repositories) {
+        std::string_view path;
+        if (!readString(path) || !readString(name)) {
+            return false;
+        }
+    }
+
+    if (!readTable(_eapis) || !readTable(_licenses) || !readTable(_keywords) ||
+        !readTable(_slots) || !readTable(_iuse) ||
+        !readNumber(_savedFields)) {
+        return false;
+    }
+    if ((_savedFields & ~uint64_t(AllSavedFields)) != 0) {
+        return fail("saved fields");
+    }
+    if ((_savedFields & SavedDepend) != 0 && !readTable(_depends)) {
+        return false;
+    }
+
+    // The world sets are only names; see hasLocalSettings()
+    StringTable worldSets;
+    return readTable(worldSets);
+}
+
+/// Reads a category and its packages
+bool PortageEixReader::readCategory(eix_proto::Category &cat)
+{
+    std::string_view name;
+    uint64_t packageCount;
+    if (!readString(name) || !readCount(packageCount)) {
+        return false;
+    }
+    cat.set_category(std::string(name));
+    cat.mutable_package()->Reserve(static_cast<int>(packageCount));
+
+    for (uint64_t pkgNumber = 0; pkgNumber < packageCount; ++pkgNumber) {
+        uint64_t length;
+        if (!readNumber(length)) {
+            return false;
+        }
+        if (length > uint64_t(_size - _position)) {
+            return fail("package length");
+        }
+        // The package can't be read past its end
+        const qsizetype size = _size;
+        _size = _position + qsizetype(length);
+        const bool ok = readPackage(*cat.add_package());
+        const bool atEnd = _position == _size;
+        _size = size;
+        if (!ok) {
+            return false;
+        }
+        if (!atEnd) {
+            return fail("package length");
+        }
+    }
+    return true;
+}
+
+/// Reads a package and its versions
+bool PortageEixReader::readPackage(eix_proto::Package &pkg)
+{
+    std::string_view name;
+    std::string_view description;
+    std::string_view homepage;
+    uint64_t versionCount;
+    if (!readString(name) || !readString(description) ||
+        !readString(homepage) ||
+        !readWords(_licenses, *pkg.mutable_licenses()) ||
+        !readCount(versionCount)) {
+        return false;
+    }
+    pkg.set_name(std::string(name));
+    pkg.set_description(std::string(description));
+    pkg.set_homepage(std::string(homepage));
+
+    pkg.mutable_version()->Reserve(static_cast<int>(versionCount));
+    for (uint64_t verNumber = 0; verNumber < versionCount; ++verNumber) {
+        if (!readVersion(*pkg.add_version())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Reads a version
+bool PortageEixReader::readVersion(eix_proto::Version &ver)
+{
+    uint64_t maskBits;
+    uint64_t keyBits;
+    uint64_t propertyBits;
+    uint64_t restrictBits;
+    if (!readNumber(maskBits) || !readNumber(keyBits) ||
+        !readNumber(propertyBits) || !readNumber(restrictBits)) {
+        return false;
+    }
+
+    // Only what is set is written, as eix does
+    bool ok = true;
+    if (maskBits != 0) {
+        auto *flags = ver.mutable_system_mask_flags();
+        ok = ok && decodeFlags(
+                       maskBits,
+                       eix_proto::MaskFlags_MaskFlag_MaskFlag_MAX,
+                       [flags](auto flag) { flags->add_mask_flag(flag); });
+    }
+    if (keyBits != 0) {
+        auto *flags = ver.mutable_system_key_flags();
+        ok = ok && decodeFlags(
+                       keyBits,
+                       eix_proto::KeyFlags_KeyFlag_KeyFlag_MAX,
+                       [flags](auto flag) { flags->add_key_flag(flag); });
+    }
+    if (propertyBits != 0) {
+        auto *flags = ver.mutable_properties();
+        ok = ok && decodeFlags(
+                       propertyBits,
+                       eix_proto::Properties_Property_Property_MAX,
+                       [flags](auto flag) { flags->add_property(flag); });
+    }
+    if (restrictBits != 0) {
+        auto *flags = ver.mutable_restrictions();
+        ok = ok && decodeFlags(
+                       restrictBits,
+                       eix_proto::Restrictions_Restrict_Restrict_MAX,
+                       [flags](auto flag) { flags->add_restrict(flag); });
+    }
+    if (!ok) {
+        return fail("flags");
+    }
+
+    std::string_view eapi;
+    std::string_view id;
+    std::string_view slot;
+    std::string_view repository;
+    if (!readIndex(_eapis, eapi) ||
+        !readWords(_keywords, *ver.mutable_keywords()) || !readString(id) ||
+        !readIndex(_slots, slot) || !readIndex(_repositories, repository) ||
+        !readWords(_iuse, _words)) {
+        return false;
+    }
+    ver.set_eapi(std::string(eapi));
+    ver.set_id(std::string(id));
+    ver.set_slot(std::string(slot));
+    ver.mutable_repository()->set_repository(std::string(repository));
+
+    // The IUSE words carry the default of each flag, as in the ebuild
+    for (auto flag : _words) {
+        const char prefix = flag.empty() ? 0 : flag[0];
+        if (prefix == '+') {
+            ver.add_iuse_plus(std::string(flag.substr(1)));
+        } else if (prefix == '-') {
+            ver.add_iuse_minus(std::string(flag.substr(1)));
+        } else {
+            ver.add_iuse(std::string(flag));
+        }
+    }
+
+    if ((_savedFields & SavedRequiredUse) != 0 &&
+        !readWords(_iuse, *ver.mutable_required_use())) {
+        return false;
+    }
+    if ((_savedFields & SavedDepend) != 0 &&
+        (!readWords(_depends, *ver.mutable_depend()) ||
+         !readWords(_depends, *ver.mutable_rdepend()) ||
+         !readWords(_depends, *ver.mutable_pdepend()) ||
+         !readWords(_depends, *ver.mutable_bdepend()))) {
+        return false;
+    }
+    if ((_savedFields & SavedSrcUri) != 0) {
+        std::string_view srcUri;
+        if (!readString(srcUri)) {
+            return false;
+        }
+        ver.set_src_uri(std::string(srcUri));
+    }
+    return true;
+}
+
+/// Notes what couldn't be read, and where, and returns false
+bool PortageEixReader::fail(const char *what)
+{
+    if (_error.isEmpty()) {
+        _error = QString("bad %1 at byte %2 of %3")
+                     .arg(what)
+                     .arg(_position)
+                     .arg(_eixFile);
+    }
+    return false;
+}
+
+/*!
+ * Marks the installed versions whose packages are in the world file, as eix
+ * does. An entry with a slot, e.g. "dev-lang/python:3.12", only marks the
+ * versions in that slot.
+ */
+void PortageEixReader::markWorld(eix_proto::Collection &eix) const
+{
+    QFile world(_worldFile);
+    if (!world.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    // package -> slots, where an empty slot is any slot
+    std::unordered_map<std::string, std::vector<std::string>> entries;
+    while (!world.atEnd()) {
+        const std::string line = world.readLine().trimmed().toStdString();
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        const size_t colon = line.find(':');
+        auto &slots = entries[line.substr(0, colon)];
+        if (colon == std::string::npos) {
+            slots.emplace_back();
+        } else {
+            slots.push_back(line.substr(colon + 1));
+        }
+    }
+    if (entries.empty()) {
+        return;
+    }
+
+    std::string key;
+    for (auto &cat : *eix.mutable_category()) {
+        for (auto &pkg : *cat.mutable_package()) {
+            key.assign(cat.category()).append(1, '/').append(pkg.name());
+            const auto entry = entries.find(key);
+            if (entry == entries.end()) {
+                continue;
+            }
+            for (auto &ver : *pkg.mutable_version()) {
+                if (!ver.has_installed()) {
+                    continue;
+                }
+                // The world file doesn't give sub-slots
+                std::string_view slot = ver.slot();
+                slot = slot.substr(0, slot.find('/'));
+                for (const auto &worldSlot : entry->second) {
+                    if (worldSlot.empty() || worldSlot == slot) {
+                        ver.mutable_system_mask_flags()->add_mask_flag(
+                            eix_proto::MaskFlags_MaskFlag_WORLD);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
+
+/*!
+ * Marks the versions that are in the package database as installed, dated
+ * by their package directories (as ApplicationData does when it follows an
+ * emerge).
+ */
+void PortageEixReader::markInstalled(eix_proto::Collection &eix,
+                                     const QStringList &packageDatabase) const
+{
+    if (packageDatabase.isEmpty()) {
+        return;
+    }
+    std::unordered_set<std::string> installed;
+    installed.reserve(packageDatabase.size());
+    for (const QString &entry : packageDatabase) {
+        installed.insert(entry.toStdString());
+    }
+
+    const QDir root(_packageDatabaseRoot);
+    std::string key;
+    for (auto &cat : *eix.mutable_category()) {
+        for (auto &pkg : *cat.mutable_package()) {
+            key.assign(cat.category())
+                .append(1, '/')
+                .append(pkg.name())
+                .append(1, '-');
+            const size_t prefixSize = key.size();
+            for (auto &ver : *pkg.mutable_version()) {
+                key.resize(prefixSize);
+                key.append(ver.id());
+                if (installed.count(key) == 0) {
+                    continue;
+                }
+                const QFileInfo versionDir(
+                    root.filePath(QString::fromStdString(key)));
+                ver.mutable_installed()->set_date(
+                    versionDir.lastModified().toSecsSinceEpoch());
+            }
+        }
+    }
+}
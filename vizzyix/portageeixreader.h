@@ -0,0 +1,133 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "eix.pb.h"
+
+/*! class PortageEixReader
+ *
+ * Reads the eix database (/var/cache/eix/portage.eix) straight into the eix
+ * Collection, without running "eix --proto" to convert it to protobuf first.
+ * The file is memory mapped and decoded in one pass.
+ *
+ * The database format is eix's own, and it changes between eix versions, so
+ * the format version in the header has to be one this reader knows
+ * (formatVersion). Anything unexpected, e.g. another version, a count that
+ * doesn't fit, a package that isn't the length its header says, or bytes
+ * left over at the end, makes read() fail, and the caller runs eix instead.
+ *
+ * The layout, as written by eix-update (format version 39):
+ *
+ *     "eix\n", the format version, the number of categories
+ *     the repositories: a count, then a path and a name for each
+ *     the EAPI, licence, keyword, slot and IUSE string tables
+ *     which optional fields are saved (see SavedField)
+ *     the dependency string table, if dependencies are saved
+ *     the world sets: a count, then a name for each
+ *     each category: its name, the number of packages, then the packages
+ *
+ * A package is its length in bytes (not counting the length itself), its
+ * name, description, homepage, licences and versions. A version is its saved
+ * mask, keyword, properties and restrict flags, its EAPI, keywords, id,
+ * slot, repository and IUSE, and then whichever optional fields are saved.
+ *
+ * Numbers are big-endian, in as few bytes as they need. A number of more than
+ * one byte is preceded by one 0xFF for each extra byte; if its first byte is
+ * itself 0xFF, that is written as 0x00 after the markers. A string is its
+ * length and then its bytes. A string table is a count and then the strings,
+ * and fields that use one hold the number of a string, or a count and then
+ * the numbers of a list of words.
+ *
+ * eix adds some things to its output that are not in the database, and these
+ * are filled in here the same way: which versions are installed, from the
+ * package database, and which installed packages are in the world file. What
+ * eix works out from the local settings (the local mask and keyword flags,
+ * and the packages of the world sets) is not, so eix has to be run instead
+ * if there are any (see hasLocalSettings()).
+ */
+class PortageEixReader
+{
+  public:
+    /// The eix database format version that can be read
+    static constexpr uint64_t formatVersion = 39;
+
+    PortageEixReader(const QString &eixFile,
+                     const QString &configDir,
+                     const QString &worldFile,
+                     const QString &packageDatabaseRoot);
+
+    PortageEixReader(const PortageEixReader &) = delete;
+    PortageEixReader &operator=(PortageEixReader &) = delete;
+
+    bool read(eix_proto::Collection &eix, const QStringList &packageDatabase);
+    const QString &error() const;
+    bool hasLocalSettings() const;
+
+  private:
+    /// The optional version fields, as bits of the header's saved fields
+    enum SavedField {
+        SavedDepend = 1,
+        SavedRequiredUse = 2,
+        SavedSrcUri = 4,
+        AllSavedFields = 7
+    };
+
+    /// A string table from the header, or a list of words from one
+    typedef std::vector<std::string_view> StringTable;
+
+    bool readNumber(uint64_t &value);
+    bool readCount(uint64_t &count, uint64_t minimumSize = 1);
+    bool readString(std::string_view &text);
+    bool readTable(StringTable &table);
+    bool readIndex(const StringTable &table, std::string_view &text);
+    bool readWords(const StringTable &table, StringTable &words);
+    bool readWords(const StringTable &table, std::string &text);
+    bool readHeader();
+    bool readCategory(eix_proto::Category &cat);
+    bool readPackage(eix_proto::Package &pkg);
+    bool readVersion(eix_proto::Version &ver);
+    bool fail(const char *what);
+    void markWorld(eix_proto::Collection &eix) const;
+    void markInstalled(eix_proto::Collection &eix,
+                       const QStringList &packageDatabase) const;
+
+  private:
+    /// Where the eix database, the portage settings, the world file and the
+    /// package database are
+    const QString _eixFile;
+    const QString _configDir;
+    const QString _worldFile;
+    const QString _packageDatabaseRoot;
+
+    /// Why the last read() failed
+    QString _error;
+
+    /// The mapped database, while it is being read
+    const uint8_t *_data;
+    qsizetype _size;
+
+    /// Where the next read starts
+    qsizetype _position;
+
+    /// The header, while the database is being read
+    uint64_t _categoryCount;
+    StringTable _repositories;
+    StringTable _eapis;
+    StringTable _licenses;
+    StringTable _keywords;
+    StringTable _slots;
+    StringTable _iuse;
+    StringTable _depends;
+    uint64_t _savedFields;
+
+    /// The words of the field being read, kept to save allocating them
+    StringTable _words;
+};
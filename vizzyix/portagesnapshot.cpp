@@ -0,0 +1,291 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "portagesnapshot.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtLogging>
+#include <cstring>
+
+/// Constructor, nothing is read until it is asked for
+PortageSnapshot::PortageSnapshot(const QString &eixFile,
+                                 const QString &emergeLogFile,
+                                 const QString &packageDatabaseRoot,
+                                 const QString &snapshotFile)
+    : _sources{eixFile, emergeLogFile, packageDatabaseRoot},
+      _snapshotFile(snapshotFile), _recordingSources(), _recordingActive(false)
+{
+}
+
+/// The snapshot file under the user's cache directory (~/.cache/vizzyix)
+QString PortageSnapshot::defaultSnapshotFile()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+           "/portage.snapshot";
+}
+
+/// Whether there is a complete snapshot, however old
+bool PortageSnapshot::exists() const
+{
+    Header header;
+    return readHeader(header);
+}
+
+/*!
+ * Whether there is a snapshot and none of the files it depends on have
+ * changed since it was made.
+ */
+bool PortageSnapshot::isCurrent() const
+{
+    Header header;
+    return readHeader(header) && sameSources(header, sourceHeader());
+}
+
+/*!
+ * Maps the snapshot file into memory, so that tables(), eixOutput() and
+ * packageDatabase() can be read. The data is not copied, so it is only good
+ * until unmap() is called.
+ *
+ * Returns false if there is no usable snapshot.
+ */
+bool PortageSnapshot::map()
+{
+    unmap();
+
+    Header header;
+    if (!readHeader(header)) {
+        return false;
+    }
+
+    _mapped.setFileName(_snapshotFile);
+    if (!_mapped.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const uchar *data = _mapped.map(0, _mapped.size());
+    if (data == nullptr) {
+        qWarning() << "Failed to map snapshot" << _snapshotFile << ":"
+                   << _mapped.errorString();
+        _mapped.close();
+        return false;
+    }
+
+    const auto *eix = reinterpret_cast<const char *>(data) + sizeof(header);
+    _mappedEix = QByteArray::fromRawData(eix, header.eixSize);
+    _mappedPackageDatabase = QByteArray::fromRawData(
+        eix + header.eixSize, header.packageDatabaseSize);
+    _mappedTables = QByteArray::fromRawData(
+        eix + header.eixSize + header.packageDatabaseSize, header.tablesSize);
+    return true;
+}
+
+/// The eix output from the mapped snapshot
+QByteArray PortageSnapshot::eixOutput() const
+{
+    return _mappedEix;
+}
+
+/*!
+ * The installed package directories from the mapped snapshot, as
+ * "category/package-version" relative to the package database root.
+ */
+QStringList PortageSnapshot::packageDatabase() const
+{
+    if (_mappedPackageDatabase.isEmpty()) {
+        return QStringList();
+    }
+    return QString::fromUtf8(_mappedPackageDatabase).split('\n');
+}
+
+/// The tables from the mapped snapshot, see SnapshotImage
+QByteArray PortageSnapshot::tables() const
+{
+    return _mappedTables;
+}
+
+/// Releases the mapping made by map()
+void PortageSnapshot::unmap()
+{
+    _mappedEix.clear();
+    _mappedPackageDatabase.clear();
+    _mappedTables.clear();
+    if (_mapped.isOpen()) {
+        _mapped.close(); // also unmaps
+    }
+}
+
+/*!
+ * Starts collecting data for a new snapshot. This should be called just
+ * before eix is started, so that the snapshot is tied to the files as they
+ * were when they were read.
+ */
+void PortageSnapshot::startRecording()
+{
+    _recording.clear();
+    _recordingPackageDatabase.clear();
+    _recordingTables.clear();
+    _recordingSources = sourceHeader();
+    _recordingActive = true;
+}
+
+/// Whether data is being collected for a new snapshot
+bool PortageSnapshot::isRecording() const
+{
+    return _recordingActive;
+}
+
+/// Adds some eix output to the new snapshot, if recording
+void PortageSnapshot::record(const QByteArray &data)
+{
+    if (_recordingActive) {
+        _recording.append(data);
+    }
+}
+
+/// Sets the package database list for the new snapshot
+void PortageSnapshot::setPackageDatabase(const QStringList &entries)
+{
+    _recordingPackageDatabase = entries;
+}
+
+/*!
+ * Sets the tables for the new snapshot, made from the data the recorded eix
+ * output and package database were loaded into (see SnapshotImage).
+ */
+void PortageSnapshot::setTables(const QByteArray &tables)
+{
+    _recordingTables = tables;
+}
+
+/*!
+ * Whether the data recorded so far is the same as the saved snapshot, i.e.
+ * whether a refresh found anything new.
+ */
+bool PortageSnapshot::sameAsSaved()
+{
+    if (!map()) {
+        return false;
+    }
+    bool same = _mappedEix == _recording &&
+                _mappedPackageDatabase == recordedPackageDatabase();
+    unmap();
+    return same;
+}
+
+/*!
+ * Writes out the recorded data, replacing the previous snapshot. Returns
+ * false if it could not be written; the snapshot is just not used then.
+ */
+bool PortageSnapshot::save()
+{
+    if (!_recordingActive) {
+        return false;
+    }
+
+    QByteArray packageDatabase = recordedPackageDatabase();
+
+    Header header = _recordingSources;
+    header.eixSize = _recording.size();
+    header.packageDatabaseSize = packageDatabase.size();
+    header.tablesSize = _recordingTables.size();
+
+    QDir().mkpath(QFileInfo(_snapshotFile).absolutePath());
+
+    // Must not be replaced while it is mapped
+    unmap();
+
+    QSaveFile file(_snapshotFile);
+    bool ok =
+        file.open(QIODevice::WriteOnly) &&
+        file.write(reinterpret_cast<const char *>(&header), sizeof(header)) ==
+            sizeof(header) &&
+        file.write(_recording) == _recording.size() &&
+        file.write(packageDatabase) == packageDatabase.size() &&
+        file.write(_recordingTables) == _recordingTables.size() &&
+        file.commit();
+    if (!ok) {
+        qWarning() << "Failed to write snapshot" << _snapshotFile << ":"
+                   << file.errorString();
+    }
+
+    discard();
+    return ok;
+}
+
+/// Stops recording and throws away anything recorded
+void PortageSnapshot::discard()
+{
+    _recording.clear();
+    _recordingPackageDatabase.clear();
+    _recordingTables.clear();
+    _recordingActive = false;
+}
+
+/*!
+ * Reads the header of the snapshot file, and checks that the file is
+ * complete.
+ */
+bool PortageSnapshot::readHeader(Header &header) const
+{
+    QFile file(_snapshotFile);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    if (file.read(reinterpret_cast<char *>(&header), sizeof(header)) !=
+        sizeof(header)) {
+        return false;
+    }
+
+    return std::memcmp(header.magic, snapshotMagic, sizeof(snapshotMagic)) ==
+               0 &&
+           header.eixSize >= 0 && header.packageDatabaseSize >= 0 &&
+           header.tablesSize >= 0 &&
+           file.size() == static_cast<qint64>(sizeof(header)) +
+                              header.eixSize + header.packageDatabaseSize +
+                              header.tablesSize;
+}
+
+/// The header that a current snapshot would have (apart from the sizes)
+PortageSnapshot::Header PortageSnapshot::sourceHeader() const
+{
+    Header header;
+    std::memcpy(header.magic, snapshotMagic, sizeof(snapshotMagic));
+
+    for (int source = 0; source < sourceCount; ++source) {
+        QFileInfo info(_sources[source]);
+        header.sourceModified[source] =
+            info.exists() ? info.lastModified().toMSecsSinceEpoch() : -1;
+        header.sourceSize[source] = info.exists() ? info.size() : -1;
+    }
+    header.eixSize = 0;
+    header.packageDatabaseSize = 0;
+    header.tablesSize = 0;
+    return header;
+}
+
+/*!
+ * Whether two headers are for the same state of the source files. A file
+ * that doesn't exist never matches.
+ */
+bool PortageSnapshot::sameSources(const Header &a, const Header &b)
+{
+    for (int source = 0; source < sourceCount; ++source) {
+        if (a.sourceModified[source] < 0 ||
+            a.sourceModified[source] != b.sourceModified[source] ||
+            a.sourceSize[source] != b.sourceSize[source]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// The recorded package database list, as it is stored in the file
+QByteArray PortageSnapshot::recordedPackageDatabase() const
+{
+    return _recordingPackageDatabase.join('\n').toUtf8();
+}
@@ -0,0 +1,116 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+/*! class PortageSnapshot
+ *
+ * A copy of everything read in by a full (unfiltered) load, so the next run
+ * of the application can show it straight away.
+ *
+ * The main part is the tables the load worked out (see tables()): the
+ * package list's columns and text, the installed versions and zombies of
+ * each package, the facets and the search index, laid out by SnapshotImage.
+ * These are read straight back out of the mapped file, so nothing has to be
+ * decoded or merged again. The protobuf output of eix is kept as well, but
+ * only to decode the details of a package when it is picked (see
+ * LoadGeneration::setStream()), and the list of installed package
+ * directories is only kept to tell whether a refresh found anything new
+ * (see sameAsSaved()).
+ *
+ * The snapshot records the modification times and sizes of the files it
+ * depends on: the eix database (portage.eix), the emerge log (written by
+ * every install or uninstall) and the package database root. If any of them
+ * have changed, the snapshot can still be shown but should be refreshed.
+ *
+ * The file is memory mapped when read, and written atomically, so a crash
+ * part way through just leaves the previous snapshot in place.
+ */
+class PortageSnapshot
+{
+  public:
+    PortageSnapshot(const QString &eixFile,
+                    const QString &emergeLogFile,
+                    const QString &packageDatabaseRoot,
+                    const QString &snapshotFile = defaultSnapshotFile());
+
+    PortageSnapshot(const PortageSnapshot &) = delete;
+    PortageSnapshot &operator=(PortageSnapshot &) = delete;
+
+    static QString defaultSnapshotFile();
+
+    bool exists() const;
+    bool isCurrent() const;
+    bool map();
+    QByteArray eixOutput() const;
+    QStringList packageDatabase() const;
+    QByteArray tables() const;
+    void unmap();
+
+    void startRecording();
+    bool isRecording() const;
+    void record(const QByteArray &data);
+    void setPackageDatabase(const QStringList &entries);
+    void setTables(const QByteArray &tables);
+    bool sameAsSaved();
+    bool save();
+    void discard();
+
+  private:
+    /// The number of files the snapshot depends on
+    static constexpr int sourceCount = 3;
+
+    /// The start of the snapshot file, followed by the three sections
+    struct Header {
+        char magic[8];
+        qint64 sourceModified[sourceCount];
+        qint64 sourceSize[sourceCount];
+        qint64 eixSize;
+        qint64 packageDatabaseSize;
+        qint64 tablesSize;
+    };
+
+    static constexpr char snapshotMagic[8] = {
+        'V', 'Z', 'X', 'S', 'N', 'A', 'P', '2'};
+
+    bool readHeader(Header &header) const;
+    Header sourceHeader() const;
+    static bool sameSources(const Header &a, const Header &b);
+    QByteArray recordedPackageDatabase() const;
+
+  private:
+    /// The files the snapshot depends on
+    QString _sources[sourceCount];
+
+    /// Where the snapshot is kept
+    QString _snapshotFile;
+
+    /// The open snapshot file while it is mapped
+    QFile _mapped;
+
+    /// The sections of the snapshot file, while it is mapped
+    QByteArray _mappedEix;
+    QByteArray _mappedPackageDatabase;
+    QByteArray _mappedTables;
+
+    /// The eix output being collected for a new snapshot
+    QByteArray _recording;
+
+    /// The package database list for a new snapshot
+    QStringList _recordingPackageDatabase;
+
+    /// The tables for a new snapshot
+    QByteArray _recordingTables;
+
+    /// The state of the source files when the recording started
+    Header _recordingSources;
+
+    /// Whether data is being collected for a new snapshot
+    bool _recordingActive;
+};
@@ -0,0 +1,259 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "portagewatcher.h"
+
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <algorithm>
+
+/// Constructor just saves the paths; nothing is watched until start()
+PortageWatcher::PortageWatcher(const QString &eixFile,
+                               const QString &emergeLogFile,
+                               const QString &packageDatabaseRoot,
+                               QObject *parent)
+    : QObject(parent), _eixFile(eixFile), _emergeLogFile(emergeLogFile),
+      _packageDatabaseRoot(packageDatabaseRoot)
+{
+    _batchTimer.setSingleShot(true);
+    _batchTimer.setInterval(defaultBatchDelay);
+
+    connect(&_watcher,
+            &QFileSystemWatcher::fileChanged,
+            this,
+            &PortageWatcher::onFileChanged);
+    connect(&_watcher,
+            &QFileSystemWatcher::directoryChanged,
+            this,
+            &PortageWatcher::onDirectoryChanged);
+    connect(&_batchTimer,
+            &QTimer::timeout,
+            this,
+            &PortageWatcher::onBatchTimeout);
+}
+
+/*!
+ * Starts watching. Any changes from before this are not reported, so it
+ * should be called before the data is read.
+ */
+void PortageWatcher::start()
+{
+    stop();
+
+    watchFile(_eixFile);
+    watchFile(_emergeLogFile);
+    const QString eixDirectory = QFileInfo(_eixFile).absolutePath();
+    if (QFileInfo(eixDirectory).isDir()) {
+        _watcher.addPath(eixDirectory);
+    }
+    if (QFileInfo(_packageDatabaseRoot).isDir()) {
+        _watcher.addPath(_packageDatabaseRoot);
+    } else {
+        qWarning() << "(PortageWatcher) no package database at"
+                   << _packageDatabaseRoot;
+    }
+    scanCategories(false);
+}
+
+/// Stops watching, and forgets about any changes not yet reported
+void PortageWatcher::stop()
+{
+    const QStringList paths = _watcher.files() + _watcher.directories();
+    if (!paths.isEmpty()) {
+        _watcher.removePaths(paths);
+    }
+    _categoryTimes.clear();
+    _batchTimer.stop();
+    _eixChanged = false;
+    _emergeLogChanged = false;
+    _rootChanged = false;
+    _changedCategories.clear();
+}
+
+/// Whether anything is being watched
+bool PortageWatcher::isActive() const
+{
+    return !_watcher.files().isEmpty() || !_watcher.directories().isEmpty();
+}
+
+/*!
+ * Holds back the reports, e.g. while eix is running and the data can't be
+ * changed. The changes are still collected, and reported after release().
+ */
+void PortageWatcher::hold()
+{
+    _held = true;
+}
+
+/// Reports anything that changed while the reports were held back
+void PortageWatcher::release()
+{
+    _held = false;
+    if (_eixChanged || _emergeLogChanged || _rootChanged ||
+        !_changedCategories.isEmpty()) {
+        _batchTimer.start();
+    }
+}
+
+/// Sets how long to wait for the events to stop before reporting a batch
+void PortageWatcher::setBatchDelay(int msecs)
+{
+    _batchTimer.setInterval(msecs);
+}
+
+/*!
+ * Watches the given file, if it exists and isn't already being watched. A
+ * file that is replaced, rather than written in place, stops being watched,
+ * so this is checked again after each batch.
+ */
+void PortageWatcher::watchFile(const QString &path)
+{
+    if (!_watcher.files().contains(path) && QFileInfo::exists(path)) {
+        _watcher.addPath(path);
+    }
+}
+
+/*!
+ * Brings the list of category directories up to date, watching any new ones.
+ *
+ * report:
+ *     Whether to add new and removed categories to the batch
+ */
+void PortageWatcher::scanCategories(bool report)
+{
+    const QDir root(_packageDatabaseRoot);
+    const QFileInfoList found =
+        root.entryInfoList(QDir::NoDotAndDotDot | QDir::Dirs);
+
+    QSet<QString> present;
+    const QStringList watched = _watcher.directories();
+    for (const auto &categoryInfo : found) {
+        const QString name = categoryInfo.fileName();
+        present.insert(name);
+
+        if (!watched.contains(categoryInfo.filePath())) {
+            _watcher.addPath(categoryInfo.filePath());
+        }
+        if (!_categoryTimes.contains(name)) {
+            _categoryTimes.insert(name, categoryInfo.lastModified());
+            if (report) {
+                _changedCategories.insert(name);
+            }
+        }
+    }
+
+    for (auto category = _categoryTimes.begin();
+         category != _categoryTimes.end();) {
+        if (present.contains(category.key())) {
+            ++category;
+        } else {
+            if (report) {
+                _changedCategories.insert(category.key());
+            }
+            category = _categoryTimes.erase(category);
+        }
+    }
+}
+
+/// Adds any category whose directory time has changed to the batch
+void PortageWatcher::checkCategoryTimes()
+{
+    const QDir root(_packageDatabaseRoot);
+    for (auto category = _categoryTimes.cbegin();
+         category != _categoryTimes.cend();
+         ++category) {
+        QFileInfo categoryInfo(root.filePath(category.key()));
+        if (categoryInfo.lastModified() != category.value()) {
+            _changedCategories.insert(category.key());
+        }
+    }
+}
+
+/*!
+ * Adds an event to the batch: the batch is reported when the events have
+ * stopped for the batch delay, or soon after maxDelay if they don't stop.
+ */
+void PortageWatcher::startBatch()
+{
+    if (!_batchTimer.isActive()) {
+        _batchAge.start();
+        _batchTimer.start();
+    } else if (_batchAge.elapsed() < maxDelay) {
+        _batchTimer.start();
+    }
+}
+
+/// The eix database or the emerge log has been written or replaced
+void PortageWatcher::onFileChanged(const QString &path)
+{
+    if (path == _eixFile) {
+        _eixChanged = true;
+    } else if (path == _emergeLogFile) {
+        _emergeLogChanged = true;
+    }
+    startBatch();
+}
+
+/*!
+ * A category has been added or removed, or packages in a category have, or
+ * the eix database has turned up (e.g. made by eix-update for the first
+ * time) or been replaced
+ */
+void PortageWatcher::onDirectoryChanged(const QString &path)
+{
+    if (path == QFileInfo(_eixFile).absolutePath()) {
+        if (_watcher.files().contains(_eixFile) ||
+            !QFileInfo::exists(_eixFile)) {
+            // Something else in the eix cache directory
+            return;
+        }
+        _eixChanged = true;
+    } else if (path == _packageDatabaseRoot) {
+        _rootChanged = true;
+    } else {
+        _changedCategories.insert(QFileInfo(path).fileName());
+    }
+    startBatch();
+}
+
+/// Reports what has changed in the batch, unless that is being held back
+void PortageWatcher::onBatchTimeout()
+{
+    if (_held) {
+        return;
+    }
+
+    watchFile(_eixFile);
+    watchFile(_emergeLogFile);
+    if (_rootChanged) {
+        scanCategories(true);
+    }
+    if (_emergeLogChanged) {
+        checkCategoryTimes();
+    }
+
+    const QDir root(_packageDatabaseRoot);
+    QStringList categories(_changedCategories.cbegin(),
+                           _changedCategories.cend());
+    std::sort(categories.begin(), categories.end());
+    for (const auto &category : categories) {
+        auto time = _categoryTimes.find(category);
+        if (time != _categoryTimes.end()) {
+            time.value() = QFileInfo(root.filePath(category)).lastModified();
+        }
+    }
+
+    const bool eixChanged = _eixChanged;
+    _eixChanged = false;
+    _emergeLogChanged = false;
+    _rootChanged = false;
+    _changedCategories.clear();
+
+    if (eixChanged) {
+        emit eixDatabaseChanged();
+    }
+    if (!categories.isEmpty()) {
+        emit packageDatabaseChanged(categories);
+    }
+}
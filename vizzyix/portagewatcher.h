@@ -0,0 +1,103 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QObject>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+
+/*! class PortageWatcher
+ *
+ * Watches the files the portage data is read from, so the display can follow
+ * changes without the user having to reload:
+ *  - the eix database (portage.eix), rewritten by eix-update, and the
+ *    directory it is in, so that a new eix database is noticed too
+ *  - the emerge log, written by every install or uninstall
+ *  - the package database root, and each of its category directories
+ *
+ * A running emerge touches these many times, so the events are collected
+ * into a batch, which is reported once things have been quiet for a moment
+ * (or after maxDelay, if they never are). Only the package database
+ * categories whose directories actually changed are reported.
+ *
+ * The emerge log is the backstop for missed directory events: when it
+ * changes, the category directory times are checked against the ones seen
+ * last.
+ */
+class PortageWatcher : public QObject
+{
+    Q_OBJECT
+
+  public:
+    PortageWatcher(const QString &eixFile,
+                   const QString &emergeLogFile,
+                   const QString &packageDatabaseRoot,
+                   QObject *parent = nullptr);
+
+    void start();
+    void stop();
+    bool isActive() const;
+    void hold();
+    void release();
+    void setBatchDelay(int msecs);
+
+  public:
+    /// How long to wait for the events to stop before reporting a batch
+    static constexpr int defaultBatchDelay = 500;
+
+    /// The longest a batch is held back while events keep arriving
+    static constexpr int maxDelay = 5000;
+
+  signals:
+    /// The eix database has been rewritten, e.g. by eix-update
+    void eixDatabaseChanged();
+
+    /// Packages have been added to or removed from these categories of the
+    /// package database, e.g. "dev-qt"
+    void packageDatabaseChanged(const QStringList &categories);
+
+  private:
+    void watchFile(const QString &path);
+    void scanCategories(bool report);
+    void checkCategoryTimes();
+    void startBatch();
+
+  private slots:
+    void onFileChanged(const QString &path);
+    void onDirectoryChanged(const QString &path);
+    void onBatchTimeout();
+
+  private:
+    /// The files and directory being watched
+    const QString _eixFile;
+    const QString _emergeLogFile;
+    const QString _packageDatabaseRoot;
+
+    /// Does the watching (inotify, on Linux)
+    QFileSystemWatcher _watcher;
+
+    /// The last seen modification time of each category directory, by name
+    QHash<QString, QDateTime> _categoryTimes;
+
+    /// Reports the batch once the events have stopped
+    QTimer _batchTimer;
+
+    /// Time since the first event of the batch
+    QElapsedTimer _batchAge;
+
+    /// What has changed in the current batch
+    bool _eixChanged{false};
+    bool _emergeLogChanged{false};
+    bool _rootChanged{false};
+    QSet<QString> _changedCategories;
+
+    /// Whether batches are being held back, see hold()
+    bool _held{false};
+};
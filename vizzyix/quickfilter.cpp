@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "quickfilter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string_view>
+
+#if defined(__x86_64__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace
+{
+/// Folds the ASCII capitals in some text to lower case
+void foldCase(std::string &text)
+{
+    for (char &c : text) {
+        if (c >= 'A' && c <= 'Z') {
+            c += 'a' - 'A';
+        }
+    }
+}
+
+/// Where the pattern first is in data[0, size), or size if it isn't there
+size_t findScalar(const char *data, size_t size, const std::string &pattern)
+{
+    const size_t pos = std::string_view(data, size).find(pattern);
+    return pos == std::string_view::npos ? size : pos;
+}
+
+#if defined(__SSE2__)
+/*!
+ * Like findScalar(), but looks at 16 places at a time. A place is only
+ * compared in full if its byte is the first byte of the pattern and the
+ * byte the length of the pattern on is the last, which is rare.
+ */
+size_t findSse2(const char *data, size_t size, const std::string &pattern)
+{
+    const size_t length = pattern.size();
+    const __m128i first = _mm_set1_epi8(pattern.front());
+    const __m128i last = _mm_set1_epi8(pattern.back());
+    size_t pos = 0;
+    for (; pos + length + 15 <= size; pos += 16) {
+        const __m128i firstBlock =
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        const __m128i lastBlock = _mm_loadu_si128(
+            reinterpret_cast<const __m128i *>(data + pos + length - 1));
+        unsigned mask = _mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(firstBlock, first),
+                          _mm_cmpeq_epi8(lastBlock, last)));
+        while (mask != 0) {
+            const size_t candidate = pos + __builtin_ctz(mask);
+            if (length < 3 || memcmp(data + candidate + 1,
+                                     pattern.data() + 1,
+                                     length - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return pos + findScalar(data + pos, size - pos, pattern);
+}
+#endif
+
+#if defined(__x86_64__)
+/// Like findSse2(), but 32 places at a time, for processors with AVX2
+__attribute__((target("avx2"))) size_t
+findAvx2(const char *data, size_t size, const std::string &pattern)
+{
+    const size_t length = pattern.size();
+    const __m256i first = _mm256_set1_epi8(pattern.front());
+    const __m256i last = _mm256_set1_epi8(pattern.back());
+    size_t pos = 0;
+    for (; pos + length + 31 <= size; pos += 32) {
+        const __m256i firstBlock =
+            _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + pos));
+        const __m256i lastBlock = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i *>(data + pos + length - 1));
+        unsigned mask = _mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(firstBlock, first),
+                             _mm256_cmpeq_epi8(lastBlock, last)));
+        while (mask != 0) {
+            const size_t candidate = pos + __builtin_ctz(mask);
+            if (length < 3 || memcmp(data + candidate + 1,
+                                     pattern.data() + 1,
+                                     length - 2) == 0) {
+                return candidate;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return pos + findScalar(data + pos, size - pos, pattern);
+}
+#endif
+} // namespace
+
+/// Constructor makes an empty filter, using the fastest matcher there is
+QuickFilter::QuickFilter() : _offsets{0}, _matcher(bestMatcher())
+{
+}
+
+/*!
+ * Copies the names and descriptions of the given packages (indexes into the
+ * store) into the filter, replacing what was there. The packages are
+ * numbered from 0 in the same order, for match().
+ */
+void QuickFilter::build(const PackageStore &store, const QVector<int> &packages)
+{
+    clear();
+    size_t length = 0;
+    for (int index : packages) {
+        length += store.name(index).size() + store.description(index).size();
+    }
+    _text.reserve(length + 2 * packages.size());
+    _offsets.reserve(packages.size() + 1);
+
+    for (int index : packages) {
+        _text.append(store.name(index));
+        _text.push_back('\n');
+        _text.append(store.description(index));
+        _text.push_back('\n');
+        _offsets.push_back(static_cast<uint32_t>(_text.size()));
+    }
+    foldCase(_text);
+}
+
+/// Empties the filter
+void QuickFilter::clear()
+{
+    _text.clear();
+    _offsets.assign(1, 0);
+}
+
+/// The number of packages in the filter
+int QuickFilter::size() const
+{
+    return static_cast<int>(_offsets.size()) - 1;
+}
+
+/*!
+ * Finds which of the packages from begin up to end have the given text in
+ * their name or description, ignoring case. Bit n of the bitmap is set if
+ * package begin + n does. An empty text matches every package.
+ */
+void QuickFilter::match(const QString &text,
+                        int begin,
+                        int end,
+                        std::vector<uint64_t> &bitmap) const
+{
+    bitmap.assign((end - begin + 63) / 64, 0);
+    std::string pattern = text.toStdString();
+    foldCase(pattern);
+    if (pattern.empty()) {
+        for (int n = 0; n < end - begin; ++n) {
+            bitmap[n / 64] |= uint64_t(1) << (n % 64);
+        }
+        return;
+    }
+    if (pattern.find('\n') != std::string::npos) {
+        return; // Not in any one name or description
+    }
+
+    // Once a package matches, the rest of it is skipped
+    const size_t to = _offsets[end];
+    int entry = begin;
+    for (size_t pos = find(_offsets[begin], to, pattern); pos < to;
+         pos = find(_offsets[entry + 1], to, pattern)) {
+        entry = std::upper_bound(_offsets.cbegin() + entry + 1,
+                                 _offsets.cbegin() + end + 1,
+                                 pos) -
+                _offsets.cbegin() - 1;
+        const int n = entry - begin;
+        bitmap[n / 64] |= uint64_t(1) << (n % 64);
+    }
+}
+
+/// Whether bit n of a bitmap from match() is set
+bool QuickFilter::isSet(const std::vector<uint64_t> &bitmap, int n)
+{
+    return (bitmap[n / 64] >> (n % 64)) & 1;
+}
+
+/// How the text is scanned
+QuickFilter::Matcher QuickFilter::matcher() const
+{
+    return _matcher;
+}
+
+/*!
+ * Sets how the text is scanned, e.g. to compare the matchers. Asking for a
+ * matcher the processor can't run gets the best one it can.
+ */
+void QuickFilter::setMatcher(Matcher matcher)
+{
+    _matcher = std::min(matcher, bestMatcher());
+}
+
+/// The fastest matcher this processor can run
+QuickFilter::Matcher QuickFilter::bestMatcher()
+{
+#if defined(__x86_64__)
+    if (__builtin_cpu_supports("avx2")) {
+        return Avx2Matcher;
+    }
+#endif
+#if defined(__SSE2__)
+    return Sse2Matcher;
+#else
+    return ScalarMatcher;
+#endif
+}
+
+/// Where the pattern first is in _text[from, to), or to if it isn't there
+size_t
+QuickFilter::find(size_t from, size_t to, const std::string &pattern) const
+{
+    const char *data = _text.data() + from;
+    switch (_matcher) {
+#if defined(__x86_64__)
+    case Avx2Matcher:
+        return from + findAvx2(data, to - from, pattern);
+#endif
+#if defined(__SSE2__)
+    case Sse2Matcher:
+        return from + findSse2(data, to - from, pattern);
+#endif
+    default:
+        return from + findScalar(data, to - from, pattern);
+    }
+}
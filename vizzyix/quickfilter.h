@@ -0,0 +1,67 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "packagestore.h"
+
+/*! class QuickFilter
+ *
+ * Narrows the package list to the packages whose name or description
+ * contains some text, on every keystroke, without going back to the eix data
+ * (compare SearchIndex, which the main search uses).
+ *
+ * The names and descriptions of a list of packages (the package layout, see
+ * ApplicationData::layOutPackages()) are copied, in lower case, into one
+ * buffer, with a table of where each package starts. The packages of any
+ * category tree node are then one stretch of the buffer, which is scanned 16
+ * or 32 bytes at a time with SSE2 or AVX2 where the processor has them. The
+ * packages that match are returned as a bitmap.
+ *
+ * Only ASCII letters are folded, so e.g. "É" only matches itself.
+ */
+class QuickFilter
+{
+  public:
+    /// The ways of scanning the text, fastest last
+    enum Matcher { ScalarMatcher, Sse2Matcher, Avx2Matcher };
+
+    QuickFilter();
+
+    QuickFilter(const QuickFilter &) = delete;
+    QuickFilter &operator=(QuickFilter &) = delete;
+
+    void build(const PackageStore &store, const QVector<int> &packages);
+    void clear();
+    int size() const;
+
+    void match(const QString &text,
+               int begin,
+               int end,
+               std::vector<uint64_t> &bitmap) const;
+    static bool isSet(const std::vector<uint64_t> &bitmap, int n);
+
+    Matcher matcher() const;
+    void setMatcher(Matcher matcher);
+    static Matcher bestMatcher();
+
+  private:
+    size_t find(size_t from, size_t to, const std::string &pattern) const;
+
+  private:
+    /// Each package's name and description, in lower case, each followed
+    /// by a newline
+    std::string _text;
+
+    /// Where each package's text starts in _text, plus the end
+    std::vector<uint32_t> _offsets;
+
+    /// How _text is scanned, see setMatcher()
+    Matcher _matcher;
+};
@@ -0,0 +1,305 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "searchindex.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "snapshotimage.h"
+
+namespace
+{
+/// Appends text in lower case (ASCII only, like the package name matching)
+void appendLower(std::string &out, const std::string &text)
+{
+    for (char c : text) {
+        out.push_back((c >= 'A' && c <= 'Z') ? char(c - 'A' + 'a') : c);
+    }
+}
+
+/// Whether a table of starts goes from 0 up to 'end', never going down
+template <typename T> bool isStartTable(const std::vector<T> &starts, T end)
+{
+    return !starts.empty() && starts.front() == 0 && starts.back() == end &&
+           std::is_sorted(starts.begin(), starts.end());
+}
+} // namespace
+
+/// Constructor, the index is empty until build() is called
+SearchIndex::SearchIndex()
+{
+    clear();
+}
+
+/*!
+ * Builds the index for the given eix data, replacing anything already there.
+ * Only the names and descriptions are used, so the packages may be
+ * summaries (see EixLazyDecoder).
+ */
+void SearchIndex::build(const eix_proto::Collection &eix)
+{
+    clear();
+
+    // The text of each entry
+    for (int catNumber = 0; catNumber < eix.category_size(); ++catNumber) {
+        const auto &cat = eix.category(catNumber);
+        _categoryStart.push_back(entryCount());
+        for (int pkgNumber = 0; pkgNumber < cat.package_size(); ++pkgNumber) {
+            const auto &pkg = cat.package(pkgNumber);
+            appendLower(_text, cat.category());
+            _text.push_back('/');
+            appendLower(_text, pkg.name());
+            _text.push_back('\n');
+            appendLower(_text, pkg.description());
+            _textStart.push_back(static_cast<uint32_t>(_text.size()));
+            _entryCategory.push_back(catNumber);
+        }
+    }
+    _categoryStart.push_back(entryCount());
+
+    // The distinct trigrams of each entry, counted up for each trigram.
+    // lastEntry avoids sorting each entry's trigrams to find repeats.
+    std::vector<Trigram> entryTrigramList;
+    std::vector<uint32_t> entryTrigramStart{0};
+    std::vector<int> lastEntry(trigramCount, -1);
+    entryTrigramList.reserve(_text.size());
+    entryTrigramStart.reserve(entryCount() + 1);
+    _postingStart.assign(trigramCount + 1, 0);
+    for (int entry = 0; entry < entryCount(); ++entry) {
+        std::string_view text = entryText(entry);
+        for (size_t i = 0; i + 3 <= text.size(); ++i) {
+            Trigram trigram = trigramAt(text, i);
+            if (lastEntry[trigram] != entry) {
+                lastEntry[trigram] = entry;
+                ++_postingStart[trigram + 1];
+                entryTrigramList.push_back(trigram);
+            }
+        }
+        entryTrigramStart.push_back(
+            static_cast<uint32_t>(entryTrigramList.size()));
+    }
+
+    // Lay the entries out trigram by trigram; they go in in ascending order
+    for (Trigram trigram = 0; trigram < trigramCount; ++trigram) {
+        _postingStart[trigram + 1] += _postingStart[trigram];
+    }
+    std::vector<uint32_t> next(_postingStart.begin(), _postingStart.end() - 1);
+    _postings.resize(entryTrigramList.size());
+    for (int entry = 0; entry < entryCount(); ++entry) {
+        for (uint32_t i = entryTrigramStart[entry];
+             i < entryTrigramStart[entry + 1];
+             ++i) {
+            _postings[next[entryTrigramList[i]]++] = entry;
+        }
+    }
+}
+
+/// Empties the index
+void SearchIndex::clear()
+{
+    _text.clear();
+    _textStart.assign(1, 0);
+    _entryCategory.clear();
+    _categoryStart.clear();
+    _postingStart.clear();
+    _postings.clear();
+    _lastText.clear();
+    _lastResult.clear();
+}
+
+/// Writes the index to a snapshot
+void SearchIndex::save(SnapshotImage &image) const
+{
+    image.write(std::string_view(_text));
+    image.write(_textStart);
+    image.write(_entryCategory);
+    image.write(_categoryStart);
+    image.write(_postingStart);
+    image.write(_postings);
+}
+
+/*!
+ * Reads back an index written by save(), replacing what was there. Returns
+ * false, leaving the index empty, if the image doesn't hold a whole index.
+ */
+bool SearchIndex::restore(SnapshotImage &image)
+{
+    clear();
+    bool ok = image.read(_text) && image.read(_textStart) &&
+              image.read(_entryCategory) && image.read(_categoryStart) &&
+              image.read(_postingStart) && image.read(_postings);
+
+    // An index that was never built has no tables at all
+    const bool built = !_categoryStart.empty();
+    const int categories = built ? int(_categoryStart.size()) - 1 : 0;
+    ok = ok && _textStart.size() == _entryCategory.size() + 1 &&
+         isStartTable(_textStart, static_cast<uint32_t>(_text.size()));
+    if (built) {
+        ok = ok && isStartTable(_categoryStart, entryCount()) &&
+             _postingStart.size() == trigramCount + 1 &&
+             isStartTable(_postingStart,
+                          static_cast<uint32_t>(_postings.size()));
+    } else {
+        ok = ok && _entryCategory.empty() && _postingStart.empty() &&
+             _postings.empty();
+    }
+    for (size_t entry = 0; ok && entry < _entryCategory.size(); ++entry) {
+        const int catNumber = _entryCategory[entry];
+        ok = catNumber >= 0 && catNumber < categories &&
+             int(entry) >= _categoryStart[catNumber] &&
+             int(entry) < _categoryStart[catNumber + 1];
+    }
+    for (size_t i = 0; ok && i < _postings.size(); ++i) {
+        ok = _postings[i] >= 0 && _postings[i] < entryCount();
+    }
+    if (!ok) {
+        clear();
+        return false;
+    }
+    return true;
+}
+
+/// Whether there is nothing in the index
+bool SearchIndex::isEmpty() const
+{
+    return _entryCategory.empty();
+}
+
+/// The number of packages in the index
+int SearchIndex::entryCount() const
+{
+    return static_cast<int>(_entryCategory.size());
+}
+
+/// The eix category number of an entry
+int SearchIndex::categoryNumber(int entry) const
+{
+    return _entryCategory[entry];
+}
+
+/// The package number of an entry, within its eix category
+int SearchIndex::packageNumber(int entry) const
+{
+    return entry - _categoryStart[_entryCategory[entry]];
+}
+
+/*!
+ * Returns the entries whose category, name or description contains the
+ * given text, in ascending order. The text must be in lower case; an empty
+ * text matches everything.
+ *
+ * The result is only good until the next call.
+ */
+const std::vector<int> &SearchIndex::find(const std::string &text)
+{
+    std::vector<int> result;
+
+    if (!_lastText.empty() && text.find(_lastText) != std::string::npos) {
+        // Anything that contains text also contains _lastText
+        findByScan(text, &_lastResult, result);
+    } else if (text.size() >= 3) {
+        findByTrigrams(text, result);
+    } else {
+        findByScan(text, nullptr, result);
+    }
+
+    _lastText = text;
+    _lastResult.swap(result);
+    return _lastResult;
+}
+
+/// The lower case text of an entry
+std::string_view SearchIndex::entryText(int entry) const
+{
+    return std::string_view(_text).substr(
+        _textStart[entry], _textStart[entry + 1] - _textStart[entry]);
+}
+
+/*!
+ * The trigram starting at position i of the text. Each trigram is hashed
+ * down to one of trigramCount numbers, so the lists fit in a flat array; two
+ * trigrams sharing a number only means a few more entries to check.
+ */
+SearchIndex::Trigram SearchIndex::trigramAt(std::string_view text, size_t i)
+{
+    Trigram value = Trigram(uint8_t(text[i])) << 16 |
+                    Trigram(uint8_t(text[i + 1])) << 8 |
+                    Trigram(uint8_t(text[i + 2]));
+    return (value * 2654435761u) >> (32 - trigramBits);
+}
+
+/// The distinct trigrams of a text, in ascending order
+void SearchIndex::textTrigrams(std::string_view text,
+                               std::vector<Trigram> &trigrams)
+{
+    trigrams.clear();
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        trigrams.push_back(trigramAt(text, i));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                   trigrams.end());
+}
+
+/*!
+ * Finds the entries that have all the trigrams of the text, shortest list
+ * first, then checks that those really contain the text.
+ */
+void SearchIndex::findByTrigrams(const std::string &text,
+                                 std::vector<int> &result)
+{
+    std::vector<Trigram> trigrams;
+    textTrigrams(text, trigrams);
+
+    std::vector<Trigram> lists;
+    for (Trigram trigram : trigrams) {
+        if (_postingStart[trigram] == _postingStart[trigram + 1]) {
+            return; // no entry has it
+        }
+        lists.push_back(trigram);
+    }
+    std::sort(lists.begin(), lists.end(), [this](Trigram a, Trigram b) {
+        return _postingStart[a + 1] - _postingStart[a] <
+               _postingStart[b + 1] - _postingStart[b];
+    });
+
+    std::vector<int> candidates(_postings.begin() + _postingStart[lists[0]],
+                                _postings.begin() +
+                                    _postingStart[lists[0] + 1]);
+    std::vector<int> common;
+    for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+        common.clear();
+        std::set_intersection(candidates.begin(),
+                              candidates.end(),
+                              _postings.begin() + _postingStart[lists[i]],
+                              _postings.begin() + _postingStart[lists[i] + 1],
+                              std::back_inserter(common));
+        candidates.swap(common);
+    }
+
+    findByScan(text, &candidates, result);
+}
+
+/*!
+ * Checks each of the candidate entries (or every entry, if there is no
+ * candidate list) for the text.
+ */
+void SearchIndex::findByScan(const std::string &text,
+                             const std::vector<int> *candidates,
+                             std::vector<int> &result) const
+{
+    if (candidates == nullptr) {
+        for (int entry = 0; entry < entryCount(); ++entry) {
+            if (entryText(entry).find(text) != std::string_view::npos) {
+                result.push_back(entry);
+            }
+        }
+    } else {
+        for (int entry : *candidates) {
+            if (entryText(entry).find(text) != std::string_view::npos) {
+                result.push_back(entry);
+            }
+        }
+    }
+}
@@ -0,0 +1,86 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "eix.pb.h"
+
+class SnapshotImage;
+
+/*! class SearchIndex
+ *
+ * A trigram index over the text of every package in the eix data: the
+ * category, the package name and the description, in lower case. Each
+ * package is an "entry", numbered in eix order (category by category).
+ *
+ * find() returns the entries whose text contains a search string. Strings of
+ * three or more characters only look at the entries that have all of the
+ * string's trigrams, and each of those is then checked. If the string
+ * extends the previous one (e.g. the next keystroke), only the previous
+ * result is checked.
+ *
+ * The index can be saved to a snapshot and read back as it is (see save()
+ * and restore()), so it only has to be built once for each eix run.
+ */
+class SearchIndex
+{
+  public:
+    SearchIndex();
+
+    SearchIndex(const SearchIndex &) = delete;
+    SearchIndex &operator=(SearchIndex &) = delete;
+
+    void build(const eix_proto::Collection &eix);
+    void clear();
+    void save(SnapshotImage &image) const;
+    bool restore(SnapshotImage &image);
+    bool isEmpty() const;
+    int entryCount() const;
+    int categoryNumber(int entry) const;
+    int packageNumber(int entry) const;
+    const std::vector<int> &find(const std::string &text);
+
+  private:
+    typedef uint32_t Trigram;
+
+    /// Trigrams are hashed to this many bits
+    static constexpr int trigramBits = 16;
+    static constexpr Trigram trigramCount = Trigram(1) << trigramBits;
+
+    std::string_view entryText(int entry) const;
+    static Trigram trigramAt(std::string_view text, size_t i);
+    static void textTrigrams(std::string_view text,
+                             std::vector<Trigram> &trigrams);
+    void findByTrigrams(const std::string &text, std::vector<int> &result);
+    void findByScan(const std::string &text,
+                    const std::vector<int> *candidates,
+                    std::vector<int> &result) const;
+
+  private:
+    /// The lower case text of all the entries, one after another
+    std::string _text;
+
+    /// Where each entry's text starts in _text, plus the end of the last
+    std::vector<uint32_t> _textStart;
+
+    /// The eix category of each entry
+    std::vector<int> _entryCategory;
+
+    /// The first entry of each eix category
+    std::vector<int> _categoryStart;
+
+    /// Start of each trigram's entries in _postings, plus the end of the last
+    std::vector<uint32_t> _postingStart;
+
+    /// The entries for each trigram, in ascending order
+    std::vector<int> _postings;
+
+    /// The text given to the last find() call, and what it found
+    std::string _lastText;
+    std::vector<int> _lastResult;
+};
@@ -0,0 +1,126 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "snapshotimage.h"
+
+/// Constructor for an empty image, to write to
+SnapshotImage::SnapshotImage()
+    : _data(nullptr), _size(0), _position(0), _valid(true)
+{
+}
+
+/*!
+ * Constructor for an image to read, e.g. from a mapped file. The data is not
+ * copied, so it has to stay there until the image has been read.
+ */
+SnapshotImage::SnapshotImage(const char *data, qsizetype size)
+    : _data(data), _size(size), _position(0), _valid(true)
+{
+}
+
+/// What has been written
+const QByteArray &SnapshotImage::bytes() const
+{
+    return _bytes;
+}
+
+/// Whether everything read so far was there
+bool SnapshotImage::isValid() const
+{
+    return _valid;
+}
+
+/// Whether the whole image has been read
+bool SnapshotImage::atEnd() const
+{
+    return _valid && _position == _size;
+}
+
+/// Writes a number
+void SnapshotImage::write(uint64_t value)
+{
+    writeBytes(&value, sizeof(value));
+}
+
+/// Writes some text, as it is
+void SnapshotImage::write(std::string_view text)
+{
+    write(uint64_t(text.size()));
+    writeBytes(text.data(), text.size());
+}
+
+/// Writes a list of strings, as UTF-8
+void SnapshotImage::write(const QStringList &list)
+{
+    write(uint64_t(list.size()));
+    for (const QString &text : list) {
+        write(std::string_view(text.toStdString()));
+    }
+}
+
+/// Reads a number
+bool SnapshotImage::read(uint64_t &value)
+{
+    const char *data = readBytes(sizeof(value));
+    if (data == nullptr) {
+        return false;
+    }
+    std::memcpy(&value, data, sizeof(value));
+    return true;
+}
+
+/// Reads some text
+bool SnapshotImage::read(std::string &text)
+{
+    uint64_t size;
+    if (!read(size)) {
+        return false;
+    }
+    const char *data = readBytes(size);
+    if (data == nullptr) {
+        return false;
+    }
+    text.assign(data, size);
+    return true;
+}
+
+/// Reads a list of strings
+bool SnapshotImage::read(QStringList &list)
+{
+    uint64_t count;
+    if (!read(count) || count > uint64_t(_size)) {
+        _valid = false;
+        return false;
+    }
+    list.clear();
+    list.reserve(count);
+    std::string text;
+    for (uint64_t n = 0; n < count; ++n) {
+        if (!read(text)) {
+            return false;
+        }
+        list.append(QString::fromStdString(text));
+    }
+    return true;
+}
+
+/// Adds some bytes to the end of the image
+void SnapshotImage::writeBytes(const void *data, size_t size)
+{
+    _bytes.append(static_cast<const char *>(data), size);
+}
+
+/*!
+ * Returns the next 'size' bytes of the image and moves on past them, or
+ * nullptr if there aren't that many left.
+ */
+const char *SnapshotImage::readBytes(uint64_t size)
+{
+    if (!_valid || size > uint64_t(_size - _position)) {
+        _valid = false;
+        return nullptr;
+    }
+    const char *data = _data + _position;
+    _position += size;
+    return data;
+}
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <QByteArray>
+#include <QStringList>
+#include <QtGlobal>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/*! class SnapshotImage
+ *
+ * The tables a load works out (see PortageSnapshot), laid out one after
+ * another as they are in memory, so they can be read back out of a mapped
+ * file without working anything out again.
+ *
+ * Each table is written as its length and then its bytes. An array of plain
+ * values is copied as a whole, so reading it back is a single copy; only
+ * text that has to become QStrings is converted one string at a time.
+ *
+ * An image is either written to (the default constructor), or read from some
+ * bytes that it doesn't own. Reading past the end, or a length that doesn't
+ * fit, makes the image invalid and every read after that fails.
+ */
+class SnapshotImage
+{
+  public:
+    SnapshotImage();
+    SnapshotImage(const char *data, qsizetype size);
+
+    SnapshotImage(const SnapshotImage &) = delete;
+    SnapshotImage &operator=(SnapshotImage &) = delete;
+
+    const QByteArray &bytes() const;
+    bool isValid() const;
+    bool atEnd() const;
+
+    void write(uint64_t value);
+    void write(std::string_view text);
+    void write(const QStringList &list);
+    template <typename T> void write(const std::vector<T> &values);
+    template <typename T>
+    void write(const std::vector<std::vector<T>> &values);
+
+    bool read(uint64_t &value);
+    bool read(std::string &text);
+    bool read(QStringList &list);
+    template <typename T> bool read(std::vector<T> &values);
+    template <typename T> bool read(std::vector<std::vector<T>> &values);
+
+  private:
+    void writeBytes(const void *data, size_t size);
+    const char *readBytes(uint64_t size);
+
+  private:
+    /// What has been written so far
+    QByteArray _bytes;
+
+    /// What is being read
+    const char *_data;
+    qsizetype _size;
+
+    /// Where the next read starts
+    qsizetype _position;
+
+    /// Whether every read so far has been good
+    bool _valid;
+};
+
+/// Writes an array of plain values
+template <typename T> void SnapshotImage::write(const std::vector<T> &values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    write(uint64_t(values.size()));
+    writeBytes(values.data(), values.size() * sizeof(T));
+}
+
+/// Writes an array of arrays of plain values
+template <typename T>
+void SnapshotImage::write(const std::vector<std::vector<T>> &values)
+{
+    write(uint64_t(values.size()));
+    for (const auto &value : values) {
+        write(value);
+    }
+}
+
+/// Reads an array written by write()
+template <typename T> bool SnapshotImage::read(std::vector<T> &values)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    uint64_t count;
+    if (!read(count) || count > uint64_t(_size) / sizeof(T)) {
+        _valid = false;
+        return false;
+    }
+    const char *data = readBytes(count * sizeof(T));
+    if (data == nullptr) {
+        return false;
+    }
+    values.resize(count);
+    if (count > 0) {
+        std::memcpy(values.data(), data, count * sizeof(T));
+    }
+    return true;
+}
+
+/// Reads an array of arrays written by write()
+template <typename T>
+bool SnapshotImage::read(std::vector<std::vector<T>> &values)
+{
+    uint64_t count;
+    if (!read(count) || count > uint64_t(_size)) {
+        _valid = false;
+        return false;
+    }
+    values.resize(count);
+    for (auto &value : values) {
+        if (!read(value)) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "stringpool.h"
+
+#include "snapshotimage.h"
+
+namespace
+{
+/// The number of hash table slots to start with
+constexpr size_t initialSlots = 1024;
+} // namespace
+
+/// Constructor, the pool starts empty
+StringPool::StringPool()
+{
+    clear();
+}
+
+/// Returns the id of the string, adding it if it isn't already there
+StringPool::Id StringPool::add(std::string_view text)
+{
+    const uint32_t textHash = hash(text);
+    size_t slot = slotFor(text, textHash);
+    if (_slots[slot] != 0) {
+        return _slots[slot] - 1;
+    }
+
+    const Id id = static_cast<Id>(_hash.size());
+    _text.append(text);
+    _start.push_back(static_cast<uint32_t>(_text.size()));
+    _hash.push_back(textHash);
+    _slots[slot] = id + 1;
+
+    if (_hash.size() * 2 > _slots.size()) {
+        grow();
+    }
+    return id;
+}
+
+/// Returns the id of the string, or npos if it isn't in the pool
+StringPool::Id StringPool::find(std::string_view text) const
+{
+    const size_t slot = slotFor(text, hash(text));
+    return _slots[slot] == 0 ? npos : _slots[slot] - 1;
+}
+
+/// The string with the given id; good until the next add() or clear()
+std::string_view StringPool::str(Id id) const
+{
+    return std::string_view(_text).substr(_start[id],
+                                          _start[id + 1] - _start[id]);
+}
+
+/// The number of distinct strings
+int StringPool::size() const
+{
+    return static_cast<int>(_hash.size());
+}
+
+/// Empties the pool; the ids start from 0 again
+void StringPool::clear()
+{
+    _text.clear();
+    _start.assign(1, 0);
+    _hash.clear();
+    _slots.assign(initialSlots, 0);
+}
+
+/// Writes the pool to a snapshot, hash table and all
+void StringPool::save(SnapshotImage &image) const
+{
+    image.write(_text);
+    image.write(_start);
+    image.write(_hash);
+    image.write(_slots);
+}
+
+/*!
+ * Reads back a pool written by save(), replacing what was there. Nothing is
+ * hashed again. Returns false, leaving the pool empty, if the image doesn't
+ * hold a whole pool.
+ */
+bool StringPool::restore(SnapshotImage &image)
+{
+    bool ok = image.read(_text) && image.read(_start) && image.read(_hash) &&
+              image.read(_slots);
+
+    // Enough to make sure str() and the hash table stay in bounds
+    ok = ok && _start.size() == _hash.size() + 1 && _start[0] == 0 &&
+         _start.back() == _text.size() && _slots.size() >= initialSlots &&
+         (_slots.size() & (_slots.size() - 1)) == 0 &&
+         _hash.size() * 2 <= _slots.size();
+    for (size_t n = 1; ok && n < _start.size(); ++n) {
+        ok = _start[n - 1] <= _start[n];
+    }
+    for (size_t n = 0; ok && n < _slots.size(); ++n) {
+        ok = _slots[n] <= _hash.size();
+    }
+    if (!ok) {
+        clear();
+    }
+    return ok;
+}
+
+/// FNV-1a, which is quick for short strings like package names
+uint32_t StringPool::hash(std::string_view text)
+{
+    uint32_t result = 2166136261u;
+    for (char c : text) {
+        result = (result ^ uint8_t(c)) * 16777619u;
+    }
+    return result;
+}
+
+/// The slot holding the string, or the empty slot where it would go
+size_t StringPool::slotFor(std::string_view text, uint32_t textHash) const
+{
+    const size_t mask = _slots.size() - 1;
+    for (size_t slot = textHash & mask;; slot = (slot + 1) & mask) {
+        const Id entry = _slots[slot];
+        if (entry == 0 || (_hash[entry - 1] == textHash &&
+                           str(entry - 1) == text)) {
+            return slot;
+        }
+    }
+}
+
+/// Doubles the hash table and puts the ids back in
+void StringPool::grow()
+{
+    std::vector<Id> slots(_slots.size() * 2, 0);
+    const size_t mask = slots.size() - 1;
+    for (Id id = 0; id < _hash.size(); ++id) {
+        size_t slot = _hash[id] & mask;
+        while (slots[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = id + 1;
+    }
+    _slots.swap(slots);
+}
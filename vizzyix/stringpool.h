@@ -0,0 +1,62 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class SnapshotImage;
+
+/*! class StringPool
+ *
+ * Interns strings: each distinct string is stored once and given a 32-bit
+ * id, numbered from 0 in the order they were first added. Comparing ids is
+ * then the same as comparing the strings.
+ *
+ * The strings are kept one after another in a single buffer, and found with
+ * an open addressing hash table of ids.
+ */
+class StringPool
+{
+  public:
+    typedef uint32_t Id;
+
+    /// Returned by find() for a string that isn't in the pool
+    static constexpr Id npos = UINT32_MAX;
+
+    StringPool();
+
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(StringPool &) = delete;
+
+    Id add(std::string_view text);
+    Id find(std::string_view text) const;
+    std::string_view str(Id id) const;
+    int size() const;
+    void clear();
+
+    void save(SnapshotImage &image) const;
+    bool restore(SnapshotImage &image);
+
+  private:
+    static uint32_t hash(std::string_view text);
+    size_t slotFor(std::string_view text, uint32_t textHash) const;
+    void grow();
+
+  private:
+    /// The strings, one after another
+    std::string _text;
+
+    /// Where each string starts in _text, plus the end of the last
+    std::vector<uint32_t> _start;
+
+    /// The hash of each string, so growing doesn't hash them again
+    std::vector<uint32_t> _hash;
+
+    /// The hash table: id + 1 for each used slot, 0 for an empty one. The
+    /// size is a power of two, and at most half the slots are used.
+    std::vector<Id> _slots;
+};
@@ -0,0 +1,232 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#include "versionkey.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+/*!
+ * The bytes that mark each part of a key. They are chosen so that the parts
+ * sort as PMS says they should: e.g. a version with fewer components comes
+ * first, so the end of the components comes before another component.
+ */
+enum Marker : char {
+    EndComponents = 0x01,
+    FractionComponent = 0x02,
+    NumberComponent = 0x03,
+    NoLetter = 0x01,
+    Alpha = 0x02,
+    Beta = 0x03,
+    Pre = 0x04,
+    ReleaseCandidate = 0x05,
+    EndSuffixes = 0x06,
+    Patch = 0x07,
+    Invalid = '\xff'
+};
+
+/// The suffixes a version may have, with their markers
+struct Suffix {
+    std::string_view name;
+    Marker marker;
+};
+
+/// "pre" and "p" both start with p, so the longer ones are tried first
+constexpr Suffix suffixes[] = {{"alpha", Alpha},
+                               {"beta", Beta},
+                               {"pre", Pre},
+                               {"rc", ReleaseCandidate},
+                               {"p", Patch}};
+
+/// The most digits a number may have; its length has to fit in a byte
+constexpr size_t maxDigits = 200;
+
+/// Versions with a component of at least this many 9s are live versions
+constexpr size_t liveNines = 4;
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+/*!
+ * Returns the digits starting at pos, and moves pos past them. The result is
+ * empty if there aren't any, or if there are too many.
+ */
+std::string_view takeDigits(std::string_view text, size_t &pos)
+{
+    const size_t start = pos;
+    while (pos < text.size() && isDigit(text[pos])) {
+        ++pos;
+    }
+    if (pos - start > maxDigits) {
+        return {};
+    }
+    return text.substr(start, pos - start);
+}
+
+/// Whether the text has the given part at pos
+bool hasAt(std::string_view text, size_t pos, std::string_view part)
+{
+    return text.substr(pos, part.size()) == part;
+}
+} // namespace
+
+/*!
+ * Returns the sort key of a version. A version that isn't valid gets a key
+ * that sorts after every valid version, and is only equal to the key of the
+ * same text.
+ */
+std::string VersionKey::key(std::string_view version)
+{
+    std::string result;
+    result.reserve(version.size() + 8);
+    if (!parse(version, &result)) {
+        result.assign(1, Invalid);
+        result.append(version);
+    }
+    return result;
+}
+
+/// Whether the text is a valid version, with or without a revision
+bool VersionKey::isValid(std::string_view version)
+{
+    return parse(version, nullptr);
+}
+
+/*!
+ * Whether the version is a live version, built from the latest sources:
+ * e.g. "9999", or "6.8.9999". There's no way to tell from the version alone,
+ * but that's how they are numbered by convention.
+ */
+bool VersionKey::isLive(std::string_view version)
+{
+    size_t pos = 0;
+    do {
+        const std::string_view digits = takeDigits(version, pos);
+        if (digits.size() >= liveNines &&
+            std::all_of(digits.begin(), digits.end(), [](char c) {
+                return c == '9';
+            })) {
+            return true;
+        }
+    } while (pos < version.size() && version[pos++] == '.');
+    return false;
+}
+
+/// Compares two versions: less than, equal to or greater than 0
+int VersionKey::compare(std::string_view first, std::string_view second)
+{
+    return key(first).compare(key(second));
+}
+
+/*!
+ * Parses a version, and makes its key if key isn't null. Returns false if
+ * the version isn't valid.
+ */
+bool VersionKey::parse(std::string_view version, std::string *key)
+{
+    // The first component is always compared as a number
+    size_t pos = 0;
+    std::string_view digits = takeDigits(version, pos);
+    if (digits.empty()) {
+        return false;
+    }
+    appendNumber(key, digits);
+
+    // The rest are compared as fractions if either one starts with a 0,
+    // which is the same as comparing them as strings. A fraction is always
+    // less than a number that doesn't start with a 0.
+    while (pos < version.size() && version[pos] == '.') {
+        ++pos;
+        digits = takeDigits(version, pos);
+        if (digits.empty()) {
+            return false;
+        }
+        if (key == nullptr) {
+            continue;
+        }
+        if (digits[0] == '0') {
+            // Trailing zeros don't count
+            const size_t last = digits.find_last_not_of('0');
+            key->push_back(FractionComponent);
+            key->append(digits.substr(0, last == std::string_view::npos
+                                             ? 0
+                                             : last + 1));
+            key->push_back('\0');
+        } else {
+            key->push_back(NumberComponent);
+            appendNumber(key, digits);
+        }
+    }
+
+    char letter = NoLetter;
+    if (pos < version.size() && version[pos] >= 'a' && version[pos] <= 'z') {
+        letter = version[pos++];
+    }
+    if (key != nullptr) {
+        key->push_back(EndComponents);
+        key->push_back(letter);
+    }
+
+    while (pos < version.size() && version[pos] == '_') {
+        ++pos;
+        const auto suffix =
+            std::find_if(std::begin(suffixes),
+                         std::end(suffixes),
+                         [&](const Suffix &s) {
+                             return hasAt(version, pos, s.name);
+                         });
+        if (suffix == std::end(suffixes)) {
+            return false;
+        }
+        pos += suffix->name.size();
+
+        // A suffix without a number is the same as with a 0
+        const size_t start = pos;
+        digits = takeDigits(version, pos);
+        if (digits.empty() && pos != start) {
+            return false; // too many digits
+        }
+        if (key != nullptr) {
+            key->push_back(suffix->marker);
+            appendNumber(key, digits);
+        }
+    }
+    if (key != nullptr) {
+        key->push_back(EndSuffixes);
+    }
+
+    // No revision is the same as -r0
+    digits = {};
+    if (pos < version.size()) {
+        if (!hasAt(version, pos, "-r")) {
+            return false;
+        }
+        pos += 2;
+        digits = takeDigits(version, pos);
+        if (digits.empty() || pos != version.size()) {
+            return false;
+        }
+    }
+    appendNumber(key, digits);
+    return true;
+}
+
+/*!
+ * Adds a number to the key: the number of digits, without leading zeros,
+ * then the digits. So a longer number sorts after a shorter one.
+ */
+void VersionKey::appendNumber(std::string *key, std::string_view digits)
+{
+    if (key == nullptr) {
+        return;
+    }
+    const size_t first = digits.find_first_not_of('0');
+    digits = first == std::string_view::npos ? std::string_view()
+                                             : digits.substr(first);
+    key->push_back(static_cast<char>(digits.size()));
+    key->append(digits);
+}
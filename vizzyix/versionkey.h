@@ -0,0 +1,35 @@
+// SPDX-FileCopyrightText: 2026 Bill Binder <dxtwjb@gmail.com>
+// SPDX-License-Identifier: GPL-2.0-only
+
+#pragma once
+
+#include <string>
+#include <string_view>
+
+/*! class VersionKey
+ *
+ * Parses package versions as PMS (the Package Manager Specification)
+ * defines them, e.g. "1.2.3b_rc2_p1-r4", and makes sort keys from them.
+ *
+ * Comparing two keys a byte at a time (as memcmp() or std::string does)
+ * gives the same answer as comparing the versions with the PMS algorithm:
+ * the numeric components as numbers (or as fractions, when they start with
+ * a 0), then the letter, the suffixes (_alpha < _beta < _pre < _rc < none <
+ * _p) and the revision. Versions that only differ in how they are written
+ * (e.g. "1.0-r0" and "1.0") have the same key.
+ *
+ * A key is made once for each version, so sorting and comparing versions
+ * doesn't have to parse them again.
+ */
+class VersionKey
+{
+  public:
+    static std::string key(std::string_view version);
+    static bool isValid(std::string_view version);
+    static bool isLive(std::string_view version);
+    static int compare(std::string_view first, std::string_view second);
+
+  private:
+    static bool parse(std::string_view version, std::string *key);
+    static void appendNumber(std::string *key, std::string_view digits);
+};